@@ -0,0 +1,50 @@
+#include "DroneAssetManifest.h"
+#include "DroneFPCharacter.h"
+#include "RaceGate.h"
+
+const FPrimaryAssetType UDroneAssetManifest::PrimaryAssetType(TEXT("DroneAssetManifest"));
+
+void UDroneAssetManifest::GetGroupPaths(EGroup Group, TArray<FSoftObjectPath>& OutPaths) const
+{
+    auto AddPath = [&OutPaths](const FSoftObjectPath& Path)
+    {
+        if (Path.IsValid())
+        {
+            OutPaths.Add(Path);
+        }
+    };
+
+    auto AddAll = [&AddPath](const TArray<TSoftObjectPtr<UObject>>& Assets)
+    {
+        for (const TSoftObjectPtr<UObject>& Asset : Assets)
+        {
+            AddPath(Asset.ToSoftObjectPath());
+        }
+    };
+
+    switch (Group)
+    {
+    case Group_Drone:
+        AddPath(DroneClass.ToSoftObjectPath());
+        AddAll(DroneAssets);
+        break;
+
+    case Group_Course:
+        AddPath(GateClass.ToSoftObjectPath());
+        AddAll(CourseAssets);
+        break;
+
+    case Group_Weapon:
+        AddPath(WeaponClass.ToSoftObjectPath());
+        AddAll(WeaponAssets);
+        break;
+
+    default:
+        break;
+    }
+}
+
+FPrimaryAssetId UDroneAssetManifest::GetPrimaryAssetId() const
+{
+    return FPrimaryAssetId(PrimaryAssetType, GetFName());
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "DroneAssetManifest.generated.h"
+
+class ADroneFPCharacter;
+class ARaceGate;
+
+/**
+ * What has to be in memory before a pilot can fly, grouped so each group
+ * streams in as its own request. Found by the asset manager as primary
+ * asset type DroneAssetManifest (see DefaultGame.ini) and loaded by
+ * UDronePreloadSubsystem.
+ */
+UCLASS(BlueprintType)
+class DRONERACERFP_API UDroneAssetManifest : public UPrimaryDataAsset
+{
+    GENERATED_BODY()
+
+public:
+    static const FPrimaryAssetType PrimaryAssetType;
+
+    enum EGroup : uint8
+    {
+        Group_Drone,
+        Group_Course,
+        Group_Weapon,
+        Group_Num
+    };
+
+    /** Pawn the game mode spawns for pilots */
+    UPROPERTY(EditDefaultsOnly, Category = "Drone")
+    TSoftClassPtr<ADroneFPCharacter> DroneClass;
+
+    /** Input mapping contexts and actions, meshes, sounds */
+    UPROPERTY(EditDefaultsOnly, Category = "Drone")
+    TArray<TSoftObjectPtr<UObject>> DroneAssets;
+
+    UPROPERTY(EditDefaultsOnly, Category = "Course")
+    TSoftClassPtr<ARaceGate> GateClass;
+
+    /** Gate meshes and Glow / Dark materials, the instanced gate highlight */
+    UPROPERTY(EditDefaultsOnly, Category = "Course")
+    TArray<TSoftObjectPtr<UObject>> CourseAssets;
+
+    UPROPERTY(EditDefaultsOnly, Category = "Weapon")
+    TSoftClassPtr<AActor> WeaponClass;
+
+    UPROPERTY(EditDefaultsOnly, Category = "Weapon")
+    TArray<TSoftObjectPtr<UObject>> WeaponAssets;
+
+    void GetGroupPaths(EGroup Group, TArray<FSoftObjectPath>& OutPaths) const;
+
+    virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+};
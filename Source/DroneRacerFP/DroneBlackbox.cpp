@@ -0,0 +1,162 @@
+#include "DroneBlackbox.h"
+
+#include "HAL/FileManager.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Compression.h"
+#include "Misc/Paths.h"
+
+namespace DroneBlackbox
+{
+    // Uncompressed CSV per gzip member
+    constexpr int32 ChunkBytes = 256 * 1024;
+
+    // Writer wakes up this often; the producer never signals, so Push stays syscall free
+    constexpr float PollSeconds = 0.05f;
+
+    const ANSICHAR* CsvHeader =
+        "loopIteration,time (us),"
+        "rcCommand[0],rcCommand[1],rcCommand[2],rcCommand[3],"
+        "gyroADC[0],gyroADC[1],gyroADC[2],"
+        "vbatLatest (V),"
+        "attitude[0] (deg),attitude[1] (deg),attitude[2] (deg),"
+        "velocity[0] (cm/s),velocity[1] (cm/s),velocity[2] (cm/s),"
+        "lift (N),health,impactEnergy (J)\n";
+
+    // 4S pack, for tools that expect a voltage
+    constexpr float EmptyVolts = 13.2f;
+    constexpr float FullVolts = 16.8f;
+}
+
+FDroneBlackboxWriter::FDroneBlackboxWriter() = default;
+
+FDroneBlackboxWriter::~FDroneBlackboxWriter()
+{
+    Close();
+}
+
+bool FDroneBlackboxWriter::Open(const FString& Path)
+{
+    Close();
+
+    IFileManager::Get().MakeDirectory(*FPaths::GetPath(Path), true);
+    File.Reset(IFileManager::Get().CreateFileWriter(*Path, FILEWRITE_AllowRead));
+    if (!File)
+    {
+        UE_LOG(LogTemp, Error, TEXT("DroneBlackbox: could not create %s"), *Path);
+        return false;
+    }
+
+    Chunk.Reset(DroneBlackbox::ChunkBytes + 1024);
+    Chunk.Append(DroneBlackbox::CsvHeader, FCStringAnsi::Strlen(DroneBlackbox::CsvHeader));
+    LoopIteration = 0;
+    NumDropped = 0;
+
+    bStopping = false;
+    WriterThread = FRunnableThread::Create(this, TEXT("DroneBlackboxWriter"), 0, TPri_BelowNormal);
+
+    UE_LOG(LogTemp, Log, TEXT("DroneBlackbox: recording to %s"), *Path);
+    return WriterThread != nullptr;
+}
+
+void FDroneBlackboxWriter::Close()
+{
+    if (WriterThread)
+    {
+        bStopping = true;
+        WriterThread->WaitForCompletion();
+        delete WriterThread;
+        WriterThread = nullptr;
+
+        if (NumDropped > 0)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("DroneBlackbox: %llu samples dropped"), GetNumDropped());
+        }
+    }
+
+    File.Reset();
+}
+
+void FDroneBlackboxWriter::Push(const FDroneBlackboxSample& Sample)
+{
+    if (!Queue.Enqueue(Sample))
+    {
+        NumDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+uint32 FDroneBlackboxWriter::Run()
+{
+    while (!bStopping)
+    {
+        FPlatformProcess::SleepNoStats(DroneBlackbox::PollSeconds);
+        Drain();
+    }
+
+    // Everything pushed before Close
+    Drain();
+    FlushChunk();
+    return 0;
+}
+
+void FDroneBlackboxWriter::Stop()
+{
+    bStopping = true;
+}
+
+void FDroneBlackboxWriter::Drain()
+{
+    FDroneBlackboxSample Sample;
+    while (Queue.Dequeue(Sample))
+    {
+        AppendRow(Sample);
+        if (Chunk.Num() >= DroneBlackbox::ChunkBytes)
+        {
+            FlushChunk();
+        }
+    }
+}
+
+void FDroneBlackboxWriter::AppendRow(const FDroneBlackboxSample& S)
+{
+    using namespace DroneBlackbox;
+
+    // Betaflight units: rcCommand roll/pitch/yaw -500..500, throttle 1000..2000
+    const int32 Throttle = 1000 + FMath::RoundToInt(S.Throttle01 * 1000.f);
+    const float Volts = FMath::Lerp(EmptyVolts, FullVolts, S.Battery01);
+
+    ANSICHAR Row[512];
+    const int32 Length = FCStringAnsi::Snprintf(Row, UE_ARRAY_COUNT(Row),
+        "%u,%llu,%d,%d,%d,%d,%.1f,%.1f,%.1f,%.2f,%.2f,%.2f,%.2f,%.1f,%.1f,%.1f,%.2f,%.1f,%.3f\n",
+        LoopIteration++, S.TimeUs,
+        FMath::RoundToInt(S.Roll * 500.f), FMath::RoundToInt(S.Pitch * 500.f), FMath::RoundToInt(S.Yaw * 500.f), Throttle,
+        S.BodyRates.X, S.BodyRates.Y, S.BodyRates.Z,
+        Volts,
+        S.Attitude.X, S.Attitude.Y, S.Attitude.Z,
+        S.Velocity.X, S.Velocity.Y, S.Velocity.Z,
+        S.Lift, S.Health, S.ImpactEnergy);
+
+    if (Length > 0)
+    {
+        Chunk.Append(Row, FMath::Min(Length, int32(UE_ARRAY_COUNT(Row)) - 1));
+    }
+}
+
+void FDroneBlackboxWriter::FlushChunk()
+{
+    if (Chunk.Num() == 0 || !File)
+        return;
+
+    int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Gzip, Chunk.Num());
+    Compressed.SetNumUninitialized(CompressedSize, EAllowShrinking::No);
+    if (FCompression::CompressMemory(NAME_Gzip, Compressed.GetData(), CompressedSize, Chunk.GetData(), Chunk.Num()))
+    {
+        File->Serialize(Compressed.GetData(), CompressedSize);
+        File->Flush();
+    }
+    else
+    {
+        UE_LOG(LogTemp, Error, TEXT("DroneBlackbox: compression failed, %d bytes lost"), Chunk.Num());
+    }
+
+    Chunk.Reset();
+}
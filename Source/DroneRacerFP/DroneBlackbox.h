@@ -0,0 +1,104 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/CircularQueue.h"
+#include "HAL/Runnable.h"
+#include <atomic>
+
+class FRunnableThread;
+class FArchive;
+
+/**
+ * One physics step of flight data, recorded by ADroneFPCharacter. With
+ * bThreadedFlight the steps run on the flight thread, and one sample covers
+ * the game frame instead.
+ */
+struct FDroneBlackboxSample
+{
+    /** Session time (us) */
+    uint64 TimeUs = 0;
+
+    /** Sticks: throttle 0..1, roll / pitch / yaw -1..1 */
+    float Throttle01 = 0.f;
+    float Roll = 0.f;
+    float Pitch = 0.f;
+    float Yaw = 0.f;
+
+    /** Attitude (deg) */
+    FVector3f Attitude = FVector3f::ZeroVector;
+
+    /** Body rates roll / pitch / yaw (deg/s) */
+    FVector3f BodyRates = FVector3f::ZeroVector;
+
+    /** World velocity (cm/s) */
+    FVector3f Velocity = FVector3f::ZeroVector;
+
+    /** N */
+    float Lift = 0.f;
+
+    float Health = 0.f;
+    float Battery01 = 0.f;
+
+    /** Energy of an impact during this step (J), 0 if none */
+    float ImpactEnergy = 0.f;
+};
+
+/**
+ * Streams blackbox samples to a gzip-compressed CSV file in the layout of
+ * Betaflight's blackbox_decode output (loopIteration, time (us), rcCommand[],
+ * gyroADC[], vbatLatest (V), ...), so PIDtoolbox and other tools that read
+ * decoded logs open it directly. Simulation-only values (attitude, velocity,
+ * lift, health, impacts) follow as extra columns. There are no motor[]
+ * columns: the stick-driven flight model has no per-motor outputs, only the
+ * total lift.
+ *
+ * Push() is called by the game thread and only writes into a fixed-size
+ * lock-free single-producer/single-consumer ring, dropping samples (and
+ * counting them) if the writer ever falls that far behind. The writer thread
+ * polls the ring, formats rows and appends each ~256 KB chunk as its own gzip
+ * member; concatenated members are one valid gzip stream. Memory is bounded
+ * by the ring and one chunk.
+ */
+class DRONERACERFP_API FDroneBlackboxWriter : public FRunnable
+{
+public:
+    /** Ring capacity: 8 s at 1 kHz, over a minute at the default 120 Hz physics step */
+    static constexpr uint32 QueueCapacity = 8192;
+
+    FDroneBlackboxWriter();
+    virtual ~FDroneBlackboxWriter();
+
+    bool Open(const FString& Path);
+
+    /** Flushes everything pushed so far and closes the file */
+    void Close();
+
+    bool IsOpen() const { return WriterThread != nullptr; }
+
+    /** Game thread only */
+    void Push(const FDroneBlackboxSample& Sample);
+
+    uint64 GetNumDropped() const { return NumDropped.load(std::memory_order_relaxed); }
+
+    // FRunnable
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    void Drain();
+    void AppendRow(const FDroneBlackboxSample& Sample);
+    void FlushChunk();
+
+    // Power of two; TCircularQueue keeps one slot free
+    TCircularQueue<FDroneBlackboxSample> Queue { QueueCapacity };
+
+    // Writer thread only
+    TUniquePtr<FArchive> File;
+    TArray<ANSICHAR> Chunk;
+    TArray<uint8> Compressed;
+    uint32 LoopIteration = 0;
+
+    FRunnableThread* WriterThread = nullptr;
+    std::atomic<bool> bStopping { false };
+    std::atomic<uint64> NumDropped { 0 };
+};
@@ -0,0 +1,52 @@
+#include "DroneCollectibleComponent.h"
+#include "DroneCollectibleSubsystem.h"
+
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+void UDroneCollectibleComponent::BeginPlay()
+{
+    Super::BeginPlay();
+
+    if (UDroneCollectibleSubsystem* Collectibles = GetWorld()->GetSubsystem<UDroneCollectibleSubsystem>())
+    {
+        CollectibleId = Collectibles->AddCollectible(GetComponentLocation(), Radius, RespawnSeconds, Type, this);
+    }
+}
+
+void UDroneCollectibleComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (UDroneCollectibleSubsystem* Collectibles = GetWorld()->GetSubsystem<UDroneCollectibleSubsystem>())
+    {
+        Collectibles->RemoveCollectible(CollectibleId);
+    }
+    CollectibleId = INDEX_NONE;
+
+    Super::EndPlay(EndPlayReason);
+}
+
+bool UDroneCollectibleComponent::IsAvailable() const
+{
+    const UDroneCollectibleSubsystem* Collectibles = GetWorld() ? GetWorld()->GetSubsystem<UDroneCollectibleSubsystem>() : nullptr;
+    return Collectibles && Collectibles->IsCollectibleActive(CollectibleId);
+}
+
+void UDroneCollectibleComponent::NotifyPickedUp(ADroneFPCharacter* Drone)
+{
+    if (bHideOwnerWhileCollected && GetOwner())
+    {
+        GetOwner()->SetActorHiddenInGame(true);
+    }
+
+    OnPickUp.Broadcast(Drone);
+}
+
+void UDroneCollectibleComponent::NotifyRespawned()
+{
+    if (bHideOwnerWhileCollected && GetOwner())
+    {
+        GetOwner()->SetActorHiddenInGame(false);
+    }
+
+    OnRespawn.Broadcast();
+}
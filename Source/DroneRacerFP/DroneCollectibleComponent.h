@@ -0,0 +1,62 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+#include "DroneCollectibleComponent.generated.h"
+
+class ADroneFPCharacter;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnDronePickUp, ADroneFPCharacter*, Drone);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnDroneCollectibleRespawn);
+
+/**
+ * A pickup drones collect by flying through it, registered with
+ * UDroneCollectibleSubsystem at BeginPlay. Unlike UTP_PickUpComponent it has
+ * no collision of its own; the subsystem tests drone motion against all
+ * pickups at once.
+ *
+ * OnPickUp is broadcast once per collection. With RespawnSeconds > 0 the
+ * pickup comes back after that long and can be collected again.
+ */
+UCLASS(Blueprintable, BlueprintType, ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class DRONERACERFP_API UDroneCollectibleComponent : public USceneComponent
+{
+    GENERATED_BODY()
+
+public:
+    UPROPERTY(BlueprintAssignable, Category = "Interaction")
+    FOnDronePickUp OnPickUp;
+
+    UPROPERTY(BlueprintAssignable, Category = "Interaction")
+    FOnDroneCollectibleRespawn OnRespawn;
+
+    /** cm */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Collectible", meta = (ClampMin = "1"))
+    float Radius = 32.f;
+
+    /** Seconds until the pickup is back, 0 to collect it once */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Collectible", meta = (ClampMin = "0"))
+    float RespawnSeconds = 0.f;
+
+    /** Passed to UDroneCollectibleSubsystem::OnCollected, e.g. Boost or Battery */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Collectible")
+    FName Type;
+
+    /** Hide the owning actor while collected */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Collectible")
+    bool bHideOwnerWhileCollected = true;
+
+    UFUNCTION(BlueprintPure, Category = "Collectible")
+    bool IsAvailable() const;
+
+    /** Called by the subsystem */
+    void NotifyPickedUp(ADroneFPCharacter* Drone);
+    void NotifyRespawned();
+
+protected:
+    virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+    int32 CollectibleId = INDEX_NONE;
+};
@@ -0,0 +1,214 @@
+#include "DroneCollectibleSubsystem.h"
+#include "DroneCollectibleComponent.h"
+#include "DroneRacerFP.h"
+
+#include "Engine/World.h"
+
+namespace DroneCollectibles
+{
+    constexpr int32 MinBuckets = 64;
+
+    bool RespawnsFirst(const TPair<double, int32>& A, const TPair<double, int32>& B)
+    {
+        return A.Key < B.Key;
+    }
+}
+
+FIntVector UDroneCollectibleSubsystem::CellOf(const FVector& Location)
+{
+    return FIntVector(
+        FMath::FloorToInt32(Location.X / CellSize),
+        FMath::FloorToInt32(Location.Y / CellSize),
+        FMath::FloorToInt32(Location.Z / CellSize));
+}
+
+int32 UDroneCollectibleSubsystem::BucketOf(const FIntVector& Cell) const
+{
+    // Large primes spread neighbouring cells over the table
+    const uint32 Hash = uint32(Cell.X) * 73856093u ^ uint32(Cell.Y) * 19349663u ^ uint32(Cell.Z) * 83492791u;
+    return int32(Hash & uint32(Buckets.Num() - 1));
+}
+
+void UDroneCollectibleSubsystem::LinkToBucket(int32 CollectibleId)
+{
+    const int32 Bucket = BucketOf(Collectibles[CollectibleId].Cell);
+    Collectibles[CollectibleId].Next = Buckets[Bucket];
+    Buckets[Bucket] = CollectibleId;
+}
+
+void UDroneCollectibleSubsystem::Rehash(int32 NumBuckets)
+{
+    Buckets.Init(INDEX_NONE, NumBuckets);
+    for (int32 Id = 0; Id < Collectibles.Num(); ++Id)
+    {
+        if (Collectibles[Id].bUsed)
+        {
+            LinkToBucket(Id);
+        }
+    }
+}
+
+int32 UDroneCollectibleSubsystem::AddCollectible(const FVector& Location, float Radius, float RespawnSeconds, FName Type,
+    UDroneCollectibleComponent* Component)
+{
+    // Reuse a removed slot first
+    int32 Id = FirstFree;
+    if (Id != INDEX_NONE)
+    {
+        FirstFree = Collectibles[Id].Next;
+    }
+    else
+    {
+        Id = Collectibles.AddDefaulted();
+    }
+
+    FCollectible& Collectible = Collectibles[Id];
+    Collectible.Location = Location;
+    Collectible.Cell = CellOf(Location);
+    Collectible.Radius = FMath::Max(Radius, 0.f);
+    Collectible.RespawnSeconds = RespawnSeconds;
+    Collectible.Type = Type;
+    Collectible.Component = Component;
+    Collectible.bUsed = true;
+    Collectible.bActive = true;
+
+    MaxRadius = FMath::Max(MaxRadius, Collectible.Radius);
+    ++NumCollectibles;
+
+    // Keep chains about one pickup long
+    if (NumCollectibles > Buckets.Num())
+    {
+        Rehash(FMath::Max(int32(FMath::RoundUpToPowerOfTwo(NumCollectibles * 2)), DroneCollectibles::MinBuckets));
+    }
+    else
+    {
+        LinkToBucket(Id);
+    }
+
+    return Id;
+}
+
+void UDroneCollectibleSubsystem::RemoveCollectible(int32 CollectibleId)
+{
+    if (!Collectibles.IsValidIndex(CollectibleId) || !Collectibles[CollectibleId].bUsed)
+        return;
+
+    // Unlink from its bucket
+    int32* Link = &Buckets[BucketOf(Collectibles[CollectibleId].Cell)];
+    while (*Link != CollectibleId)
+    {
+        Link = &Collectibles[*Link].Next;
+    }
+    *Link = Collectibles[CollectibleId].Next;
+
+    // A pending respawn is skipped once the slot is reused, see Tick
+    Collectibles[CollectibleId] = FCollectible();
+    Collectibles[CollectibleId].Next = FirstFree;
+    FirstFree = CollectibleId;
+    --NumCollectibles;
+}
+
+bool UDroneCollectibleSubsystem::IsCollectibleActive(int32 CollectibleId) const
+{
+    return Collectibles.IsValidIndex(CollectibleId) && Collectibles[CollectibleId].bActive;
+}
+
+void UDroneCollectibleSubsystem::SweepDrone(ADroneFPCharacter* Drone, const FVector& Start, const FVector& End, float DroneRadius)
+{
+    if (NumCollectibles == 0)
+        return;
+
+    DRONERACER_SCOPED_STAT(CollectibleSweep);
+
+    // Cells any pickup touching the swept sphere can be centered in
+    const FVector Padding(DroneRadius + MaxRadius);
+    const FIntVector MinCell = CellOf(Start.ComponentMin(End) - Padding);
+    const FIntVector MaxCell = CellOf(Start.ComponentMax(End) + Padding);
+
+    // Collected after the walk, handlers may add or remove pickups
+    TArray<int32, TInlineAllocator<8>> Hits;
+    for (int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z)
+    {
+        for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+        {
+            for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+            {
+                const FIntVector Cell(X, Y, Z);
+                for (int32 Id = Buckets[BucketOf(Cell)]; Id != INDEX_NONE; Id = Collectibles[Id].Next)
+                {
+                    const FCollectible& Collectible = Collectibles[Id];
+                    if (!Collectible.bActive || Collectible.Cell != Cell)
+                        continue;
+
+                    const float Reach = Collectible.Radius + DroneRadius;
+                    if (FMath::PointDistToSegmentSquared(Collectible.Location, Start, End) <= Reach * Reach)
+                    {
+                        Hits.Add(Id);
+                    }
+                }
+            }
+        }
+    }
+
+    for (const int32 Id : Hits)
+    {
+        Collect(Id, Drone);
+    }
+}
+
+void UDroneCollectibleSubsystem::Collect(int32 CollectibleId, ADroneFPCharacter* Drone)
+{
+    // An earlier handler in this sweep may have removed it
+    if (!IsCollectibleActive(CollectibleId))
+        return;
+
+    DRONERACER_COUNT_EVENT(Pickups);
+
+    FCollectible& Collectible = Collectibles[CollectibleId];
+    Collectible.bActive = false;
+    if (Collectible.RespawnSeconds > 0.f)
+    {
+        Collectible.RespawnTime = GetWorld()->GetTimeSeconds() + Collectible.RespawnSeconds;
+        Respawns.HeapPush(TPair<double, int32>(Collectible.RespawnTime, CollectibleId), DroneCollectibles::RespawnsFirst);
+    }
+
+    const FName Type = Collectible.Type;
+    UDroneCollectibleComponent* Component = Collectible.Component.Get();
+
+    OnCollected.Broadcast(CollectibleId, Type, Drone);
+    if (Component)
+    {
+        Component->NotifyPickedUp(Drone);
+    }
+}
+
+void UDroneCollectibleSubsystem::Tick(float DeltaTime)
+{
+    const double Now = GetWorld()->GetTimeSeconds();
+    while (Respawns.Num() > 0 && Respawns.HeapTop().Key <= Now)
+    {
+        TPair<double, int32> Due;
+        Respawns.HeapPop(Due, DroneCollectibles::RespawnsFirst, EAllowShrinking::No);
+
+        // Skip slots removed (and maybe reused) since they were collected
+        FCollectible& Collectible = Collectibles[Due.Value];
+        if (!Collectible.bUsed || Collectible.bActive || Collectible.RespawnTime != Due.Key)
+            continue;
+
+        Collectible.bActive = true;
+
+        const FName Type = Collectible.Type;
+        UDroneCollectibleComponent* Component = Collectible.Component.Get();
+
+        OnRespawned.Broadcast(Due.Value, Type);
+        if (Component)
+        {
+            Component->NotifyRespawned();
+        }
+    }
+}
+
+TStatId UDroneCollectibleSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UDroneCollectibleSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DroneCollectibleSubsystem.generated.h"
+
+class ADroneFPCharacter;
+class UDroneCollectibleComponent;
+
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnDroneCollected, int32 /*CollectibleId*/, FName /*Type*/, ADroneFPCharacter* /*Drone*/);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnDroneCollectibleRespawned, int32 /*CollectibleId*/, FName /*Type*/);
+
+/**
+ * Pickups on a course (boosts, batteries, ...), stored in a uniform spatial
+ * hash instead of one overlap volume each.
+ *
+ * Drones test the segment they moved along in a physics step against the
+ * cells it touches, so the cost of a step depends on how many pickups are
+ * near the drone, not on how many the course has. Collected pickups stay in
+ * their slot and are reactivated in place after RespawnSeconds; removed
+ * slots are reused by the next pickup added.
+ *
+ * Pickups are added in bulk by code, or one at a time by
+ * UDroneCollectibleComponent, which keeps UTP_PickUpComponent's OnPickUp
+ * semantics.
+ */
+UCLASS()
+class DRONERACERFP_API UDroneCollectibleSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    /** Hash cell size (cm), a few times the usual pickup radius */
+    static constexpr float CellSize = 400.f;
+
+    /**
+     * Adds a pickup; RespawnSeconds <= 0 means it is collected once.
+     * Returns its id, valid until it is removed.
+     */
+    int32 AddCollectible(const FVector& Location, float Radius, float RespawnSeconds, FName Type,
+        UDroneCollectibleComponent* Component = nullptr);
+
+    void RemoveCollectible(int32 CollectibleId);
+
+    bool IsCollectibleActive(int32 CollectibleId) const;
+
+    int32 GetNumCollectibles() const { return NumCollectibles; }
+
+    /** Collects every active pickup within DroneRadius of the segment Start -> End */
+    void SweepDrone(ADroneFPCharacter* Drone, const FVector& Start, const FVector& End, float DroneRadius);
+
+    /** Broadcast for every pickup collected, before the pickup's component is notified */
+    FOnDroneCollected OnCollected;
+
+    FOnDroneCollectibleRespawned OnRespawned;
+
+    // UTickableWorldSubsystem
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+private:
+    struct FCollectible
+    {
+        FVector Location = FVector::ZeroVector;
+        FIntVector Cell = FIntVector::ZeroValue;
+        float Radius = 0.f;
+        float RespawnSeconds = 0.f;
+        double RespawnTime = 0.0;
+        FName Type;
+        TWeakObjectPtr<UDroneCollectibleComponent> Component;
+
+        /** Next slot in the same bucket, or the next free slot */
+        int32 Next = INDEX_NONE;
+
+        bool bUsed = false;
+        bool bActive = false;
+    };
+
+    static FIntVector CellOf(const FVector& Location);
+    int32 BucketOf(const FIntVector& Cell) const;
+    void LinkToBucket(int32 CollectibleId);
+    void Rehash(int32 NumBuckets);
+    void Collect(int32 CollectibleId, ADroneFPCharacter* Drone);
+
+    TArray<FCollectible> Collectibles;
+
+    /** First slot per bucket; a power of two, at least one bucket per pickup */
+    TArray<int32> Buckets;
+
+    int32 FirstFree = INDEX_NONE;
+    int32 NumCollectibles = 0;
+
+    /** Largest pickup radius, pads the cells a sweep visits */
+    float MaxRadius = 0.f;
+
+    /** Min-heap of (respawn time, id) */
+    TArray<TPair<double, int32>> Respawns;
+};
@@ -0,0 +1,242 @@
+#include "DroneContactSubsystem.h"
+#include "DroneFPCharacter.h"
+#include "DroneRacerFP.h"
+
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<bool> CVarDroneContacts(
+    TEXT("DroneRacer.DroneContacts"),
+    true,
+    TEXT("Resolve drone-to-drone collisions in one grid pass per frame (0: through the capsule sweep); applies to drones spawned afterwards"));
+
+namespace DroneContacts
+{
+    /** Neighbour cells after a cell in (X, Y, Z) order; with the cell itself they cover every pair once */
+    const FIntVector ForwardNeighbours[13] =
+    {
+        FIntVector(1, 0, 0),
+        FIntVector(-1, 1, 0), FIntVector(0, 1, 0), FIntVector(1, 1, 0),
+        FIntVector(-1, -1, 1), FIntVector(0, -1, 1), FIntVector(1, -1, 1),
+        FIntVector(-1, 0, 1), FIntVector(0, 0, 1), FIntVector(1, 0, 1),
+        FIntVector(-1, 1, 1), FIntVector(0, 1, 1), FIntVector(1, 1, 1),
+    };
+
+    /** Gap (cm) drones are pushed apart to, so resting drones don't touch again every frame */
+    constexpr float ContactSkin = 0.1f;
+
+    bool CellLess(const FIntVector& A, const FIntVector& B)
+    {
+        if (A.Z != B.Z) return A.Z < B.Z;
+        if (A.Y != B.Y) return A.Y < B.Y;
+        return A.X < B.X;
+    }
+}
+
+bool UDroneContactSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UDroneContactSubsystem::Deinitialize()
+{
+    Bodies.Empty();
+    Sweeps.Empty();
+    SortedSweeps.Empty();
+    CellStarts.Empty();
+
+    Super::Deinitialize();
+}
+
+int32 UDroneContactSubsystem::Register(ADroneFPCharacter* Drone)
+{
+    if (!Drone || !CVarDroneContacts.GetValueOnGameThread())
+        return INDEX_NONE;
+
+    // Drones only block each other here from now on
+    Drone->GetCapsuleComponent()->SetCollisionResponseToChannel(ECC_Pawn, ECR_Ignore);
+
+    FBody Body;
+    Body.Drone = Drone;
+    Body.Start = Drone->GetActorLocation();
+    return Bodies.Add(MoveTemp(Body));
+}
+
+void UDroneContactSubsystem::Unregister(int32 Handle)
+{
+    if (Bodies.IsValidIndex(Handle))
+    {
+        Bodies.RemoveAt(Handle);
+    }
+}
+
+void UDroneContactSubsystem::Tick(float DeltaTime)
+{
+    if (Bodies.Num() < 2)
+    {
+        for (FBody& Body : Bodies)
+        {
+            if (const ADroneFPCharacter* Drone = Body.Drone.Get())
+                Body.Start = Drone->GetActorLocation();
+        }
+        return;
+    }
+
+    DRONERACER_SCOPED_STAT(DroneContacts);
+
+    GatherSweeps();
+    BuildGrid();
+    FindContacts();
+
+    // The next pass sweeps from where this one left every drone
+    for (const FSweep& Sweep : Sweeps)
+    {
+        Bodies[Sweep.Handle].Start = Sweep.Drone->GetActorLocation();
+    }
+}
+
+void UDroneContactSubsystem::GatherSweeps()
+{
+    Sweeps.Reset();
+
+    float MaxRadius = 0.f;
+    float MaxDistance = 0.f;
+    for (auto It = Bodies.CreateIterator(); It; ++It)
+    {
+        ADroneFPCharacter* Drone = It->Drone.Get();
+        if (!Drone)
+            continue;
+
+        FSweep& Sweep = Sweeps.AddDefaulted_GetRef();
+        Sweep.Drone = Drone;
+        Sweep.Handle = It.GetIndex();
+        Sweep.End = Drone->GetActorLocation();
+        Sweep.Start = FVector::DistSquared(It->Start, Sweep.End) <= FMath::Square(MaxSweepDistance) ? It->Start : Sweep.End;
+        Sweep.Velocity = Drone->GetVelocity();
+        Sweep.Radius = Drone->GetCapsuleComponent()->GetScaledCapsuleRadius();
+        Sweep.Mass = Drone->GetMass();
+
+        MaxRadius = FMath::Max(MaxRadius, Sweep.Radius);
+        MaxDistance = FMath::Max(MaxDistance, float(FVector::Dist(Sweep.Start, Sweep.End)));
+    }
+
+    // Drones that touch during the frame have the middles of their motion at most this far apart
+    CellSize = FMath::Max(MinCellSize, 2.f * MaxRadius + MaxDistance);
+
+    for (FSweep& Sweep : Sweeps)
+    {
+        const FVector Middle = (Sweep.Start + Sweep.End) * 0.5 / CellSize;
+        Sweep.Cell = FIntVector(FMath::FloorToInt32(Middle.X), FMath::FloorToInt32(Middle.Y), FMath::FloorToInt32(Middle.Z));
+    }
+}
+
+void UDroneContactSubsystem::BuildGrid()
+{
+    SortedSweeps.Reset();
+    for (int32 Index = 0; Index < Sweeps.Num(); ++Index)
+    {
+        SortedSweeps.Add(Index);
+    }
+
+    SortedSweeps.Sort([this](int32 A, int32 B) { return DroneContacts::CellLess(Sweeps[A].Cell, Sweeps[B].Cell); });
+
+    CellStarts.Reset();
+    for (int32 Sorted = 0; Sorted < SortedSweeps.Num(); ++Sorted)
+    {
+        const FIntVector& Cell = Sweeps[SortedSweeps[Sorted]].Cell;
+        if (Sorted == 0 || Sweeps[SortedSweeps[Sorted - 1]].Cell != Cell)
+        {
+            CellStarts.Add(Cell, Sorted);
+        }
+    }
+}
+
+void UDroneContactSubsystem::FindContacts()
+{
+    const int32 NumSorted = SortedSweeps.Num();
+    for (int32 Sorted = 0; Sorted < NumSorted; ++Sorted)
+    {
+        FSweep& A = Sweeps[SortedSweeps[Sorted]];
+
+        // The rest of its own cell
+        for (int32 Other = Sorted + 1; Other < NumSorted && Sweeps[SortedSweeps[Other]].Cell == A.Cell; ++Other)
+        {
+            TestPair(A, Sweeps[SortedSweeps[Other]]);
+        }
+
+        for (const FIntVector& Offset : DroneContacts::ForwardNeighbours)
+        {
+            const FIntVector Cell = A.Cell + Offset;
+            const int32* CellStart = CellStarts.Find(Cell);
+            if (!CellStart)
+                continue;
+
+            for (int32 Other = *CellStart; Other < NumSorted && Sweeps[SortedSweeps[Other]].Cell == Cell; ++Other)
+            {
+                TestPair(A, Sweeps[SortedSweeps[Other]]);
+            }
+        }
+    }
+}
+
+void UDroneContactSubsystem::TestPair(FSweep& A, FSweep& B)
+{
+    // Relative motion of A seen from B, over the frame (T 0..1)
+    const float Radius = A.Radius + B.Radius;
+    const FVector P = A.Start - B.Start;
+    const FVector V = (A.End - A.Start) - (B.End - B.Start);
+
+    double T = 0.0;
+    const double C = P.SizeSquared() - FMath::Square(Radius);
+    if (C > 0.0)
+    {
+        // |P + T V| = Radius, first root; none when separating or missing
+        const double HalfB = FVector::DotProduct(P, V);
+        const double A2 = V.SizeSquared();
+        if (HalfB >= 0.0 || A2 <= UE_SMALL_NUMBER)
+            return;
+
+        const double Discriminant = HalfB * HalfB - A2 * C;
+        if (Discriminant < 0.0)
+            return;
+
+        T = (-HalfB - FMath::Sqrt(Discriminant)) / A2;
+        if (T > 1.0)
+            return;
+    }
+
+    DRONERACER_COUNT_EVENT(DroneContactPairs);
+
+    FVector ContactA = FMath::Lerp(A.Start, A.End, T);
+    FVector ContactB = FMath::Lerp(B.Start, B.End, T);
+    const FVector Normal = (ContactA - ContactB).GetSafeNormal(UE_SMALL_NUMBER, FVector::UpVector);
+
+    // Both move by the other's share of the mass, so the heavier drone is pushed less
+    const float TotalMass = FMath::Max(A.Mass + B.Mass, UE_SMALL_NUMBER);
+    const float ShareA = B.Mass / TotalMass;
+    const float ShareB = A.Mass / TotalMass;
+
+    // Just clear of each other; further if they started out overlapping (spawned together, teleported into each other)
+    const float Overlap = Radius + DroneContacts::ContactSkin - float(FVector::Dist(ContactA, ContactB));
+    if (Overlap > 0.f)
+    {
+        ContactA += Normal * (Overlap * ShareA);
+        ContactB -= Normal * (Overlap * ShareB);
+    }
+
+    // Inelastic along the normal, like a world impact: the closing speed is removed, momentum is kept
+    const float Closing = FMath::Max(float(FVector::DotProduct(B.Velocity - A.Velocity, Normal)), 0.f);
+    A.Velocity += Normal * (Closing * ShareA);
+    B.Velocity -= Normal * (Closing * ShareB);
+    A.End = ContactA;
+    B.End = ContactB;
+
+    A.Drone->ApplyDroneContact(ContactA, A.Velocity, Closing * ShareA);
+    B.Drone->ApplyDroneContact(ContactB, B.Velocity, Closing * ShareB);
+}
+
+TStatId UDroneContactSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UDroneContactSubsystem, STATGROUP_Tickables);
+}
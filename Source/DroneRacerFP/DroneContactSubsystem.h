@@ -0,0 +1,94 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/SparseArray.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DroneContactSubsystem.generated.h"
+
+class ADroneFPCharacter;
+
+/**
+ * Drone-to-drone collisions, in one pass over all drones instead of through
+ * every drone's capsule sweep.
+ *
+ * Registered drones stop blocking each other in the engine sweep
+ * (AddActorWorldOffset only stops them at the world). Once per frame, after
+ * every drone has run its physics steps, each drone's motion over the frame
+ * is a swept sphere from where the last pass left it to where it is now:
+ *   - drones are binned into a uniform grid by the middle of their motion,
+ *     cells sized so two drones can only touch if they are in the same or
+ *     neighbouring cells;
+ *   - each pair in a cell and its 13 forward neighbours is tested once with
+ *     a continuous sphere-sphere sweep, so fast drones can't pass through
+ *     each other between frames;
+ *   - a contact puts both drones back where they touched and removes their
+ *     closing speed in proportion to their masses. Each drone takes the
+ *     impact damage of its own speed change, through the same energy model
+ *     as a world impact (ADroneFPCharacter::ApplyDroneContact).
+ *
+ * The cost is linear in the number of drones plus the number of close pairs.
+ * DroneRacer.DroneContacts 0 goes back to the engine sweep for drones
+ * spawned afterwards.
+ */
+UCLASS()
+class DRONERACERFP_API UDroneContactSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    /** Smallest grid cell (cm), keeps the grid from getting finer than useful for slow drones */
+    static constexpr float MinCellSize = 100.f;
+
+    /** Longer moves in one frame are teleports (rewinds, respawns) and aren't swept */
+    static constexpr float MaxSweepDistance = 1500.f;
+
+    /** Returns a handle for Unregister, INDEX_NONE when drone contacts are off */
+    int32 Register(ADroneFPCharacter* Drone);
+    void Unregister(int32 Handle);
+
+    // UWorldSubsystem
+    virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+    virtual void Deinitialize() override;
+
+    // UTickableWorldSubsystem
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+private:
+    struct FBody
+    {
+        TWeakObjectPtr<ADroneFPCharacter> Drone;
+
+        /** Where the last pass left the drone */
+        FVector Start = FVector::ZeroVector;
+    };
+
+    /** A registered drone's motion this frame */
+    struct FSweep
+    {
+        ADroneFPCharacter* Drone;
+        int32 Handle;
+        FVector Start;
+        FVector End;
+        FVector Velocity;
+        float Radius;
+        float Mass;
+        FIntVector Cell;
+    };
+
+    void GatherSweeps();
+    void BuildGrid();
+    void FindContacts();
+    void TestPair(FSweep& A, FSweep& B);
+
+    TSparseArray<FBody> Bodies;
+
+    // Rebuilt every pass, memory kept between frames
+    TArray<FSweep> Sweeps;
+
+    /** Sweeps sorted by cell, and the first index into SortedSweeps of every occupied cell */
+    TArray<int32> SortedSweeps;
+    TMap<FIntVector, int32> CellStarts;
+
+    float CellSize = MinCellSize;
+};
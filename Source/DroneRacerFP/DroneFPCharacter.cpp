@@ -1,14 +1,31 @@
 ﻿#include "DroneFPCharacter.h"
+#include "DroneRacerFP.h"
+#include "DroneFlightModel.h"
+#include "DroneFlightThreadSubsystem.h"
+#include "DroneStreamingSourceComponent.h"
+#include "DroneMotorSynthComponent.h"
+#include "DroneTrajectoryComponent.h"
+#include "DroneWindSubsystem.h"
+#include "DroneCollectibleSubsystem.h"
+#include "DroneContactSubsystem.h"
+#include "DroneHitHistorySubsystem.h"
+#include "DronePreloadSubsystem.h"
+#include "DroneSignificanceSubsystem.h"
+#include "RaceGateManager.h"
 
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/InputComponent.h"
+#include "Components/StaticMeshComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/PlayerController.h"
 #include "PhysicalMaterials/PhysicalMaterial.h"
 #include "EnhancedInputComponent.h"
 #include "EnhancedInputSubsystems.h"
 #include "Engine/LocalPlayer.h"
+#include "EngineUtils.h"
+#include "Misc/Guid.h"
+#include "Misc/Paths.h"
 
 ADroneFPCharacter::ADroneFPCharacter()
 {
@@ -20,6 +37,26 @@ ADroneFPCharacter::ADroneFPCharacter()
     FirstPersonCamera->SetRelativeLocation(FVector(0.f, 0.f, 64.f));
     FirstPersonCamera->bUsePawnControlRotation = false; // we rotate the whole actor
 
+    // Streams world cells along the projected flight path and the upcoming gates
+    StreamingSource = CreateDefaultSubobject<UDroneStreamingSourceComponent>(TEXT("StreamingSource"));
+
+    // Procedural motor sound from the throttle and body rates
+    MotorSynth = CreateDefaultSubobject<UDroneMotorSynthComponent>(TEXT("MotorSynth"));
+    MotorSynth->SetupAttachment(GetCapsuleComponent());
+
+    Trajectory = CreateDefaultSubobject<UDroneTrajectoryComponent>(TEXT("Trajectory"));
+
+    // Next-gate highlight: lives in world space and only this drone's viewport renders it
+    GateHighlight = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("GateHighlight"));
+    GateHighlight->SetupAttachment(GetCapsuleComponent());
+    GateHighlight->SetUsingAbsoluteLocation(true);
+    GateHighlight->SetUsingAbsoluteRotation(true);
+    GateHighlight->SetUsingAbsoluteScale(true);
+    GateHighlight->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+    GateHighlight->SetCastShadow(false);
+    GateHighlight->SetOnlyOwnerSee(true);
+    GateHighlight->SetVisibility(false);
+
 
     //get the arms mesh
     Mesh1P = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("CharacterMesh1P"));
@@ -51,7 +88,84 @@ void ADroneFPCharacter::BeginPlay()
 {
     Super::BeginPlay();
 
+    INC_DWORD_STAT(STAT_DroneRacer_NumDrones);
+
     Health = MaxHealth;
+    Battery01 = 1.f;
+    StateTime = GetWorld()->GetTimeSeconds();
+
+    History.Init(FMath::CeilToInt(RewindHistorySeconds / PhysicsStepSeconds));
+
+    WindSubsystem = GetWorld()->GetSubsystem<UDroneWindSubsystem>();
+    CollectibleSubsystem = GetWorld()->GetSubsystem<UDroneCollectibleSubsystem>();
+
+    // Shots at this drone are resolved against its recent positions on the server
+    UDroneHitHistorySubsystem* HitHistory = GetWorld()->GetSubsystem<UDroneHitHistorySubsystem>();
+    if (HitHistory && HasAuthority())
+    {
+        HitHistorySlot = HitHistory->RegisterDrone(this);
+    }
+
+    if (UDroneSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UDroneSignificanceSubsystem>())
+    {
+        SignificanceHandle = Significance->Register(this, EDroneSignificanceKind::Drone);
+    }
+
+    // Other drones are collided with there instead of in the capsule sweep
+    if (UDroneContactSubsystem* Contacts = GetWorld()->GetSubsystem<UDroneContactSubsystem>())
+    {
+        ContactHandle = Contacts->Register(this);
+    }
+
+    if (bSITLFlightController)
+    {
+        FlightChannel = MakeShared<FDroneFlightChannel, ESPMode::ThreadSafe>();
+        SITLBridge = MakeUnique<FDroneSITLBridge>(FlightChannel.ToSharedRef(), SITL);
+        if (SITLBridge->IsRunning())
+        {
+            SendFlightState();
+        }
+        else
+        {
+            SITLBridge.Reset();
+            FlightChannel.Reset();
+        }
+    }
+
+    UDroneFlightThreadSubsystem* FlightThread = GetWorld()->GetSubsystem<UDroneFlightThreadSubsystem>();
+    if (bThreadedFlight && !FlightChannel && FlightThread)
+    {
+        FlightChannel = FlightThread->AddDrone();
+        SendFlightState();
+    }
+
+    if (bRecordBlackbox)
+    {
+        const FString Path = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Blackbox"),
+            FString::Printf(TEXT("%s_%s.csv.gz"), *GetName(), *FDateTime::Now().ToString()));
+
+        Blackbox = MakeUnique<FDroneBlackboxWriter>();
+        if (!Blackbox->Open(Path))
+        {
+            Blackbox.Reset();
+        }
+    }
+
+    // Find RaceGateManager in the level
+    if (!RaceGateManager)
+    {
+        for (TActorIterator<ARaceGateManager> It(GetWorld()); It; ++It)
+        {
+            RaceGateManager = *It;
+            break;
+        }
+    }
+
+    if (RaceGateManager)
+    {
+        RacerIndex = RaceGateManager->RegisterRacer(this);
+    }
+
     if (Mesh1P)
     {
         Mesh1P->SetHiddenInGame(true);
@@ -84,6 +198,63 @@ void ADroneFPCharacter::BeginPlay()
         }
     }
 }
+void ADroneFPCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    DEC_DWORD_STAT(STAT_DroneRacer_NumDrones);
+
+    if (RaceGateManager)
+    {
+        RaceGateManager->UnregisterRacer(RacerIndex);
+        RacerIndex = INDEX_NONE;
+    }
+
+    if (UDroneHitHistorySubsystem* HitHistory = GetWorld()->GetSubsystem<UDroneHitHistorySubsystem>())
+    {
+        HitHistory->UnregisterDrone(HitHistorySlot);
+        HitHistorySlot = INDEX_NONE;
+    }
+
+    if (UDroneSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UDroneSignificanceSubsystem>())
+    {
+        Significance->Unregister(SignificanceHandle);
+        SignificanceHandle = INDEX_NONE;
+    }
+
+    if (UDroneContactSubsystem* Contacts = GetWorld()->GetSubsystem<UDroneContactSubsystem>())
+    {
+        Contacts->Unregister(ContactHandle);
+        ContactHandle = INDEX_NONE;
+    }
+
+    // Joins the I/O thread before the channel goes
+    SITLBridge.Reset();
+
+    if (FlightChannel)
+    {
+        if (UDroneFlightThreadSubsystem* FlightThread = GetWorld()->GetSubsystem<UDroneFlightThreadSubsystem>())
+        {
+            FlightThread->RemoveDrone(FlightChannel.ToSharedRef());
+        }
+        FlightChannel.Reset();
+    }
+
+    // Flushes the rest of the log on the writer thread
+    Blackbox.Reset();
+
+    Super::EndPlay(EndPlayReason);
+}
+
+void ADroneFPCharacter::NotifyControllerChanged()
+{
+    Super::NotifyControllerChanged();
+
+    // Possessed (or unpossessed) after registering with the race: the highlight follows who looks through the drone
+    if (RaceGateManager)
+    {
+        RaceGateManager->RefreshHighlight(RacerIndex);
+    }
+}
+
 void ADroneFPCharacter::ApplyMappingContext()
 {
     APlayerController* PC = Cast<APlayerController>(Controller);
@@ -147,6 +318,12 @@ void ADroneFPCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCo
                 this, &ADroneFPCharacter::Roll);
         }
 
+        if (IA_Rewind)
+        {
+            EIC->BindAction(IA_Rewind, ETriggerEvent::Started,
+                this, &ADroneFPCharacter::Rewind);
+        }
+
     }
     else
     {
@@ -156,62 +333,318 @@ void ADroneFPCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCo
 
 void ADroneFPCharacter::Tick(float DeltaTime)
 {
+    DRONERACER_SCOPED_STAT(DroneTick);
+
     Super::Tick(DeltaTime);
 
-    if (!bThrottleArmed)return;
+    if (bInterpolateMesh)
+    {
+        PrevTickTransform = GetActorTransform();
+        LastTickTime = GetWorld()->GetTimeSeconds();
+    }
+
+    // Placed by the network, flown on the machine that owns it
+    if (IsNetDriven())
+    {
+        PublishTelemetry();
+        return;
+    }
 
-    if (DeltaTime <= 0.f)return;
+    if (FlightChannel)
+    {
+        // The flight thread's state arrives once per frame
+        StateTime = GetWorld()->GetTimeSeconds();
+        TickThreadedFlight(DeltaTime);
+        PublishTelemetry();
+        ReportNetState(DeltaTime);
+        return;
+    }
 
+    // A lower tick rate (see SetSignificanceTickInterval) needs more steps per tick for the same time
+    const int32 MaxSteps = FMath::Max(MaxPhysicsStepsPerFrame, FMath::CeilToInt32(GetActorTickInterval() / PhysicsStepSeconds) + 1);
 
-    // ===== 1) Update orientation from yaw/pitch/roll inputs (DJI Mode 2) =====
+    // Fixed steps keep the flight model (and the rewind history) independent of frame rate
+    StepAccumulator += DeltaTime;
+    int32 NumSteps = 0;
+    while (StepAccumulator >= PhysicsStepSeconds && !bCrashRespawnPending)
+    {
+        if (NumSteps++ == MaxSteps)
+        {
+            StepAccumulator = 0.f;
+            break;
+        }
+
+        // StepAccumulator - PhysicsStepSeconds of the frame is left after this step
+        StateTime = GetWorld()->GetTimeSeconds() - (StepAccumulator - PhysicsStepSeconds);
+
+        if (bThrottleArmed)
+        {
+            UpdateFlight(PhysicsStepSeconds);
+        }
+        else
+        {
+            // Keeps the replay's step count equal to the time the lap took
+            Replay.AddStep(FDroneFlightInput(), FVector::ZeroVector, false);
+        }
+        RecordState();
+        StepAccumulator -= PhysicsStepSeconds;
+    }
+
+    if (bCrashRespawnPending)
+    {
+        bCrashRespawnPending = false;
+        RewindSeconds(CrashRespawnSeconds);
+    }
+
+    // Publish even when disarmed so the OSD always shows the current state
+    PublishTelemetry();
+    ReportNetState(DeltaTime);
+}
+
+void ADroneFPCharacter::TickThreadedFlight(float DeltaTime)
+{
+    if (PendingFlightState && FlightChannel->Send(*PendingFlightState))
+    {
+        PendingFlightState.Reset();
+    }
+
+    // Sticks and the air at the drone, used by every flight thread step until the next frame
+    FDroneFlightCommand Command;
+    Command.Input = GetFlightInput();
+    Command.bArmed = bThrottleArmed;
+    Command.Wind = WindSubsystem ? WindSubsystem->SampleWind(GetActorLocation()) : FVector::ZeroVector;
+    FlightChannel->Send(Command);
+
+    if (SITLBridge)
+    {
+        SITLBridge->AllowUntilNowPlusLead();
+    }
+
+    FDroneFlightOutput Output;
+    if (FlightChannel->ReceiveLatest(Output) && Output.Version == FlightStateVersion && bThrottleArmed)
+    {
+        if (Output.bHasMotors)
+        {
+            // Betaflight's rear right, front right, rear left, front left to the synth's front right, rear left, front left, rear right
+            const float RPMs[4] =
+            {
+                Output.Motors01[1] * MotorSynth->MaxRPM,
+                Output.Motors01[2] * MotorSynth->MaxRPM,
+                Output.Motors01[3] * MotorSynth->MaxRPM,
+                Output.Motors01[0] * MotorSynth->MaxRPM,
+            };
+            MotorSynth->SetMotorRPMs(RPMs);
+        }
+
+        SetActorRotation(Output.State.Rotation);
+        Velocity = Output.State.Velocity;
+        Battery01 = Output.State.Battery01;
+
+        const FVector StartLocation = GetActorLocation();
+        FHitResult Hit;
+        {
+            DRONERACER_SCOPED_STAT(Sweep);
+            SetActorLocation(Output.State.Location, true, &Hit);
+        }
+
+        if (RaceGateManager)
+        {
+            // The move covers the frame: moving gates are tested where they were at its start and end
+            RaceGateManager->DroneMoved(this, StartLocation, GetActorLocation(), StateTime - DeltaTime, StateTime);
+        }
+
+        if (CollectibleSubsystem)
+        {
+            CollectibleSubsystem->SweepDrone(this, StartLocation, GetActorLocation(), GetCapsuleComponent()->GetScaledCapsuleRadius());
+        }
+
+        if (WindSubsystem)
+        {
+            WindSubsystem->AddPropWash(GetActorLocation(), -GetActorUpVector(), GetMotorThrottle01(), DeltaTime);
+        }
+
+        if (Hit.IsValidBlockingHit())
+        {
+            // Same slide as UpdateFlight; the flight thread continues from where the world stopped us
+            const FVector Normal = Hit.Normal.GetSafeNormal();
+            const float Vn = FVector::DotProduct(Velocity, Normal);
+            if (Vn < 0.f)
+            {
+                Velocity -= Normal * Vn;
+            }
+
+            HandleImpactDamage(Hit);
+            SendFlightState();
+        }
+
+        if (Blackbox)
+        {
+            RecordBlackbox(Command.Input, FDroneFlightModel::GetLift(GetFlightParams(), Command.Input.Throttle01, Battery01), DeltaTime);
+        }
+    }
+
+    if (bReplayLapEnded)
+    {
+        FinishLapReplay();
+    }
+
+    // Rewind history keeps one sample per PhysicsStepSeconds, so rewinding works the same in both modes
+    StepAccumulator += DeltaTime;
+    for (int32 NumSamples = 0; StepAccumulator >= PhysicsStepSeconds; ++NumSamples)
+    {
+        if (NumSamples == MaxPhysicsStepsPerFrame)
+        {
+            StepAccumulator = 0.f;
+            break;
+        }
+
+        RecordState();
+        StepAccumulator -= PhysicsStepSeconds;
+    }
+
+    if (bCrashRespawnPending)
+    {
+        bCrashRespawnPending = false;
+        RewindSeconds(CrashRespawnSeconds);
+    }
+}
+
+void ADroneFPCharacter::SendFlightState()
+{
+    if (!FlightChannel)
+        return;
+
+    FDroneFlightCommand Command;
+    Command.Type = FDroneFlightCommand::EType::SetState;
+    Command.Version = ++FlightStateVersion;
+    Command.State = GetFlightState();
+    Command.Params = GetFlightParams();
+
+    // Losing it would leave the flight thread on a state every later result is ignored for
+    PendingFlightState = Command;
+    if (FlightChannel->Send(Command))
+    {
+        PendingFlightState.Reset();
+    }
+}
+
+void ADroneFPCharacter::SetSignificanceTickInterval(float Seconds)
+{
+    SetActorTickInterval(Seconds);
 
-    const float dPitch = PitchInput * PitchRateDeg * DeltaTime; // nose up/down
-    const float dYaw = YawInput * YawRateDeg * DeltaTime; // rotate about vertical
-    const float dRoll = RollInput * RollRateDeg * DeltaTime; // bank about longitudinal
+    const bool bInterpolate = Seconds > 0.f && GetMesh();
+    if (bInterpolate == bInterpolateMesh)
+        return;
 
-    const FRotator DeltaRot(dPitch, dYaw, dRoll);
-    AddActorLocalRotation(DeltaRot);
+    bInterpolateMesh = bInterpolate;
+    if (bInterpolateMesh)
+    {
+        PrevTickTransform = GetActorTransform();
+        LastTickTime = GetWorld()->GetTimeSeconds();
+    }
+    else if (USkeletalMeshComponent* DroneMesh = GetMesh())
+    {
+        // Back onto the capsule
+        DroneMesh->SetRelativeTransform(GetBaseTransformForMesh());
+    }
+}
 
-    // ===== 2) Compute lift magnitude from throttle input =====
+void ADroneFPCharacter::UpdateVisualInterpolation()
+{
+    USkeletalMeshComponent* DroneMesh = GetMesh();
+    const float Interval = GetActorTickInterval();
+    if (!bInterpolateMesh || !DroneMesh || Interval <= 0.f)
+        return;
 
-    // ThrottleInput is -1..+1 (Left Stick Y)
-    // Map stick to 0..1 for lift (0 = no lift, 1 = MaxLiftForce)
-    const float LiftMag = Throttle01 * MaxLiftForce; // Newtons
+    // One tick behind: from the transform before the last tick to the one after it
+    const float Alpha = FMath::Clamp(float(GetWorld()->GetTimeSeconds() - LastTickTime) / Interval, 0.f, 1.f);
 
-    // ===== 3) Compute forces in world space =====
+    FTransform Visual;
+    Visual.Blend(PrevTickTransform, GetActorTransform(), Alpha);
+    DroneMesh->SetWorldTransform(GetBaseTransformForMesh() * Visual);
+}
 
-    // Drone local up (lift direction), and world up
-    const FVector UpLocal = GetActorUpVector();
-    const FVector WorldUp = FVector::UpVector;
+FTransform ADroneFPCharacter::GetBaseTransformForMesh() const
+{
+    const USkeletalMeshComponent* DroneMesh = GetMesh();
+    return FTransform(GetBaseRotationOffset(), GetBaseTranslationOffset(), DroneMesh ? DroneMesh->GetRelativeScale3D() : FVector::OneVector);
+}
 
-    // Lift along local up
-    const FVector Lift = UpLocal * LiftMag;
+FDroneFlightParams ADroneFPCharacter::GetFlightParams() const
+{
+    FDroneFlightParams Params;
+    Params.Mass = Mass;
+    Params.MaxLiftForce = MaxLiftForce;
+    Params.DragCoeff = DragCoeff;
+    Params.PitchRateDeg = PitchRateDeg;
+    Params.RollRateDeg = RollRateDeg;
+    Params.YawRateDeg = YawRateDeg;
+    Params.BatteryFullThrottleSeconds = BatteryFullThrottleSeconds;
+    Params.bBatteryCutsLift = bBatteryCutsLift;
 
     // Gravity from world settings (gravity Z is negative)
-    const float GravityZ = GetWorld() ? GetWorld()->GetGravityZ() : -980.f;
-    const FVector Gravity = FVector(0.f, 0.f, GravityZ * Mass);
+    Params.GravityZ = GetWorld() ? GetWorld()->GetGravityZ() : -980.f;
+    return Params;
+}
+
+FDroneFlightInput ADroneFPCharacter::GetFlightInput() const
+{
+    FDroneFlightInput Input;
+    Input.Throttle01 = Throttle01;
+    Input.Yaw = YawInput;
+    Input.Pitch = PitchInput;
+    Input.Roll = RollInput;
+    return Input;
+}
+
+void ADroneFPCharacter::UpdateFlight(float DeltaTime)
+{
+    const FDroneFlightParams Params = GetFlightParams();
+    const FDroneFlightInput Input = GetFlightInput();
 
-    // Simple linear drag opposite to velocity
-    const FVector Drag = -DragCoeff * Velocity;
+    // ===== 1) Update orientation from yaw/pitch/roll inputs (DJI Mode 2) =====
+    {
+        DRONERACER_SCOPED_STAT(Orientation);
 
-    // Total acceleration
-    const FVector Accel = (Lift + Gravity + Drag) / FMath::Max(Mass, KINDA_SMALL_NUMBER);
+        SetActorRotation(FDroneFlightModel::Rotate(Params, GetActorQuat(), Input, DeltaTime));
+    }
 
-    // ===== 4) Integrate velocity and position =====
+    // ===== 2) Lift, gravity and drag against the air (course wind + other drones' prop wash) =====
+    FVector Delta;
+    float Lift;
+    {
+        DRONERACER_SCOPED_STAT(Forces);
 
-    Velocity += Accel * DeltaTime;
+        const FVector Wind = WindSubsystem ? WindSubsystem->SampleWind(GetActorLocation()) : FVector::ZeroVector;
+        Lift = FDroneFlightModel::GetLift(Params, Input.Throttle01, Battery01);
+        Delta = FDroneFlightModel::Accelerate(Params, GetActorQuat(), Input, Wind, DeltaTime, Velocity, Battery01);
+        Replay.AddStep(Input, Wind, true);
 
-    const FVector Delta = Velocity * DeltaTime;
+        UE_LOG(LogTemp, Verbose, TEXT("Throttle01=%.3f  Velocity=%s"), Throttle01, *Velocity.ToString());
+    }
 
-    UE_LOG(LogTemp, Warning, TEXT("Throttle01=%.3f  Lift=%s  Velocity=%s  LiftMag=%.3f" ),
-        Throttle01,
-        *Lift.ToString(),
-        *Velocity.ToString(),
-        LiftMag
-        );
     // Use sweep so we still get collision
+    const FVector StartLocation = GetActorLocation();
     FHitResult Hit;
-    AddActorWorldOffset(Delta, true, &Hit);
+    {
+        DRONERACER_SCOPED_STAT(Sweep);
+        AddActorWorldOffset(Delta, true, &Hit);
+    }
+
+    if (RaceGateManager)
+    {
+        RaceGateManager->DroneMoved(this, StartLocation, GetActorLocation(), StateTime - DeltaTime, StateTime);
+    }
+
+    if (CollectibleSubsystem)
+    {
+        CollectibleSubsystem->SweepDrone(this, StartLocation, GetActorLocation(), GetCapsuleComponent()->GetScaledCapsuleRadius());
+    }
+
+    if (WindSubsystem)
+    {
+        WindSubsystem->AddPropWash(GetActorLocation(), -GetActorUpVector(), GetMotorThrottle01(), DeltaTime);
+    }
 
     if (Hit.IsValidBlockingHit())
     {
@@ -223,11 +656,270 @@ void ADroneFPCharacter::Tick(float DeltaTime)
             Velocity -= Normal * Vn;
         }
 
+        // The world moved us, not the flight model
+        Replay.AddContact(GetActorLocation(), Velocity);
+
         HandleImpactDamage(Hit);
     }
+
+    if (Blackbox)
+    {
+        RecordBlackbox(Input, Lift, DeltaTime);
+    }
+
+    if (bReplayLapEnded)
+    {
+        FinishLapReplay();
+    }
+}
+
+void ADroneFPCharacter::RecordBlackbox(const FDroneFlightInput& Input, float Lift, float DeltaTime)
+{
+    const FRotator Attitude = GetActorRotation();
+
+    FDroneBlackboxSample Sample;
+    BlackboxTimeUs += uint64(DeltaTime * 1e6f);
+    Sample.TimeUs = BlackboxTimeUs;
+    Sample.Throttle01 = Input.Throttle01;
+    Sample.Roll = Input.Roll;
+    Sample.Pitch = Input.Pitch;
+    Sample.Yaw = Input.Yaw;
+    Sample.Attitude = FVector3f(Attitude.Roll, Attitude.Pitch, Attitude.Yaw);
+
+    // Rate mode: the body turns at the commanded rates
+    Sample.BodyRates = FVector3f(Input.Roll * RollRateDeg, Input.Pitch * PitchRateDeg, Input.Yaw * YawRateDeg);
+    Sample.Velocity = FVector3f(Velocity);
+    Sample.Lift = Lift;
+    Sample.Health = Health;
+    Sample.Battery01 = Battery01;
+    Sample.ImpactEnergy = StepImpactEnergy;
+    StepImpactEnergy = 0.f;
+
+    Blackbox->Push(Sample);
+}
+
+// ===== Lap replays =====
+
+FDroneFlightState ADroneFPCharacter::GetFlightState() const
+{
+    FDroneFlightState State;
+    State.Location = GetActorLocation();
+    State.Rotation = GetActorQuat();
+    State.Velocity = Velocity;
+    State.Battery01 = Battery01;
+    return State;
+}
+
+void ADroneFPCharacter::BeginLapReplay(uint64 CourseId, const FTransform& CourseTransform, uint32 GateTest)
+{
+    bReplayLapEnded = false;
+    // The flight thread's steps aren't recorded, so its laps can't be re-simulated
+    if (bRecordReplays && !FlightChannel)
+    {
+        Replay.BeginLap(CourseId, CourseTransform, GateTest, PhysicsStepSeconds, GetFlightParams(), GetFlightState());
+    }
+}
+
+FString ADroneFPCharacter::EndLapReplay(bool bStartNextLap)
+{
+    if (!Replay.IsRecording())
+        return FString();
+
+    // Called mid-step by the gate test; the step's contact is still to come
+    bReplayLapEnded = true;
+    bReplayNextLap = bStartNextLap;
+    EndedReplayName = FString::Printf(TEXT("%s_%s.drreplay"), *GetName(), *FGuid::NewGuid().ToString(EGuidFormats::Digits));
+    return Replay.IsTainted() ? FString() : EndedReplayName;
+}
+
+void ADroneFPCharacter::FinishLapReplay()
+{
+    bReplayLapEnded = false;
+    Replay.EndLap(FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Replays"), EndedReplayName));
+
+    if (bReplayNextLap)
+    {
+        Replay.BeginNextLap(GetFlightState());
+    }
+}
+
+// ===== Network =====
+
+bool ADroneFPCharacter::IsNetDriven() const
+{
+    if (GetLocalRole() == ROLE_SimulatedProxy)
+        return true;
+
+    // The server's copy of a drone a client flies
+    return HasAuthority() && IsPlayerControlled() && !IsLocallyControlled();
+}
+
+void ADroneFPCharacter::ReportNetState(float DeltaTime)
+{
+    if (HasAuthority() || !IsLocallyControlled())
+        return;
+
+    TimeSinceNetReport += DeltaTime;
+    if (TimeSinceNetReport < 1.f / NetStateRate)
+        return;
+    TimeSinceNetReport = 0.f;
+
+    FDroneNetState State;
+    State.Location = GetActorLocation();
+    State.Rotation = GetActorRotation();
+    State.Velocity = Velocity;
+    State.Health = Health;
+    State.TeleportCount = TeleportCount;
+    ServerReportState(State);
+}
+
+void ADroneFPCharacter::ServerReportState_Implementation(const FDroneNetState& State)
+{
+    if (State.Location.ContainsNaN() || State.Velocity.ContainsNaN() || State.Rotation.ContainsNaN())
+        return;
+
+    // Reports are unreliable, so the reach grows with the time since the last one that arrived
+    const double Now = GetWorld()->GetTimeSeconds();
+    if (LastNetStateTime >= 0.0 && State.TeleportCount == LastNetTeleportCount)
+    {
+        const double Reach = MaxNetSpeed * (Now - LastNetStateTime) + GetCapsuleComponent()->GetScaledCapsuleRadius();
+        if (FVector::DistSquared(State.Location, GetActorLocation()) > FMath::Square(Reach))
+        {
+            UE_LOG(LogTemp, Verbose, TEXT("%s: state report moved too far, ignored"), *GetName());
+            return;
+        }
+    }
+    LastNetStateTime = Now;
+    LastNetTeleportCount = State.TeleportCount;
+
+    // Replicated on to the other clients from here, and recorded for shots by UDroneHitHistorySubsystem
+    SetActorLocationAndRotation(State.Location, State.Rotation.Quaternion(), false, nullptr, ETeleportType::TeleportPhysics);
+    Velocity = State.Velocity;
+    Health = FMath::Clamp(State.Health, 0.f, MaxHealth);
+}
+
+// ===== Rewind =====
+
+void ADroneFPCharacter::RecordState()
+{
+    FDroneStateSample Sample;
+    Sample.Location = GetActorLocation();
+    Sample.Rotation = GetActorQuat();
+    Sample.Velocity = Velocity;
+    Sample.Throttle01 = Throttle01;
+    Sample.Health = Health;
+    Sample.Battery01 = Battery01;
+    Sample.bArmed = bThrottleArmed;
+
+    if (const FRacerProgress* Progress = RaceGateManager ? RaceGateManager->GetRacerProgress(RacerIndex) : nullptr)
+    {
+        Sample.GateIndex = Progress->GateIndex;
+        Sample.Lap = Progress->Lap;
+        Sample.LapTime = float(StateTime - Progress->LapStartTime);
+        Sample.TimeSinceLastGate = float(StateTime - Progress->LastGatePassTime);
+        Sample.LastSplit = Progress->LastSplit;
+    }
+
+    History.Push(Sample);
+}
+
+bool ADroneFPCharacter::RewindSeconds(float Seconds)
+{
+    int32 StepsBack = FMath::Clamp(FMath::RoundToInt(Seconds / PhysicsStepSeconds), 0, FMath::Max(History.Num() - 1, 0));
+
+    // Never back over a finish line: that lap is complete (and submitted) and would complete a second time
+    if (const FRacerProgress* Progress = RaceGateManager ? RaceGateManager->GetRacerProgress(RacerIndex) : nullptr)
+    {
+        const int32 NumGates = RaceGateManager->GetNumGates();
+        const auto LapsCompleted = [NumGates](int32 Lap, int32 GateIndex) { return Lap - 1 + (GateIndex >= NumGates ? 1 : 0); };
+        const int32 Completed = LapsCompleted(Progress->Lap, Progress->GateIndex);
+        for (; StepsBack > 0; --StepsBack)
+        {
+            const FDroneStateSample* Candidate = History.GetFromNewest(StepsBack);
+            if (Candidate->GateIndex == INDEX_NONE || LapsCompleted(Candidate->Lap, Candidate->GateIndex) == Completed)
+                break;
+        }
+    }
+
+    const FDroneStateSample* Sample = History.GetFromNewest(StepsBack);
+    if (!Sample)
+        return false;
+
+    // Copy out, the slot is handed back to the ring below
+    const FDroneStateSample Restored = *Sample;
+    const int32 NumDiscarded = FMath::Min(StepsBack, History.Num() - 1);
+    History.DiscardNewest(NumDiscarded);
+    RestoreState(Restored);
+
+    UE_LOG(LogTemp, Log, TEXT("Drone rewound %.2f s"), NumDiscarded * PhysicsStepSeconds);
+    return true;
+}
+
+void ADroneFPCharacter::RestoreState(const FDroneStateSample& Sample)
+{
+    SetActorLocationAndRotation(Sample.Location, Sample.Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+
+    // The lap in progress no longer follows from its inputs
+    Replay.Taint();
+    ++TeleportCount;
+    Velocity = Sample.Velocity;
+    Throttle01 = Sample.Throttle01;
+    Battery01 = Sample.Battery01;
+    bThrottleArmed = Sample.bArmed;
+
+    // The sample may be from the step that killed the drone
+    Health = Sample.Health > 0.f ? Sample.Health : MaxHealth;
+
+    // The restored times are relative to now, where the next step starts
+    StateTime = GetWorld()->GetTimeSeconds();
+
+    if (RaceGateManager && Sample.GateIndex != INDEX_NONE)
+    {
+        RaceGateManager->RestoreRacerProgress(RacerIndex, Sample.GateIndex, Sample.Lap, Sample.LapTime, Sample.TimeSinceLastGate, Sample.LastSplit);
+    }
+
+    StepAccumulator = 0.f;
+    SendFlightState();
+}
+
+void ADroneFPCharacter::Rewind(const FInputActionValue& Value)
+{
+    if (bPracticeMode)
+    {
+        RewindSeconds(PracticeRewindSeconds);
+    }
+}
+
+void ADroneFPCharacter::PublishTelemetry()
+{
+    Telemetry.FrameNumber = GFrameCounter;
+    Telemetry.bArmed = bThrottleArmed;
+    Telemetry.Throttle01 = Throttle01;
+    Telemetry.BodyRatesDeg = FVector(RollInput * RollRateDeg, PitchInput * PitchRateDeg, YawInput * YawRateDeg);
+    Telemetry.SpeedMs = Velocity.Size() / 100.f;
+    Telemetry.AltitudeM = GetActorLocation().Z / 100.f;
+    Telemetry.Health = Health;
+    Telemetry.MaxHealth = MaxHealth;
+    Telemetry.Battery01 = Battery01;
+
+    const FRacerProgress* Progress = RaceGateManager ? RaceGateManager->GetRacerProgress(RacerIndex) : nullptr;
+    if (Progress)
+    {
+        Telemetry.CurrentGate = Progress->GateIndex;
+        Telemetry.NumGates = RaceGateManager->GetNumGates();
+        Telemetry.Lap = Progress->Lap;
+        Telemetry.NumLaps = RaceGateManager->NumLaps;
+        Telemetry.LapTime = RaceGateManager->GetLapTime(RacerIndex);
+        Telemetry.LastSplit = Progress->LastSplit;
+        Telemetry.DeltaToBest = Progress->DeltaToBest;
+        Telemetry.bHasDeltaToBest = Progress->bHasDeltaToBest;
+    }
 }
+
 void ADroneFPCharacter::HandleImpactDamage(const FHitResult& Hit)
 {
+    DRONERACER_SCOPED_STAT(ImpactDamage);
+
     if (!Hit.IsValidBlockingHit()) return;
     if (Health <= 0.f) return;
 
@@ -242,14 +934,47 @@ void ADroneFPCharacter::HandleImpactDamage(const FHitResult& Hit)
         return; // grazing / sliding, no real impact
     }
 
+    // Hardness multiplier based on what we hit (1.0 = neutral)
+    ApplyImpactDamage(ImpactSpeedCm, GetSurfaceHardness(Hit));
+}
+
+void ADroneFPCharacter::ApplyDroneContact(const FVector& Location, const FVector& NewVelocity, float ImpactSpeedCm)
+{
+    // The machine flying it resolves the contact; the next state from there moves it here
+    if (IsNetDriven())
+        return;
+
+    // Back along the path just flown, swept in case the other drone pushed this one toward the course
+    SetActorLocation(Location, true);
+    Velocity = NewVelocity;
+
+    // The other drone moved us, not the flight model
+    Replay.AddContact(GetActorLocation(), Velocity, FDroneReplayContact::DronePush);
+    if (FlightChannel)
+    {
+        SendFlightState();
+    }
+
+    // The sweep can carry the drone through a gate trigger, armed or not; the lap ends with this step's push
+    if (bReplayLapEnded)
+    {
+        FinishLapReplay();
+    }
+
+    if (Health > 0.f && ImpactSpeedCm > KINDA_SMALL_NUMBER)
+    {
+        ApplyImpactDamage(ImpactSpeedCm, DroneContactHardness);
+    }
+}
+
+void ADroneFPCharacter::ApplyImpactDamage(float ImpactSpeedCm, float Hardness)
+{
     // Convert to m/s for energy calculation
     const float ImpactSpeedM = ImpactSpeedCm / 100.f;
 
     // Kinetic energy-ish: 0.5 * m * v^2
     const float ImpactEnergy = 0.5f * Mass * ImpactSpeedM * ImpactSpeedM;
-
-    // Hardness multiplier based on what we hit (1.0 = neutral)
-    const float Hardness = GetSurfaceHardness(Hit);
+    StepImpactEnergy += ImpactEnergy;
 
     // Map energy range to 0..1 damage factor
     const float Damage01 = FMath::GetMappedRangeValueClamped(
@@ -316,6 +1041,24 @@ void ADroneFPCharacter::ApplyDamageToDrone(float DamageAmount)
     }
 }
 
+void ADroneFPCharacter::ApplyWeaponHit(float DamageAmount)
+{
+    // The client flying the drone owns its health; the server's copy only follows its reports
+    if (HasAuthority() && IsNetDriven())
+    {
+        ClientApplyWeaponHit(DamageAmount);
+    }
+    else
+    {
+        ApplyDamageToDrone(DamageAmount);
+    }
+}
+
+void ADroneFPCharacter::ClientApplyWeaponHit_Implementation(float DamageAmount)
+{
+    ApplyDamageToDrone(DamageAmount);
+}
+
 void ADroneFPCharacter::OnDroneDestroyed()
 {
     UE_LOG(LogTemp, Warning, TEXT("Drone destroyed!"));
@@ -324,6 +1067,9 @@ void ADroneFPCharacter::OnDroneDestroyed()
     bThrottleArmed = false;
     Velocity = FVector::ZeroVector;
 
+    // Back to a few seconds before the crash once the current step is done
+    bCrashRespawnPending = bRespawnOnCrash;
+
     // You could also:
     // - Enable SimulatePhysics on mesh and let it ragdoll
     // - Trigger explosion FX
@@ -346,6 +1092,12 @@ void ADroneFPCharacter::Throttle(const FInputActionValue& Value)
         {
             bThrottleArmed = true;
             UE_LOG(LogTemp, Warning, TEXT("Throttle armed!"));
+
+            // Startup metric: time to first armed throttle
+            if (UDronePreloadSubsystem* Preload = GetGameInstance()->GetSubsystem<UDronePreloadSubsystem>())
+            {
+                Preload->NotifyThrottleArmed();
+            }
         }
         else
         {
@@ -394,13 +1146,6 @@ void ADroneFPCharacter::Move(const FInputActionValue& Value)
         AddMovementInput(Forward, Y);
         AddMovementInput(Right, X);
     }
-
-    if (GEngine)
-    {
-        GEngine->AddOnScreenDebugMessage(
-            -1, 0.f, FColor::Green,
-            FString::Printf(TEXT("Move: X=%.2f Y=%.2f"), X, Y));
-    }
 }
 
 void ADroneFPCharacter::Look(const FInputActionValue& Value)
@@ -411,11 +1156,4 @@ void ADroneFPCharacter::Look(const FInputActionValue& Value)
 
     AddControllerYawInput(X);
     AddControllerPitchInput(Y);
-
-    if (GEngine)
-    {
-        GEngine->AddOnScreenDebugMessage(
-            -1, 0.f, FColor::Cyan,
-            FString::Printf(TEXT("Look: X=%.2f Y=%.2f"), X, Y));
-    }
 }
\ No newline at end of file
@@ -2,12 +2,51 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "Engine/NetSerialization.h"
 #include "InputActionValue.h"
 #include "InputMappingContext.h"
+#include "DroneTelemetry.h"
+#include "DroneStateHistory.h"
+#include "DroneBlackbox.h"
+#include "DroneReplay.h"
+#include "DroneFlightThread.h"
+#include "DroneSITLBridge.h"
 #include "DroneFPCharacter.generated.h"
 
 class UCameraComponent;
 class UInputAction;
+class ARaceGateManager;
+class UDroneStreamingSourceComponent;
+class UDroneMotorSynthComponent;
+class UDroneTrajectoryComponent;
+class UDroneWindSubsystem;
+class UDroneCollectibleSubsystem;
+struct FDroneFlightParams;
+struct FDroneFlightInput;
+struct FDroneFlightState;
+
+/** Where the machine flying a drone has it, reported to the server every few frames */
+USTRUCT()
+struct FDroneNetState
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    FVector_NetQuantize100 Location;
+
+    UPROPERTY()
+    FRotator Rotation = FRotator::ZeroRotator;
+
+    UPROPERTY()
+    FVector_NetQuantize10 Velocity;
+
+    UPROPERTY()
+    float Health = 0.f;
+
+    /** Bumped by every rewind and respawn, which may move the drone anywhere on its lap */
+    UPROPERTY()
+    uint8 TeleportCount = 0;
+};
 
 /**
  * Physics-based first-person drone character, DJI Mode 2 controls.
@@ -30,14 +69,116 @@ public:
 
     virtual void Tick(float DeltaTime) override;
 
+    /** Flight-model velocity (cm/s); the movement component is inactive */
+    virtual FVector GetVelocity() const override { return Velocity; }
+
+    ARaceGateManager* GetRaceGateManager() const { return RaceGateManager; }
+
+    /** Index of this drone's progress in the race, INDEX_NONE without a race */
+    int32 GetRacerIndex() const { return RacerIndex; }
+
+    /** World time the drone's state is for: the end of the physics step running or last run */
+    double GetStateTime() const { return StateTime; }
+
+    /** Highlight over this drone's next gate, only visible in its own viewport */
+    UStaticMeshComponent* GetGateHighlight() const { return GateHighlight; }
+
+    UDroneMotorSynthComponent* GetMotorSynth() const { return MotorSynth; }
+
+    /** Null unless flown by a SITL flight controller */
+    FDroneSITLBridge* GetSITLBridge() const { return SITLBridge.Get(); }
+
+    /** Snapshot of the flight state published at the end of the last Tick */
+    const FDroneTelemetrySnapshot& GetTelemetry() const { return Telemetry; }
+
+    /** Current physical parameters in the form FDroneFlightModel takes */
+    FDroneFlightParams GetFlightParams() const;
+
+    float GetPhysicsStepSeconds() const { return PhysicsStepSeconds; }
+
+    /** Current stick input in the form FDroneFlightModel takes */
+    FDroneFlightInput GetFlightInput() const;
+
+    bool IsPracticeMode() const { return bPracticeMode; }
+
+    /**
+     * Starts recording a lap replay from the current state; called by the race
+     * when the racer starts over. GateTest is the FDroneReplayHeader::EGateTest
+     * the race scores the lap with.
+     */
+    void BeginLapReplay(uint64 CourseId, const FTransform& CourseTransform, uint32 GateTest);
+
+    /**
+     * Ends the lap replay with the current physics step, which crossed the
+     * last gate. Returns the file name the replay is written to (under
+     * Saved/Replays), empty if the lap can't be replayed.
+     */
+    FString EndLapReplay(bool bStartNextLap);
+
+    float GetHealth() const { return Health; }
+
+    /**
+     * Moved by another machine: the server's copy of a client's drone, which
+     * follows its reports, or another client's, which follows the server.
+     * Such drones don't fly, race or collide here.
+     */
+    bool IsNetDriven() const;
+
+    /** Server: a shot hit the drone; the damage is taken where the drone is flown */
+    void ApplyWeaponHit(float DamageAmount);
+
+    /** kg */
+    float GetMass() const { return Mass; }
+
+    /**
+     * Contact with another drone, resolved by UDroneContactSubsystem: puts the
+     * drone at Location with NewVelocity, and damages it like a world impact
+     * at ImpactSpeedCm against a surface of DroneContactHardness.
+     */
+    void ApplyDroneContact(const FVector& Location, const FVector& NewVelocity, float ImpactSpeedCm);
+
+    /**
+     * Ticks every Seconds instead of every frame (0: every frame), set by
+     * UDroneSignificanceSubsystem for drones nobody is near. The flight model
+     * still runs every physics step; the drone catches up when it ticks.
+     */
+    void SetSignificanceTickInterval(float Seconds);
+
+    /** Moves the mesh between the drone's last two ticks, called every frame while the tick interval is set */
+    void UpdateVisualInterpolation();
+
+    /**
+     * Restores the state recorded Seconds ago, clamped to the recorded history
+     * and to the current lap. The lap in progress is practice from then on.
+     */
+    UFUNCTION(BlueprintCallable, Category = "Flight|Rewind")
+    bool RewindSeconds(float Seconds);
+
 protected:
     virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+    virtual void NotifyControllerChanged() override;
     virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
     /** First person camera */
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
     UCameraComponent* FirstPersonCamera;
 
+    /** World Partition streaming ahead of the drone */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+    UDroneStreamingSourceComponent* StreamingSource;
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+    UDroneMotorSynthComponent* MotorSynth;
+
+    /** Predicted path while the sticks are held, practice mode only */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+    UDroneTrajectoryComponent* Trajectory;
+
+    /** Placed over the next gate by the race manager */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+    UStaticMeshComponent* GateHighlight;
+
     // ===== Enhanced Input Actions (set in BP_DroneFPCharacter) =====
     UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Input")
     UInputMappingContext* IMC_Default;
@@ -58,6 +199,10 @@ protected:
     UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Input")
     UInputAction* IA_Roll;
 
+    /** Practice rewind by PracticeRewindSeconds; ignored unless bPracticeMode. The lap then counts as practice and isn't stored */
+    UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Input")
+    UInputAction* IA_Rewind;
+
     UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Input")
     UInputMappingContext* DefaultMappingContext;
 
@@ -91,7 +236,7 @@ protected:
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Flight|Physics")
     float MaxLiftForce = 2800.0f;  //4 x lift force per motor of Kgf per motor.
 
-    /** Linear drag coefficient */
+    /** Linear drag coefficient, applied to the velocity relative to the wind */
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Flight|Physics")
     float DragCoeff = 1.0f;
 
@@ -128,6 +273,92 @@ protected:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flight|Health")
     float MaxEnergyForMaxDamage = 100.f; // J-ish
 
+    // Surface hardness of another drone for contact damage (see GetSurfaceHardness)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flight|Health")
+    float DroneContactHardness = 1.f;
+
+    // Battery
+
+    /** Seconds of flight a full battery gives at full throttle */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flight|Battery")
+    float BatteryFullThrottleSeconds = 240.f;
+
+    /** Cut the lift when the battery is empty; off, the battery only drains for the OSD */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flight|Battery")
+    bool bBatteryCutsLift = false;
+
+    /** Remaining charge 0..1 */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Flight|Battery")
+    float Battery01 = 1.f;
+
+    // ===== Fixed step / rewind =====
+
+    /** Flight model step (s); Tick runs as many steps as the frame time covers */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Flight|Physics", meta = (ClampMin = "0.001"))
+    float PhysicsStepSeconds = 1.f / 120.f;
+
+    /** Steps run at most per frame; time beyond that is dropped (hitches slow the drone down instead of spiralling) */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Flight|Physics", meta = (ClampMin = "1"))
+    int32 MaxPhysicsStepsPerFrame = 8;
+
+    /**
+     * Fly on the 1 kHz flight thread (see FDroneFlightThread) instead of in
+     * Tick, so game thread hitches don't reach the controls. Tick then only
+     * sweeps the drone to the latest simulated state; collisions, gates and
+     * pickups stay on the game thread. Laps flown this way have no replay.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Flight|Physics")
+    bool bThreadedFlight = false;
+
+    /**
+     * Flown by a Betaflight SITL flight controller on this machine (see
+     * FDroneSITLBridge): the sticks go to it as RC channels and its motor
+     * outputs turn and lift the drone. Threaded like bThreadedFlight; falls
+     * back to the stick-rate model if the sockets can't be opened.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Flight|SITL")
+    bool bSITLFlightController = false;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Flight|SITL", meta = (EditCondition = "bSITLFlightController"))
+    FDroneSITLSettings SITL;
+
+    /** Seconds of state kept for rewinding, allocated at BeginPlay */
+    UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Flight|Rewind", meta = (ClampMin = "0.5"))
+    float RewindHistorySeconds = 10.f;
+
+    /** Enables the IA_Rewind input */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flight|Rewind")
+    bool bPracticeMode = true;
+
+    /** How far IA_Rewind goes back */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flight|Rewind")
+    float PracticeRewindSeconds = 3.f;
+
+    /** Respawn at the state CrashRespawnSeconds before the crash instead of staying down */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flight|Rewind")
+    bool bRespawnOnCrash = true;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flight|Rewind")
+    float CrashRespawnSeconds = 2.f;
+
+    // ===== Blackbox =====
+
+    /**
+     * Record every physics step while armed to Saved/Blackbox/<drone>_<time>.csv.gz.
+     * The log rate is the physics rate, 1 / PhysicsStepSeconds (120 Hz by default;
+     * 0.001 gives 1 kHz logs). With bThreadedFlight it is one row per game frame.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flight|Blackbox")
+    bool bRecordBlackbox = false;
+
+    /** Record a replay of every lap so submitted lap times can be verified (see LapVerifier.h) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race")
+    bool bRecordReplays = true;
+
+    /** Race the drone is flying, found in the level at BeginPlay if not set */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race")
+    ARaceGateManager* RaceGateManager;
+
     // ===== Input handlers (Enhanced Input) =====
 
     void Throttle(const FInputActionValue& Value);
@@ -137,15 +368,128 @@ protected:
 
     void Move(const FInputActionValue& Value);
     void Look(const FInputActionValue& Value);
+    void Rewind(const FInputActionValue& Value);
 
     void HandleImpactDamage(const FHitResult& Hit);
+    void ApplyImpactDamage(float ImpactSpeedCm, float Hardness);
     float GetSurfaceHardness(const FHitResult& Hit) const;
+
+    /** Takes health off, destroying the drone at 0 (impacts, weapon hits) */
     void ApplyDamageToDrone(float DamageAmount);
     void OnDroneDestroyed();
 
+    // ===== Network =====
+
+    /** How often a client flying its drone reports the drone's state to the server (Hz) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network", meta = (ClampMin = "1"))
+    float NetStateRate = 60.f;
+
+    /** Reports moving the drone faster than this since the last accepted one are ignored, except across a rewind (cm/s) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network")
+    float MaxNetSpeed = 10000.f;
+
 private:
     void ApplyMappingContext();
-    float Throttle01;
+    void UpdateFlight(float DeltaTime);
+    void RecordState();
+    void RecordBlackbox(const FDroneFlightInput& Input, float Lift, float DeltaTime);
+    void FinishLapReplay();
+    FDroneFlightState GetFlightState() const;
+
+    /** Throttle the motors run at, 0 once an empty battery cuts them */
+    float GetMotorThrottle01() const { return bBatteryCutsLift && Battery01 <= 0.f ? 0.f : Throttle01; }
+    void RestoreState(const FDroneStateSample& Sample);
+
+    /** Tick with bThreadedFlight: sends the sticks and moves to the flight thread's latest state */
+    void TickThreadedFlight(float DeltaTime);
+
+    /** Makes the flight thread continue from the drone's current state */
+    void SendFlightState();
+    void PublishTelemetry();
+
+    /** Mesh transform relative to the capsule as set up in the Blueprint */
+    FTransform GetBaseTransformForMesh() const;
+
+    /** Client flying its drone: reports the state to the server at NetStateRate */
+    void ReportNetState(float DeltaTime);
+
+    UFUNCTION(Server, Unreliable)
+    void ServerReportState(const FDroneNetState& State);
+
+    UFUNCTION(Client, Reliable)
+    void ClientApplyWeaponHit(float DamageAmount);
+
+    float TimeSinceNetReport = 0.f;
+    uint8 TeleportCount = 0;
+
+    // Server, of the last report it accepted
+    double LastNetStateTime = -1.0;
+    uint8 LastNetTeleportCount = 0;
+
+    FDroneTelemetrySnapshot Telemetry;
+
+    int32 RacerIndex = INDEX_NONE;
+
+    /** Slot in UDroneHitHistorySubsystem, server only */
+    int32 HitHistorySlot = INDEX_NONE;
+
+    /** Handle in UDroneSignificanceSubsystem */
+    int32 SignificanceHandle = INDEX_NONE;
+
+    /** Handle in UDroneContactSubsystem, INDEX_NONE when drones collide through the capsule sweep */
+    int32 ContactHandle = INDEX_NONE;
+
+    /** Actor transform before the last tick and when it ran, for UpdateVisualInterpolation */
+    FTransform PrevTickTransform;
+    double LastTickTime = 0.0;
+    bool bInterpolateMesh = false;
+
+    UPROPERTY(Transient)
+    UDroneWindSubsystem* WindSubsystem;
+
+    UPROPERTY(Transient)
+    UDroneCollectibleSubsystem* CollectibleSubsystem;
+
+    /** Frame time not yet simulated, always < PhysicsStepSeconds between frames */
+    float StepAccumulator = 0.f;
+
+    /** See GetStateTime */
+    double StateTime = 0.0;
+
+    /** Set with bThreadedFlight or bSITLFlightController */
+    TSharedPtr<FDroneFlightChannel, ESPMode::ThreadSafe> FlightChannel;
+
+    /** Steps FlightChannel instead of the flight thread with bSITLFlightController */
+    TUniquePtr<FDroneSITLBridge> SITLBridge;
+
+    /** Of the last state sent to the flight thread; older results are ignored */
+    uint32 FlightStateVersion = 0;
+
+    /** A state the full command ring didn't take yet, resent before the next input */
+    TOptional<FDroneFlightCommand> PendingFlightState;
+
+    /** One sample per physics step */
+    FDroneStateHistory History;
+
+    /** Set when the drone is destroyed mid-step, handled after the step loop */
+    bool bCrashRespawnPending = false;
+
+    /** Null unless bRecordBlackbox */
+    TUniquePtr<FDroneBlackboxWriter> Blackbox;
+    uint64 BlackboxTimeUs = 0;
+
+    /** Impact energy (J) of the current step, for the blackbox */
+    float StepImpactEnergy = 0.f;
+
+    /** Replay of the lap in progress */
+    FDroneReplayRecorder Replay;
+
+    /** Set by EndLapReplay, the replay is ended once the current step is complete */
+    bool bReplayLapEnded = false;
+    bool bReplayNextLap = false;
+    FString EndedReplayName;
+
+    float Throttle01 = 0.f;
     bool bThrottleArmed = false;
 
     UPROPERTY(VisibleDefaultsOnly, Category = Mesh)
@@ -0,0 +1,134 @@
+#include "DroneFlightModel.h"
+
+FQuat FDroneFlightModel::Rotate(const FDroneFlightParams& Params, const FQuat& Rotation, const FDroneFlightInput& Input, float DeltaTime)
+{
+    const float dPitch = Input.Pitch * Params.PitchRateDeg * DeltaTime; // nose up/down
+    const float dYaw = Input.Yaw * Params.YawRateDeg * DeltaTime; // rotate about vertical
+    const float dRoll = Input.Roll * Params.RollRateDeg * DeltaTime; // bank about longitudinal
+
+    // Local rotation, like AActor::AddActorLocalRotation
+    return Rotation * FRotator(dPitch, dYaw, dRoll).Quaternion();
+}
+
+FVector FDroneFlightModel::Accelerate(const FDroneFlightParams& Params, const FQuat& Rotation, const FDroneFlightInput& Input,
+    const FVector& Wind, float DeltaTime, FVector& InOutVelocity, float& InOutBattery01)
+{
+    // ===== Lift magnitude from throttle =====
+
+    // 0 = no lift, 1 = MaxLiftForce
+    const float LiftMag = GetLift(Params, Input.Throttle01, InOutBattery01); // Newtons
+
+    // Drain proportional to throttle
+    const float Drain = Input.Throttle01 * DeltaTime / FMath::Max(Params.BatteryFullThrottleSeconds, KINDA_SMALL_NUMBER);
+    InOutBattery01 = FMath::Max(InOutBattery01 - Drain, 0.f);
+
+    // ===== Forces in world space =====
+
+    // Lift along local up
+    const FVector Lift = Rotation.GetUpVector() * LiftMag;
+
+    const FVector Gravity = FVector(0.f, 0.f, Params.GravityZ * Params.Mass);
+
+    // Simple linear drag opposite to the velocity through the air
+    const FVector Drag = -Params.DragCoeff * (InOutVelocity - Wind);
+
+    const FVector Accel = (Lift + Gravity + Drag) / FMath::Max(Params.Mass, KINDA_SMALL_NUMBER);
+
+    // ===== Integrate =====
+
+    InOutVelocity += Accel * DeltaTime;
+    return InOutVelocity * DeltaTime;
+}
+
+void FDroneFlightModel::StepRepeated(const FDroneFlightParams& Params, FDroneFlightState& State, const FDroneFlightInput& Input,
+    const FVector& Wind, float DeltaTime, int32 NumSteps)
+{
+    if (NumSteps <= 0)
+        return;
+
+    // Lift is cut the step the battery runs out; closed form only while it lasts
+    const float Drain = Input.Throttle01 * DeltaTime / FMath::Max(Params.BatteryFullThrottleSeconds, KINDA_SMALL_NUMBER);
+    const bool bBatteryLasts = !Params.bBatteryCutsLift || State.Battery01 - Drain * NumSteps > 0.f || Input.Throttle01 <= 0.f;
+    const bool bCentred = Input.Pitch == 0.f && Input.Yaw == 0.f && Input.Roll == 0.f;
+    if (!bCentred || !bBatteryLasts)
+    {
+        for (int32 Step = 0; Step < NumSteps; ++Step)
+        {
+            FDroneFlightModel::Step(Params, State, Input, Wind, DeltaTime);
+        }
+        return;
+    }
+
+    // Each step is v' = v + (A - C v) dt, x' = x + v' dt with constant A and C:
+    // v_n = V + (v_0 - V) R^n with V = A / C, R = 1 - C dt, and x_n = x_0 + dt * sum(v_1..v_n)
+    const float Mass = FMath::Max(Params.Mass, KINDA_SMALL_NUMBER);
+    const float LiftMag = GetLift(Params, Input.Throttle01, State.Battery01);
+    const FVector A = (State.Rotation.GetUpVector() * LiftMag + FVector(0.f, 0.f, Params.GravityZ * Params.Mass)
+        + Params.DragCoeff * Wind) / Mass;
+    const float C = Params.DragCoeff / Mass;
+    const float N = float(NumSteps);
+
+    if (C * DeltaTime < KINDA_SMALL_NUMBER)
+    {
+        // No drag: constant acceleration
+        State.Location += DeltaTime * (N * State.Velocity + A * DeltaTime * (N * (N + 1.f) * 0.5f));
+        State.Velocity += A * (DeltaTime * N);
+    }
+    else
+    {
+        const FVector Terminal = A / C;
+        const float R = 1.f - C * DeltaTime;
+        const float RN = FMath::Pow(R, N);
+        const FVector Transient = State.Velocity - Terminal;
+        State.Location += DeltaTime * (N * Terminal + Transient * (R * (1.f - RN) / (1.f - R)));
+        State.Velocity = Terminal + Transient * RN;
+    }
+
+    State.Battery01 = FMath::Max(State.Battery01 - Drain * NumSteps, 0.f);
+}
+
+void FDroneFlightModel::StepMotors(const FDroneFlightParams& Params, const FDroneMotorParams& MotorParams, FDroneFlightState& State,
+    FDroneMotorState& Motors, const float (&Commands01)[4], const FVector& Wind, float DeltaTime)
+{
+    // Betaflight Quad X, props in; positions in the flight controller's forward-right-down body frame
+    static constexpr float Forward[4] = { -1.f, 1.f, -1.f, 1.f };
+    static constexpr float Right[4] = { 1.f, 1.f, -1.f, -1.f };
+    static constexpr float Clockwise[4] = { 1.f, -1.f, -1.f, 1.f };
+
+    const float Follow = 1.f - FMath::Exp(-DeltaTime / FMath::Max(MotorParams.MotorTimeConstant, KINDA_SMALL_NUMBER));
+
+    // Torque in FRD per unit thrust: thrust points up (-Z), so r x F = (-y T, x T, 0); props react against their spin
+    FVector Torque = FVector::ZeroVector;
+    float TotalThrust = 0.f;
+    for (int32 Motor = 0; Motor < 4; ++Motor)
+    {
+        Motors.Spin01[Motor] += (FMath::Clamp(Commands01[Motor], 0.f, 1.f) - Motors.Spin01[Motor]) * Follow;
+        const float Thrust = Motors.Spin01[Motor] * Motors.Spin01[Motor];
+        TotalThrust += Thrust;
+
+        Torque.X -= Right[Motor] * Thrust;
+        Torque.Y += Forward[Motor] * Thrust;
+        Torque.Z -= Clockwise[Motor] * Thrust;
+    }
+
+    // Each side has two motors, each pair two
+    Torque.X *= 0.5f;
+    Torque.Y *= 0.5f;
+    Torque.Z *= 0.5f;
+
+    // FRD to the drone's local axes (Z up): the mirror flips an angular vector's X and Y
+    const FVector AccelDeg(-Torque.X * MotorParams.RollPitchAccelDeg, -Torque.Y * MotorParams.RollPitchAccelDeg, Torque.Z * MotorParams.YawAccelDeg);
+    const FVector AccelRad(FMath::DegreesToRadians(AccelDeg.X), FMath::DegreesToRadians(AccelDeg.Y), FMath::DegreesToRadians(AccelDeg.Z));
+    Motors.BodyRates += (AccelRad - MotorParams.AngularDamping * Motors.BodyRates) * DeltaTime;
+
+    const float Rate = float(Motors.BodyRates.Size());
+    if (Rate > KINDA_SMALL_NUMBER)
+    {
+        // Local rotation, as in Rotate
+        State.Rotation = (State.Rotation * FQuat(Motors.BodyRates / Rate, Rate * DeltaTime)).GetNormalized();
+    }
+
+    FDroneFlightInput Input;
+    Input.Throttle01 = TotalThrust * 0.25f;
+    State.Location += Accelerate(Params, State.Rotation, Input, Wind, DeltaTime, State.Velocity, State.Battery01);
+}
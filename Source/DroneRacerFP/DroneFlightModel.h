@@ -0,0 +1,134 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Physical parameters of a drone, filled from ADroneFPCharacter's properties */
+struct FDroneFlightParams
+{
+    /** kg */
+    float Mass = .7f;
+
+    /** Lift at full throttle (N) */
+    float MaxLiftForce = 2800.f;
+
+    float DragCoeff = 1.f;
+
+    /** Rates (deg/s) at full stick */
+    float PitchRateDeg = 120.f;
+    float RollRateDeg = 120.f;
+    float YawRateDeg = 90.f;
+
+    /** Seconds of flight a full battery gives at full throttle */
+    float BatteryFullThrottleSeconds = 240.f;
+
+    /** An empty battery cuts the lift; otherwise it only drains, for the OSD */
+    bool bBatteryCutsLift = false;
+
+    /** Negative, cm/s^2 */
+    float GravityZ = -980.f;
+};
+
+/** Pilot input for one step */
+struct FDroneFlightInput
+{
+    /** 0..1 */
+    float Throttle01 = 0.f;
+
+    /** -1..+1 */
+    float Yaw = 0.f;
+    float Pitch = 0.f;
+    float Roll = 0.f;
+};
+
+/** Rigid-body state the model integrates */
+struct FDroneFlightState
+{
+    FVector Location = FVector::ZeroVector;
+    FQuat Rotation = FQuat::Identity;
+
+    /** cm/s */
+    FVector Velocity = FVector::ZeroVector;
+
+    float Battery01 = 1.f;
+};
+
+/**
+ * Motor response for flight controllers that command the four motors
+ * directly (see DroneSITLBridge.h). Motors are in Betaflight's Quad X order,
+ * props in: rear right (CW), front right (CCW), rear left (CCW), front left (CW).
+ */
+struct FDroneMotorParams
+{
+    /** Roll / pitch angular acceleration (deg/s^2) from one side's motors at full thrust, the other side stopped */
+    float RollPitchAccelDeg = 6000.f;
+
+    /** Yaw angular acceleration (deg/s^2) from the reaction torque of the CW or CCW pair at full thrust */
+    float YawAccelDeg = 1200.f;
+
+    /** Body rates decay at this rate (1/s) with balanced motors */
+    float AngularDamping = 1.f;
+
+    /** Spin-up / spin-down time constant of a motor (s) */
+    float MotorTimeConstant = 0.02f;
+};
+
+/** What the motor-driven model integrates on top of FDroneFlightState */
+struct FDroneMotorState
+{
+    /** Angular velocity (rad/s) about the drone's local axes, as FQuat axis times angle */
+    FVector BodyRates = FVector::ZeroVector;
+
+    /** Motor speeds 0..1 following the commands; thrust is speed squared */
+    float Spin01[4] = { 0.f, 0.f, 0.f, 0.f };
+};
+
+/**
+ * The drone flight model (DJI Mode 2 rates, lift along local up, gravity and
+ * linear drag against the air), free of actors and the world so the same code
+ * drives ADroneFPCharacter and headless simulations (see DroneTrainingEnv.h).
+ *
+ * Collisions are left to the caller: the character sweeps the returned
+ * displacement against the world.
+ */
+struct DRONERACERFP_API FDroneFlightModel
+{
+    /** Lift (N) at Throttle01 with Battery01 left */
+    static float GetLift(const FDroneFlightParams& Params, float Throttle01, float Battery01)
+    {
+        return Params.bBatteryCutsLift && Battery01 <= 0.f ? 0.f : Throttle01 * Params.MaxLiftForce;
+    }
+
+    /** Orientation after applying the stick rates for DeltaTime */
+    static FQuat Rotate(const FDroneFlightParams& Params, const FQuat& Rotation, const FDroneFlightInput& Input, float DeltaTime);
+
+    /**
+     * Integrates velocity and drains the battery for DeltaTime.
+     * Wind is the air velocity at the drone (cm/s). Returns the displacement of this step.
+     */
+    static FVector Accelerate(const FDroneFlightParams& Params, const FQuat& Rotation, const FDroneFlightInput& Input,
+        const FVector& Wind, float DeltaTime, FVector& InOutVelocity, float& InOutBattery01);
+
+    /** Rotate + Accelerate + move, without collision */
+    static void Step(const FDroneFlightParams& Params, FDroneFlightState& State, const FDroneFlightInput& Input,
+        const FVector& Wind, float DeltaTime)
+    {
+        State.Rotation = Rotate(Params, State.Rotation, Input, DeltaTime);
+        State.Location += Accelerate(Params, State.Rotation, Input, Wind, DeltaTime, State.Velocity, State.Battery01);
+    }
+
+    /**
+     * Same as NumSteps calls of Step with the same input and wind. With the
+     * sticks centred the attitude is constant and the steps are summed in
+     * closed form, O(1) whatever NumSteps is.
+     */
+    static void StepRepeated(const FDroneFlightParams& Params, FDroneFlightState& State, const FDroneFlightInput& Input,
+        const FVector& Wind, float DeltaTime, int32 NumSteps);
+
+    /**
+     * One step driven by motor commands (0..1) instead of stick rates: the
+     * motors' thrust differences turn the drone, their mean thrust lifts it
+     * like Throttle01 does in Accelerate.
+     */
+    static void StepMotors(const FDroneFlightParams& Params, const FDroneMotorParams& MotorParams, FDroneFlightState& State,
+        FDroneMotorState& Motors, const float (&Commands01)[4], const FVector& Wind, float DeltaTime);
+};
@@ -0,0 +1,144 @@
+#include "DroneFlightThread.h"
+#include "DroneRacerFP.h"
+
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
+
+bool FDroneFlightChannel::ReceiveLatest(FDroneFlightOutput& OutOutput)
+{
+    if (!Outputs.IsDirty())
+        return false;
+
+    Outputs.SwapReadBuffers();
+    OutOutput = Outputs.Read();
+    return true;
+}
+
+void FDroneFlightChannel::DequeueCommands()
+{
+    FDroneFlightCommand Command;
+    while (Commands.Dequeue(Command))
+    {
+        if (Command.Type == FDroneFlightCommand::EType::SetState)
+        {
+            Current.Version = Command.Version;
+            Current.State = Command.State;
+            Current.Params = Command.Params;
+            Simulated.State = Command.State;
+            Simulated.Version = Command.Version;
+            bHasState = true;
+        }
+        else
+        {
+            Current.Input = Command.Input;
+            Current.bArmed = Command.bArmed;
+            Current.Wind = Command.Wind;
+        }
+    }
+}
+
+FDroneFlightThread::FDroneFlightThread()
+{
+    Thread = FRunnableThread::Create(this, TEXT("DroneFlightThread"), 0, TPri_AboveNormal);
+}
+
+FDroneFlightThread::~FDroneFlightThread()
+{
+    if (Thread)
+    {
+        Thread->Kill(true);
+        delete Thread;
+        Thread = nullptr;
+    }
+}
+
+void FDroneFlightThread::AddChannel(const FDroneFlightChannelRef& Channel)
+{
+    FScopeLock Lock(&ChannelsLock);
+    Channels.AddUnique(Channel);
+}
+
+void FDroneFlightThread::RemoveChannel(const FDroneFlightChannelRef& Channel)
+{
+    FScopeLock Lock(&ChannelsLock);
+    Channels.Remove(Channel);
+}
+
+void FDroneFlightThread::AllowUntilNowPlusLead()
+{
+    AllowedUntil.store(FPlatformTime::Seconds() + MaxLeadSeconds, std::memory_order_relaxed);
+}
+
+void FDroneFlightThread::Stop()
+{
+    bStopping = true;
+}
+
+uint32 FDroneFlightThread::Run()
+{
+    double NextStepTime = FPlatformTime::Seconds();
+    while (!bStopping)
+    {
+        const double Now = FPlatformTime::Seconds();
+
+        // Held back: the game is paused or stalled for longer than the lead. Starts over from now when released.
+        const double Allowed = AllowedUntil.load(std::memory_order_relaxed);
+        if (Allowed < Now && NextStepTime > Allowed)
+        {
+            NextStepTime = Now;
+            FPlatformProcess::SleepNoStats(StepSeconds);
+            continue;
+        }
+
+        int32 NumSteps = 0;
+        while (NextStepTime <= Now && NumSteps < MaxCatchUpSteps)
+        {
+            NextStepTime += StepSeconds;
+            ++NumSteps;
+        }
+
+        // So far behind that catching up would only make it worse
+        if (NextStepTime <= Now)
+        {
+            NextStepTime = Now;
+        }
+
+        if (NumSteps > 0)
+        {
+            StepChannels(NumSteps);
+        }
+
+        // Sleep most of the wait, the scheduler may oversleep a little; the next loop catches up
+        const double Wait = NextStepTime - FPlatformTime::Seconds();
+        FPlatformProcess::SleepNoStats(Wait > 0.0005 ? float(Wait - 0.0003) : 0.f);
+    }
+    return 0;
+}
+
+void FDroneFlightThread::StepChannels(int32 NumSteps)
+{
+    DRONERACER_SCOPED_STAT(FlightThread);
+
+    FScopeLock Lock(&ChannelsLock);
+    for (const FDroneFlightChannelRef& Channel : Channels)
+    {
+        FDroneFlightChannel& C = *Channel;
+        for (int32 Step = 0; Step < NumSteps; ++Step)
+        {
+            // Commands take effect at the step they arrive before
+            C.DequeueCommands();
+
+            if (C.bHasState && C.Current.bArmed)
+            {
+                FDroneFlightModel::Step(C.Current.Params, C.Simulated.State, C.Current.Input, C.Current.Wind, StepSeconds);
+                ++C.Simulated.NumSteps;
+            }
+        }
+
+        if (C.bHasState)
+        {
+            C.Outputs.Write(C.Simulated);
+        }
+    }
+}
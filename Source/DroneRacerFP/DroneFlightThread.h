@@ -0,0 +1,132 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/CircularQueue.h"
+#include "Containers/TripleBuffer.h"
+#include "HAL/Runnable.h"
+#include "HAL/CriticalSection.h"
+#include "DroneFlightModel.h"
+#include <atomic>
+
+/** Game thread -> flight thread */
+struct FDroneFlightCommand
+{
+    enum class EType : uint8
+    {
+        /** Sticks, arming and the wind at the drone, held until the next one */
+        Input,
+
+        /** Replaces the simulated state (spawn, collision response, rewind) */
+        SetState,
+    };
+
+    EType Type = EType::Input;
+
+    FDroneFlightInput Input;
+    bool bArmed = false;
+
+    /** cm/s */
+    FVector Wind = FVector::ZeroVector;
+
+    // SetState only
+    uint32 Version = 0;
+    FDroneFlightState State;
+    FDroneFlightParams Params;
+};
+
+/** Flight thread -> game thread */
+struct FDroneFlightOutput
+{
+    FDroneFlightState State;
+
+    /** Version of the last SetState the state follows from */
+    uint32 Version = 0;
+
+    /** Steps simulated since the drone was added */
+    uint64 NumSteps = 0;
+
+    /** Motor speeds 0..1 when a flight controller drives the drone (FDroneSITLBridge) */
+    float Motors01[4] = { 0.f, 0.f, 0.f, 0.f };
+    bool bHasMotors = false;
+};
+
+/**
+ * One drone's connection to FDroneFlightThread. Commands go through a
+ * single-producer single-consumer ring and states come back through a
+ * triple buffer, so neither thread ever blocks the other.
+ */
+class FDroneFlightChannel
+{
+public:
+    FDroneFlightChannel() : Commands(CommandCapacity) {}
+
+    /** Game thread; false if the flight thread fell CommandCapacity commands behind */
+    bool Send(const FDroneFlightCommand& Command) { return Commands.Enqueue(Command); }
+
+    /** Game thread; the newest state, false if none was published since the last call */
+    bool ReceiveLatest(FDroneFlightOutput& OutOutput);
+
+private:
+    friend class FDroneFlightThread;
+    friend class FDroneSITLBridge;
+
+    static constexpr uint32 CommandCapacity = 64;
+
+    /** Simulating thread: applies the commands that arrived since the last step */
+    void DequeueCommands();
+
+    TCircularQueue<FDroneFlightCommand> Commands;
+    TTripleBuffer<FDroneFlightOutput> Outputs;
+
+    // Flight thread only
+    FDroneFlightCommand Current;
+    FDroneFlightOutput Simulated;
+    bool bHasState = false;
+};
+
+using FDroneFlightChannelRef = TSharedRef<FDroneFlightChannel, ESPMode::ThreadSafe>;
+
+/**
+ * Runs FDroneFlightModel for every added drone at a fixed StepHz on its own
+ * thread, so game thread hitches don't change how the drones fly.
+ *
+ * The thread follows the wall clock but never runs more than MaxLeadSeconds
+ * past the last AllowUntilNowPlusLead from the game thread: a game thread
+ * spike up to that long doesn't stop the drones, a paused game does.
+ */
+class DRONERACERFP_API FDroneFlightThread : public FRunnable
+{
+public:
+    static constexpr int32 StepHz = 1000;
+    static constexpr float StepSeconds = 1.f / StepHz;
+    static constexpr double MaxLeadSeconds = 0.1;
+
+    /** Steps run at most to catch up at once; further behind, the time is dropped */
+    static constexpr int32 MaxCatchUpSteps = 20;
+
+    FDroneFlightThread();
+    virtual ~FDroneFlightThread();
+
+    void AddChannel(const FDroneFlightChannelRef& Channel);
+    void RemoveChannel(const FDroneFlightChannelRef& Channel);
+
+    /** Game thread, every frame the world isn't paused: lets the thread simulate MaxLeadSeconds past now */
+    void AllowUntilNowPlusLead();
+
+    // FRunnable
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    void StepChannels(int32 NumSteps);
+
+    FRunnableThread* Thread = nullptr;
+    std::atomic<bool> bStopping { false };
+
+    /** FPlatformTime::Seconds the thread may simulate up to */
+    std::atomic<double> AllowedUntil { 0.0 };
+
+    /** Only contended while a drone is added or removed */
+    FCriticalSection ChannelsLock;
+    TArray<FDroneFlightChannelRef> Channels;
+};
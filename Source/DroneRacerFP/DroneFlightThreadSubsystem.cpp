@@ -0,0 +1,49 @@
+#include "DroneFlightThreadSubsystem.h"
+
+FDroneFlightChannelRef UDroneFlightThreadSubsystem::AddDrone()
+{
+    if (!FlightThread)
+    {
+        FlightThread = MakeUnique<FDroneFlightThread>();
+        FlightThread->AllowUntilNowPlusLead();
+        UE_LOG(LogTemp, Log, TEXT("DroneFlightThread: started at %d Hz"), FDroneFlightThread::StepHz);
+    }
+
+    FDroneFlightChannelRef Channel = MakeShared<FDroneFlightChannel, ESPMode::ThreadSafe>();
+    FlightThread->AddChannel(Channel);
+    return Channel;
+}
+
+void UDroneFlightThreadSubsystem::RemoveDrone(const FDroneFlightChannelRef& Channel)
+{
+    if (FlightThread)
+    {
+        FlightThread->RemoveChannel(Channel);
+    }
+}
+
+bool UDroneFlightThreadSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UDroneFlightThreadSubsystem::Deinitialize()
+{
+    // Waits for the thread to finish its steps
+    FlightThread.Reset();
+
+    Super::Deinitialize();
+}
+
+void UDroneFlightThreadSubsystem::Tick(float DeltaTime)
+{
+    if (FlightThread)
+    {
+        FlightThread->AllowUntilNowPlusLead();
+    }
+}
+
+TStatId UDroneFlightThreadSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UDroneFlightThreadSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DroneFlightThread.h"
+#include "DroneFlightThreadSubsystem.generated.h"
+
+/**
+ * Owns the world's FDroneFlightThread, started when the first drone with
+ * bThreadedFlight is added and stopped with the world. Ticks only while the
+ * game isn't paused, which is what keeps the flight thread running.
+ */
+UCLASS()
+class DRONERACERFP_API UDroneFlightThreadSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    /** Returns the channel to send the drone's commands through */
+    FDroneFlightChannelRef AddDrone();
+    void RemoveDrone(const FDroneFlightChannelRef& Channel);
+
+    // UWorldSubsystem
+    virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+    virtual void Deinitialize() override;
+
+    // UTickableWorldSubsystem
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+private:
+    TUniquePtr<FDroneFlightThread> FlightThread;
+};
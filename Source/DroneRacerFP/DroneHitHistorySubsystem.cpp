@@ -0,0 +1,191 @@
+#include "DroneHitHistorySubsystem.h"
+#include "DroneFPCharacter.h"
+#include "DroneRacerFP.h"
+
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+
+namespace DroneHitHistory
+{
+    /** Distance along Start + Dir * t to where the ray enters the sphere, false if it misses within MaxDistance */
+    bool RaySphere(const FVector& Start, const FVector& Dir, float MaxDistance, const FVector& Center, float Radius, float& OutDistance)
+    {
+        const FVector M = Start - Center;
+        const double B = FVector::DotProduct(M, Dir);
+        const double C = M.SizeSquared() - double(Radius) * Radius;
+
+        // Outside and pointing away
+        if (C > 0.0 && B > 0.0)
+            return false;
+
+        const double Discriminant = B * B - C;
+        if (Discriminant < 0.0)
+            return false;
+
+        // Starting inside counts as a hit at the muzzle
+        const double Distance = FMath::Max(-B - FMath::Sqrt(Discriminant), 0.0);
+        if (Distance > MaxDistance)
+            return false;
+
+        OutDistance = float(Distance);
+        return true;
+    }
+}
+
+bool UDroneHitHistorySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+int32 UDroneHitHistorySubsystem::RegisterDrone(ADroneFPCharacter* Drone)
+{
+    if (!Drone || RegisteredMask == MAX_uint32)
+        return INDEX_NONE;
+
+    const int32 Slot = FMath::CountTrailingZeros(~RegisteredMask);
+    RegisteredMask |= 1u << Slot;
+    Drones[Slot] = Drone;
+    Radii[Slot] = Drone->GetCapsuleComponent()->GetScaledCapsuleRadius();
+    return Slot;
+}
+
+void UDroneHitHistorySubsystem::UnregisterDrone(int32 Slot)
+{
+    if (Slot >= 0 && Slot < MaxDrones)
+    {
+        RegisteredMask &= ~(1u << Slot);
+        Drones[Slot] = nullptr;
+    }
+}
+
+void UDroneHitHistorySubsystem::Tick(float DeltaTime)
+{
+    if (GetWorld()->GetNetMode() == NM_Client)
+        return;
+
+    const double Now = GetWorld()->GetTimeSeconds();
+    if (NewestFrame != INDEX_NONE && Now - Frames[NewestFrame].Time < MinFrameInterval)
+        return;
+
+    NewestFrame = (NewestFrame + 1) % NumFrames;
+    NumRecorded = FMath::Min(NumRecorded + 1, NumFrames);
+
+    FFrame& Frame = Frames[NewestFrame];
+    Frame.Time = Now;
+    Frame.ValidMask = 0;
+
+    for (uint32 Mask = RegisteredMask; Mask != 0; Mask &= Mask - 1)
+    {
+        const int32 Slot = FMath::CountTrailingZeros(Mask);
+        const ADroneFPCharacter* Drone = Drones[Slot].Get();
+        if (Drone && Drone->GetHealth() > 0.f)
+        {
+            Frame.Locations[Slot] = Drone->GetActorLocation();
+            Frame.ValidMask |= 1u << Slot;
+        }
+    }
+}
+
+bool UDroneHitHistorySubsystem::FindFrames(double ViewTime, const FFrame*& OutOlder, const FFrame*& OutNewer, float& OutAlpha) const
+{
+    if (NumRecorded == 0)
+        return false;
+
+    const FFrame& Newest = Frames[NewestFrame];
+    ViewTime = FMath::Max(ViewTime, Newest.Time - MaxRewindSeconds);
+
+    OutNewer = &Newest;
+    OutOlder = &Newest;
+    OutAlpha = 1.f;
+    if (ViewTime >= Newest.Time)
+        return true;
+
+    // Walk back to the first frame at or before ViewTime
+    for (int32 Age = 1; Age < NumRecorded; ++Age)
+    {
+        const FFrame& Frame = Frames[(NewestFrame - Age + NumFrames) % NumFrames];
+        OutOlder = &Frame;
+        if (Frame.Time <= ViewTime)
+        {
+            const double Span = OutNewer->Time - Frame.Time;
+            OutAlpha = Span > 0.0 ? float((ViewTime - Frame.Time) / Span) : 1.f;
+            return true;
+        }
+        OutNewer = &Frame;
+    }
+
+    // Older than the history, use the oldest frame
+    OutAlpha = 0.f;
+    return true;
+}
+
+bool UDroneHitHistorySubsystem::LocationAt(const FFrame& Older, const FFrame& Newer, float Alpha, int32 Slot, FVector& OutLocation)
+{
+    const uint32 Bit = 1u << Slot;
+    const bool bInOlder = (Older.ValidMask & Bit) != 0;
+    const bool bInNewer = (Newer.ValidMask & Bit) != 0;
+
+    if (bInOlder && bInNewer)
+    {
+        OutLocation = FMath::Lerp(Older.Locations[Slot], Newer.Locations[Slot], double(Alpha));
+        return true;
+    }
+    if (bInOlder || bInNewer)
+    {
+        OutLocation = bInOlder ? Older.Locations[Slot] : Newer.Locations[Slot];
+        return true;
+    }
+    return false;
+}
+
+bool UDroneHitHistorySubsystem::GetDroneLocationAtTime(int32 Slot, double ViewTime, FVector& OutLocation) const
+{
+    const FFrame* Older;
+    const FFrame* Newer;
+    float Alpha;
+    return Slot >= 0 && Slot < MaxDrones && FindFrames(ViewTime, Older, Newer, Alpha)
+        && LocationAt(*Older, *Newer, Alpha, Slot, OutLocation);
+}
+
+bool UDroneHitHistorySubsystem::TraceAtTime(const FVector& Start, const FVector& End, double ViewTime, const AActor* IgnoredActor,
+    FDroneRewindHit& OutHit) const
+{
+    DRONERACER_SCOPED_STAT(LagCompTrace);
+
+    const FFrame* Older;
+    const FFrame* Newer;
+    float Alpha;
+    if (!FindFrames(ViewTime, Older, Newer, Alpha))
+        return false;
+
+    FVector Dir;
+    float Length;
+    (End - Start).ToDirectionAndLength(Dir, Length);
+
+    OutHit = FDroneRewindHit();
+    OutHit.Distance = Length;
+    for (uint32 Mask = (Older->ValidMask | Newer->ValidMask) & RegisteredMask; Mask != 0; Mask &= Mask - 1)
+    {
+        const int32 Slot = FMath::CountTrailingZeros(Mask);
+        ADroneFPCharacter* Drone = Drones[Slot].Get();
+        if (!Drone || Drone == IgnoredActor)
+            continue;
+
+        FVector Center;
+        float Distance;
+        if (LocationAt(*Older, *Newer, Alpha, Slot, Center)
+            && DroneHitHistory::RaySphere(Start, Dir, OutHit.Distance, Center, Radii[Slot], Distance))
+        {
+            OutHit.Drone = Drone;
+            OutHit.Distance = Distance;
+            OutHit.Location = Start + Dir * Distance;
+        }
+    }
+
+    return OutHit.Drone != nullptr;
+}
+
+TStatId UDroneHitHistorySubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UDroneHitHistorySubsystem, STATGROUP_Tickables);
+}
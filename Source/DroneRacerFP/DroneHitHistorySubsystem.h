@@ -0,0 +1,89 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StaticArray.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DroneHitHistorySubsystem.generated.h"
+
+class ADroneFPCharacter;
+
+struct FDroneRewindHit
+{
+    ADroneFPCharacter* Drone = nullptr;
+    FVector Location = FVector::ZeroVector;
+
+    /** Along the traced segment (cm) */
+    float Distance = 0.f;
+};
+
+/**
+ * Server-side history of drone hit volumes for lag-compensated hits.
+ *
+ * Every frame the server records where each registered drone is (a
+ * client's drone where its last state report put it) into a fixed ring of NumFrames frames, at most one per MinFrameInterval, which
+ * covers a little over MaxRewindSeconds. A shot is then traced against the
+ * drones as they were at the shooter's view time, interpolated between the
+ * two frames around it. Hit volumes are spheres of the drone's capsule
+ * radius. Everything is sized up front for MaxDrones, so recording and
+ * tracing don't allocate.
+ *
+ * Records on the server (and in standalone games) only; clients never trace.
+ */
+UCLASS()
+class DRONERACERFP_API UDroneHitHistorySubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    static constexpr int32 MaxDrones = 32;
+    static constexpr int32 NumFrames = 64;
+    static constexpr double MinFrameInterval = 1.0 / 120.0;
+    static constexpr float MaxRewindSeconds = 0.5f;
+
+    /** Returns the drone's slot, INDEX_NONE if all MaxDrones are taken */
+    int32 RegisterDrone(ADroneFPCharacter* Drone);
+    void UnregisterDrone(int32 Slot);
+
+    /**
+     * Closest drone the segment Start -> End hits, with drones where they
+     * were at ViewTime (world seconds, clamped to the recorded history).
+     */
+    bool TraceAtTime(const FVector& Start, const FVector& End, double ViewTime, const AActor* IgnoredActor,
+        FDroneRewindHit& OutHit) const;
+
+    /** Where the drone in Slot was at ViewTime */
+    bool GetDroneLocationAtTime(int32 Slot, double ViewTime, FVector& OutLocation) const;
+
+    float GetDroneRadius(int32 Slot) const { return Radii[Slot]; }
+
+    // UWorldSubsystem
+    virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+    // UTickableWorldSubsystem
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+private:
+    struct FFrame
+    {
+        double Time = 0.0;
+
+        /** Bit per slot, set if the drone was alive and registered */
+        uint32 ValidMask = 0;
+
+        TStaticArray<FVector, MaxDrones> Locations;
+    };
+
+    /** Newer and older frame around ViewTime and the blend toward the newer one */
+    bool FindFrames(double ViewTime, const FFrame*& OutOlder, const FFrame*& OutNewer, float& OutAlpha) const;
+
+    static bool LocationAt(const FFrame& Older, const FFrame& Newer, float Alpha, int32 Slot, FVector& OutLocation);
+
+    TStaticArray<FFrame, NumFrames> Frames;
+    int32 NewestFrame = INDEX_NONE;
+    int32 NumRecorded = 0;
+
+    TStaticArray<TWeakObjectPtr<ADroneFPCharacter>, MaxDrones> Drones;
+    TStaticArray<float, MaxDrones> Radii;
+    uint32 RegisteredMask = 0;
+};
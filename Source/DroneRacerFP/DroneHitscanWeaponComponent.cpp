@@ -0,0 +1,114 @@
+#include "DroneHitscanWeaponComponent.h"
+#include "DroneFPCharacter.h"
+#include "DroneHitHistorySubsystem.h"
+
+#include "DrawDebugHelpers.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<bool> CVarLagCompensation(
+    TEXT("DroneRacer.LagCompensation"),
+    true,
+    TEXT("Resolve drone shots against where the shooter saw the targets (0: where they are on the server now)"));
+
+static TAutoConsoleVariable<bool> CVarLagCompensationDebug(
+    TEXT("DroneRacer.LagCompensation.Debug"),
+    false,
+    TEXT("Draw every shot and the rewound target volumes on the server"));
+
+UDroneHitscanWeaponComponent::UDroneHitscanWeaponComponent()
+{
+    SetIsReplicatedByDefault(true);
+}
+
+void UDroneHitscanWeaponComponent::Fire()
+{
+    const APawn* Pawn = Cast<APawn>(GetOwner());
+    if (!Pawn || !Pawn->IsLocallyControlled())
+        return;
+
+    const double Now = GetWorld()->GetTimeSeconds();
+    if (LastFireTime >= 0.0 && Now - LastFireTime < FireIntervalSeconds)
+        return;
+    LastFireTime = Now;
+
+    const FVector Start = Pawn->GetActorLocation();
+    const FVector Direction = Pawn->GetActorForwardVector();
+    if (Pawn->HasAuthority())
+    {
+        ResolveShot(Start, Direction);
+    }
+    else
+    {
+        ServerFire(Start, Direction);
+    }
+}
+
+void UDroneHitscanWeaponComponent::ServerFire_Implementation(FVector_NetQuantize Start, FVector_NetQuantizeNormal Direction)
+{
+    // Network jitter may bunch shots up a little
+    const double Now = GetWorld()->GetTimeSeconds();
+    if (LastServerFireTime >= 0.0 && Now - LastServerFireTime < FireIntervalSeconds * 0.5f)
+        return;
+    LastServerFireTime = Now;
+
+    ResolveShot(Start, Direction.GetSafeNormal());
+}
+
+void UDroneHitscanWeaponComponent::ResolveShot(const FVector& Start, const FVector& Direction)
+{
+    UWorld* World = GetWorld();
+    const APawn* Shooter = Cast<APawn>(GetOwner());
+    UDroneHitHistorySubsystem* HitHistory = World->GetSubsystem<UDroneHitHistorySubsystem>();
+    if (!Shooter || !HitHistory || Direction.IsNearlyZero())
+        return;
+
+    if (FVector::DistSquared(Start, Shooter->GetActorLocation()) > FMath::Square(MaxMuzzleError))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("DroneHitscanWeapon: %s fired from too far away, shot ignored"), *Shooter->GetName());
+        return;
+    }
+
+    // Static world as it is now; it doesn't move
+    FVector End = Start + Direction * Range;
+    FHitResult WorldHit;
+    FCollisionQueryParams Params(SCENE_QUERY_STAT(DroneHitscan), false, Shooter);
+    if (World->LineTraceSingleByObjectType(WorldHit, Start, End, FCollisionObjectQueryParams(ECC_WorldStatic), Params))
+    {
+        End = WorldHit.Location;
+    }
+
+    // The shooter saw other drones as this server had them a round trip ago, plus the wait for their replication
+    double ViewTime = World->GetTimeSeconds();
+    const APlayerState* PlayerState = Shooter->GetPlayerState();
+    if (CVarLagCompensation.GetValueOnGameThread() && PlayerState && !Shooter->IsLocallyControlled())
+    {
+        ViewTime -= FMath::Min(PlayerState->ExactPing * 0.001f + ReplicationDelaySeconds, UDroneHitHistorySubsystem::MaxRewindSeconds);
+    }
+
+    FDroneRewindHit Hit;
+    const bool bHit = HitHistory->TraceAtTime(Start, End, ViewTime, Shooter, Hit);
+
+    if (CVarLagCompensationDebug.GetValueOnGameThread())
+    {
+        DrawDebugLine(World, Start, bHit ? Hit.Location : End, bHit ? FColor::Red : FColor::White, false, 1.f);
+        for (int32 Slot = 0; Slot < UDroneHitHistorySubsystem::MaxDrones; ++Slot)
+        {
+            FVector Rewound;
+            if (HitHistory->GetDroneLocationAtTime(Slot, ViewTime, Rewound))
+            {
+                DrawDebugSphere(World, Rewound, HitHistory->GetDroneRadius(Slot), 8, FColor::Yellow, false, 1.f);
+            }
+        }
+    }
+
+    if (bHit)
+    {
+        UE_LOG(LogTemp, Log, TEXT("DroneHitscanWeapon: %s hit %s (rewound %.0f ms)"),
+            *Shooter->GetName(), *Hit.Drone->GetName(), (World->GetTimeSeconds() - ViewTime) * 1000.0);
+
+        Hit.Drone->ApplyWeaponHit(Damage);
+        OnHit.Broadcast(Hit.Drone, Hit.Location);
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Engine/NetSerialization.h"
+#include "DroneHitscanWeaponComponent.generated.h"
+
+class ADroneFPCharacter;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnDroneShotHit, ADroneFPCharacter*, Target, FVector, Location);
+
+/**
+ * Drone combat weapon: an instant shot along the drone's nose, resolved on
+ * the server with lag compensation.
+ *
+ * The owning client sends where it fired from and in which direction. The
+ * server traces the static world as it is now, then the other drones as the
+ * shooter saw them: rewound by the shooter's round trip time plus
+ * ReplicationDelaySeconds (see UDroneHitHistorySubsystem). The server's
+ * drones follow the states their clients report (ADroneFPCharacter::
+ * IsNetDriven), so the history holds where each drone really flew. Hits go
+ * through ADroneFPCharacter::ApplyWeaponHit, which damages the drone on the
+ * client flying it.
+ *
+ * To try it on one machine, play in editor with two clients (net mode Play
+ * As Client), add latency with "NetEmulation.PktLag 150", and compare
+ * against "DroneRacer.LagCompensation 0". "DroneRacer.LagCompensation.Debug 1"
+ * draws the rewound hit volumes of every shot on the server.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class DRONERACERFP_API UDroneHitscanWeaponComponent : public UActorComponent
+{
+    GENERATED_BODY()
+
+public:
+    UDroneHitscanWeaponComponent();
+
+    /** Fires if the owner is locally controlled and the weapon is ready */
+    UFUNCTION(BlueprintCallable, Category = "Weapon")
+    void Fire();
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon")
+    float Damage = 20.f;
+
+    /** cm */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon")
+    float Range = 10000.f;
+
+    /** Minimum time between shots, also enforced by the server */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon", meta = (ClampMin = "0.01"))
+    float FireIntervalSeconds = 0.15f;
+
+    /** How long the server's drone states wait for replication on average, on top of the round trip (half the drones' net update interval) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon|Network")
+    float ReplicationDelaySeconds = 0.005f;
+
+    /** Shots starting further than this from the shooter's server position are rejected (cm) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon|Network")
+    float MaxMuzzleError = 300.f;
+
+    /** Broadcast on the server for every hit */
+    UPROPERTY(BlueprintAssignable, Category = "Weapon")
+    FOnDroneShotHit OnHit;
+
+private:
+    UFUNCTION(Server, Unreliable)
+    void ServerFire(FVector_NetQuantize Start, FVector_NetQuantizeNormal Direction);
+
+    void ResolveShot(const FVector& Start, const FVector& Direction);
+
+    double LastFireTime = -1.0;
+    double LastServerFireTime = -1.0;
+};
@@ -0,0 +1,125 @@
+#include "DroneMotorSynth.h"
+#include "DroneRacerFP.h"
+
+void FDroneMotorSynth::Init(float InSampleRate, const FDroneMotorSynthSettings& InSettings, uint32 InNoiseSeed)
+{
+    Settings = InSettings;
+    Settings.NumBlades = FMath::Max(Settings.NumBlades, 1);
+    SampleRate = FMath::Max(InSampleRate, 1.f);
+
+    const float BlockSeconds = BlockFrames / SampleRate;
+    SpoolAlpha = 1.f - FMath::Exp(-BlockSeconds / FMath::Max(Settings.SpoolSeconds, BlockSeconds));
+    InvFullVolumeRPM = 1.f / FMath::Max(Settings.FullVolumeRPM, 1.f);
+    NoiseAlpha = 1.f - FMath::Exp(-UE_TWO_PI * Settings.NoiseCutoffHz / SampleRate);
+
+    // Normalized so all harmonics of four motors at once stay within [-1, 1]
+    float GainSum = 0.f;
+    for (int32 Harmonic = 0; Harmonic < NumHarmonics; ++Harmonic)
+    {
+        HarmonicGains[Harmonic] = 1.f / FMath::Pow(float(Harmonic + 1), Settings.HarmonicFalloff);
+        GainSum += HarmonicGains[Harmonic];
+    }
+    for (float& Gain : HarmonicGains)
+    {
+        Gain /= GainSum * 4.f;
+    }
+
+    // Motors start out of phase with each other, as real ones are
+    PhasorCos = MakeVectorRegister(1.f, 0.f, -1.f, 0.f);
+    PhasorSin = MakeVectorRegister(0.f, 1.f, 0.f, -1.f);
+    CurrentRPM = VectorZeroFloat();
+    CurrentToneGain = 0.f;
+    CurrentNoiseGain = 0.f;
+    NoiseState = 0.f;
+    NoiseSeed = InNoiseSeed ? InNoiseSeed : 1;
+}
+
+void FDroneMotorSynth::Render(const FDroneMotorSynthParams& Params, float* Out, int32 NumFrames)
+{
+    DRONERACER_SCOPED_STAT(MotorSynth);
+
+    const VectorRegister4Float TargetRPM = VectorLoad(Params.MotorRPM);
+    const VectorRegister4Float SpoolAlphaV = VectorSetFloat1(SpoolAlpha);
+
+    // RPM -> radians per sample of the blade pass frequency
+    const VectorRegister4Float RPMToStep = VectorSetFloat1(
+        Params.PitchScale * Settings.NumBlades / 60.f * UE_TWO_PI / SampleRate);
+
+    const float TargetToneGain = Params.Gain;
+    const float TargetNoiseGain = Params.Gain * Settings.NoiseLevel * FMath::Clamp(Params.Throttle01, 0.f, 1.f);
+    const VectorRegister4Float InvFullVolumeRPMV = VectorSetFloat1(InvFullVolumeRPM);
+
+    VectorRegister4Float HarmonicGainsV[NumHarmonics];
+    for (int32 Harmonic = 0; Harmonic < NumHarmonics; ++Harmonic)
+    {
+        HarmonicGainsV[Harmonic] = VectorSetFloat1(HarmonicGains[Harmonic]);
+    }
+    const VectorRegister4Float Two = VectorSetFloat1(2.f);
+    const VectorRegister4Float Half = VectorSetFloat1(0.5f);
+    const VectorRegister4Float Three = VectorSetFloat1(3.f);
+    const VectorRegister4Float One = VectorSetFloat1(1.f);
+
+    for (int32 BlockStart = 0; BlockStart < NumFrames; BlockStart += BlockFrames)
+    {
+        const int32 BlockEnd = FMath::Min(BlockStart + BlockFrames, NumFrames);
+
+        // Motors spool toward their targets
+        CurrentRPM = VectorMultiplyAdd(VectorSubtract(TargetRPM, CurrentRPM), SpoolAlphaV, CurrentRPM);
+        const VectorRegister4Float StepAngle = VectorMultiply(CurrentRPM, RPMToStep);
+        VectorRegister4Float StepSin, StepCos;
+        VectorSinCos(&StepSin, &StepCos, &StepAngle);
+
+        // Louder with speed; a stopped motor is silent
+        const VectorRegister4Float MotorLevel = VectorMin(VectorMultiply(CurrentRPM, InvFullVolumeRPMV), One);
+
+        // Rounding makes the phasors drift off the unit circle; one Newton step per block pulls them back
+        const VectorRegister4Float LengthSquared = VectorMultiplyAdd(PhasorCos, PhasorCos, VectorMultiply(PhasorSin, PhasorSin));
+        const VectorRegister4Float Correction = VectorMultiply(Half, VectorSubtract(Three, LengthSquared));
+        PhasorCos = VectorMultiply(PhasorCos, Correction);
+        PhasorSin = VectorMultiply(PhasorSin, Correction);
+
+        // Loudness is ramped over the block, not stepped, so it doesn't click
+        const float ToneGainStart = CurrentToneGain;
+        const float NoiseGainStart = CurrentNoiseGain;
+        CurrentToneGain += (TargetToneGain - CurrentToneGain) * SpoolAlpha;
+        CurrentNoiseGain += (TargetNoiseGain - CurrentNoiseGain) * SpoolAlpha;
+        const float RampStep = 1.f / float(BlockEnd - BlockStart);
+
+        for (int32 Frame = BlockStart; Frame < BlockEnd; ++Frame)
+        {
+            // Advance every motor's phasor by its step
+            const VectorRegister4Float NextCos = VectorNegateMultiplyAdd(PhasorSin, StepSin, VectorMultiply(PhasorCos, StepCos));
+            PhasorSin = VectorMultiplyAdd(PhasorCos, StepSin, VectorMultiply(PhasorSin, StepCos));
+            PhasorCos = NextCos;
+
+            // Harmonic stack by recurrence
+            const VectorRegister4Float TwoCos = VectorMultiply(Two, PhasorCos);
+            VectorRegister4Float Previous = VectorZeroFloat();
+            VectorRegister4Float Current = PhasorSin;
+            VectorRegister4Float Sum = VectorMultiply(Current, HarmonicGainsV[0]);
+            for (int32 Harmonic = 1; Harmonic < NumHarmonics; ++Harmonic)
+            {
+                const VectorRegister4Float Next = VectorSubtract(VectorMultiply(TwoCos, Current), Previous);
+                Previous = Current;
+                Current = Next;
+                Sum = VectorMultiplyAdd(Current, HarmonicGainsV[Harmonic], Sum);
+            }
+
+            alignas(16) float Lanes[4];
+            VectorStoreAligned(VectorMultiply(Sum, MotorLevel), Lanes);
+            const float Tone = (Lanes[0] + Lanes[1]) + (Lanes[2] + Lanes[3]);
+
+            // Prop wash: xorshift white noise through a one-pole low pass
+            NoiseSeed ^= NoiseSeed << 13;
+            NoiseSeed ^= NoiseSeed >> 17;
+            NoiseSeed ^= NoiseSeed << 5;
+            const float White = float(NoiseSeed) * (2.f / 4294967295.f) - 1.f;
+            NoiseState += (White - NoiseState) * NoiseAlpha;
+
+            const float Ramp = (Frame - BlockStart + 1) * RampStep;
+            const float ToneGain = ToneGainStart + (CurrentToneGain - ToneGainStart) * Ramp;
+            const float NoiseGain = NoiseGainStart + (CurrentNoiseGain - NoiseGainStart) * Ramp;
+            Out[Frame] = Tone * ToneGain + NoiseState * NoiseGain;
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/VectorRegister.h"
+
+/** What the motor synth renders, set from the game thread once per frame */
+struct FDroneMotorSynthParams
+{
+    /** Target speed of each motor; the synth spools toward it */
+    float MotorRPM[4] = { 0.f, 0.f, 0.f, 0.f };
+
+    /** 0..1, scales the prop wash noise */
+    float Throttle01 = 0.f;
+
+    /** Doppler shift applied to every frequency (1: none) */
+    float PitchScale = 1.f;
+
+    /** Linear output gain */
+    float Gain = 1.f;
+};
+
+/** Sound of the motors and props, fixed for the life of a synth */
+struct FDroneMotorSynthSettings
+{
+    /** Props have this many blades; the fundamental is the blade pass frequency */
+    int32 NumBlades = 3;
+
+    /** Amplitude of harmonic k is 1 / k^HarmonicFalloff */
+    float HarmonicFalloff = 1.2f;
+
+    /** Motors get louder with speed up to this RPM */
+    float FullVolumeRPM = 25000.f;
+
+    /** Time constant of a motor reaching a new speed (s) */
+    float SpoolSeconds = 0.04f;
+
+    /** Prop wash noise relative to the tones at full throttle */
+    float NoiseLevel = 0.25f;
+
+    /** Cutoff of the prop wash noise (Hz) */
+    float NoiseCutoffHz = 2500.f;
+};
+
+/**
+ * Procedural FPV motor sound: for each of the four motors a stack of
+ * NumHarmonics harmonics over its blade pass frequency, plus low-passed
+ * noise for the prop wash, rendered into a mono buffer.
+ *
+ * The four motors are the four lanes of one SIMD register. Each motor runs
+ * a rotating phasor (no sin per sample); its harmonics come from the
+ * Chebyshev recurrence sin((k+1)x) = 2 cos(x) sin(kx) - sin((k-1)x). Speed,
+ * Doppler and loudness are updated every BlockFrames frames, with the motor
+ * speeds following their targets over SpoolSeconds.
+ *
+ * No engine audio dependencies, so it renders the same in a synth component
+ * on the audio render thread and offline (see UDroneMotorSynthCommandlet).
+ * Render doesn't allocate or lock.
+ */
+class DRONERACERFP_API FDroneMotorSynth
+{
+public:
+    static constexpr int32 NumHarmonics = 6;
+
+    /** Frames between parameter updates */
+    static constexpr int32 BlockFrames = 16;
+
+    void Init(float InSampleRate, const FDroneMotorSynthSettings& InSettings, uint32 NoiseSeed);
+
+    /** Writes NumFrames mono samples to Out */
+    void Render(const FDroneMotorSynthParams& Params, float* Out, int32 NumFrames);
+
+private:
+    FDroneMotorSynthSettings Settings;
+    float SampleRate = 48000.f;
+
+    /** Per-block smoothing factor of the motor speeds */
+    float SpoolAlpha = 1.f;
+
+    float InvFullVolumeRPM = 0.f;
+
+    /** Per-sample factor of the one-pole noise filter */
+    float NoiseAlpha = 1.f;
+
+    float HarmonicGains[NumHarmonics] = {};
+
+    /** Phasor (cos, sin) of each motor's blade pass frequency */
+    VectorRegister4Float PhasorCos;
+    VectorRegister4Float PhasorSin;
+
+    VectorRegister4Float CurrentRPM;
+
+    /** Loudness at the end of the last block, ramped from within the next */
+    float CurrentToneGain = 0.f;
+    float CurrentNoiseGain = 0.f;
+
+    float NoiseState = 0.f;
+    uint32 NoiseSeed = 1;
+};
@@ -0,0 +1,147 @@
+#include "DroneMotorSynthCommandlet.h"
+#include "DroneMotorSynth.h"
+
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace DroneMotorSynthCommandlet
+{
+    void WriteWav(const TArray<float>& Samples, int32 SampleRate, const FString& Path)
+    {
+        TArray<uint8> Wav;
+        FMemoryWriter Writer(Wav);
+
+        auto WriteTag = [&Writer](const char* Tag)
+        {
+            Writer.Serialize(const_cast<char*>(Tag), 4);
+        };
+
+        uint32 DataBytes = Samples.Num() * sizeof(int16);
+        uint32 RiffBytes = 36 + DataBytes;
+        uint32 FormatBytes = 16;
+        uint16 Format = 1;      // PCM
+        uint16 Channels = 1;
+        uint32 Rate = SampleRate;
+        uint32 ByteRate = SampleRate * sizeof(int16);
+        uint16 BlockAlign = sizeof(int16);
+        uint16 BitsPerSample = 16;
+
+        WriteTag("RIFF");
+        Writer << RiffBytes;
+        WriteTag("WAVE");
+        WriteTag("fmt ");
+        Writer << FormatBytes << Format << Channels << Rate << ByteRate << BlockAlign << BitsPerSample;
+        WriteTag("data");
+        Writer << DataBytes;
+        for (const float Sample : Samples)
+        {
+            int16 Value = int16(FMath::Clamp(Sample, -1.f, 1.f) * 32767.f);
+            Writer << Value;
+        }
+
+        if (!FFileHelper::SaveArrayToFile(Wav, *Path))
+        {
+            UE_LOG(LogTemp, Error, TEXT("DroneMotorSynth: can't write %s"), *Path);
+        }
+    }
+}
+
+UDroneMotorSynthCommandlet::UDroneMotorSynthCommandlet()
+{
+    IsClient = false;
+    IsEditor = false;
+    IsServer = false;
+    LogToConsole = true;
+}
+
+int32 UDroneMotorSynthCommandlet::Main(const FString& Params)
+{
+    int32 NumDrones = 16;
+    float Seconds = 10.f;
+    int32 SampleRate = 48000;
+    int32 BufferFrames = 512;
+    float BudgetMs = 1.f;
+    FString WavPath;
+    FParse::Value(*Params, TEXT("Drones="), NumDrones);
+    FParse::Value(*Params, TEXT("Seconds="), Seconds);
+    FParse::Value(*Params, TEXT("SampleRate="), SampleRate);
+    FParse::Value(*Params, TEXT("BufferFrames="), BufferFrames);
+    FParse::Value(*Params, TEXT("BudgetMs="), BudgetMs);
+    FParse::Value(*Params, TEXT("Wav="), WavPath);
+
+    NumDrones = FMath::Max(NumDrones, 1);
+    SampleRate = FMath::Max(SampleRate, 8000);
+    BufferFrames = FMath::Max(BufferFrames, 1);
+
+    TArray<FDroneMotorSynth> Synths;
+    Synths.SetNum(NumDrones);
+    for (int32 Drone = 0; Drone < NumDrones; ++Drone)
+    {
+        Synths[Drone].Init(float(SampleRate), FDroneMotorSynthSettings(), uint32(Drone + 1) * 2654435761u);
+    }
+
+    const int32 NumBuffers = FMath::Max(FMath::CeilToInt32(Seconds * SampleRate / BufferFrames), 1);
+    TArray<float> Mix;
+    if (!WavPath.IsEmpty())
+    {
+        Mix.Reserve(NumBuffers * BufferFrames);
+    }
+
+    TArray<float> Buffer, MixBuffer;
+    Buffer.SetNumUninitialized(BufferFrames);
+    MixBuffer.SetNumUninitialized(BufferFrames);
+
+    double TotalSeconds = 0.0;
+    double MaxBufferSeconds = 0.0;
+    for (int32 BufferIndex = 0; BufferIndex < NumBuffers; ++BufferIndex)
+    {
+        const float Time = float(BufferIndex) * BufferFrames / SampleRate;
+        FMemory::Memzero(MixBuffer.GetData(), BufferFrames * sizeof(float));
+
+        const double Start = FPlatformTime::Seconds();
+        for (int32 Drone = 0; Drone < NumDrones; ++Drone)
+        {
+            // Each drone sweeps throttle and rolls on its own period, passing by with some Doppler
+            const float Phase = Time * (0.3f + 0.05f * Drone);
+            const float Throttle01 = 0.5f + 0.45f * FMath::Sin(UE_TWO_PI * Phase);
+            const float Roll = 0.15f * FMath::Sin(UE_TWO_PI * Phase * 3.f);
+
+            FDroneMotorSynthParams SynthParams;
+            for (int32 Motor = 0; Motor < 4; ++Motor)
+            {
+                const float Mix01 = FMath::Clamp(Throttle01 + ((Motor & 1) ? Roll : -Roll), 0.f, 1.f);
+                SynthParams.MotorRPM[Motor] = FMath::Lerp(4000.f, 30000.f, Mix01);
+            }
+            SynthParams.Throttle01 = Throttle01;
+            SynthParams.PitchScale = 1.f + 0.1f * FMath::Sin(UE_TWO_PI * Phase * 0.5f);
+            SynthParams.Gain = 1.f / NumDrones;
+
+            Synths[Drone].Render(SynthParams, Buffer.GetData(), BufferFrames);
+            for (int32 Frame = 0; Frame < BufferFrames; ++Frame)
+            {
+                MixBuffer[Frame] += Buffer[Frame];
+            }
+        }
+        const double BufferSeconds = FPlatformTime::Seconds() - Start;
+        TotalSeconds += BufferSeconds;
+        MaxBufferSeconds = FMath::Max(MaxBufferSeconds, BufferSeconds);
+
+        if (!WavPath.IsEmpty())
+        {
+            Mix.Append(MixBuffer);
+        }
+    }
+
+    const double AverageMs = TotalSeconds / NumBuffers * 1000.0;
+    UE_LOG(LogTemp, Display, TEXT("DroneMotorSynth: %d drones, %d-frame buffers at %d Hz: %.3f ms per buffer on average, %.3f ms at most (budget %.3f ms, buffer length %.2f ms)"),
+        NumDrones, BufferFrames, SampleRate, AverageMs, MaxBufferSeconds * 1000.0, BudgetMs, BufferFrames * 1000.0 / SampleRate);
+
+    if (!WavPath.IsEmpty())
+    {
+        DroneMotorSynthCommandlet::WriteWav(Mix, SampleRate, WavPath);
+        UE_LOG(LogTemp, Display, TEXT("DroneMotorSynth: wrote %s"), *WavPath);
+    }
+
+    return AverageMs > BudgetMs ? 1 : 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "DroneMotorSynthCommandlet.generated.h"
+
+/**
+ * Renders FDroneMotorSynth offline, without an audio device (e.g. with
+ * -nullrhi -nosound on a Linux build box):
+ *
+ *   UnrealEditor-Cmd DroneRacerFP.uproject -run=DroneMotorSynth -nullrhi -nosound -unattended
+ *       [-Drones=16] [-Seconds=10] [-SampleRate=48000] [-BufferFrames=512] [-BudgetMs=1] [-Wav=<path>]
+ *
+ * Every drone flies its own throttle and rate sweep. Logs the render time
+ * of one buffer for all drones together and returns 1 if the average is
+ * over BudgetMs. With -Wav the mix is written as a 16-bit mono WAV file.
+ */
+UCLASS()
+class UDroneMotorSynthCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UDroneMotorSynthCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,137 @@
+#include "DroneMotorSynthComponent.h"
+#include "DroneFPCharacter.h"
+
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+
+namespace DroneMotorSynth
+{
+    /** Quad X motor order: front right, rear left, front left, rear right */
+    constexpr float RollSign[4] = { -1.f, 1.f, 1.f, -1.f };
+    constexpr float PitchSign[4] = { 1.f, -1.f, 1.f, -1.f };
+    constexpr float YawSign[4] = { 1.f, 1.f, -1.f, -1.f };
+
+    /** Doppler shifts beyond this are clamped (supersonic relative speeds) */
+    constexpr float MinPitchScale = 0.5f;
+    constexpr float MaxPitchScale = 2.f;
+
+    /** Smoothing time constant of the Doppler shift (s), hides listener velocity noise */
+    constexpr float DopplerSmoothingSeconds = 0.05f;
+}
+
+UDroneMotorSynthComponent::UDroneMotorSynthComponent(const FObjectInitializer& ObjectInitializer)
+    : Super(ObjectInitializer)
+{
+    PrimaryComponentTick.bCanEverTick = true;
+    PrimaryComponentTick.TickGroup = TG_PostPhysics;
+
+    NumChannels = 1;
+    bAutoActivate = true;
+    bAllowSpatialization = true;
+}
+
+bool UDroneMotorSynthComponent::Init(int32& SampleRate)
+{
+    NumChannels = 1;
+
+    FDroneMotorSynthSettings Settings;
+    Settings.NumBlades = NumBlades;
+    Synth.Init(float(SampleRate), Settings, uint32(GetUniqueID()) * 2654435761u);
+    return true;
+}
+
+int32 UDroneMotorSynthComponent::OnGenerateAudio(float* OutAudio, int32 NumSamples)
+{
+    // Latest parameters the game thread published, if any
+    if (ParamChannel.IsDirty())
+    {
+        ParamChannel.SwapReadBuffers();
+    }
+
+    Synth.Render(ParamChannel.Read(), OutAudio, NumSamples);
+    return NumSamples;
+}
+
+void UDroneMotorSynthComponent::SetMotorRPMs(const float (&RPMs)[4])
+{
+    FMemory::Memcpy(MotorRPMOverride, RPMs, sizeof(MotorRPMOverride));
+    bHasMotorRPMOverride = true;
+}
+
+void UDroneMotorSynthComponent::ClearMotorRPMs()
+{
+    bHasMotorRPMOverride = false;
+}
+
+void UDroneMotorSynthComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+    Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+    FDroneMotorSynthParams& Params = ParamChannel.GetWriteBuffer();
+    UpdateMotorRPMs(Params);
+    Params.PitchScale = UpdateDoppler(DeltaTime);
+    Params.Gain = Gain;
+    ParamChannel.SwapWriteBuffers();
+}
+
+void UDroneMotorSynthComponent::UpdateMotorRPMs(FDroneMotorSynthParams& Params) const
+{
+    const ADroneFPCharacter* Drone = Cast<ADroneFPCharacter>(GetOwner());
+    const FDroneTelemetrySnapshot* Telemetry = Drone ? &Drone->GetTelemetry() : nullptr;
+    Params.Throttle01 = Telemetry && Telemetry->bArmed ? Telemetry->Throttle01 : 0.f;
+
+    if (bHasMotorRPMOverride)
+    {
+        FMemory::Memcpy(Params.MotorRPM, MotorRPMOverride, sizeof(Params.MotorRPM));
+        return;
+    }
+
+    // Disarmed motors stop
+    if (!Telemetry || !Telemetry->bArmed)
+    {
+        FMemory::Memzero(Params.MotorRPM, sizeof(Params.MotorRPM));
+        return;
+    }
+
+    const FVector Rates = Telemetry->BodyRatesDeg / FullMixerRateDeg;
+    for (int32 Motor = 0; Motor < 4; ++Motor)
+    {
+        const float Mix = Telemetry->Throttle01 + MixerAuthority * (
+            DroneMotorSynth::RollSign[Motor] * Rates.X +
+            DroneMotorSynth::PitchSign[Motor] * Rates.Y +
+            DroneMotorSynth::YawSign[Motor] * Rates.Z);
+        Params.MotorRPM[Motor] = FMath::Lerp(IdleRPM, MaxRPM, FMath::Clamp(Mix, 0.f, 1.f));
+    }
+}
+
+float UDroneMotorSynthComponent::UpdateDoppler(float DeltaTime)
+{
+    const APlayerController* Listener = GetWorld()->GetFirstPlayerController();
+    const AActor* Owner = GetOwner();
+    if (SpeedOfSound <= 0.f || !Listener || !Owner || DeltaTime <= 0.f)
+    {
+        PitchScale = 1.f;
+        return PitchScale;
+    }
+
+    FVector ListenerLocation, FrontDir, RightDir;
+    Listener->GetAudioListenerPosition(ListenerLocation, FrontDir, RightDir);
+    const FVector ListenerVelocity = bHasListenerLocation ? (ListenerLocation - LastListenerLocation) / DeltaTime : FVector::ZeroVector;
+    LastListenerLocation = ListenerLocation;
+    bHasListenerLocation = true;
+
+    // The pilot's own drone doesn't move relative to them
+    float Target = 1.f;
+    const APawn* Pawn = Cast<APawn>(Owner);
+    if (!Pawn || Listener->GetViewTarget() != Pawn)
+    {
+        const FVector ToListener = (ListenerLocation - GetComponentLocation()).GetSafeNormal();
+        const float ListenerSpeed = FVector::DotProduct(ListenerVelocity, ToListener);
+        const float SourceSpeed = FVector::DotProduct(Owner->GetVelocity(), ToListener);
+        Target = FMath::Clamp((SpeedOfSound - ListenerSpeed) / FMath::Max(SpeedOfSound - SourceSpeed, 1.f),
+            DroneMotorSynth::MinPitchScale, DroneMotorSynth::MaxPitchScale);
+    }
+
+    PitchScale += (Target - PitchScale) * (1.f - FMath::Exp(-DeltaTime / DroneMotorSynth::DopplerSmoothingSeconds));
+    return PitchScale;
+}
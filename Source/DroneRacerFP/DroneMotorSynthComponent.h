@@ -0,0 +1,82 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SynthComponent.h"
+#include "Containers/TripleBuffer.h"
+#include "DroneMotorSynth.h"
+#include "DroneMotorSynthComponent.generated.h"
+
+/**
+ * Motor sound of the owning ADroneFPCharacter, synthesized by
+ * FDroneMotorSynth on the audio render thread.
+ *
+ * Every tick the game thread turns the drone's throttle and commanded body
+ * rates into four motor speeds (a quad X mixer), or takes the speeds set
+ * with SetMotorRPMs when a flight controller reports real ones, adds the
+ * Doppler shift toward the first local listener, and hands the result to
+ * the audio thread through a triple buffer: neither side ever waits on the
+ * other and nothing is allocated per frame.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class DRONERACERFP_API UDroneMotorSynthComponent : public USynthComponent
+{
+    GENERATED_BODY()
+
+public:
+    UDroneMotorSynthComponent(const FObjectInitializer& ObjectInitializer);
+
+    virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+    /** Real motor speeds (e.g. ESC telemetry), used instead of the mixer until ClearMotorRPMs */
+    void SetMotorRPMs(const float (&RPMs)[4]);
+    void ClearMotorRPMs();
+
+    /** Motor speed with the throttle at zero while armed */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motor Sound")
+    float IdleRPM = 4000.f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motor Sound")
+    float MaxRPM = 30000.f;
+
+    /** Share of MaxRPM a full-rate roll, pitch or yaw moves the motors apart */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motor Sound", meta = (ClampMin = "0", ClampMax = "1"))
+    float MixerAuthority = 0.15f;
+
+    /** Body rate (deg/s) that counts as full rate for the mixer */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motor Sound", meta = (ClampMin = "1"))
+    float FullMixerRateDeg = 120.f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motor Sound", meta = (ClampMin = "0"))
+    float Gain = 0.8f;
+
+    /** cm/s; 0 disables the Doppler shift */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motor Sound", meta = (ClampMin = "0"))
+    float SpeedOfSound = 34300.f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motor Sound", meta = (ClampMin = "1"))
+    int32 NumBlades = 3;
+
+protected:
+    // USynthComponent
+    virtual bool Init(int32& SampleRate) override;
+    virtual int32 OnGenerateAudio(float* OutAudio, int32 NumSamples) override;
+
+private:
+    void UpdateMotorRPMs(FDroneMotorSynthParams& Params) const;
+    float UpdateDoppler(float DeltaTime);
+
+    /** Audio render thread only */
+    FDroneMotorSynth Synth;
+
+    /** Game thread writes, audio render thread reads */
+    TTripleBuffer<FDroneMotorSynthParams> ParamChannel;
+
+    float MotorRPMOverride[4] = { 0.f, 0.f, 0.f, 0.f };
+    bool bHasMotorRPMOverride = false;
+
+    /** For the listener's velocity */
+    FVector LastListenerLocation = FVector::ZeroVector;
+    bool bHasListenerLocation = false;
+
+    float PitchScale = 1.f;
+};
@@ -0,0 +1,209 @@
+#include "DroneOSDHUD.h"
+#include "DroneFPCharacter.h"
+#include "DronePreloadSubsystem.h"
+#include "DroneTelemetry.h"
+
+#include "CanvasItem.h"
+#include "Engine/Canvas.h"
+#include "Engine/Engine.h"
+#include "Engine/Font.h"
+#include "Engine/GameInstance.h"
+
+ADroneOSDHUD::ADroneOSDHUD()
+{
+}
+
+void ADroneOSDHUD::DrawHUD()
+{
+    Super::DrawHUD();
+
+    if (!Canvas)
+        return;
+
+    // No drone until the preload is done
+    const UDronePreloadSubsystem* Preload = GetGameInstance() ? GetGameInstance()->GetSubsystem<UDronePreloadSubsystem>() : nullptr;
+    if (Preload && !Preload->IsReady())
+    {
+        DrawLoading(Preload->GetProgress());
+        return;
+    }
+
+    const ADroneFPCharacter* Drone = Cast<ADroneFPCharacter>(GetOwningPawn());
+    if (!Drone)
+        return;
+
+    if (LayoutSize.X != FMath::TruncToInt(Canvas->ClipX) || LayoutSize.Y != FMath::TruncToInt(Canvas->ClipY))
+    {
+        UpdateLayout();
+    }
+
+    const FDroneTelemetrySnapshot& Snapshot = Drone->GetTelemetry();
+    if (Snapshot.FrameNumber != LastSnapshotFrame)
+    {
+        LastSnapshotFrame = Snapshot.FrameNumber;
+        RefreshFields(Snapshot);
+    }
+
+    // ===== Bars =====
+
+    DrawBar(ThrottleBarPos, ThrottleBarSize, CachedThrottle01, true, false);
+    DrawBar(HealthBarPos, HealthBarSize, CachedHealth01, false, CachedHealth01 < WarningLevel01);
+    DrawBar(BatteryBarPos, BatteryBarSize, CachedBattery01, false, CachedBattery01 < WarningLevel01);
+
+    // ===== Text =====
+
+    const UFont* Font = GEngine ? GEngine->GetMediumFont() : nullptr;
+    if (!Font)
+        return;
+
+    for (const FOSDField& Field : Fields)
+    {
+        FCanvasTextItem TextItem(Field.Position, Field.Text, Font, Field.bWarning ? WarningColor : TextColor);
+        TextItem.EnableShadow(FLinearColor::Black);
+        Canvas->DrawItem(TextItem);
+    }
+}
+
+void ADroneOSDHUD::RefreshFields(const FDroneTelemetrySnapshot& Snapshot)
+{
+    const float Health01 = Snapshot.MaxHealth > 0.f ? Snapshot.Health / Snapshot.MaxHealth : 0.f;
+
+    CachedThrottle01 = Snapshot.Throttle01;
+    CachedHealth01 = Health01;
+    CachedBattery01 = Snapshot.Battery01;
+
+    // Keys are the values at display precision, so text is only rebuilt when what is shown changes
+
+    const int32 ThrottlePct = FMath::RoundToInt(Snapshot.Throttle01 * 100.f);
+    RefreshField(Field_Throttle, ThrottlePct + (Snapshot.bArmed ? 0 : 1000), false, [&]()
+    {
+        return Snapshot.bArmed
+            ? FString::Printf(TEXT("THR %3d%%"), ThrottlePct)
+            : FString(TEXT("DISARMED"));
+    });
+
+    const int32 Speed10 = FMath::RoundToInt(Snapshot.SpeedMs * 10.f);
+    RefreshField(Field_Speed, Speed10, false, [&]()
+    {
+        return FString::Printf(TEXT("%5.1f m/s"), Speed10 / 10.f);
+    });
+
+    const int32 Alt10 = FMath::RoundToInt(Snapshot.AltitudeM * 10.f);
+    RefreshField(Field_Altitude, Alt10, false, [&]()
+    {
+        return FString::Printf(TEXT("ALT %6.1f m"), Alt10 / 10.f);
+    });
+
+    const int32 HealthInt = FMath::CeilToInt(Snapshot.Health);
+    RefreshField(Field_Health, HealthInt, Health01 < WarningLevel01, [&]()
+    {
+        return FString::Printf(TEXT("HP %3d"), HealthInt);
+    });
+
+    const int32 BatteryPct = FMath::CeilToInt(Snapshot.Battery01 * 100.f);
+    RefreshField(Field_Battery, BatteryPct, Snapshot.Battery01 < WarningLevel01, [&]()
+    {
+        return FString::Printf(TEXT("BAT %3d%%"), BatteryPct);
+    });
+
+    const bool bHasCourse = Snapshot.NumGates > 0;
+    const int64 GateKey = bHasCourse ? (int64(Snapshot.CurrentGate) << 32) | uint32(Snapshot.NumGates) : -1;
+    RefreshField(Field_Gate, GateKey, false, [&]()
+    {
+        if (!bHasCourse)
+            return FString();
+        if (Snapshot.CurrentGate >= Snapshot.NumGates)
+            return FString(TEXT("FINISH"));
+        return FString::Printf(TEXT("GATE %d/%d"), Snapshot.CurrentGate + 1, Snapshot.NumGates);
+    });
+
+    const int64 LapKey = bHasCourse ? (int64(Snapshot.Lap) << 32) | uint32(Snapshot.NumLaps) : -1;
+    RefreshField(Field_Lap, LapKey, false, [&]()
+    {
+        return bHasCourse ? FString::Printf(TEXT("LAP %d/%d"), Snapshot.Lap, Snapshot.NumLaps) : FString();
+    });
+
+    const int32 LapTime10 = bHasCourse ? FMath::FloorToInt(Snapshot.LapTime * 10.f) : -1;
+    RefreshField(Field_LapTime, LapTime10, false, [&]()
+    {
+        return LapTime10 >= 0 ? FString::Printf(TEXT("%02d:%04.1f"), LapTime10 / 600, (LapTime10 % 600) / 10.f) : FString();
+    });
+
+    const int32 Split100 = Snapshot.LastSplit >= 0.f ? FMath::RoundToInt(Snapshot.LastSplit * 100.f) : -1;
+    RefreshField(Field_Split, Split100, false, [&]()
+    {
+        return Split100 >= 0 ? FString::Printf(TEXT("SPLIT %.2f"), Split100 / 100.f) : FString();
+    });
+
+    // Behind the best lap shows as a warning
+    const int32 Delta100 = FMath::RoundToInt(Snapshot.DeltaToBest * 100.f);
+    RefreshField(Field_Delta, Snapshot.bHasDeltaToBest ? Delta100 : MAX_int64, Snapshot.bHasDeltaToBest && Delta100 > 0, [&]()
+    {
+        return Snapshot.bHasDeltaToBest ? FString::Printf(TEXT("%+.2f"), Delta100 / 100.f) : FString();
+    });
+}
+
+void ADroneOSDHUD::UpdateLayout()
+{
+    LayoutSize = FIntPoint(FMath::TruncToInt(Canvas->ClipX), FMath::TruncToInt(Canvas->ClipY));
+
+    const FVector2D Size(LayoutSize.X, LayoutSize.Y);
+    auto At = [&Size](float X01, float Y01) { return FVector2D(X01 * Size.X, Y01 * Size.Y); };
+
+    // Bottom left: flight, bottom right: drone state, top: race
+    Fields[Field_Throttle].Position = At(0.05f, 0.78f);
+    Fields[Field_Speed].Position = At(0.05f, 0.82f);
+    Fields[Field_Altitude].Position = At(0.05f, 0.86f);
+    Fields[Field_Health].Position = At(0.80f, 0.78f);
+    Fields[Field_Battery].Position = At(0.80f, 0.84f);
+    Fields[Field_Gate].Position = At(0.05f, 0.05f);
+    Fields[Field_Lap].Position = At(0.05f, 0.09f);
+    Fields[Field_LapTime].Position = At(0.45f, 0.05f);
+    Fields[Field_Split].Position = At(0.45f, 0.09f);
+    Fields[Field_Delta].Position = At(0.45f, 0.13f);
+
+    ThrottleBarPos = At(0.03f, 0.72f);
+    ThrottleBarSize = At(0.008f, 0.18f);
+    HealthBarPos = At(0.88f, 0.785f);
+    HealthBarSize = At(0.08f, 0.012f);
+    BatteryBarPos = At(0.88f, 0.845f);
+    BatteryBarSize = At(0.08f, 0.012f);
+}
+
+void ADroneOSDHUD::DrawLoading(float Progress01)
+{
+    const int32 Percent = FMath::FloorToInt32(Progress01 * 100.f);
+    if (Percent != LoadingPercent || LoadingText.IsEmpty())
+    {
+        LoadingPercent = Percent;
+        LoadingText = FText::FromString(FString::Printf(TEXT("LOADING %d%%"), Percent));
+    }
+
+    const FVector2D Size(Canvas->ClipX * 0.3f, 8.f);
+    const FVector2D Position((Canvas->ClipX - Size.X) * 0.5f, Canvas->ClipY * 0.5f);
+    DrawBar(Position, Size, Progress01, false, false);
+
+    if (const UFont* Font = GEngine ? GEngine->GetMediumFont() : nullptr)
+    {
+        FCanvasTextItem TextItem(Position - FVector2D(0.f, 24.f), LoadingText, Font, TextColor);
+        TextItem.EnableShadow(FLinearColor::Black);
+        Canvas->DrawItem(TextItem);
+    }
+}
+
+void ADroneOSDHUD::DrawBar(const FVector2D& Position, const FVector2D& Size, float Fill01, bool bVertical, bool bWarning)
+{
+    const float Fill = FMath::Clamp(Fill01, 0.f, 1.f);
+
+    FCanvasTileItem Background(Position, Size, BarBackgroundColor);
+    Background.BlendMode = SE_BLEND_Translucent;
+    Canvas->DrawItem(Background);
+
+    // Vertical bars fill from the bottom
+    const FVector2D FillSize = bVertical ? FVector2D(Size.X, Size.Y * Fill) : FVector2D(Size.X * Fill, Size.Y);
+    const FVector2D FillPos = bVertical ? FVector2D(Position.X, Position.Y + Size.Y - FillSize.Y) : Position;
+
+    FCanvasTileItem Foreground(FillPos, FillSize, bWarning ? WarningColor : TextColor);
+    Foreground.BlendMode = SE_BLEND_Translucent;
+    Canvas->DrawItem(Foreground);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/HUD.h"
+#include "DroneOSDHUD.generated.h"
+
+struct FDroneTelemetrySnapshot;
+
+/**
+ * FPV-style on-screen display for ADroneFPCharacter.
+ *
+ * Reads the drone's telemetry snapshot once per frame. Every field keeps its
+ * last quantized value and formatted text; text is only rebuilt when the
+ * quantized value changes, so a steady frame draws without allocating.
+ */
+UCLASS()
+class DRONERACERFP_API ADroneOSDHUD : public AHUD
+{
+    GENERATED_BODY()
+
+public:
+    ADroneOSDHUD();
+
+    virtual void DrawHUD() override;
+
+protected:
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "OSD")
+    FLinearColor TextColor = FLinearColor(0.9f, 1.f, 0.9f, 1.f);
+
+    /** Used for health / battery below WarningLevel01 */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "OSD")
+    FLinearColor WarningColor = FLinearColor(1.f, 0.25f, 0.1f, 1.f);
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "OSD")
+    FLinearColor BarBackgroundColor = FLinearColor(0.f, 0.f, 0.f, 0.4f);
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "OSD", meta = (ClampMin = "0", ClampMax = "1"))
+    float WarningLevel01 = 0.25f;
+
+private:
+    enum EOSDField : uint8
+    {
+        Field_Throttle,
+        Field_Speed,
+        Field_Altitude,
+        Field_Health,
+        Field_Battery,
+        Field_Gate,
+        Field_Lap,
+        Field_LapTime,
+        Field_Split,
+        Field_Delta,
+        Field_Num
+    };
+
+    struct FOSDField
+    {
+        /** Quantized value the text was built from */
+        int64 Key = MIN_int64;
+        FText Text;
+        bool bWarning = false;
+
+        /** Screen position, rebuilt only when the viewport size changes */
+        FVector2D Position = FVector2D::ZeroVector;
+    };
+
+    /** Rebuilds a field's text only if its quantized key changed */
+    template <typename FormatFuncType>
+    void RefreshField(EOSDField Field, int64 Key, bool bWarning, FormatFuncType&& FormatFunc)
+    {
+        FOSDField& Entry = Fields[Field];
+        Entry.bWarning = bWarning;
+        if (Entry.Key != Key)
+        {
+            Entry.Key = Key;
+            Entry.Text = FText::FromString(FormatFunc());
+        }
+    }
+
+    void RefreshFields(const FDroneTelemetrySnapshot& Snapshot);
+    void UpdateLayout();
+    void DrawBar(const FVector2D& Position, const FVector2D& Size, float Fill01, bool bVertical, bool bWarning);
+    void DrawLoading(float Progress01);
+
+    FOSDField Fields[Field_Num];
+
+    /** Viewport size the field positions were laid out for */
+    FIntPoint LayoutSize = FIntPoint::ZeroValue;
+
+    /** Frame of the last snapshot consumed, skips the refresh when the drone did not tick */
+    uint64 LastSnapshotFrame = 0;
+
+    // Bars (throttle, health, battery) in screen space
+    FVector2D ThrottleBarPos, ThrottleBarSize;
+    FVector2D HealthBarPos, HealthBarSize;
+    FVector2D BatteryBarPos, BatteryBarSize;
+
+    float CachedThrottle01 = 0.f;
+    float CachedHealth01 = 1.f;
+    float CachedBattery01 = 1.f;
+
+    // Asset preload progress, shown until there is a drone
+    int32 LoadingPercent = -1;
+    FText LoadingText;
+};
@@ -0,0 +1,197 @@
+#include "DronePreloadSubsystem.h"
+#include "DroneFPCharacter.h"
+
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace DronePreload
+{
+    double SecondsSinceLaunch()
+    {
+        return FPlatformTime::Seconds() - GStartTime;
+    }
+}
+
+void UDronePreloadSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    State = EDronePreloadState::Loading;
+    PreloadStartSeconds = DronePreload::SecondsSinceLaunch();
+
+    UAssetManager& AssetManager = UAssetManager::Get();
+    TArray<FPrimaryAssetId> ManifestIds;
+    AssetManager.GetPrimaryAssetIdList(UDroneAssetManifest::PrimaryAssetType, ManifestIds);
+    if (ManifestIds.Num() == 0)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("DronePreload: no DroneAssetManifest found, streaming %s only"), *FallbackDroneClass.ToString());
+        RequestGroups(nullptr);
+        return;
+    }
+
+    if (ManifestIds.Num() > 1)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("DronePreload: %d manifests, using %s"), ManifestIds.Num(), *ManifestIds[0].ToString());
+    }
+
+    ManifestId = ManifestIds[0];
+    ManifestHandle = AssetManager.LoadPrimaryAsset(ManifestId, TArray<FName>(),
+        FStreamableDelegate::CreateUObject(this, &UDronePreloadSubsystem::OnManifestLoaded));
+    if (!ManifestHandle)
+    {
+        // Already loaded; OnManifestLoaded ignores a second call
+        OnManifestLoaded();
+    }
+}
+
+void UDronePreloadSubsystem::Deinitialize()
+{
+    for (const TSharedPtr<FStreamableHandle>& Handle : GroupHandles)
+    {
+        if (Handle)
+        {
+            Handle->ReleaseHandle();
+        }
+    }
+    GroupHandles.Reset();
+
+    if (ManifestId.IsValid())
+    {
+        UAssetManager::Get().UnloadPrimaryAsset(ManifestId);
+    }
+
+    Super::Deinitialize();
+}
+
+void UDronePreloadSubsystem::OnManifestLoaded()
+{
+    Manifest = Cast<UDroneAssetManifest>(UAssetManager::Get().GetPrimaryAssetObject(ManifestId));
+    if (!Manifest)
+    {
+        UE_LOG(LogTemp, Error, TEXT("DronePreload: could not load %s"), *ManifestId.ToString());
+    }
+
+    RequestGroups(Manifest);
+}
+
+void UDronePreloadSubsystem::RequestGroups(const UDroneAssetManifest* InManifest)
+{
+    if (bGroupsRequested)
+        return;
+    bGroupsRequested = true;
+
+    FStreamableManager& Streamable = UAssetManager::GetStreamableManager();
+
+    // Held until every request is made; groups already in memory complete right away
+    NumPendingGroups = 1;
+
+    // One request per group, so a slow group doesn't hold up reading the others
+    for (int32 Group = 0; Group < UDroneAssetManifest::Group_Num; ++Group)
+    {
+        TArray<FSoftObjectPath> Paths;
+        if (InManifest)
+        {
+            InManifest->GetGroupPaths(UDroneAssetManifest::EGroup(Group), Paths);
+        }
+        else if (Group == UDroneAssetManifest::Group_Drone)
+        {
+            Paths.Add(FallbackDroneClass);
+        }
+
+        if (Paths.Num() == 0)
+            continue;
+
+        ++NumPendingGroups;
+        TSharedPtr<FStreamableHandle> Handle = Streamable.RequestAsyncLoad(MoveTemp(Paths),
+            FStreamableDelegate::CreateUObject(this, &UDronePreloadSubsystem::OnGroupLoaded),
+            FStreamableManager::AsyncLoadHighPriority, /*bManageActiveHandle*/ false, /*bStartStalled*/ false,
+            FString::Printf(TEXT("DronePreload Group %d"), Group));
+
+        if (Handle)
+        {
+            GroupHandles.Add(MoveTemp(Handle));
+        }
+    }
+
+    OnGroupLoaded();
+}
+
+void UDronePreloadSubsystem::OnGroupLoaded()
+{
+    if (--NumPendingGroups == 0)
+    {
+        Finish(GetDroneClass() ? EDronePreloadState::Ready : EDronePreloadState::Failed);
+    }
+}
+
+void UDronePreloadSubsystem::Finish(EDronePreloadState FinalState)
+{
+    State = FinalState;
+    PreloadDoneSeconds = DronePreload::SecondsSinceLaunch();
+
+    UE_LOG(LogTemp, Display, TEXT("DronePreload: %s in %.2f s (%.2f s after launch)"),
+        State == EDronePreloadState::Ready ? TEXT("ready") : TEXT("failed"),
+        PreloadDoneSeconds - PreloadStartSeconds, PreloadDoneSeconds);
+
+    OnPreloadComplete.Broadcast();
+}
+
+float UDronePreloadSubsystem::GetProgress() const
+{
+    if (IsReady())
+        return 1.f;
+
+    if (GroupHandles.Num() == 0)
+        return 0.f;
+
+    float Progress = 0.f;
+    for (const TSharedPtr<FStreamableHandle>& Handle : GroupHandles)
+    {
+        Progress += Handle->GetProgress();
+    }
+    return Progress / GroupHandles.Num();
+}
+
+UClass* UDronePreloadSubsystem::GetDroneClass() const
+{
+    if (Manifest && !Manifest->DroneClass.IsNull())
+    {
+        return Manifest->DroneClass.Get();
+    }
+    return FallbackDroneClass.ResolveClass();
+}
+
+void UDronePreloadSubsystem::NotifyThrottleArmed()
+{
+    if (FirstArmedSeconds >= 0.0)
+        return;
+
+    FirstArmedSeconds = DronePreload::SecondsSinceLaunch();
+    UE_LOG(LogTemp, Display, TEXT("DronePreload: time to first armed throttle %.2f s"), FirstArmedSeconds);
+
+    WriteStartupMetrics();
+}
+
+void UDronePreloadSubsystem::WriteStartupMetrics() const
+{
+    const FString Path = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Metrics"), TEXT("StartupTimes.csv"));
+
+    FString Lines;
+    if (!IFileManager::Get().FileExists(*Path))
+    {
+        Lines = TEXT("Timestamp,BuildVersion,Map,PreloadSeconds,PreloadDoneSeconds,FirstArmedSeconds\n");
+    }
+
+    const UWorld* World = GetGameInstance()->GetWorld();
+    Lines += FString::Printf(TEXT("%s,%s,%s,%.3f,%.3f,%.3f\n"),
+        *FDateTime::UtcNow().ToIso8601(), FApp::GetBuildVersion(), World ? *World->GetMapName() : TEXT(""),
+        PreloadDoneSeconds - PreloadStartSeconds, PreloadDoneSeconds, FirstArmedSeconds);
+
+    FFileHelper::SaveStringToFile(Lines, *Path, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM,
+        &IFileManager::Get(), FILEWRITE_Append);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "DroneAssetManifest.h"
+#include "DronePreloadSubsystem.generated.h"
+
+struct FStreamableHandle;
+
+enum class EDronePreloadState : uint8
+{
+    Idle,
+    Loading,
+    Ready,
+    Failed,
+};
+
+DECLARE_MULTICAST_DELEGATE(FOnDronePreloadComplete);
+
+/**
+ * Streams in everything in UDroneAssetManifest when the game starts, so the
+ * map doesn't load the drone, gate and weapon assets synchronously as it
+ * comes up. Each manifest group is its own async request and they run in
+ * parallel; the handles are kept, so the assets stay loaded for the session.
+ *
+ * Also measures startup: the time from launch until the preload finished and
+ * until the first pilot armed the throttle. Both are logged and appended to
+ * Saved/Metrics/StartupTimes.csv together with the build version, so startup
+ * time can be compared release over release.
+ */
+UCLASS(Config = Game)
+class DRONERACERFP_API UDronePreloadSubsystem : public UGameInstanceSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    virtual void Deinitialize() override;
+
+    EDronePreloadState GetState() const { return State; }
+    bool IsReady() const { return State == EDronePreloadState::Ready || State == EDronePreloadState::Failed; }
+
+    /** 0..1 over all groups */
+    float GetProgress() const;
+
+    /** Pawn class for pilots; null until the preload is done */
+    UClass* GetDroneClass() const;
+
+    /** Broadcast once when the preload is done (or failed) */
+    FOnDronePreloadComplete OnPreloadComplete;
+
+    /** Called by drones when they are armed; records the time to first armed throttle */
+    void NotifyThrottleArmed();
+
+protected:
+    /** Used when no manifest is found */
+    UPROPERTY(Config)
+    FSoftClassPath FallbackDroneClass = FSoftClassPath(TEXT("/Game/BP_DroneFPCharacter.BP_DroneFPCharacter_C"));
+
+private:
+    void OnManifestLoaded();
+    void RequestGroups(const UDroneAssetManifest* Manifest);
+    void OnGroupLoaded();
+    void Finish(EDronePreloadState FinalState);
+    void WriteStartupMetrics() const;
+
+    EDronePreloadState State = EDronePreloadState::Idle;
+
+    UPROPERTY(Transient)
+    TObjectPtr<const UDroneAssetManifest> Manifest;
+
+    FPrimaryAssetId ManifestId;
+    TSharedPtr<FStreamableHandle> ManifestHandle;
+    TArray<TSharedPtr<FStreamableHandle>> GroupHandles;
+    int32 NumPendingGroups = 0;
+    bool bGroupsRequested = false;
+
+    /** Seconds since launch (GStartTime) */
+    double PreloadStartSeconds = 0.0;
+    double PreloadDoneSeconds = -1.0;
+    double FirstArmedSeconds = -1.0;
+};
@@ -4,4 +4,40 @@
 #include "Modules/ModuleManager.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, DroneRacerFP, "DroneRacerFP" );
- 
\ No newline at end of file
+
+DEFINE_STAT(STAT_DroneRacer_DroneTick);
+DEFINE_STAT(STAT_DroneRacer_Orientation);
+DEFINE_STAT(STAT_DroneRacer_Forces);
+DEFINE_STAT(STAT_DroneRacer_Sweep);
+DEFINE_STAT(STAT_DroneRacer_ImpactDamage);
+DEFINE_STAT(STAT_DroneRacer_FlightThread);
+DEFINE_STAT(STAT_DroneRacer_DroneContacts);
+DEFINE_STAT(STAT_DroneRacer_SITLBridge);
+DEFINE_STAT(STAT_DroneRacer_GatePassed);
+DEFINE_STAT(STAT_DroneRacer_GateMotion);
+DEFINE_STAT(STAT_DroneRacer_DeltaToBest);
+DEFINE_STAT(STAT_DroneRacer_RaceBroadcast);
+DEFINE_STAT(STAT_DroneRacer_ProjectileSpawn);
+DEFINE_STAT(STAT_DroneRacer_WindBake);
+DEFINE_STAT(STAT_DroneRacer_WindDecay);
+DEFINE_STAT(STAT_DroneRacer_SensorIssue);
+DEFINE_STAT(STAT_DroneRacer_SensorCollect);
+DEFINE_STAT(STAT_DroneRacer_CollectibleSweep);
+DEFINE_STAT(STAT_DroneRacer_LagCompTrace);
+DEFINE_STAT(STAT_DroneRacer_Trajectory);
+DEFINE_STAT(STAT_DroneRacer_MotorSynth);
+DEFINE_STAT(STAT_DroneRacer_Significance);
+DEFINE_STAT(STAT_DroneRacer_ThrottledDrones);
+DEFINE_STAT(STAT_DroneRacer_SuspendedGates);
+DEFINE_STAT(STAT_DroneRacer_CulledProjectileFX);
+DEFINE_STAT(STAT_DroneRacer_SignificanceDeferred);
+DEFINE_STAT(STAT_DroneRacer_NumDrones);
+DEFINE_STAT(STAT_DroneRacer_NumGates);
+DEFINE_STAT(STAT_DroneRacer_NumProjectiles);
+DEFINE_STAT(STAT_DroneRacer_DroneContactPairs);
+DEFINE_STAT(STAT_DroneRacer_GatePasses);
+DEFINE_STAT(STAT_DroneRacer_ProjectileSpawns);
+DEFINE_STAT(STAT_DroneRacer_SensorRays);
+DEFINE_STAT(STAT_DroneRacer_Pickups);
+
+CSV_DEFINE_CATEGORY_MODULE(DRONERACERFP_API, DroneRacer, true);
@@ -3,3 +3,82 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+// ===== Profiling: "stat DroneRacer", Unreal Insights and CSV captures =====
+
+DECLARE_STATS_GROUP(TEXT("DroneRacer"), STATGROUP_DroneRacer, STATCAT_Advanced);
+
+// Drone flight
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Drone Tick"), STAT_DroneRacer_DroneTick, STATGROUP_DroneRacer, DRONERACERFP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Drone Orientation"), STAT_DroneRacer_Orientation, STATGROUP_DroneRacer, DRONERACERFP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Drone Forces"), STAT_DroneRacer_Forces, STATGROUP_DroneRacer, DRONERACERFP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Drone Sweep"), STAT_DroneRacer_Sweep, STATGROUP_DroneRacer, DRONERACERFP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Impact Damage"), STAT_DroneRacer_ImpactDamage, STATGROUP_DroneRacer, DRONERACERFP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Flight Thread"), STAT_DroneRacer_FlightThread, STATGROUP_DroneRacer, DRONERACERFP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Drone Contacts"), STAT_DroneRacer_DroneContacts, STATGROUP_DroneRacer, DRONERACERFP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("SITL Bridge"), STAT_DroneRacer_SITLBridge, STATGROUP_DroneRacer, DRONERACERFP_API);
+
+// Race / weapon
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Gate Passed"), STAT_DroneRacer_GatePassed, STATGROUP_DroneRacer, DRONERACERFP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Gate Motion"), STAT_DroneRacer_GateMotion, STATGROUP_DroneRacer, DRONERACERFP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Delta To Best"), STAT_DroneRacer_DeltaToBest, STATGROUP_DroneRacer, DRONERACERFP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Race Broadcast"), STAT_DroneRacer_RaceBroadcast, STATGROUP_DroneRacer, DRONERACERFP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Projectile Spawn"), STAT_DroneRacer_ProjectileSpawn, STATGROUP_DroneRacer, DRONERACERFP_API);
+
+// Wind
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Wind Bake"), STAT_DroneRacer_WindBake, STATGROUP_DroneRacer, DRONERACERFP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Wind Decay"), STAT_DroneRacer_WindDecay, STATGROUP_DroneRacer, DRONERACERFP_API);
+
+// Range sensors
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Sensor Issue"), STAT_DroneRacer_SensorIssue, STATGROUP_DroneRacer, DRONERACERFP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Sensor Collect"), STAT_DroneRacer_SensorCollect, STATGROUP_DroneRacer, DRONERACERFP_API);
+
+// Collectibles
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Collectible Sweep"), STAT_DroneRacer_CollectibleSweep, STATGROUP_DroneRacer, DRONERACERFP_API);
+
+// Combat
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Lag Comp Trace"), STAT_DroneRacer_LagCompTrace, STATGROUP_DroneRacer, DRONERACERFP_API);
+
+// Practice
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Trajectory Prediction"), STAT_DroneRacer_Trajectory, STATGROUP_DroneRacer, DRONERACERFP_API);
+
+// Audio
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Motor Synth"), STAT_DroneRacer_MotorSynth, STATGROUP_DroneRacer, DRONERACERFP_API);
+
+// Significance
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Significance"), STAT_DroneRacer_Significance, STATGROUP_DroneRacer, DRONERACERFP_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Throttled Drones"), STAT_DroneRacer_ThrottledDrones, STATGROUP_DroneRacer, DRONERACERFP_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Suspended Gates"), STAT_DroneRacer_SuspendedGates, STATGROUP_DroneRacer, DRONERACERFP_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Culled Projectile FX"), STAT_DroneRacer_CulledProjectileFX, STATGROUP_DroneRacer, DRONERACERFP_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Significance Deferred"), STAT_DroneRacer_SignificanceDeferred, STATGROUP_DroneRacer, DRONERACERFP_API);
+
+// Live object counts (accumulators, not reset per frame)
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Drones"), STAT_DroneRacer_NumDrones, STATGROUP_DroneRacer, DRONERACERFP_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Gates"), STAT_DroneRacer_NumGates, STATGROUP_DroneRacer, DRONERACERFP_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Projectiles"), STAT_DroneRacer_NumProjectiles, STATGROUP_DroneRacer, DRONERACERFP_API);
+
+// Per-frame event counts
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Drone Contact Pairs"), STAT_DroneRacer_DroneContactPairs, STATGROUP_DroneRacer, DRONERACERFP_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Gate Passes"), STAT_DroneRacer_GatePasses, STATGROUP_DroneRacer, DRONERACERFP_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Projectile Spawns"), STAT_DroneRacer_ProjectileSpawns, STATGROUP_DroneRacer, DRONERACERFP_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Sensor Rays"), STAT_DroneRacer_SensorRays, STATGROUP_DroneRacer, DRONERACERFP_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Pickups"), STAT_DroneRacer_Pickups, STATGROUP_DroneRacer, DRONERACERFP_API);
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(DRONERACERFP_API, DroneRacer);
+
+/**
+ * Times the enclosing scope under one name in all three profilers:
+ * the STAT_DroneRacer_<Name> cycle counter, a CPU trace event and a CSV timing stat.
+ */
+#define DRONERACER_SCOPED_STAT(Name) \
+    SCOPE_CYCLE_COUNTER(STAT_DroneRacer_##Name); \
+    TRACE_CPUPROFILER_EVENT_SCOPE(DroneRacer_##Name); \
+    CSV_SCOPED_TIMING_STAT(DroneRacer, Name)
+
+/** Counts one event in the per-frame stat counter and the CSV capture */
+#define DRONERACER_COUNT_EVENT(Name) \
+    INC_DWORD_STAT(STAT_DroneRacer_##Name); \
+    CSV_CUSTOM_STAT(DroneRacer, Name, 1, ECsvCustomStatOp::Accumulate)
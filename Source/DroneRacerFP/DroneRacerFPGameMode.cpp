@@ -1,25 +1,66 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "DroneRacerFPGameMode.h"
-#include "DroneRacerFPCharacter.h"
-#include "UObject/ConstructorHelpers.h"
+#include "DroneOSDHUD.h"
+#include "DronePreloadSubsystem.h"
+
+#include "Engine/GameInstance.h"
 
 ADroneRacerFPGameMode::ADroneRacerFPGameMode()
 	: Super()
 {
-    // set default pawn class to our Blueprinted character
-    static ConstructorHelpers::FClassFinder<APawn> PlayerPawnClassFinder(
-        TEXT("/Game/BP_DroneFPCharacter")
-    );
+    // The drone class (BP_DroneFPCharacter) is streamed in by UDronePreloadSubsystem
+    // instead of being loaded here, while the game mode's CDO is constructed
+
+    // Pilot OSD, reads the drone's telemetry snapshot
+    HUDClass = ADroneOSDHUD::StaticClass();
 
+}
+
+void ADroneRacerFPGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+    Super::InitGame(MapName, Options, ErrorMessage);
 
-    if (PlayerPawnClassFinder.Succeeded())
+    UDronePreloadSubsystem* Preload = GetGameInstance()->GetSubsystem<UDronePreloadSubsystem>();
+    if (Preload && !Preload->IsReady())
     {
-        DefaultPawnClass = PlayerPawnClassFinder.Class;
+        Preload->OnPreloadComplete.AddUObject(this, &ADroneRacerFPGameMode::OnPreloadComplete);
     }
-    else
+}
+
+UClass* ADroneRacerFPGameMode::GetDefaultPawnClassForController_Implementation(AController* InController)
+{
+    const UDronePreloadSubsystem* Preload = GetGameInstance()->GetSubsystem<UDronePreloadSubsystem>();
+    UClass* DroneClass = Preload ? Preload->GetDroneClass() : nullptr;
+    if (!DroneClass)
     {
         UE_LOG(LogTemp, Warning, TEXT("DroneRacerFPGameMode: Could not find BP_DroneFPCharacter!"));
+        return Super::GetDefaultPawnClassForController_Implementation(InController);
+    }
+    return DroneClass;
+}
+
+void ADroneRacerFPGameMode::RestartPlayer(AController* NewPlayer)
+{
+    const UDronePreloadSubsystem* Preload = GetGameInstance()->GetSubsystem<UDronePreloadSubsystem>();
+    if (Preload && !Preload->IsReady())
+    {
+        // The HUD shows the loading state meanwhile
+        PendingRestarts.AddUnique(NewPlayer);
+        return;
     }
 
+    Super::RestartPlayer(NewPlayer);
+}
+
+void ADroneRacerFPGameMode::OnPreloadComplete()
+{
+    TArray<TWeakObjectPtr<AController>> Restarts = MoveTemp(PendingRestarts);
+    for (const TWeakObjectPtr<AController>& Controller : Restarts)
+    {
+        if (Controller.IsValid())
+        {
+            RestartPlayer(Controller.Get());
+        }
+    }
 }
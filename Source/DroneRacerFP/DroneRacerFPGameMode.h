@@ -6,6 +6,8 @@
 #include "GameFramework/GameModeBase.h"
 #include "DroneRacerFPGameMode.generated.h"
 
+// Spawns pilots as the drone class from UDronePreloadSubsystem.
+// Players that join before the preload is done are spawned once it is.
 UCLASS(minimalapi)
 class ADroneRacerFPGameMode : public AGameModeBase
 {
@@ -13,7 +15,14 @@ class ADroneRacerFPGameMode : public AGameModeBase
 
 public:
 	ADroneRacerFPGameMode();
-};
 
+    virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+    virtual UClass* GetDefaultPawnClassForController_Implementation(AController* InController) override;
+    virtual void RestartPlayer(AController* NewPlayer) override;
 
+private:
+    void OnPreloadComplete();
 
+    // Waiting for the preload to spawn
+    TArray<TWeakObjectPtr<AController>> PendingRestarts;
+};
@@ -1,6 +1,9 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "DroneRacerFPProjectile.h"
+#include "DroneRacerFP.h"
+#include "DroneSignificanceSubsystem.h"
+#include "Particles/ParticleSystemComponent.h"
 #include "GameFramework/ProjectileMovementComponent.h"
 #include "Components/SphereComponent.h"
 
@@ -31,6 +34,42 @@ ADroneRacerFPProjectile::ADroneRacerFPProjectile()
 	InitialLifeSpan = 3.0f;
 }
 
+void ADroneRacerFPProjectile::BeginPlay()
+{
+	Super::BeginPlay();
+
+	INC_DWORD_STAT(STAT_DroneRacer_NumProjectiles);
+
+	if (UDroneSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UDroneSignificanceSubsystem>())
+	{
+		SignificanceHandle = Significance->Register(this, EDroneSignificanceKind::Projectile);
+	}
+}
+
+void ADroneRacerFPProjectile::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	DEC_DWORD_STAT(STAT_DroneRacer_NumProjectiles);
+
+	if (UDroneSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UDroneSignificanceSubsystem>())
+	{
+		Significance->Unregister(SignificanceHandle);
+		SignificanceHandle = INDEX_NONE;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ADroneRacerFPProjectile::SetEffectsCulled(bool bCulled)
+{
+	// Trails and glows added in the Blueprint (Niagara or Cascade)
+	TInlineComponentArray<UFXSystemComponent*> Effects(this);
+	for (UFXSystemComponent* Effect : Effects)
+	{
+		Effect->SetComponentTickEnabled(!bCulled);
+		Effect->SetVisibility(!bCulled);
+	}
+}
+
 void ADroneRacerFPProjectile::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
 {
 	// Only add impulse and destroy projectile if we hit a physics
@@ -25,6 +25,12 @@ class ADroneRacerFPProjectile : public AActor
 public:
 	ADroneRacerFPProjectile();
 
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Hides and stops the projectile's effect components while it is off screen; movement is not affected */
+	void SetEffectsCulled(bool bCulled);
+
 	/** called when projectile hits something */
 	UFUNCTION()
 	void OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
@@ -33,5 +39,9 @@ public:
 	USphereComponent* GetCollisionComp() const { return CollisionComp; }
 	/** Returns ProjectileMovement subobject **/
 	UProjectileMovementComponent* GetProjectileMovement() const { return ProjectileMovement; }
+
+private:
+	/** Handle in UDroneSignificanceSubsystem */
+	int32 SignificanceHandle = INDEX_NONE;
 };
 
@@ -0,0 +1,117 @@
+#include "DroneRangeSensorComponent.h"
+#include "DroneRacerFP.h"
+
+#include "Engine/World.h"
+
+UDroneRangeSensorComponent::UDroneRangeSensorComponent()
+{
+    PrimaryComponentTick.bCanEverTick = true;
+    PrimaryComponentTick.TickGroup = TG_PostPhysics; // issue from where the drone ended up this frame
+}
+
+void UDroneRangeSensorComponent::BeginPlay()
+{
+    Super::BeginPlay();
+
+    const int32 NumRays = GetNumRays();
+    RayDirections.SetNumUninitialized(NumRays);
+    PendingTraces.SetNum(NumRays);
+    Ranges.Init(MaxRange, NumRays);
+    MinRange = MaxRange;
+
+    // A full ring doesn't repeat its first ray at 360 degrees
+    const bool bFullRing = HorizontalFOV >= 360.f;
+    const float YawStep = RaysPerRow > 1 ? HorizontalFOV / (bFullRing ? RaysPerRow : RaysPerRow - 1) : 0.f;
+    const float YawStart = RaysPerRow > 1 ? -0.5f * HorizontalFOV : 0.f;
+    const float PitchStep = NumRows > 1 ? VerticalFOV / (NumRows - 1) : 0.f;
+    const float PitchStart = NumRows > 1 ? -0.5f * VerticalFOV : 0.f;
+
+    for (int32 Row = 0; Row < NumRows; ++Row)
+    {
+        for (int32 Column = 0; Column < RaysPerRow; ++Column)
+        {
+            const FRotator Rotation(PitchStart + Row * PitchStep, YawStart + Column * YawStep, 0.f);
+            RayDirections[Row * RaysPerRow + Column] = Rotation.Vector();
+        }
+    }
+
+    QueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(DroneRangeSensor), /*bTraceComplex*/ false, GetOwner());
+}
+
+void UDroneRangeSensorComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+    Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+    if (bScanPending)
+    {
+        CollectScan();
+    }
+
+    TimeToNextScan -= DeltaTime;
+    if (TimeToNextScan <= 0.f && !bScanPending)
+    {
+        IssueScan();
+
+        // No catching up after a hitch: the next scan would see the same world
+        TimeToNextScan = FMath::Max(TimeToNextScan + 1.f / RateHz, 0.f);
+    }
+}
+
+void UDroneRangeSensorComponent::IssueScan()
+{
+    DRONERACER_SCOPED_STAT(SensorIssue);
+
+    UWorld* World = GetWorld();
+    const FTransform& SensorTransform = GetComponentTransform();
+    const FVector Start = SensorTransform.GetLocation();
+
+    for (int32 RayIndex = 0; RayIndex < RayDirections.Num(); ++RayIndex)
+    {
+        const FVector End = Start + SensorTransform.TransformVectorNoScale(RayDirections[RayIndex]) * MaxRange;
+        PendingTraces[RayIndex] = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Start, End, TraceChannel, QueryParams);
+    }
+
+    INC_DWORD_STAT_BY(STAT_DroneRacer_SensorRays, RayDirections.Num());
+
+    PendingScanTime = World->GetTimeSeconds();
+    bScanPending = true;
+}
+
+void UDroneRangeSensorComponent::CollectScan()
+{
+    DRONERACER_SCOPED_STAT(SensorCollect);
+
+    UWorld* World = GetWorld();
+    FTraceDatum Datum;
+    float NewMin = MaxRange;
+    int32 NewStale = 0;
+
+    for (int32 RayIndex = 0; RayIndex < PendingTraces.Num(); ++RayIndex)
+    {
+        // No result isn't "nothing hit": the ray keeps its last range rather than reading as clear
+        if (World->QueryTraceData(PendingTraces[RayIndex], Datum))
+        {
+            float Range = MaxRange;
+            for (const FHitResult& Hit : Datum.OutHits)
+            {
+                if (Hit.bBlockingHit)
+                {
+                    Range = FMath::Min(Range, Hit.Distance);
+                }
+            }
+            Ranges[RayIndex] = Range;
+        }
+        else
+        {
+            ++NewStale;
+        }
+
+        NewMin = FMath::Min(NewMin, Ranges[RayIndex]);
+        PendingTraces[RayIndex] = FTraceHandle();
+    }
+
+    MinRange = NewMin;
+    NumStaleRays = NewStale;
+    ScanTime = PendingScanTime;
+    bScanPending = false;
+}
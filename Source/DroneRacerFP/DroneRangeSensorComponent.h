@@ -0,0 +1,101 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+#include "WorldCollision.h"
+#include "DroneRangeSensorComponent.generated.h"
+
+/**
+ * Simulated range sensor: a ring (one row) or a low-resolution lidar scan
+ * (several rows) of rays fanned out around the component's forward axis.
+ *
+ * A scan is issued as async line traces, which the physics scene runs in
+ * parallel with the rest of the frame; the ranges are collected on the next
+ * tick into a buffer allocated once at BeginPlay, so a scan costs no
+ * game-thread traces and no allocations. Scans run at up to RateHz, but at
+ * most one per frame, since the world doesn't change between them; the cost
+ * is therefore bounded by RaysPerRow * NumRows per drone per frame.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class DRONERACERFP_API UDroneRangeSensorComponent : public USceneComponent
+{
+    GENERATED_BODY()
+
+public:
+    UDroneRangeSensorComponent();
+
+    virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+    /** Rays per row */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Sensor", meta = (ClampMin = "1", ClampMax = "1024"))
+    int32 RaysPerRow = 16;
+
+    /** 1 for a ring, more for a scan */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Sensor", meta = (ClampMin = "1", ClampMax = "64"))
+    int32 NumRows = 4;
+
+    /** Horizontal field of view (degrees), 360 for a full ring */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Sensor", meta = (ClampMin = "1", ClampMax = "360"))
+    float HorizontalFOV = 360.f;
+
+    /** Vertical field of view (degrees) covered by the rows */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Sensor", meta = (ClampMin = "0", ClampMax = "180"))
+    float VerticalFOV = 30.f;
+
+    /** cm */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sensor", meta = (ClampMin = "1"))
+    float MaxRange = 3000.f;
+
+    /** Scans per second */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sensor", meta = (ClampMin = "0.1"))
+    float RateHz = 100.f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sensor")
+    TEnumAsByte<ECollisionChannel> TraceChannel = ECC_Visibility;
+
+    int32 GetNumRays() const { return RaysPerRow * NumRows; }
+
+    /**
+     * Range per ray from the last completed scan (cm), MaxRange where nothing
+     * was hit. A ray whose trace returned no result keeps its previous range.
+     */
+    TConstArrayView<float> GetRanges() const { return Ranges; }
+
+    /** Rays of the last scan whose trace returned no result and that hold an older range */
+    UFUNCTION(BlueprintPure, Category = "Sensor")
+    int32 GetNumStaleRays() const { return NumStaleRays; }
+
+    UFUNCTION(BlueprintPure, Category = "Sensor")
+    float GetRange(int32 RayIndex) const { return Ranges.IsValidIndex(RayIndex) ? Ranges[RayIndex] : MaxRange; }
+
+    /** Shortest range of the last scan (cm) */
+    UFUNCTION(BlueprintPure, Category = "Sensor")
+    float GetMinRange() const { return MinRange; }
+
+    /** Ray direction relative to the component, rows bottom to top */
+    FVector GetRayDirection(int32 RayIndex) const { return RayDirections[RayIndex]; }
+
+    /** World time the last completed scan was issued at */
+    float GetScanTime() const { return ScanTime; }
+
+protected:
+    virtual void BeginPlay() override;
+
+private:
+    void CollectScan();
+    void IssueScan();
+
+    // Allocated at BeginPlay, reused by every scan
+    TArray<FVector> RayDirections;
+    TArray<FTraceHandle> PendingTraces;
+    TArray<float> Ranges;
+
+    FCollisionQueryParams QueryParams;
+
+    float MinRange = 0.f;
+    int32 NumStaleRays = 0;
+    float ScanTime = 0.f;
+    float PendingScanTime = 0.f;
+    float TimeToNextScan = 0.f;
+    bool bScanPending = false;
+};
@@ -0,0 +1,200 @@
+#include "DroneReplay.h"
+
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
+#include "Hash/CityHash.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+// ===== FDroneReplay =====
+
+FDroneFlightState FDroneReplay::GetInitialState() const
+{
+    FDroneFlightState State;
+    State.Location = FVector(Header.Location[0], Header.Location[1], Header.Location[2]);
+    State.Rotation = FQuat(Header.Rotation[0], Header.Rotation[1], Header.Rotation[2], Header.Rotation[3]);
+    State.Velocity = FVector(Header.Velocity[0], Header.Velocity[1], Header.Velocity[2]);
+    State.Battery01 = Header.Battery01;
+    return State;
+}
+
+FTransform FDroneReplay::GetCourseTransform() const
+{
+    return FTransform(
+        FQuat(Header.CourseRotation[0], Header.CourseRotation[1], Header.CourseRotation[2], Header.CourseRotation[3]),
+        FVector(Header.CourseLocation[0], Header.CourseLocation[1], Header.CourseLocation[2]),
+        FVector(Header.CourseScale[0], Header.CourseScale[1], Header.CourseScale[2]));
+}
+
+uint64 FDroneReplay::ComputeFlightHash(const FDroneFlightParams& Params, float StepSeconds)
+{
+    const float Fields[] =
+    {
+        Params.Mass, Params.MaxLiftForce, Params.DragCoeff,
+        Params.PitchRateDeg, Params.RollRateDeg, Params.YawRateDeg,
+        Params.BatteryFullThrottleSeconds, Params.bBatteryCutsLift ? 1.f : 0.f,
+        Params.GravityZ, StepSeconds,
+    };
+    return CityHash64(reinterpret_cast<const char*>(Fields), sizeof(Fields));
+}
+
+bool FDroneReplay::Load(const FString& Path)
+{
+    TArray64<uint8> Bytes;
+    if (!FFileHelper::LoadFileToArray(Bytes, *Path, FILEREAD_Silent) || Bytes.Num() < int64(sizeof(FDroneReplayHeader)))
+        return false;
+
+    FMemory::Memcpy(&Header, Bytes.GetData(), sizeof(Header));
+    if (Header.Magic != FDroneReplayHeader::ExpectedMagic || Header.Version != FDroneReplayHeader::CurrentVersion
+        || Header.HeaderSize != sizeof(FDroneReplayHeader))
+        return false;
+
+    const int64 StepsBytes = int64(Header.NumSteps) * sizeof(FDroneReplayStep);
+    const int64 ContactsBytes = int64(Header.NumContacts) * sizeof(FDroneReplayContact);
+    if (Bytes.Num() != int64(sizeof(FDroneReplayHeader)) + StepsBytes + ContactsBytes)
+        return false;
+
+    const uint8* Data = Bytes.GetData() + sizeof(FDroneReplayHeader);
+    Steps.SetNumUninitialized(Header.NumSteps);
+    FMemory::Memcpy(Steps.GetData(), Data, StepsBytes);
+    Contacts.SetNumUninitialized(Header.NumContacts);
+    FMemory::Memcpy(Contacts.GetData(), Data + StepsBytes, ContactsBytes);
+    return true;
+}
+
+bool FDroneReplay::Save(const FString& Path) const
+{
+    TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*Path));
+    if (!Writer)
+        return false;
+
+    FDroneReplayHeader Out = Header;
+    Out.NumSteps = Steps.Num();
+    Out.NumContacts = Contacts.Num();
+
+    Writer->Serialize(&Out, sizeof(Out));
+    Writer->Serialize(const_cast<FDroneReplayStep*>(Steps.GetData()), Steps.Num() * sizeof(FDroneReplayStep));
+    Writer->Serialize(const_cast<FDroneReplayContact*>(Contacts.GetData()), Contacts.Num() * sizeof(FDroneReplayContact));
+    return Writer->Close();
+}
+
+// ===== FDroneReplayRecorder =====
+
+void FDroneReplayRecorder::BeginLap(uint64 CourseId, const FTransform& CourseTransform, uint32 GateTest, float StepSeconds, const FDroneFlightParams& Params, const FDroneFlightState& State)
+{
+    FDroneReplayHeader& Header = Replay.Header;
+    Header = FDroneReplayHeader();
+    Header.CourseId = CourseId;
+    Header.GateTest = GateTest;
+    Header.StepSeconds = StepSeconds;
+    Header.Params = Params;
+    Header.FlightHash = FDroneReplay::ComputeFlightHash(Params, StepSeconds);
+
+    const FVector CourseLocation = CourseTransform.GetLocation();
+    const FQuat CourseRotation = CourseTransform.GetRotation();
+    const FVector CourseScale = CourseTransform.GetScale3D();
+    for (int32 Axis = 0; Axis < 3; ++Axis)
+    {
+        Header.CourseLocation[Axis] = CourseLocation[Axis];
+        Header.CourseScale[Axis] = CourseScale[Axis];
+    }
+    Header.CourseRotation[0] = CourseRotation.X;
+    Header.CourseRotation[1] = CourseRotation.Y;
+    Header.CourseRotation[2] = CourseRotation.Z;
+    Header.CourseRotation[3] = CourseRotation.W;
+
+    StartRecording(State);
+}
+
+void FDroneReplayRecorder::BeginNextLap(const FDroneFlightState& State)
+{
+    // EndLap kept the course and params in the header
+    StartRecording(State);
+}
+
+void FDroneReplayRecorder::StartRecording(const FDroneFlightState& State)
+{
+    FDroneReplayHeader& Header = Replay.Header;
+    Header.Location[0] = State.Location.X;
+    Header.Location[1] = State.Location.Y;
+    Header.Location[2] = State.Location.Z;
+    Header.Rotation[0] = State.Rotation.X;
+    Header.Rotation[1] = State.Rotation.Y;
+    Header.Rotation[2] = State.Rotation.Z;
+    Header.Rotation[3] = State.Rotation.W;
+    Header.Velocity[0] = State.Velocity.X;
+    Header.Velocity[1] = State.Velocity.Y;
+    Header.Velocity[2] = State.Velocity.Z;
+    Header.Battery01 = State.Battery01;
+
+    // Keeps the capacity of the previous lap
+    Replay.Steps.Reset();
+    Replay.Contacts.Reset();
+
+    bRecording = true;
+    bTainted = false;
+}
+
+void FDroneReplayRecorder::AddStep(const FDroneFlightInput& Input, const FVector& Wind, bool bArmed)
+{
+    if (!bRecording)
+        return;
+
+    FDroneReplayStep& Step = Replay.Steps.AddDefaulted_GetRef();
+    Step.Input = Input;
+    Step.Wind[0] = float(Wind.X);
+    Step.Wind[1] = float(Wind.Y);
+    Step.Wind[2] = float(Wind.Z);
+    Step.Flags = bArmed ? FDroneReplayStep::Armed : 0;
+}
+
+void FDroneReplayRecorder::AddContact(const FVector& Location, const FVector& Velocity, uint32 Flags)
+{
+    if (!bRecording || Replay.Steps.Num() == 0)
+        return;
+
+    const uint32 StepIndex = Replay.Steps.Num() - 1;
+    Replay.Steps.Last().Flags |= FDroneReplayStep::Contact;
+
+    // A slide and a push in the same step (or two pushes) leave one state to continue from
+    const bool bSameStep = Replay.Contacts.Num() > 0 && Replay.Contacts.Last().Step == StepIndex;
+    FDroneReplayContact& Contact = bSameStep ? Replay.Contacts.Last() : Replay.Contacts.AddDefaulted_GetRef();
+    Contact.Step = StepIndex;
+    Contact.Flags |= Flags;
+    Contact.Location[0] = Location.X;
+    Contact.Location[1] = Location.Y;
+    Contact.Location[2] = Location.Z;
+    Contact.Velocity[0] = Velocity.X;
+    Contact.Velocity[1] = Velocity.Y;
+    Contact.Velocity[2] = Velocity.Z;
+}
+
+bool FDroneReplayRecorder::EndLap(const FString& Path)
+{
+    const bool bValid = bRecording && !bTainted && Replay.Steps.Num() > 0;
+    bRecording = false;
+
+    if (!bValid)
+    {
+        Replay.Steps.Reset();
+        Replay.Contacts.Reset();
+        return false;
+    }
+
+    // Written on the thread pool; the next lap starts with a buffer of the same size
+    const int32 NumSteps = Replay.Steps.Num();
+    Async(EAsyncExecution::ThreadPool, [Path, ToSave = MoveTemp(Replay)]()
+    {
+        IFileManager::Get().MakeDirectory(*FPaths::GetPath(Path), true);
+        if (!ToSave.Save(Path))
+        {
+            UE_LOG(LogTemp, Error, TEXT("DroneReplay: could not write %s"), *Path);
+        }
+    });
+
+    const FDroneReplayHeader LastHeader = Replay.Header;
+    Replay = FDroneReplay();
+    Replay.Header = LastHeader;
+    Replay.Steps.Reserve(NumSteps);
+    return true;
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DroneFlightModel.h"
+
+// ===== Lap replay file format (.drreplay) =====
+//
+// [FDroneReplayHeader][FDroneReplayStep x NumSteps][FDroneReplayContact x NumContacts]
+//
+// One file per lap: the drone state when the lap started and the flight
+// model input of every physics step until the step that crossed the last
+// gate. Steps where the world changed the state beyond the flight model
+// (sweep contacts) carry the resulting state so a headless re-simulation
+// can follow them, one record per step however many contacts it had.
+// Little-endian raw POD records, like course files.
+
+struct FDroneReplayHeader
+{
+    /** How the race scored gate passes */
+    enum EGateTest : uint32
+    {
+        /** Instanced gates: the step's segment through the opening (RaceCourse::SegmentCrossesGate) */
+        Opening = 0,
+        /** Gate actors: the drone beginning to overlap ARaceGate::GateTrigger (RaceCourse::SegmentEntersGateTrigger) */
+        Trigger = 1,
+    };
+
+    static constexpr uint32 ExpectedMagic = 0x50525244; // 'DRRP'
+    static constexpr uint16 CurrentVersion = 5;
+
+    uint32 Magic = ExpectedMagic;
+    uint16 Version = CurrentVersion;
+    uint16 HeaderSize = sizeof(FDroneReplayHeader);
+    uint64 CourseId = 0;
+
+    float StepSeconds = 0.f;
+    uint32 NumSteps = 0;
+    uint32 NumContacts = 0;
+
+    FDroneFlightParams Params;
+
+    // Transform of the ARaceGateManager the course was loaded under; course
+    // file gates are relative to it
+    double CourseLocation[3] = {};
+    double CourseRotation[4] = { 0.0, 0.0, 0.0, 1.0 };
+    double CourseScale[3] = { 1.0, 1.0, 1.0 };
+
+    // State at the start of the lap; doubles so it restores exactly
+    double Location[3] = {};
+    double Rotation[4] = { 0.0, 0.0, 0.0, 1.0 };
+    double Velocity[3] = {};
+    float Battery01 = 1.f;
+    uint32 GateTest = Opening;
+
+    /** FDroneReplay::ComputeFlightHash of Params and StepSeconds, what verifiers allow laps by */
+    uint64 FlightHash = 0;
+};
+static_assert(sizeof(FDroneReplayHeader) == 240, "Replay header is written as raw bytes");
+
+/** One physics step, 32 bytes */
+struct FDroneReplayStep
+{
+    enum EFlags : uint32
+    {
+        Armed = 1 << 0,
+        Contact = 1 << 1,
+    };
+
+    FDroneFlightInput Input;
+
+    /** Air velocity the drone sampled (cm/s) */
+    float Wind[3] = {};
+
+    uint32 Flags = 0;
+};
+static_assert(sizeof(FDroneReplayStep) == 32, "Replay steps are written as raw bytes");
+
+/** State after a step whose sweep hit something, or another drone pushed */
+struct FDroneReplayContact
+{
+    enum EFlags : uint32
+    {
+        /** Another drone moved this one (UDroneContactSubsystem), not only the world's slide */
+        DronePush = 1 << 0,
+    };
+
+    uint32 Step = 0;
+    uint32 Flags = 0;
+    double Location[3] = {};
+    double Velocity[3] = {};
+};
+static_assert(sizeof(FDroneReplayContact) == 56, "Replay contacts are written as raw bytes");
+
+/** A loaded replay */
+struct DRONERACERFP_API FDroneReplay
+{
+    FDroneReplayHeader Header;
+    TArray<FDroneReplayStep> Steps;
+    TArray<FDroneReplayContact> Contacts;
+
+    FDroneFlightState GetInitialState() const;
+    FTransform GetCourseTransform() const;
+
+    /** Hash of the flight params and physics step a lap was flown with, field by field so padding doesn't count */
+    static uint64 ComputeFlightHash(const FDroneFlightParams& Params, float StepSeconds);
+
+    bool Load(const FString& Path);
+    bool Save(const FString& Path) const;
+};
+
+/**
+ * Records the replay of the lap in progress. Finished laps are written on the
+ * thread pool; the next lap's buffer is reserved at the size of the last one.
+ *
+ * A lap becomes unverifiable (Taint) when something outside the flight model
+ * moved the drone, e.g. a practice rewind or crash respawn.
+ */
+class DRONERACERFP_API FDroneReplayRecorder
+{
+public:
+    void BeginLap(uint64 CourseId, const FTransform& CourseTransform, uint32 GateTest, float StepSeconds, const FDroneFlightParams& Params, const FDroneFlightState& State);
+
+    /** Starts the lap following the one EndLap ended, on the same course */
+    void BeginNextLap(const FDroneFlightState& State);
+
+    void AddStep(const FDroneFlightInput& Input, const FVector& Wind, bool bArmed);
+
+    /**
+     * The last added step ended in Location / Velocity instead of where the
+     * model put it. Later contacts on the same step replace the state of
+     * earlier ones and keep their flags.
+     */
+    void AddContact(const FVector& Location, const FVector& Velocity, uint32 Flags = 0);
+
+    void Taint() { bTainted = true; }
+
+    bool IsRecording() const { return bRecording; }
+    bool IsTainted() const { return bTainted; }
+
+    /** Starts writing the lap to Path; false if nothing (or a tainted lap) was recorded */
+    bool EndLap(const FString& Path);
+
+private:
+    void StartRecording(const FDroneFlightState& State);
+
+    FDroneReplay Replay;
+    bool bRecording = false;
+    bool bTainted = false;
+};
@@ -0,0 +1,401 @@
+#include "DroneSITLBridge.h"
+#include "DroneFPCharacter.h"
+#include "DroneRacerFP.h"
+
+#include "Common/UdpSocketBuilder.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "SocketSubsystem.h"
+#include "Sockets.h"
+
+static FAutoConsoleCommandWithWorld GSITLStatsCommand(
+    TEXT("DroneRacer.SITL.Stats"),
+    TEXT("Logs packet counts, jitter and latency of every drone flown by a SITL flight controller"),
+    FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+    {
+        for (TActorIterator<ADroneFPCharacter> It(World); It; ++It)
+        {
+            FDroneSITLStats Stats;
+            FDroneSITLBridge* Bridge = It->GetSITLBridge();
+            if (!Bridge || !Bridge->GetStats(Stats))
+                continue;
+
+            UE_LOG(LogTemp, Log, TEXT("%s: %s, state %llu / rc %llu sent, motors %llu received, %llu bad, %llu send failures, "
+                "jitter %.0f us mean %.0f us max, latency %.2f ms mean %.2f ms max"),
+                *It->GetName(), Stats.bConnected ? TEXT("connected") : TEXT("no flight controller"),
+                Stats.StatePacketsSent, Stats.RcPacketsSent, Stats.MotorPacketsReceived, Stats.BadPackets, Stats.SendFailures,
+                Stats.JitterMeanUs, Stats.JitterMaxUs, Stats.LatencyMeanMs, Stats.LatencyMaxMs);
+        }
+    }));
+
+namespace DroneSITL
+{
+    /** Stick -1..1 to an RC channel, 1500 centred */
+    uint16 StickToPwm(float Stick)
+    {
+        return uint16(FMath::Clamp(FMath::RoundToInt32(1500.f + 500.f * Stick), 1000, 2000));
+    }
+
+    /** Near sea level pressure falls about 12 Pa per metre */
+    constexpr double SeaLevelPressure = 101325.0;
+    constexpr double PressurePerMetre = 12.0;
+
+    /** Shorter waits are spun instead of slept */
+    constexpr double MinWaitSeconds = 0.0002;
+}
+
+FDroneMotorParams FDroneSITLSettings::ToMotorParams() const
+{
+    FDroneMotorParams Params;
+    Params.RollPitchAccelDeg = RollPitchAccelDeg;
+    Params.YawAccelDeg = YawAccelDeg;
+    Params.AngularDamping = AngularDamping;
+    Params.MotorTimeConstant = MotorTimeConstant;
+    return Params;
+}
+
+FDroneSITLBridge::FDroneSITLBridge(const FDroneFlightChannelRef& InChannel, const FDroneSITLSettings& Settings)
+    : Channel(InChannel)
+    , MotorParams(Settings.ToMotorParams())
+{
+    // Sticks centred, throttle low, AUX channels off
+    for (int32 Index = 0; Index < FDroneSITLRcPacket::NumChannels; ++Index)
+    {
+        RcPacket.Channels[Index] = 1000;
+    }
+    RcPacket.Channels[0] = RcPacket.Channels[1] = RcPacket.Channels[3] = 1500;
+
+    if (!OpenSockets(Settings))
+        return;
+
+    AllowUntilNowPlusLead();
+    Thread = FRunnableThread::Create(this, TEXT("DroneSITLBridge"), 0, TPri_AboveNormal);
+
+    UE_LOG(LogTemp, Log, TEXT("DroneSITL: sending to 127.0.0.1:%d / %d, motors on %d, %d Hz"),
+        Settings.StatePort, Settings.RcPort, Settings.MotorPort, StepHz);
+}
+
+FDroneSITLBridge::~FDroneSITLBridge()
+{
+    if (Thread)
+    {
+        Thread->Kill(true);
+        delete Thread;
+        Thread = nullptr;
+    }
+
+    CloseSockets();
+}
+
+bool FDroneSITLBridge::OpenSockets(const FDroneSITLSettings& Settings)
+{
+    // Loopback only: the flight controller runs on this machine
+    ReceiveSocket = FUdpSocketBuilder(TEXT("DroneSITLMotors"))
+        .AsNonBlocking()
+        .AsReusable()
+        .BoundToAddress(FIPv4Address::InternalLoopback)
+        .BoundToPort(uint16(Settings.MotorPort))
+        .Build();
+
+    SendSocket = FUdpSocketBuilder(TEXT("DroneSITLSensors"))
+        .AsNonBlocking()
+        .Build();
+
+    if (!ReceiveSocket || !SendSocket)
+    {
+        UE_LOG(LogTemp, Error, TEXT("DroneSITL: can't open UDP sockets (motor port %d in use?)"), Settings.MotorPort);
+        CloseSockets();
+        return false;
+    }
+
+    StateAddress = FIPv4Endpoint(FIPv4Address::InternalLoopback, uint16(Settings.StatePort)).ToInternetAddr();
+    RcAddress = FIPv4Endpoint(FIPv4Address::InternalLoopback, uint16(Settings.RcPort)).ToInternetAddr();
+    return true;
+}
+
+void FDroneSITLBridge::CloseSockets()
+{
+    ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+    for (FSocket** Socket : { &SendSocket, &ReceiveSocket })
+    {
+        if (*Socket)
+        {
+            (*Socket)->Close();
+            SocketSubsystem->DestroySocket(*Socket);
+            *Socket = nullptr;
+        }
+    }
+}
+
+void FDroneSITLBridge::AllowUntilNowPlusLead()
+{
+    AllowedUntil.store(FPlatformTime::Seconds() + MaxLeadSeconds, std::memory_order_relaxed);
+}
+
+bool FDroneSITLBridge::GetStats(FDroneSITLStats& OutStats)
+{
+    if (Stats.IsDirty())
+    {
+        Stats.SwapReadBuffers();
+        bHasStats = true;
+    }
+
+    if (!bHasStats)
+        return false;
+
+    OutStats = Stats.Read();
+    return true;
+}
+
+void FDroneSITLBridge::Stop()
+{
+    bStopping = true;
+}
+
+uint32 FDroneSITLBridge::Run()
+{
+    double NextStepTime = FPlatformTime::Seconds();
+    WindowStart = NextStepTime;
+
+    while (!bStopping)
+    {
+        const double Now = FPlatformTime::Seconds();
+        ReceiveMotors(Now);
+        UpdateStats(Now);
+
+        // Held back by a paused or stalled game; the flight controller's clock stops with ours
+        const double Allowed = AllowedUntil.load(std::memory_order_relaxed);
+        if (Allowed < Now && NextStepTime > Allowed)
+        {
+            NextStepTime = Now;
+            FPlatformProcess::SleepNoStats(StepSeconds);
+            continue;
+        }
+
+        if (NextStepTime <= Now)
+        {
+            const double LateUs = (Now - NextStepTime) * 1e6;
+            JitterSumUs += LateUs;
+            ++JitterCount;
+            Window.JitterMaxUs = FMath::Max(Window.JitterMaxUs, float(LateUs));
+        }
+
+        int32 NumSteps = 0;
+        while (NextStepTime <= Now && NumSteps < MaxCatchUpSteps)
+        {
+            NextStepTime += StepSeconds;
+            ++NumSteps;
+        }
+
+        if (NextStepTime <= Now)
+        {
+            NextStepTime = Now;
+        }
+
+        if (NumSteps > 0)
+        {
+            StepDrone(NumSteps);
+        }
+
+        // Wakes early for a motor packet, so the answer to this step's state is used right away
+        const double Wait = NextStepTime - FPlatformTime::Seconds();
+        if (Wait > DroneSITL::MinWaitSeconds)
+        {
+            ReceiveSocket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromSeconds(Wait));
+        }
+    }
+    return 0;
+}
+
+void FDroneSITLBridge::StepDrone(int32 NumSteps)
+{
+    DRONERACER_SCOPED_STAT(SITLBridge);
+
+    FDroneFlightChannel& C = *Channel;
+    for (int32 Step = 0; Step < NumSteps; ++Step)
+    {
+        C.DequeueCommands();
+        if (!C.bHasState)
+            return;
+
+        // The flight controller's position is relative to where the drone started
+        if (OriginVersion == MAX_uint32)
+        {
+            Origin = C.Simulated.State.Location;
+            OriginVersion = C.Simulated.Version;
+        }
+
+        const FVector PreviousVelocity = C.Simulated.State.Velocity;
+        if (C.Current.bArmed)
+        {
+            FDroneFlightModel::StepMotors(C.Current.Params, MotorParams, C.Simulated.State, Motors, MotorCommands01, C.Current.Wind, StepSeconds);
+            ++C.Simulated.NumSteps;
+        }
+        Acceleration = (C.Simulated.State.Velocity - PreviousVelocity) / StepSeconds;
+
+        // The flight controller needs sensors every step, armed or not, to keep its loop running
+        ++SimSteps;
+        SendState();
+        if (SimSteps % StepsPerRcPacket == 0)
+        {
+            SendRc();
+        }
+    }
+
+    FMemory::Memcpy(C.Simulated.Motors01, Motors.Spin01, sizeof(C.Simulated.Motors01));
+    C.Simulated.bHasMotors = true;
+    C.Outputs.Write(C.Simulated);
+}
+
+void FDroneSITLBridge::SendState()
+{
+    const FDroneFlightState& State = Channel->Simulated.State;
+    const float GravityZ = Channel->Current.Params.GravityZ;
+
+    // Local / world X, Y, Z (Z up) to FRD / NED: positions flip Z, angular vectors flip X and Y
+    StatePacket.Timestamp = SimSteps * double(StepSeconds);
+
+    const FVector& Rates = Motors.BodyRates;
+    StatePacket.AngularVelocityRpy[0] = -Rates.X;
+    StatePacket.AngularVelocityRpy[1] = -Rates.Y;
+    StatePacket.AngularVelocityRpy[2] = Rates.Z;
+
+    // What an accelerometer feels: acceleration minus gravity, in the body frame
+    const FVector SpecificForce = State.Rotation.UnrotateVector(Acceleration - FVector(0.f, 0.f, GravityZ)) / 100.0;
+    StatePacket.LinearAccelerationXyz[0] = SpecificForce.X;
+    StatePacket.LinearAccelerationXyz[1] = SpecificForce.Y;
+    StatePacket.LinearAccelerationXyz[2] = -SpecificForce.Z;
+
+    StatePacket.OrientationQuat[0] = State.Rotation.W;
+    StatePacket.OrientationQuat[1] = -State.Rotation.X;
+    StatePacket.OrientationQuat[2] = -State.Rotation.Y;
+    StatePacket.OrientationQuat[3] = State.Rotation.Z;
+
+    const FVector Velocity = State.Velocity / 100.0;
+    StatePacket.VelocityXyz[0] = Velocity.X;
+    StatePacket.VelocityXyz[1] = Velocity.Y;
+    StatePacket.VelocityXyz[2] = -Velocity.Z;
+
+    const FVector Position = (State.Location - Origin) / 100.0;
+    StatePacket.PositionXyz[0] = Position.X;
+    StatePacket.PositionXyz[1] = Position.Y;
+    StatePacket.PositionXyz[2] = -Position.Z;
+
+    StatePacket.Pressure = DroneSITL::SeaLevelPressure - DroneSITL::PressurePerMetre * Position.Z;
+
+    int32 BytesSent = 0;
+    if (SendSocket->SendTo(reinterpret_cast<const uint8*>(&StatePacket), sizeof(StatePacket), BytesSent, *StateAddress))
+    {
+        ++Window.StatePacketsSent;
+
+        // Latency is measured from the first state a motor packet answers
+        if (StateSentTime < 0.0)
+        {
+            StateSentTime = FPlatformTime::Seconds();
+        }
+    }
+    else
+    {
+        ++Window.SendFailures;
+    }
+}
+
+void FDroneSITLBridge::SendRc()
+{
+    const FDroneFlightInput& Input = Channel->Current.Input;
+
+    // AETR: the model's Pitch is nose up, a pushed pitch stick is nose down
+    RcPacket.Timestamp = SimSteps * double(StepSeconds);
+    RcPacket.Channels[0] = DroneSITL::StickToPwm(Input.Roll);
+    RcPacket.Channels[1] = DroneSITL::StickToPwm(-Input.Pitch);
+    RcPacket.Channels[2] = uint16(1000 + FMath::Clamp(FMath::RoundToInt32(Input.Throttle01 * 1000.f), 0, 1000));
+    RcPacket.Channels[3] = DroneSITL::StickToPwm(Input.Yaw);
+
+    // AUX1 arms the flight controller with the drone
+    RcPacket.Channels[4] = Channel->Current.bArmed ? 2000 : 1000;
+
+    int32 BytesSent = 0;
+    if (SendSocket->SendTo(reinterpret_cast<const uint8*>(&RcPacket), sizeof(RcPacket), BytesSent, *RcAddress))
+    {
+        ++Window.RcPacketsSent;
+    }
+    else
+    {
+        ++Window.SendFailures;
+    }
+}
+
+void FDroneSITLBridge::ReceiveMotors(double Now)
+{
+    int32 BytesRead = 0;
+    while (ReceiveSocket->Recv(ReceiveBuffer, sizeof(ReceiveBuffer), BytesRead) && BytesRead > 0)
+    {
+        if (BytesRead != sizeof(FDroneSITLMotorPacket))
+        {
+            ++Window.BadPackets;
+            continue;
+        }
+
+        FDroneSITLMotorPacket Packet;
+        FMemory::Memcpy(&Packet, ReceiveBuffer, sizeof(Packet));
+
+        // 3D mode (reversible motors, -1..1) isn't modelled
+        for (int32 Motor = 0; Motor < 4; ++Motor)
+        {
+            MotorCommands01[Motor] = FMath::Clamp(Packet.MotorSpeed[Motor], 0.f, 1.f);
+        }
+
+        ++Window.MotorPacketsReceived;
+        LastMotorPacketTime = Now;
+
+        if (StateSentTime >= 0.0)
+        {
+            const double LatencyMs = (Now - StateSentTime) * 1000.0;
+            LatencySumMs += LatencyMs;
+            ++LatencyCount;
+            Window.LatencyMaxMs = FMath::Max(Window.LatencyMaxMs, float(LatencyMs));
+            StateSentTime = -1.0;
+        }
+    }
+
+    // Flight controller gone: motors stop rather than holding the last command
+    if (LastMotorPacketTime < 0.0 || Now - LastMotorPacketTime > MotorTimeoutSeconds)
+    {
+        FMemory::Memzero(MotorCommands01, sizeof(MotorCommands01));
+    }
+}
+
+void FDroneSITLBridge::UpdateStats(double Now)
+{
+    const bool bConnected = LastMotorPacketTime >= 0.0 && Now - LastMotorPacketTime <= MotorTimeoutSeconds;
+    if (bConnected != bWasConnected)
+    {
+        bWasConnected = bConnected;
+        if (bConnected)
+        {
+            UE_LOG(LogTemp, Log, TEXT("DroneSITL: flight controller connected"));
+        }
+        else
+        {
+            UE_LOG(LogTemp, Warning, TEXT("DroneSITL: no motor packets for %.0f ms, motors stopped"), MotorTimeoutSeconds * 1000.0);
+        }
+    }
+
+    if (Now - WindowStart < StatsWindowSeconds)
+        return;
+
+    Window.JitterMeanUs = JitterCount > 0 ? float(JitterSumUs / JitterCount) : 0.f;
+    Window.LatencyMeanMs = LatencyCount > 0 ? float(LatencySumMs / LatencyCount) : 0.f;
+    Window.bConnected = bConnected;
+    Stats.Write(Window);
+
+    Window = FDroneSITLStats();
+    WindowStart = Now;
+    JitterSumUs = 0.0;
+    JitterCount = 0;
+    LatencySumMs = 0.0;
+    LatencyCount = 0;
+}
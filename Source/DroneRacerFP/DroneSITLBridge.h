@@ -0,0 +1,223 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/TripleBuffer.h"
+#include "HAL/Runnable.h"
+#include "DroneFlightModel.h"
+#include "DroneFlightThread.h"
+#include <atomic>
+#include "DroneSITLBridge.generated.h"
+
+class FSocket;
+class FInternetAddr;
+
+// ===== Betaflight SITL packets (src/main/target/SITL) =====
+//
+// Raw little-endian structs over UDP on the loopback interface. Body axes
+// are forward-right-down and world axes north-east-down, mapped from the
+// drone's local X / Y / Z and world X / Y / -Z.
+
+/** Simulator -> flight controller sensors, to StatePort */
+struct FDroneSITLStatePacket
+{
+    /** Simulated seconds */
+    double Timestamp = 0.0;
+
+    /** Gyro, body roll / pitch / yaw rates (rad/s) */
+    double AngularVelocityRpy[3] = {};
+
+    /** Accelerometer, body specific force (m/s^2), -9.81 on Z at rest */
+    double LinearAccelerationXyz[3] = {};
+
+    /** Attitude W, X, Y, Z */
+    double OrientationQuat[4] = { 1.0, 0.0, 0.0, 0.0 };
+
+    /** World m/s and m from the drone's start */
+    double VelocityXyz[3] = {};
+    double PositionXyz[3] = {};
+
+    /** Pa */
+    double Pressure = 101325.0;
+};
+static_assert(sizeof(FDroneSITLStatePacket) == 144, "SITL state packets are sent as raw bytes");
+
+/** Simulator -> flight controller sticks, to RcPort */
+struct FDroneSITLRcPacket
+{
+    static constexpr int32 NumChannels = 16;
+
+    double Timestamp = 0.0;
+
+    /** 1000..2000 us, AETR then AUX1 (arm) */
+    uint16 Channels[NumChannels] = {};
+};
+static_assert(sizeof(FDroneSITLRcPacket) == 40, "SITL RC packets are sent as raw bytes");
+
+/** Flight controller -> simulator, received on MotorPort */
+struct FDroneSITLMotorPacket
+{
+    /** 0..1, Betaflight Quad X motor order */
+    float MotorSpeed[4] = {};
+};
+static_assert(sizeof(FDroneSITLMotorPacket) == 16, "SITL motor packets are received as raw bytes");
+
+/** Where the SITL process listens and how the simulated motors respond */
+USTRUCT(BlueprintType)
+struct DRONERACERFP_API FDroneSITLSettings
+{
+    GENERATED_BODY()
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SITL")
+    int32 StatePort = 9003;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SITL")
+    int32 RcPort = 9004;
+
+    /** Bound on 127.0.0.1 */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SITL")
+    int32 MotorPort = 9002;
+
+    /** See FDroneMotorParams */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SITL", meta = (ClampMin = "0"))
+    float RollPitchAccelDeg = 6000.f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SITL", meta = (ClampMin = "0"))
+    float YawAccelDeg = 1200.f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SITL", meta = (ClampMin = "0"))
+    float AngularDamping = 1.f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SITL", meta = (ClampMin = "0.001"))
+    float MotorTimeConstant = 0.02f;
+
+    FDroneMotorParams ToMotorParams() const;
+};
+
+/** Link health over the last StatsWindowSeconds */
+struct FDroneSITLStats
+{
+    uint64 StatePacketsSent = 0;
+    uint64 RcPacketsSent = 0;
+    uint64 MotorPacketsReceived = 0;
+
+    /** Received packets of the wrong size, and sends the socket refused */
+    uint64 BadPackets = 0;
+    uint64 SendFailures = 0;
+
+    /** How late step batches started against the step clock (us) */
+    float JitterMeanUs = 0.f;
+    float JitterMaxUs = 0.f;
+
+    /** From sending a state to the next motor packet (ms) */
+    float LatencyMeanMs = 0.f;
+    float LatencyMaxMs = 0.f;
+
+    /** Motor packets arrived within MotorTimeoutSeconds */
+    bool bConnected = false;
+};
+
+/**
+ * Flies one drone with a Betaflight SITL flight controller running on the
+ * same machine, in place of the stick-rate model.
+ *
+ * An I/O thread steps the drone at StepHz with FDroneFlightModel::StepMotors
+ * from the motor speeds the flight controller last sent, and after every
+ * step sends it the simulated gyro, accelerometer and attitude. Sticks go
+ * out as RC channels every StepsPerRcPacket steps. The game thread talks to
+ * the thread through the same FDroneFlightChannel as FDroneFlightThread, so
+ * the drone moves, collides and reports contacts exactly as with
+ * bThreadedFlight. Packets live in preallocated members; nothing allocates
+ * once running.
+ *
+ * Without motor packets for MotorTimeoutSeconds the motors are commanded to
+ * stop, so a closed SITL process drops the drone instead of freezing it.
+ * Jitter and latency are published every StatsWindowSeconds
+ * (DroneRacer.SITL.Stats).
+ */
+class DRONERACERFP_API FDroneSITLBridge : public FRunnable
+{
+public:
+    static constexpr int32 StepHz = 1000;
+    static constexpr float StepSeconds = 1.f / StepHz;
+
+    /** As FDroneFlightThread: a paused game holds the drone, a short hitch doesn't */
+    static constexpr double MaxLeadSeconds = 0.1;
+    static constexpr int32 MaxCatchUpSteps = 20;
+
+    /** Betaflight's RX task runs far slower than its gyro loop */
+    static constexpr int32 StepsPerRcPacket = 10;
+
+    static constexpr double MotorTimeoutSeconds = 0.1;
+    static constexpr double StatsWindowSeconds = 1.0;
+
+    /** Opens the sockets and starts the thread; check IsRunning */
+    FDroneSITLBridge(const FDroneFlightChannelRef& InChannel, const FDroneSITLSettings& Settings);
+    virtual ~FDroneSITLBridge();
+
+    bool IsRunning() const { return Thread != nullptr; }
+
+    /** Game thread, every frame the world isn't paused */
+    void AllowUntilNowPlusLead();
+
+    /** Game thread; the last full window, false before the first */
+    bool GetStats(FDroneSITLStats& OutStats);
+
+    // FRunnable
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    bool OpenSockets(const FDroneSITLSettings& Settings);
+    void CloseSockets();
+
+    void StepDrone(int32 NumSteps);
+    void SendState();
+    void SendRc();
+    void ReceiveMotors(double Now);
+    void UpdateStats(double Now);
+
+    FDroneFlightChannelRef Channel;
+    FDroneMotorParams MotorParams;
+
+    FRunnableThread* Thread = nullptr;
+    std::atomic<bool> bStopping { false };
+    std::atomic<double> AllowedUntil { 0.0 };
+
+    FSocket* SendSocket = nullptr;
+    FSocket* ReceiveSocket = nullptr;
+    TSharedPtr<FInternetAddr> StateAddress;
+    TSharedPtr<FInternetAddr> RcAddress;
+
+    // ===== I/O thread only =====
+
+    FDroneSITLStatePacket StatePacket;
+    FDroneSITLRcPacket RcPacket;
+    uint8 ReceiveBuffer[256];
+
+    FDroneMotorState Motors;
+    float MotorCommands01[4] = { 0.f, 0.f, 0.f, 0.f };
+
+    /** Where the drone was first placed, the flight controller's position origin */
+    FVector Origin = FVector::ZeroVector;
+    uint32 OriginVersion = MAX_uint32;
+
+    /** Acceleration of the last step (cm/s^2), for the accelerometer */
+    FVector Acceleration = FVector::ZeroVector;
+
+    uint64 SimSteps = 0;
+    double LastMotorPacketTime = -1.0;
+
+    /** Time the state a motor packet answers was sent, negative when one already has */
+    double StateSentTime = -1.0;
+
+    FDroneSITLStats Window;
+    double WindowStart = 0.0;
+    double JitterSumUs = 0.0;
+    int32 JitterCount = 0;
+    double LatencySumMs = 0.0;
+    int32 LatencyCount = 0;
+    bool bWasConnected = false;
+
+    TTripleBuffer<FDroneSITLStats> Stats;
+    bool bHasStats = false;
+};
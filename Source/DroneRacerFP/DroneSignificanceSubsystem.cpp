@@ -0,0 +1,350 @@
+#include "DroneSignificanceSubsystem.h"
+#include "DroneFPCharacter.h"
+#include "DroneRacerFPProjectile.h"
+#include "DroneRacerFP.h"
+#include "RaceGate.h"
+
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<bool> CVarSignificance(
+    TEXT("DroneRacer.Significance"),
+    true,
+    TEXT("Scale drone, gate and projectile updates by how relevant they are to the viewers (0: everything at full rate)"));
+
+static TAutoConsoleVariable<float> CVarSignificanceBudgetMs(
+    TEXT("DroneRacer.Significance.BudgetMs"),
+    0.2f,
+    TEXT("Game-thread time spent scoring objects per frame (ms); the rest is scored on the next frames"));
+
+static FAutoConsoleCommandWithWorld GSignificanceReportCommand(
+    TEXT("DroneRacer.Significance.Report"),
+    TEXT("Logs every drone, gate and projectile that is currently throttled"),
+    FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+    {
+        if (const UDroneSignificanceSubsystem* Significance = World ? World->GetSubsystem<UDroneSignificanceSubsystem>() : nullptr)
+        {
+            Significance->LogReport();
+        }
+    }));
+
+namespace DroneSignificance
+{
+    /** Extra view cone half angle, so objects at the screen edge don't flicker between tiers */
+    constexpr float ViewMarginDeg = 10.f;
+
+    /** Entries scored between checks of the budget */
+    constexpr int32 EntriesPerBudgetCheck = 8;
+
+    const TCHAR* KindName(EDroneSignificanceKind Kind)
+    {
+        switch (Kind)
+        {
+        case EDroneSignificanceKind::Drone:      return TEXT("Drone");
+        case EDroneSignificanceKind::Gate:       return TEXT("Gate");
+        case EDroneSignificanceKind::Projectile: return TEXT("Projectile");
+        }
+        return TEXT("?");
+    }
+}
+
+const TCHAR* LexToString(EDroneSignificance Significance)
+{
+    switch (Significance)
+    {
+    case EDroneSignificance::Full:    return TEXT("Full");
+    case EDroneSignificance::Reduced: return TEXT("Reduced");
+    case EDroneSignificance::Minimal: return TEXT("Minimal");
+    case EDroneSignificance::Off:     return TEXT("Off");
+    }
+    return TEXT("?");
+}
+
+bool UDroneSignificanceSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UDroneSignificanceSubsystem::Deinitialize()
+{
+    RestoreAll();
+    Entries.Empty();
+
+    Super::Deinitialize();
+}
+
+int32 UDroneSignificanceSubsystem::Register(AActor* Actor, EDroneSignificanceKind Kind)
+{
+    FEntry Entry;
+    Entry.Actor = Actor;
+    Entry.Kind = Kind;
+    return Entries.Add(MoveTemp(Entry));
+}
+
+void UDroneSignificanceSubsystem::Unregister(int32 Handle)
+{
+    if (!Entries.IsValidIndex(Handle))
+        return;
+
+    // The actor is going away, only the bookkeeping is undone
+    const FEntry& Entry = Entries[Handle];
+    if (IsThrottled(Entry.Kind, Entry.Significance))
+    {
+        --NumThrottled[int32(Entry.Kind)];
+    }
+    if (Entry.Kind == EDroneSignificanceKind::Drone)
+    {
+        InterpolatedDrones.Remove(Cast<ADroneFPCharacter>(Entry.Actor.Get()));
+    }
+
+    Entries.RemoveAt(Handle);
+}
+
+EDroneSignificance UDroneSignificanceSubsystem::GetSignificance(int32 Handle) const
+{
+    return Entries.IsValidIndex(Handle) ? Entries[Handle].Significance : EDroneSignificance::Full;
+}
+
+bool UDroneSignificanceSubsystem::IsThrottled(EDroneSignificanceKind Kind, EDroneSignificance Significance)
+{
+    switch (Kind)
+    {
+    case EDroneSignificanceKind::Gate:
+        return Significance >= EDroneSignificance::Minimal;
+    case EDroneSignificanceKind::Drone:
+    case EDroneSignificanceKind::Projectile:
+    default:
+        return Significance != EDroneSignificance::Full;
+    }
+}
+
+void UDroneSignificanceSubsystem::GatherViewers()
+{
+    Viewers.Reset();
+
+    // Local players, spectators and, on a server, remote players
+    for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+    {
+        const APlayerController* PC = It->Get();
+        if (!PC)
+            continue;
+
+        FVector Location;
+        FRotator Rotation;
+        PC->GetPlayerViewPoint(Location, Rotation);
+
+        const float Fov = PC->PlayerCameraManager ? PC->PlayerCameraManager->GetFOVAngle() : 90.f;
+        const float HalfAngle = FMath::Min(Fov * 0.5f + DroneSignificance::ViewMarginDeg, 89.f);
+
+        FViewer& Viewer = Viewers.AddDefaulted_GetRef();
+        Viewer.Location = Location;
+        Viewer.Direction = Rotation.Vector();
+        Viewer.CosHalfFov = FMath::Cos(FMath::DegreesToRadians(HalfAngle));
+    }
+}
+
+EDroneSignificance UDroneSignificanceSubsystem::Evaluate(const FVector& Location, EDroneSignificanceKind Kind) const
+{
+    float ClosestSquared = TNumericLimits<float>::Max();
+    bool bInAnyView = false;
+    for (const FViewer& Viewer : Viewers)
+    {
+        const FVector ToObject = Location - Viewer.Location;
+        float DistanceSquared = ToObject.SizeSquared();
+
+        const float Distance = FMath::Sqrt(DistanceSquared);
+        const bool bInView = Distance < KINDA_SMALL_NUMBER || FVector::DotProduct(ToObject, Viewer.Direction) >= Viewer.CosHalfFov * Distance;
+        if (!bInView)
+        {
+            DistanceSquared *= FMath::Square(OffscreenDistanceScale);
+        }
+
+        bInAnyView |= bInView;
+        ClosestSquared = FMath::Min(ClosestSquared, DistanceSquared);
+    }
+
+    // Projectile effects are culled off screen, by the same view cone, not by distance; past the bands nobody sees them either
+    if (Kind == EDroneSignificanceKind::Projectile)
+        return bInAnyView && ClosestSquared < FMath::Square(MinimalDistance) ? EDroneSignificance::Full : EDroneSignificance::Off;
+
+    if (ClosestSquared < FMath::Square(FullDistance))
+        return EDroneSignificance::Full;
+    if (ClosestSquared < FMath::Square(ReducedDistance))
+        return EDroneSignificance::Reduced;
+    if (ClosestSquared < FMath::Square(MinimalDistance))
+        return EDroneSignificance::Minimal;
+    return EDroneSignificance::Off;
+}
+
+void UDroneSignificanceSubsystem::Apply(FEntry& Entry, EDroneSignificance Significance)
+{
+    AActor* Actor = Entry.Actor.Get();
+
+    // Player drones always fly at full rate: that's what the pilot sees and what replays record
+    if (Entry.Kind == EDroneSignificanceKind::Drone)
+    {
+        const APawn* Pawn = Cast<APawn>(Actor);
+        if (Pawn && Pawn->IsPlayerControlled())
+        {
+            Significance = EDroneSignificance::Full;
+        }
+    }
+
+    if (Significance == Entry.Significance)
+        return;
+
+    const bool bWasThrottled = IsThrottled(Entry.Kind, Entry.Significance);
+    const bool bThrottled = IsThrottled(Entry.Kind, Significance);
+    NumThrottled[int32(Entry.Kind)] += int32(bThrottled) - int32(bWasThrottled);
+    Entry.Significance = Significance;
+
+    switch (Entry.Kind)
+    {
+    case EDroneSignificanceKind::Drone:
+        if (ADroneFPCharacter* Drone = Cast<ADroneFPCharacter>(Actor))
+        {
+            const float Interval = Significance == EDroneSignificance::Full ? 0.f
+                : Significance == EDroneSignificance::Reduced ? ReducedDroneTickInterval
+                : MinimalDroneTickInterval;
+            Drone->SetSignificanceTickInterval(Interval);
+
+            if (bThrottled)
+            {
+                InterpolatedDrones.AddUnique(Drone);
+            }
+            else
+            {
+                InterpolatedDrones.Remove(Drone);
+            }
+        }
+        break;
+
+    case EDroneSignificanceKind::Gate:
+        if (bThrottled != bWasThrottled)
+        {
+            if (ARaceGate* Gate = Cast<ARaceGate>(Actor))
+            {
+                Gate->SetAnimationSuspended(bThrottled);
+            }
+        }
+        break;
+
+    case EDroneSignificanceKind::Projectile:
+        if (bThrottled != bWasThrottled)
+        {
+            if (ADroneRacerFPProjectile* Projectile = Cast<ADroneRacerFPProjectile>(Actor))
+            {
+                Projectile->SetEffectsCulled(bThrottled);
+            }
+        }
+        break;
+    }
+}
+
+void UDroneSignificanceSubsystem::RestoreAll()
+{
+    for (FEntry& Entry : Entries)
+    {
+        if (Entry.Actor.IsValid())
+        {
+            Apply(Entry, EDroneSignificance::Full);
+        }
+    }
+}
+
+void UDroneSignificanceSubsystem::Tick(float DeltaTime)
+{
+    DRONERACER_SCOPED_STAT(Significance);
+
+    const bool bEnabled = CVarSignificance.GetValueOnGameThread();
+    if (bEnabled != bWasEnabled)
+    {
+        bWasEnabled = bEnabled;
+        if (!bEnabled)
+        {
+            RestoreAll();
+        }
+    }
+
+    int32 NumDeferred = 0;
+    if (bEnabled && Entries.Num() > 0)
+    {
+        GatherViewers();
+
+        // Round-robin from where the last frame ran out of budget
+        const double Deadline = FPlatformTime::Seconds() + CVarSignificanceBudgetMs.GetValueOnGameThread() * 0.001;
+        const int32 MaxIndex = Entries.GetMaxIndex();
+        if (Cursor >= MaxIndex)
+        {
+            Cursor = 0;
+        }
+
+        int32 NumScored = 0;
+        for (int32 Visited = 0; Visited < MaxIndex; ++Visited)
+        {
+            if (NumScored > 0 && NumScored % DroneSignificance::EntriesPerBudgetCheck == 0 && FPlatformTime::Seconds() > Deadline)
+            {
+                NumDeferred = Entries.Num() - NumScored;
+                break;
+            }
+
+            const int32 Index = Cursor;
+            Cursor = (Cursor + 1) % MaxIndex;
+            if (!Entries.IsAllocated(Index))
+                continue;
+
+            ++NumScored;
+            FEntry& Entry = Entries[Index];
+            if (const AActor* Actor = Entry.Actor.Get())
+            {
+                Apply(Entry, Evaluate(Actor->GetActorLocation(), Entry.Kind));
+            }
+        }
+    }
+
+    // Throttled drones are drawn between their last two ticks
+    for (int32 Index = InterpolatedDrones.Num() - 1; Index >= 0; --Index)
+    {
+        if (ADroneFPCharacter* Drone = InterpolatedDrones[Index].Get())
+        {
+            Drone->UpdateVisualInterpolation();
+        }
+        else
+        {
+            InterpolatedDrones.RemoveAtSwap(Index);
+        }
+    }
+
+    SET_DWORD_STAT(STAT_DroneRacer_ThrottledDrones, NumThrottled[int32(EDroneSignificanceKind::Drone)]);
+    SET_DWORD_STAT(STAT_DroneRacer_SuspendedGates, NumThrottled[int32(EDroneSignificanceKind::Gate)]);
+    SET_DWORD_STAT(STAT_DroneRacer_CulledProjectileFX, NumThrottled[int32(EDroneSignificanceKind::Projectile)]);
+    INC_DWORD_STAT_BY(STAT_DroneRacer_SignificanceDeferred, NumDeferred);
+    CSV_CUSTOM_STAT(DroneRacer, ThrottledDrones, NumThrottled[int32(EDroneSignificanceKind::Drone)], ECsvCustomStatOp::Set);
+    CSV_CUSTOM_STAT(DroneRacer, SuspendedGates, NumThrottled[int32(EDroneSignificanceKind::Gate)], ECsvCustomStatOp::Set);
+    CSV_CUSTOM_STAT(DroneRacer, CulledProjectileFX, NumThrottled[int32(EDroneSignificanceKind::Projectile)], ECsvCustomStatOp::Set);
+    CSV_CUSTOM_STAT(DroneRacer, SignificanceDeferred, NumDeferred, ECsvCustomStatOp::Set);
+}
+
+void UDroneSignificanceSubsystem::LogReport() const
+{
+    UE_LOG(LogTemp, Display, TEXT("DroneSignificance: %d objects, %d drones throttled, %d gates suspended, %d projectiles without effects"),
+        Entries.Num(), NumThrottled[int32(EDroneSignificanceKind::Drone)], NumThrottled[int32(EDroneSignificanceKind::Gate)],
+        NumThrottled[int32(EDroneSignificanceKind::Projectile)]);
+
+    for (const FEntry& Entry : Entries)
+    {
+        const AActor* Actor = Entry.Actor.Get();
+        if (Actor && IsThrottled(Entry.Kind, Entry.Significance))
+        {
+            UE_LOG(LogTemp, Display, TEXT("  %-10s %-8s %s"),
+                DroneSignificance::KindName(Entry.Kind), LexToString(Entry.Significance), *Actor->GetName());
+        }
+    }
+}
+
+TStatId UDroneSignificanceSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UDroneSignificanceSubsystem, STATGROUP_Tickables);
+}
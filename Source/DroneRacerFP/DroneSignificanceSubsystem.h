@@ -0,0 +1,126 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/SparseArray.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DroneSignificanceSubsystem.generated.h"
+
+class ADroneFPCharacter;
+
+enum class EDroneSignificanceKind : uint8
+{
+    Drone,
+    Gate,
+    Projectile,
+};
+
+/** Ordered from most to least significant */
+enum class EDroneSignificance : uint8
+{
+    Full,
+    Reduced,
+    Minimal,
+    Off,
+};
+
+const TCHAR* LexToString(EDroneSignificance Significance);
+
+/**
+ * Scores drones, gates and projectiles by how relevant they are to the
+ * players and spectators watching, and scales their per-frame work to match.
+ *
+ * Every player controller's view point is a viewer. An object's effective
+ * distance is the distance to its nearest viewer, multiplied by
+ * OffscreenDistanceScale for viewers that don't have it in their view cone;
+ * the distance bands below turn it into a significance tier. On a tier
+ * change:
+ *   - drones no player controls tick at a lower rate. Their flight model
+ *     still runs every fixed step (they catch up when they tick), and their
+ *     mesh is interpolated between ticks, see ADroneFPCharacter::SetSignificanceTickInterval;
+ *   - gates at Minimal or less suspend their animated components
+ *     (ARaceGate::SetAnimationSuspended);
+ *   - projectiles are only Full or Off: Off when no viewer has them in its
+ *     view cone (or they are past MinimalDistance), which culls their
+ *     effects (ADroneRacerFPProjectile::SetEffectsCulled). Distance alone
+ *     doesn't cull an on-screen projectile.
+ *
+ * Scoring is time-sliced: each frame continues round-robin from where the
+ * last one stopped, until DroneRacer.Significance.BudgetMs is used up.
+ * Objects not reached keep their tier. "stat DroneRacer" shows what is
+ * throttled; DroneRacer.Significance.Report lists it.
+ */
+UCLASS()
+class DRONERACERFP_API UDroneSignificanceSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    /** Upper bounds (cm) of the Full, Reduced and Minimal bands */
+    static constexpr float FullDistance = 5000.f;
+    static constexpr float ReducedDistance = 20000.f;
+    static constexpr float MinimalDistance = 60000.f;
+
+    /** Off-screen objects count as this many times further away */
+    static constexpr float OffscreenDistanceScale = 4.f;
+
+    /** Tick intervals (s) of unpossessed drones per tier; Off drones still tick at the Minimal rate */
+    static constexpr float ReducedDroneTickInterval = 1.f / 30.f;
+    static constexpr float MinimalDroneTickInterval = 1.f / 10.f;
+
+    /** Returns a handle for Unregister; objects start at Full */
+    int32 Register(AActor* Actor, EDroneSignificanceKind Kind);
+    void Unregister(int32 Handle);
+
+    EDroneSignificance GetSignificance(int32 Handle) const;
+
+    /** Logs every object below Full */
+    void LogReport() const;
+
+    // UWorldSubsystem
+    virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+    virtual void Deinitialize() override;
+
+    // UTickableWorldSubsystem
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+private:
+    struct FEntry
+    {
+        TWeakObjectPtr<AActor> Actor;
+        EDroneSignificanceKind Kind = EDroneSignificanceKind::Drone;
+        EDroneSignificance Significance = EDroneSignificance::Full;
+    };
+
+    struct FViewer
+    {
+        FVector Location;
+        FVector Direction;
+        float CosHalfFov;
+    };
+
+    void GatherViewers();
+    EDroneSignificance Evaluate(const FVector& Location, EDroneSignificanceKind Kind) const;
+    void Apply(FEntry& Entry, EDroneSignificance Significance);
+
+    /** Whether Significance changes anything for objects of Kind */
+    static bool IsThrottled(EDroneSignificanceKind Kind, EDroneSignificance Significance);
+
+    /** Puts everything back to Full, when the subsystem is disabled or shut down */
+    void RestoreAll();
+
+    TSparseArray<FEntry> Entries;
+
+    /** Entry the next frame starts scoring at */
+    int32 Cursor = 0;
+
+    TArray<FViewer> Viewers;
+
+    /** Throttled drones, interpolated every frame */
+    TArray<TWeakObjectPtr<ADroneFPCharacter>> InterpolatedDrones;
+
+    /** Objects currently throttled, per EDroneSignificanceKind */
+    int32 NumThrottled[3] = {};
+
+    bool bWasEnabled = true;
+};
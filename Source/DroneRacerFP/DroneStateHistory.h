@@ -0,0 +1,80 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Full drone state at the end of one physics step */
+struct FDroneStateSample
+{
+    FVector Location = FVector::ZeroVector;
+    FQuat Rotation = FQuat::Identity;
+
+    /** cm/s */
+    FVector Velocity = FVector::ZeroVector;
+
+    float Throttle01 = 0.f;
+    float Health = 0.f;
+    float Battery01 = 0.f;
+    bool bArmed = false;
+
+    // Race progress, INDEX_NONE gate when not racing
+    int32 GateIndex = INDEX_NONE;
+    int32 Lap = 1;
+    float LapTime = 0.f;
+    float TimeSinceLastGate = 0.f;
+    float LastSplit = -1.f;
+};
+
+/**
+ * Fixed-size ring of the most recent drone states, one per physics step.
+ *
+ * Storage is allocated once by Init; Push overwrites the oldest sample and
+ * rewinding just moves the head back, so recording and restoring never
+ * allocate.
+ */
+class FDroneStateHistory
+{
+public:
+    void Init(int32 Capacity)
+    {
+        Samples.SetNum(FMath::Max(Capacity, 1));
+        Reset();
+    }
+
+    void Reset()
+    {
+        Head = 0;
+        Count = 0;
+    }
+
+    int32 Num() const { return Count; }
+
+    void Push(const FDroneStateSample& Sample)
+    {
+        Samples[Head] = Sample;
+        Head = (Head + 1) % Samples.Num();
+        Count = FMath::Min(Count + 1, Samples.Num());
+    }
+
+    /** Sample StepsBack steps before the newest one (0 = newest), clamped to the oldest kept */
+    const FDroneStateSample* GetFromNewest(int32 StepsBack) const
+    {
+        if (Count == 0)
+            return nullptr;
+
+        StepsBack = FMath::Clamp(StepsBack, 0, Count - 1);
+        return &Samples[(Head - 1 - StepsBack + Samples.Num()) % Samples.Num()];
+    }
+
+    /** Forgets the newest samples, e.g. the future that was rewound away */
+    void DiscardNewest(int32 NumToDiscard)
+    {
+        NumToDiscard = FMath::Clamp(NumToDiscard, 0, Count);
+        Head = (Head - NumToDiscard + Samples.Num()) % Samples.Num();
+        Count -= NumToDiscard;
+    }
+
+private:
+    TArray<FDroneStateSample> Samples;
+    int32 Head = 0;
+    int32 Count = 0;
+};
@@ -0,0 +1,234 @@
+#include "DroneStreamingSourceComponent.h"
+#include "DroneFPCharacter.h"
+#include "RaceGateManager.h"
+
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "WorldPartition/WorldPartitionSubsystem.h"
+
+namespace DroneStreaming
+{
+    // Slot layout in Sources: [0] drone, [1..MaxLookahead] path, then gates
+    constexpr int32 MaxLookahead = 8;
+    constexpr int32 MaxGates = 8;
+    constexpr int32 FirstLookaheadSlot = 1;
+    constexpr int32 FirstGateSlot = FirstLookaheadSlot + MaxLookahead;
+    constexpr int32 NumSlots = FirstGateSlot + MaxGates;
+}
+
+UDroneStreamingSourceComponent::UDroneStreamingSourceComponent()
+{
+    PrimaryComponentTick.bCanEverTick = true;
+    PrimaryComponentTick.TickGroup = TG_PostPhysics; // after the drone moved this frame
+}
+
+void UDroneStreamingSourceComponent::BeginPlay()
+{
+    Super::BeginPlay();
+
+    if (!RaceGateManager)
+    {
+        if (const ADroneFPCharacter* Drone = Cast<ADroneFPCharacter>(GetOwner()))
+        {
+            RaceGateManager = Drone->GetRaceGateManager();
+        }
+    }
+    if (!RaceGateManager)
+    {
+        for (TActorIterator<ARaceGateManager> It(GetWorld()); It; ++It)
+        {
+            RaceGateManager = *It;
+            break;
+        }
+    }
+
+    // Allocate every slot once; ticks only update locations / states
+    using namespace DroneStreaming;
+    const FString BaseName = GetOwner()->GetName();
+    Sources.SetNum(NumSlots);
+    for (int32 Slot = 0; Slot < NumSlots; ++Slot)
+    {
+        FWorldPartitionStreamingSource& Source = Sources[Slot];
+        Source.Name = FName(*BaseName, Slot);
+        Source.Shapes.SetNum(Slot == 0 ? 2 : 1);
+        for (FStreamingSourceShape& Shape : Source.Shapes)
+        {
+            Shape.bUseGridLoadingRange = false;
+        }
+    }
+
+    // Drone slot: full sphere for what is close, sector for what is ahead
+    Sources[0].Shapes[1].bIsSector = true;
+    Sources[0].DebugColor = FColor::Cyan;
+
+    // Possession can come after BeginPlay (clients, respawns, AI taking over)
+    if (APawn* Pawn = Cast<APawn>(GetOwner()))
+    {
+        Pawn->ReceiveControllerChangedDelegate.AddDynamic(this, &UDroneStreamingSourceComponent::OnOwnerControllerChanged);
+    }
+    UpdateRegistration();
+}
+
+void UDroneStreamingSourceComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (APawn* Pawn = Cast<APawn>(GetOwner()))
+    {
+        Pawn->ReceiveControllerChangedDelegate.RemoveDynamic(this, &UDroneStreamingSourceComponent::OnOwnerControllerChanged);
+    }
+    SetRegistered(false);
+
+    Super::EndPlay(EndPlayReason);
+}
+
+void UDroneStreamingSourceComponent::OnOwnerControllerChanged(APawn* Pawn, AController* OldController, AController* NewController)
+{
+    // Off the old controller first, so it gets its own source back
+    SetRegistered(false);
+    UpdateRegistration();
+}
+
+void UDroneStreamingSourceComponent::UpdateRegistration()
+{
+    const APawn* Pawn = Cast<APawn>(GetOwner());
+    SetRegistered(!Pawn || Pawn->IsLocallyControlled());
+    SetComponentTickEnabled(bRegistered);
+}
+
+void UDroneStreamingSourceComponent::SetRegistered(bool bRegister)
+{
+    if (bRegister == bRegistered)
+        return;
+
+    UWorldPartitionSubsystem* WorldPartition = GetWorld()->GetSubsystem<UWorldPartitionSubsystem>();
+    if (!WorldPartition)
+        return;
+
+    if (bRegister)
+    {
+        RebuildSources();
+        WorldPartition->RegisterStreamingSourceProvider(this);
+
+        // The controller's own source would load its whole grid range on top of the budget
+        const APawn* Pawn = Cast<APawn>(GetOwner());
+        if (APlayerController* PC = Pawn ? Cast<APlayerController>(Pawn->GetController()) : nullptr)
+        {
+            SilencedController = PC;
+            bControllerSourceWasEnabled = PC->bEnableStreamingSource;
+            PC->bEnableStreamingSource = false;
+        }
+    }
+    else
+    {
+        WorldPartition->UnregisterStreamingSourceProvider(this);
+
+        if (APlayerController* PC = SilencedController.Get())
+        {
+            PC->bEnableStreamingSource = bControllerSourceWasEnabled;
+        }
+        SilencedController.Reset();
+    }
+
+    bRegistered = bRegister;
+}
+
+void UDroneStreamingSourceComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+    Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+    if (bRegistered)
+    {
+        RebuildSources();
+    }
+}
+
+void UDroneStreamingSourceComponent::RebuildSources()
+{
+    using namespace DroneStreaming;
+
+    const AActor* Owner = GetOwner();
+    const FVector Location = Owner->GetActorLocation();
+    const FVector Velocity = Owner->GetVelocity();
+    const float Speed = Velocity.Size();
+    const FRotator Heading = Speed > KINDA_SMALL_NUMBER ? Velocity.Rotation() : Owner->GetActorRotation();
+
+    // ===== Drone =====
+
+    FWorldPartitionStreamingSource& DroneSource = Sources[0];
+    DroneSource.Location = Location;
+    DroneSource.Rotation = Heading;
+    DroneSource.Velocity = Speed;
+    DroneSource.TargetState = EStreamingSourceTargetState::Activated;
+    DroneSource.Priority = EStreamingSourcePriority::Highest;
+    DroneSource.bBlockOnSlowLoading = bBlockOnSlowLoading;
+    DroneSource.Shapes[0].Radius = NearRadius;
+    DroneSource.Shapes[1].Radius = ForwardRadius;
+    DroneSource.Shapes[1].SectorAngle = ForwardSectorAngle;
+
+    // ===== Projected path =====
+
+    // Nearer points get the higher priority so cells load in the order they are reached
+    static const EStreamingSourcePriority PathPriorities[] =
+    {
+        EStreamingSourcePriority::High,
+        EStreamingSourcePriority::Normal,
+        EStreamingSourcePriority::Low,
+    };
+
+    const int32 NumPath = FMath::Clamp(NumLookaheadPoints, 0, MaxLookahead);
+    for (int32 Index = 0; Index < MaxLookahead; ++Index)
+    {
+        FWorldPartitionStreamingSource& Source = Sources[FirstLookaheadSlot + Index];
+        if (Index >= NumPath || Speed <= KINDA_SMALL_NUMBER)
+        {
+            Source.Shapes[0].Radius = 0.f; // skipped in GetStreamingSources
+            continue;
+        }
+
+        const float T = LookaheadSeconds * float(Index + 1) / float(NumPath);
+        Source.Location = Location + Velocity * T;
+        Source.Rotation = Heading;
+        Source.Velocity = Speed;
+        Source.Priority = PathPriorities[FMath::Min(Index, int32(UE_ARRAY_COUNT(PathPriorities)) - 1)];
+        // Only the first point has to be fully active when the drone arrives
+        Source.TargetState = Index == 0 ? EStreamingSourceTargetState::Activated : EStreamingSourceTargetState::Loaded;
+        Source.Shapes[0].Radius = LookaheadRadius;
+    }
+
+    // ===== Upcoming gates =====
+
+    // Gates this drone still has to fly, not the ones other racers are heading to
+    const ADroneFPCharacter* Drone = Cast<ADroneFPCharacter>(Owner);
+    const int32 RacerIndex = Drone ? Drone->GetRacerIndex() : INDEX_NONE;
+
+    const int32 NumGates = FMath::Clamp(NumPrefetchGates, 0, MaxGates);
+    for (int32 Ahead = 0; Ahead < MaxGates; ++Ahead)
+    {
+        FWorldPartitionStreamingSource& Source = Sources[FirstGateSlot + Ahead];
+        FVector GateLocation;
+        if (Ahead >= NumGates || !RaceGateManager || !RaceGateManager->GetUpcomingGateLocation(RacerIndex, Ahead, GateLocation))
+        {
+            Source.Shapes[0].Radius = 0.f;
+            continue;
+        }
+
+        Source.Location = GateLocation;
+        Source.Rotation = (GateLocation - Location).Rotation();
+        Source.TargetState = EStreamingSourceTargetState::Loaded;
+        Source.Priority = Ahead == 0 ? EStreamingSourcePriority::Normal : EStreamingSourcePriority::Low;
+        Source.Shapes[0].Radius = GateRadius;
+    }
+}
+
+bool UDroneStreamingSourceComponent::GetStreamingSources(TArray<FWorldPartitionStreamingSource>& OutStreamingSources) const
+{
+    const int32 FirstNew = OutStreamingSources.Num();
+    for (const FWorldPartitionStreamingSource& Source : Sources)
+    {
+        if (Source.Shapes.Num() > 0 && Source.Shapes.Last().Radius > 0.f)
+        {
+            OutStreamingSources.Add(Source);
+        }
+    }
+    return OutStreamingSources.Num() > FirstNew;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "WorldPartition/WorldPartitionStreamingSource.h"
+#include "DroneStreamingSourceComponent.generated.h"
+
+class ARaceGateManager;
+
+/**
+ * World Partition streaming source that follows where the drone is going,
+ * not just where it is.
+ *
+ * Each tick the owner's velocity is projected forward and the next few gates
+ * of the race are looked up; streaming sources are emitted for
+ *   - the drone itself: a small sphere plus a sector pointing along the velocity,
+ *   - points along the projected path (activated, highest priority first),
+ *   - the upcoming gates (loaded only, so they are ready but not ticking).
+ * Nothing is emitted behind the drone or for passed gates, so those cells fall
+ * out of every source and World Partition unloads them. The total count and
+ * radii are fixed, which bounds how many cells can be resident at once.
+ *
+ * Only a locally controlled owner streams: AI and remote drones emit
+ * nothing. While it streams, the component turns off its player
+ * controller's default source (bEnableStreamingSource) so it is the only
+ * one and the budget holds, and turns it back on when control changes.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class DRONERACERFP_API UDroneStreamingSourceComponent : public UActorComponent, public IWorldPartitionStreamingSourceProvider
+{
+    GENERATED_BODY()
+
+public:
+    UDroneStreamingSourceComponent();
+
+    virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+    // IWorldPartitionStreamingSourceProvider
+    virtual bool GetStreamingSources(TArray<FWorldPartitionStreamingSource>& OutStreamingSources) const override;
+    virtual const UObject* GetStreamingSourceOwner() const override { return this; }
+
+    /** Gates the lookahead follows; defaults to the owner's race when it is a drone */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming")
+    ARaceGateManager* RaceGateManager;
+
+    /** Radius kept loaded all around the drone (cm) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (ClampMin = "0"))
+    float NearRadius = 5000.f;
+
+    /** Radius of the forward sector around the drone (cm) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (ClampMin = "0"))
+    float ForwardRadius = 20000.f;
+
+    /** Full angle of the forward sector (degrees) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (ClampMin = "1", ClampMax = "360"))
+    float ForwardSectorAngle = 120.f;
+
+    /** How far ahead in time the velocity is projected (s) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (ClampMin = "0"))
+    float LookaheadSeconds = 3.f;
+
+    /** Number of points along the projected path */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (ClampMin = "0", ClampMax = "8"))
+    int32 NumLookaheadPoints = 3;
+
+    /** Radius around each projected point (cm) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (ClampMin = "0"))
+    float LookaheadRadius = 10000.f;
+
+    /** Number of upcoming gates to prefetch */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (ClampMin = "0", ClampMax = "8"))
+    int32 NumPrefetchGates = 3;
+
+    /** Radius around each prefetched gate (cm) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (ClampMin = "0"))
+    float GateRadius = 8000.f;
+
+    /** Block the game thread if the cells right around the drone are not loaded yet */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming")
+    bool bBlockOnSlowLoading = false;
+
+protected:
+    virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+    void RebuildSources();
+
+    /** Registers while the owner is locally controlled (or isn't a pawn), unregisters otherwise */
+    void UpdateRegistration();
+    void SetRegistered(bool bRegister);
+
+    UFUNCTION()
+    void OnOwnerControllerChanged(APawn* Pawn, AController* OldController, AController* NewController);
+
+    /** Rebuilt every tick in place, capacity is reserved once */
+    TArray<FWorldPartitionStreamingSource> Sources;
+
+    bool bRegistered = false;
+
+    /** Controller whose default source is turned off while registered, and what it was before */
+    TWeakObjectPtr<APlayerController> SilencedController;
+    bool bControllerSourceWasEnabled = false;
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DroneTelemetry.generated.h"
+
+/**
+ * Per-frame flight state published by ADroneFPCharacter at the end of Tick.
+ *
+ * Plain values only (no strings, no containers) so that publishing is a
+ * straight copy and readers (OSD, tools) never allocate.
+ */
+USTRUCT(BlueprintType)
+struct DRONERACERFP_API FDroneTelemetrySnapshot
+{
+    GENERATED_BODY()
+
+    /** GFrameCounter at publish time, lets readers skip unchanged snapshots */
+    uint64 FrameNumber = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    bool bArmed = false;
+
+    /** Throttle 0..1 */
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    float Throttle01 = 0.f;
+
+    /** Commanded body rates (deg/s): X roll, Y pitch, Z yaw */
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    FVector BodyRatesDeg = FVector::ZeroVector;
+
+    /** Ground speed in m/s */
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    float SpeedMs = 0.f;
+
+    /** World altitude in m */
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    float AltitudeM = 0.f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    float Health = 0.f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    float MaxHealth = 0.f;
+
+    /** Remaining battery 0..1 */
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    float Battery01 = 1.f;
+
+    /** Index of the gate the drone must fly through next, INDEX_NONE when no course */
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    int32 CurrentGate = INDEX_NONE;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    int32 NumGates = 0;
+
+    /** 1-based lap number */
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    int32 Lap = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    int32 NumLaps = 0;
+
+    /** Seconds since the current lap started */
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    float LapTime = 0.f;
+
+    /** Time between the last two gate passes, negative when there is none yet */
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    float LastSplit = -1.f;
+
+    /** Seconds behind (positive) or ahead of the pilot's best lap at this point of the course */
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    float DeltaToBest = 0.f;
+
+    /** False until the pilot has a best lap on the course */
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    bool bHasDeltaToBest = false;
+};
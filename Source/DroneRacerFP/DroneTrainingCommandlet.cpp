@@ -0,0 +1,282 @@
+#include "DroneTrainingCommandlet.h"
+#include "DroneTrainingEnv.h"
+#include "RaceCourse.h"
+#include "RaceCourseGenerator.h"
+
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformProcess.h"
+#include "Math/RandomStream.h"
+#include "Misc/CoreMisc.h"
+#include "Misc/Parse.h"
+
+namespace DroneTraining
+{
+    // Logs throughput at most this often (s)
+    constexpr double ReportInterval = 5.0;
+
+    uint64 Align64(uint64 Offset)
+    {
+        return Align(Offset, 64);
+    }
+
+    struct FThroughput
+    {
+        double WindowStart = FPlatformTime::Seconds();
+        int64 WindowSteps = 0;
+        int32 NumDrones = 0;
+
+        void Step()
+        {
+            ++WindowSteps;
+            const double Now = FPlatformTime::Seconds();
+            if (Now - WindowStart >= ReportInterval)
+            {
+                const double StepsPerSecond = WindowSteps / (Now - WindowStart);
+                UE_LOG(LogTemp, Display, TEXT("DroneTraining: %.0f steps/s, %.0f drone-steps/s"),
+                    StepsPerSecond, StepsPerSecond * NumDrones);
+                WindowStart = Now;
+                WindowSteps = 0;
+            }
+        }
+    };
+
+    /** Gate transforms, and their motions (one per gate) if any gate moves */
+    bool LoadGates(const FString& Params, int32& InOutNumLaps, TArray<FTransform>& OutGates, TArray<FRaceCourseGateMotionRecord>& OutMotions)
+    {
+        FRaceCourseFile Course;
+
+        FString CoursePath;
+        if (FParse::Value(*Params, TEXT("Course="), CoursePath))
+        {
+            if (!Course.Open(CoursePath))
+                return false;
+        }
+        else
+        {
+            FRaceCourseGeneratorSettings Settings;
+            FParse::Value(*Params, TEXT("Seed="), Settings.Seed);
+            FParse::Value(*Params, TEXT("NumGates="), Settings.NumGates);
+            FParse::Value(*Params, TEXT("MovingGateFraction="), Settings.MovingGateFraction);
+
+            TArray<FRaceCourseGateRecord> Records;
+            TArray<FRaceCourseGateMotionRecord> Motions;
+            FRaceCourseGenerator::Generate(Settings, Records);
+            FRaceCourseGenerator::GenerateMotions(Settings, Records, Motions);
+            const FRaceCourseInfo Info = FRaceCourseGenerator::MakeInfo(Settings, Records, Motions);
+            if (!Course.Open(Info, MoveTemp(Records), MoveTemp(Motions)))
+                return false;
+        }
+
+        InOutNumLaps = Course.GetInfo().NumLaps;
+        const TConstArrayView<FRaceCourseGateMotionRecord> Motions = Course.Motions();
+        int32 NextMotion = 0;
+        for (const FRaceCourseGateRecord& Record : Course.Gates())
+        {
+            OutGates.Add(Record.ToTransform());
+
+            // Both tables are sorted by gate order, as ARaceGateManager matches them
+            while (Motions.IsValidIndex(NextMotion) && Motions[NextMotion].GateOrder < Record.Order)
+            {
+                ++NextMotion;
+            }
+
+            FRaceCourseGateMotionRecord& Motion = OutMotions.AddDefaulted_GetRef();
+            if (Motions.IsValidIndex(NextMotion) && Motions[NextMotion].GateOrder == Record.Order)
+            {
+                Motion = Motions[NextMotion++];
+            }
+        }
+
+        if (Motions.Num() == 0)
+        {
+            OutMotions.Empty();
+        }
+        return OutGates.Num() > 0;
+    }
+}
+
+UDroneTrainingCommandlet::UDroneTrainingCommandlet()
+{
+    IsClient = false;
+    IsEditor = false;
+    IsServer = false;
+    LogToConsole = true;
+}
+
+int32 UDroneTrainingCommandlet::Main(const FString& Params)
+{
+    using namespace DroneTraining;
+
+    FDroneTrainingEnv::FConfig Config;
+    TArray<FTransform> Gates;
+    TArray<FRaceCourseGateMotionRecord> Motions;
+    if (!LoadGates(Params, Config.NumLaps, Gates, Motions))
+    {
+        UE_LOG(LogTemp, Error, TEXT("DroneTraining: no course"));
+        return 1;
+    }
+
+    FParse::Value(*Params, TEXT("NumDrones="), Config.NumDrones);
+    FParse::Value(*Params, TEXT("NumLaps="), Config.NumLaps);
+    FParse::Value(*Params, TEXT("EnvSeed="), Config.Seed);
+
+    // The level's wind settings aren't available without a world; the course flies calm unless asked
+    Config.Wind.bEnabled = FParse::Param(*Params, TEXT("Wind"));
+    FParse::Value(*Params, TEXT("WindX="), Config.Wind.AmbientWind.X);
+    FParse::Value(*Params, TEXT("WindY="), Config.Wind.AmbientWind.Y);
+    FParse::Value(*Params, TEXT("WindZ="), Config.Wind.AmbientWind.Z);
+    FParse::Value(*Params, TEXT("GustStrength="), Config.Wind.GustStrength);
+    FParse::Value(*Params, TEXT("GustScale="), Config.Wind.GustScale);
+
+    FDroneTrainingEnv Env;
+    if (!Env.Init(Config, Gates, Motions))
+    {
+        UE_LOG(LogTemp, Error, TEXT("DroneTraining: invalid config"));
+        return 1;
+    }
+
+    const int32 NumDrones = Env.GetNumDrones();
+    UE_LOG(LogTemp, Display, TEXT("DroneTraining: %d drones, %d gates, %d laps, wind %s"),
+        NumDrones, Gates.Num(), Config.NumLaps, Config.Wind.bEnabled ? *Config.Wind.AmbientWind.ToString() : TEXT("off"));
+
+    FThroughput Throughput;
+    Throughput.NumDrones = NumDrones;
+
+    // ===== Benchmark: random actions, local buffers =====
+
+    FString SharedName;
+    if (!FParse::Value(*Params, TEXT("Shm="), SharedName))
+    {
+        int32 NumSteps = 10000;
+        FParse::Value(*Params, TEXT("BenchmarkSteps="), NumSteps);
+
+        TArray<float> Actions;
+        TArray<float> Observations;
+        TArray<float> Rewards;
+        TArray<uint8> Dones;
+        Actions.SetNumUninitialized(NumDrones * FDroneTrainingEnv::ActDim);
+        Observations.SetNumUninitialized(NumDrones * FDroneTrainingEnv::ObsDim);
+        Rewards.SetNumUninitialized(NumDrones);
+        Dones.SetNumUninitialized(NumDrones);
+
+        FRandomStream Random(Config.Seed);
+        for (float& Action : Actions)
+        {
+            Action = Random.FRandRange(-1.f, 1.f);
+        }
+
+        const double StartTime = FPlatformTime::Seconds();
+        for (int32 StepIndex = 0; StepIndex < NumSteps && !IsEngineExitRequested(); ++StepIndex)
+        {
+            Env.Step(Actions.GetData(), Observations.GetData(), Rewards.GetData(), Dones.GetData());
+            Throughput.Step();
+        }
+
+        const double Elapsed = FMath::Max(FPlatformTime::Seconds() - StartTime, UE_DOUBLE_SMALL_NUMBER);
+        UE_LOG(LogTemp, Display, TEXT("DroneTraining: %d steps in %.2f s, %.0f steps/s, %.0f drone-steps/s, %.0fx real time"),
+            NumSteps, Elapsed, NumSteps / Elapsed, NumSteps * NumDrones / Elapsed, NumSteps * Config.StepSeconds / Elapsed);
+        return 0;
+    }
+
+    // ===== Shared memory: serve a trainer =====
+
+    FDroneEnvSharedHeader Layout;
+    Layout.NumDrones = NumDrones;
+    Layout.ObsDim = FDroneTrainingEnv::ObsDim;
+    Layout.ActDim = FDroneTrainingEnv::ActDim;
+    Layout.StepSeconds = Config.StepSeconds;
+    Layout.ObservationsOffset = Align64(sizeof(FDroneEnvSharedHeader));
+    Layout.ActionsOffset = Align64(Layout.ObservationsOffset + sizeof(float) * NumDrones * Layout.ObsDim);
+    Layout.RewardsOffset = Align64(Layout.ActionsOffset + sizeof(float) * NumDrones * Layout.ActDim);
+    Layout.DonesOffset = Align64(Layout.RewardsOffset + sizeof(float) * NumDrones);
+    Layout.ResetMaskOffset = Align64(Layout.DonesOffset + NumDrones);
+    const uint64 RegionSize = Align64(Layout.ResetMaskOffset + NumDrones);
+
+    FPlatformMemory::FSharedMemoryRegion* Region = FPlatformMemory::MapNamedSharedMemoryRegion(SharedName, /*bCreate*/ true,
+        FPlatformMemory::ESharedMemoryAccess::Read | FPlatformMemory::ESharedMemoryAccess::Write, RegionSize);
+    if (!Region)
+    {
+        UE_LOG(LogTemp, Error, TEXT("DroneTraining: can't create shared memory '%s'"), *SharedName);
+        return 1;
+    }
+
+    uint8* Base = static_cast<uint8*>(Region->GetAddress());
+    FMemory::Memzero(Base, RegionSize);
+
+    FDroneEnvSharedHeader* Header = new (Base) FDroneEnvSharedHeader();
+    Header->NumDrones = Layout.NumDrones;
+    Header->ObsDim = Layout.ObsDim;
+    Header->ActDim = Layout.ActDim;
+    Header->StepSeconds = Layout.StepSeconds;
+    Header->ObservationsOffset = Layout.ObservationsOffset;
+    Header->ActionsOffset = Layout.ActionsOffset;
+    Header->RewardsOffset = Layout.RewardsOffset;
+    Header->DonesOffset = Layout.DonesOffset;
+    Header->ResetMaskOffset = Layout.ResetMaskOffset;
+
+    float* Observations = reinterpret_cast<float*>(Base + Layout.ObservationsOffset);
+    const float* Actions = reinterpret_cast<const float*>(Base + Layout.ActionsOffset);
+    float* Rewards = reinterpret_cast<float*>(Base + Layout.RewardsOffset);
+    uint8* Dones = Base + Layout.DonesOffset;
+    uint8* ResetMask = Base + Layout.ResetMaskOffset;
+
+    Env.WriteObservations(Observations);
+
+    UE_LOG(LogTemp, Display, TEXT("DroneTraining: serving '%s' (%llu bytes)"), *SharedName, RegionSize);
+
+    uint64 Handled = 0;
+    int32 IdleSpins = 0;
+    while (!IsEngineExitRequested())
+    {
+        const uint64 Request = Header->RequestSeq.load(std::memory_order_acquire);
+        if (Request == Handled)
+        {
+            // Spin briefly (trainer turnaround is usually microseconds), then back off
+            if (++IdleSpins < 4096)
+            {
+                FPlatformProcess::Yield();
+            }
+            else
+            {
+                FPlatformProcess::SleepNoStats(0.0005f);
+            }
+            continue;
+        }
+        IdleSpins = 0;
+
+        const uint32 Command = Header->Command;
+        if (Command == FDroneEnvSharedHeader::Quit)
+        {
+            Header->ResponseSeq.store(Request, std::memory_order_release);
+            break;
+        }
+
+        if (Command == FDroneEnvSharedHeader::ResetAll)
+        {
+            Env.ResetAll();
+            Env.WriteObservations(Observations);
+            FMemory::Memzero(Rewards, sizeof(float) * NumDrones);
+            FMemory::Memzero(Dones, NumDrones);
+        }
+        else
+        {
+            for (int32 Index = 0; Index < NumDrones; ++Index)
+            {
+                if (ResetMask[Index])
+                {
+                    Env.Reset(Index);
+                    ResetMask[Index] = 0;
+                }
+            }
+
+            Env.Step(Actions, Observations, Rewards, Dones);
+            Throughput.Step();
+        }
+
+        Handled = Request;
+        Header->ResponseSeq.store(Request, std::memory_order_release);
+    }
+
+    FPlatformMemory::UnmapNamedSharedMemoryRegion(Region);
+    return 0;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "DroneTrainingCommandlet.generated.h"
+
+/**
+ * Runs FDroneTrainingEnv headless, e.g. on a CPU-only Linux box:
+ *
+ *   UnrealEditor-Cmd DroneRacerFP.uproject -run=DroneTraining -nullrhi -unattended
+ *       [-Course=<path>] [-Seed=<n> -NumGates=<n> -MovingGateFraction=<0..1>] [-NumDrones=256] [-NumLaps=1]
+ *       [-Wind [-WindX=<cm/s> -WindY= -WindZ= -GustStrength= -GustScale=]]
+ *       [-Shm=<name>] [-BenchmarkSteps=<n>]
+ *
+ * The course comes from a course file, or from the procedural generator.
+ * Its gate motions are flown as the race flies them; wind is off unless
+ * -Wind is given, since the level's wind settings need a world.
+ * With -Shm the env serves a trainer through the shared memory described in
+ * DroneTrainingEnv.h until it sends Quit; without it the env runs
+ * BenchmarkSteps steps on random actions. Steps per second are logged
+ * either way.
+ */
+UCLASS()
+class UDroneTrainingCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UDroneTrainingCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+};
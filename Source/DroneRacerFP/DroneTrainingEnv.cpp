@@ -0,0 +1,189 @@
+#include "DroneTrainingEnv.h"
+
+#include "Async/ParallelFor.h"
+
+namespace DroneTrainingEnv
+{
+    // Drones per parallel task; one drone step is far too small to schedule alone
+    constexpr int32 MinBatchSize = 64;
+
+    FORCEINLINE void WriteVector(float*& Out, const FVector& Value)
+    {
+        *Out++ = float(Value.X);
+        *Out++ = float(Value.Y);
+        *Out++ = float(Value.Z);
+    }
+}
+
+bool FDroneTrainingEnv::Init(const FConfig& InConfig, TConstArrayView<FTransform> InGates, TConstArrayView<FRaceCourseGateMotionRecord> InMotions)
+{
+    if (InGates.Num() == 0 || InConfig.NumDrones <= 0 || (InMotions.Num() > 0 && InMotions.Num() != InGates.Num()))
+        return false;
+
+    Config = InConfig;
+    Gates = InGates;
+    Motions = InMotions;
+    Drones.SetNum(Config.NumDrones);
+    Random.Initialize(Config.Seed);
+
+    // Same bounds and per-cell wind as UDroneWindSubsystem, every cell exposed
+    WindField.Empty();
+    if (Config.Wind.bEnabled)
+    {
+        FBox Bounds(ForceInit);
+        for (const FTransform& Gate : Gates)
+        {
+            Bounds += Gate.GetLocation();
+        }
+
+        WindField.Init(Bounds.ExpandBy(Config.Wind.BoundsPadding), FMath::Max(Config.Wind.CellSize, 50.f), Config.Wind.MaxBakedCells);
+        const FIntVector Dims = WindField.GetDims();
+        for (int32 Z = 0; Z < Dims.Z; ++Z)
+        {
+            for (int32 Y = 0; Y < Dims.Y; ++Y)
+            {
+                for (int32 X = 0; X < Dims.X; ++X)
+                {
+                    const FVector Wind = UDroneWindSubsystem::ComputeWind(Config.Wind, WindField.GetCellCenter(X, Y, Z));
+                    WindField.At(X, Y, Z) = FVector4f(FVector3f(Wind), 0.f);
+                }
+            }
+        }
+    }
+
+    ResetAll();
+    return true;
+}
+
+void FDroneTrainingEnv::ResetAll()
+{
+    for (int32 Index = 0; Index < Drones.Num(); ++Index)
+    {
+        Reset(Index);
+    }
+}
+
+void FDroneTrainingEnv::Reset(int32 DroneIndex)
+{
+    FDrone& Drone = Drones[DroneIndex];
+    const FTransform& FirstGate = Gates[0];
+
+    // Behind the first gate, facing it, with a little jitter so episodes differ
+    const FVector Jitter(0.f, Random.FRandRange(-100.f, 100.f), Random.FRandRange(-100.f, 100.f));
+    Drone.State.Location = FirstGate.TransformPosition(FVector(-Config.StartDistance / FirstGate.GetScale3D().X, 0.f, 0.f)) + Jitter;
+    Drone.State.Rotation = FQuat(FRotator(0.f, FirstGate.Rotator().Yaw + Random.FRandRange(-10.f, 10.f), 0.f));
+    Drone.State.Velocity = FVector::ZeroVector;
+    Drone.State.Battery01 = 1.f;
+
+    Drone.GateIndex = 0;
+    Drone.Lap = 1;
+    Drone.NumSteps = 0;
+    Drone.Time = Random.FRandRange(0.f, FMath::Max(Config.MaxStartTime, 0.f));
+    Drone.GateDistance = FVector::Dist(Drone.State.Location, GetGateTransform(0, Drone.Time).GetLocation());
+}
+
+void FDroneTrainingEnv::Step(const float* Actions, float* Observations, float* Rewards, uint8* Dones)
+{
+    ParallelFor(TEXT("DroneTrainingEnv.Step"), Drones.Num(), DroneTrainingEnv::MinBatchSize, [&](int32 Index)
+    {
+        bool bDone = false;
+        Rewards[Index] = StepDrone(Drones[Index], Actions + Index * ActDim, bDone);
+        Dones[Index] = bDone ? 1 : 0;
+    });
+
+    // Serial: resets draw from the shared random stream
+    for (int32 Index = 0; Index < Drones.Num(); ++Index)
+    {
+        if (Dones[Index])
+        {
+            Reset(Index);
+        }
+    }
+
+    WriteObservations(Observations);
+}
+
+float FDroneTrainingEnv::StepDrone(FDrone& Drone, const float* Action, bool& bOutDone) const
+{
+    FDroneFlightInput Input;
+    Input.Throttle01 = FMath::Clamp(Action[0], 0.f, 1.f);
+    Input.Yaw = FMath::Clamp(Action[1], -1.f, 1.f);
+    Input.Pitch = FMath::Clamp(Action[2], -1.f, 1.f);
+    Input.Roll = FMath::Clamp(Action[3], -1.f, 1.f);
+
+    // Sampled at the start of the step, as the character does
+    const FVector Start = Drone.State.Location;
+    const FVector Wind(WindField.Sample(Start));
+    FDroneFlightModel::Step(Config.Flight, Drone.State, Input, Wind, Config.StepSeconds);
+    ++Drone.NumSteps;
+
+    const double StartTime = Drone.Time;
+    Drone.Time += Config.StepSeconds;
+
+    float Reward = 0.f;
+    const FRaceCourseGateMotionRecord* Motion = Motions.IsValidIndex(Drone.GateIndex) ? &Motions[Drone.GateIndex] : nullptr;
+    if (RaceCourse::SegmentCrossesCourseGate(Gates[Drone.GateIndex], Motion, Config.GateHalfOpening, Start, Drone.State.Location, StartTime, Drone.Time))
+    {
+        Reward += Config.GateReward;
+
+        if (++Drone.GateIndex == Gates.Num())
+        {
+            Drone.GateIndex = 0;
+            if (++Drone.Lap > Config.NumLaps)
+            {
+                bOutDone = true;
+                return Reward;
+            }
+        }
+        Drone.GateDistance = FVector::Dist(Drone.State.Location, GetGateTransform(Drone.GateIndex, Drone.Time).GetLocation());
+    }
+    else
+    {
+        // Dense shaping: metres gained toward the next gate
+        const float Distance = FVector::Dist(Drone.State.Location, GetGateTransform(Drone.GateIndex, Drone.Time).GetLocation());
+        Reward += (Drone.GateDistance - Distance) / 100.f;
+        Drone.GateDistance = Distance;
+    }
+
+    if (Drone.State.Location.Z < 0.f || Drone.GateDistance > Config.MaxGateDistance)
+    {
+        bOutDone = true;
+        return Reward + Config.CrashPenalty;
+    }
+
+    bOutDone = Drone.NumSteps >= Config.MaxEpisodeSteps;
+    return Reward;
+}
+
+void FDroneTrainingEnv::WriteObservations(float* Observations) const
+{
+    ParallelFor(TEXT("DroneTrainingEnv.Observe"), Drones.Num(), DroneTrainingEnv::MinBatchSize, [&](int32 Index)
+    {
+        WriteObservation(Drones[Index], Observations + Index * ObsDim);
+    });
+}
+
+void FDroneTrainingEnv::WriteObservation(const FDrone& Drone, float* Out) const
+{
+    using namespace DroneTrainingEnv;
+
+    const FQuat& Rotation = Drone.State.Rotation;
+    const FVector& Location = Drone.State.Location;
+    const FTransform NextGate = GetGateTransform(Drone.GateIndex, Drone.Time);
+    const FTransform GateAfter = GetGateTransform((Drone.GateIndex + 1) % Gates.Num(), Drone.Time);
+
+    WriteVector(Out, Rotation.UnrotateVector(Drone.State.Velocity) / 100.f);
+    WriteVector(Out, Rotation.UnrotateVector(FVector::UpVector));
+    WriteVector(Out, Rotation.UnrotateVector(NextGate.GetLocation() - Location) / 100.f);
+    WriteVector(Out, Rotation.UnrotateVector(NextGate.GetUnitAxis(EAxis::X)));
+    WriteVector(Out, Rotation.UnrotateVector(GateAfter.GetLocation() - Location) / 100.f);
+
+    *Out++ = Drone.State.Battery01;
+    *Out++ = float(Drone.GateIndex) / Gates.Num();
+    *Out++ = float(Drone.NumSteps) / FMath::Max(Config.MaxEpisodeSteps, 1);
+}
+
+FTransform FDroneTrainingEnv::GetGateTransform(int32 GateIndex, double Time) const
+{
+    return Motions.IsValidIndex(GateIndex) ? RaceCourse::EvaluateGateMotion(Motions[GateIndex], Gates[GateIndex], Time) : Gates[GateIndex];
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DroneFlightModel.h"
+#include "DroneWindSubsystem.h"
+#include "RaceCourse.h"
+#include "Math/RandomStream.h"
+#include <atomic>
+
+/**
+ * Header at the start of the training shared-memory region.
+ *
+ * The region is created by the env (POSIX shm on Linux, /dev/shm/<Name>) and
+ * laid out as this header followed by the arrays at the given byte offsets,
+ * each 64-byte aligned, all little-endian:
+ *
+ *   Observations  float32[NumDrones][ObsDim]
+ *   Actions       float32[NumDrones][ActDim]   throttle 0..1, yaw, pitch, roll -1..1
+ *   Rewards       float32[NumDrones]
+ *   Dones         uint8[NumDrones]             1 when the step ended the episode
+ *   ResetMask     uint8[NumDrones]             set by the trainer to reset drones before the next step
+ *
+ * Protocol: the trainer writes Actions (and ResetMask / Command), then
+ * increments RequestSeq. The env runs the command, writes Observations,
+ * Rewards and Dones, and stores RequestSeq into ResponseSeq. Finished drones
+ * are reset right after the step, so their observations already belong to
+ * the next episode.
+ */
+struct FDroneEnvSharedHeader
+{
+    static constexpr uint32 MagicValue = 0x56455244; // 'DREV'
+    static constexpr uint32 CurrentVersion = 1;
+
+    enum ECommand : uint32
+    {
+        Step = 0,
+        ResetAll = 1,
+        Quit = 2,
+    };
+
+    uint32 Magic = MagicValue;
+    uint32 Version = CurrentVersion;
+    uint32 NumDrones = 0;
+    uint32 ObsDim = 0;
+    uint32 ActDim = 0;
+    uint32 Command = Step;
+
+    uint64 ObservationsOffset = 0;
+    uint64 ActionsOffset = 0;
+    uint64 RewardsOffset = 0;
+    uint64 DonesOffset = 0;
+    uint64 ResetMaskOffset = 0;
+
+    std::atomic<uint64> RequestSeq { 0 };
+    std::atomic<uint64> ResponseSeq { 0 };
+
+    /** Seconds of simulated time per step */
+    float StepSeconds = 0.f;
+    uint32 Padding = 0;
+};
+static_assert(sizeof(FDroneEnvSharedHeader) == 88, "Shared header layout is read by external trainers");
+static_assert(std::atomic<uint64>::is_always_lock_free, "Sequence numbers must be plain 64-bit words in shared memory");
+
+/**
+ * Vectorized race environment: N independent drones flying the same course
+ * with FDroneFlightModel and the gate crossing test the race uses for
+ * instanced gates (RaceCourse::SegmentCrossesCourseGate, gate motions
+ * included), stepped in parallel. No world is involved, so there are no
+ * obstacles: a drone crashes when it hits the ground plane or strays too far
+ * from its next gate. With Wind enabled the drones fly through the course's
+ * free-stream wind and turbulence, baked as the game bakes it but without
+ * sheltering or prop wash, which need level geometry and other drones.
+ *
+ * Each drone keeps its own course clock for the gate motions, started at a
+ * random time per episode as a lap starts at any point of the level's clock.
+ *
+ * Observation (ObsDim floats, all in the drone's body frame, distances in m):
+ *   velocity (3), world up (3), next gate offset (3), next gate forward (3),
+ *   gate after that offset (3), battery 0..1, lap progress 0..1, episode time 0..1
+ *
+ * Reward: progress toward the next gate (m), GateReward per gate, CrashPenalty on crash.
+ */
+class DRONERACERFP_API FDroneTrainingEnv
+{
+public:
+    static constexpr int32 ObsDim = 18;
+    static constexpr int32 ActDim = 4;
+
+    struct FConfig
+    {
+        int32 NumDrones = 256;
+        float StepSeconds = 1.f / 120.f;
+        int32 MaxEpisodeSteps = 120 * 90;
+        int32 NumLaps = 1;
+        int32 Seed = 0;
+
+        /** Gate opening half size at scale 1 (cm), as ARaceGateManager::InstancedGateHalfOpening */
+        FVector2f GateHalfOpening = FVector2f(150.f, 150.f);
+
+        /** Distance behind gate 0 drones start at (cm) */
+        float StartDistance = 1000.f;
+
+        /** Episode ends when the next gate is farther than this (cm) */
+        float MaxGateDistance = 20000.f;
+
+        float GateReward = 10.f;
+        float CrashPenalty = -10.f;
+
+        /** Episodes start at a random course time in [0, this) (s) */
+        float MaxStartTime = 60.f;
+
+        FDroneFlightParams Flight;
+        FDroneWindSettings Wind;
+    };
+
+    /** Motions is empty or one record per gate, Type None for gates that stand still */
+    bool Init(const FConfig& InConfig, TConstArrayView<FTransform> InGates, TConstArrayView<FRaceCourseGateMotionRecord> InMotions = {});
+
+    void ResetAll();
+    void Reset(int32 DroneIndex);
+
+    /** Steps every drone once. Arrays are NumDrones (x ObsDim / ActDim) long. */
+    void Step(const float* Actions, float* Observations, float* Rewards, uint8* Dones);
+
+    void WriteObservations(float* Observations) const;
+
+    int32 GetNumDrones() const { return Drones.Num(); }
+    const FConfig& GetConfig() const { return Config; }
+
+private:
+    struct FDrone
+    {
+        FDroneFlightState State;
+        int32 GateIndex = 0;
+        int32 Lap = 1;
+        int32 NumSteps = 0;
+        float GateDistance = 0.f;
+
+        /** Course time the gate motions are evaluated at (s) */
+        double Time = 0.0;
+    };
+
+    /** One drone's step, returns its reward and whether the episode ended */
+    float StepDrone(FDrone& Drone, const float* Action, bool& bOutDone) const;
+    void WriteObservation(const FDrone& Drone, float* Out) const;
+
+    /** Where the gate is at Time, for observations */
+    FTransform GetGateTransform(int32 GateIndex, double Time) const;
+
+    FConfig Config;
+    TArray<FTransform> Gates;
+    TArray<FRaceCourseGateMotionRecord> Motions;
+
+    /** Static wind over the course, read-only while stepping */
+    FDroneWindGrid WindField;
+    TArray<FDrone> Drones;
+    FRandomStream Random;
+};
@@ -0,0 +1,178 @@
+#include "DroneTrajectoryComponent.h"
+#include "DroneFPCharacter.h"
+#include "DroneRacerFP.h"
+#include "DroneWindSubsystem.h"
+
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+
+namespace DroneTrajectory
+{
+    bool SameInput(const FDroneFlightInput& A, const FDroneFlightInput& B)
+    {
+        return A.Throttle01 == B.Throttle01 && A.Yaw == B.Yaw && A.Pitch == B.Pitch && A.Roll == B.Roll;
+    }
+
+    /** Half size of the impact marker (cm) */
+    constexpr float ImpactMarkerSize = 15.f;
+}
+
+UDroneTrajectoryComponent::UDroneTrajectoryComponent()
+{
+    PrimaryComponentTick.bCanEverTick = true;
+
+    // After the drone moved this frame
+    PrimaryComponentTick.TickGroup = TG_PostPhysics;
+}
+
+void UDroneTrajectoryComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+    Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+    const ADroneFPCharacter* Drone = Cast<ADroneFPCharacter>(GetOwner());
+    if (!Drone || !Drone->IsLocallyControlled() || (bOnlyInPracticeMode && !Drone->IsPracticeMode()) || !Drone->GetTelemetry().bArmed)
+    {
+        Samples.Reset();
+        return;
+    }
+
+    DRONERACER_SCOPED_STAT(Trajectory);
+
+    const double Now = GetWorld()->GetTimeSeconds();
+    const FDroneFlightInput CurrentInput = Drone->GetFlightInput();
+
+    FDroneFlightState Current;
+    Current.Location = Drone->GetActorLocation();
+    Current.Rotation = Drone->GetActorQuat();
+    Current.Velocity = Drone->GetVelocity();
+    Current.Battery01 = Drone->GetTelemetry().Battery01;
+
+    // New sticks make a new path; otherwise keep what is still ahead of the drone
+    if (Samples.Num() == 0 || !DroneTrajectory::SameInput(CurrentInput, Input) || !AdvanceTo(Now, Current.Location))
+    {
+        Params = Drone->GetFlightParams();
+        Input = CurrentInput;
+        StepSeconds = Drone->GetPhysicsStepSeconds();
+        StepsPerSample = FMath::Max(FMath::RoundToInt32(SampleSeconds / StepSeconds), 1);
+
+        // The wind where the drone is now, held along the path
+        const UDroneWindSubsystem* WindSubsystem = GetWorld()->GetSubsystem<UDroneWindSubsystem>();
+        Wind = WindSubsystem ? WindSubsystem->SampleWind(Current.Location) : FVector::ZeroVector;
+
+        Restart(Now, Current);
+    }
+
+    Extend(Now + HorizonSeconds);
+    Draw(Current.Location);
+}
+
+bool UDroneTrajectoryComponent::AdvanceTo(double Now, const FVector& Location)
+{
+    // Keep the last sample at or before now as the front
+    int32 NumPassed = 0;
+    while (NumPassed + 1 < Samples.Num() && Samples[NumPassed + 1].Time <= Now)
+    {
+        ++NumPassed;
+    }
+
+    // Ran past the end of the path (horizon shorter than the frame, or the path stopped at an impact)
+    if (NumPassed + 1 >= Samples.Num())
+        return false;
+
+    if (NumPassed > 0)
+    {
+        Samples.RemoveAt(0, NumPassed, EAllowShrinking::No);
+        NumSwept = FMath::Max(NumSwept - NumPassed, 1);
+    }
+
+    // Where the path says the drone should be now
+    const FSample& Before = Samples[0];
+    const FSample& After = Samples[1];
+    const float Alpha = float((Now - Before.Time) / FMath::Max(After.Time - Before.Time, UE_SMALL_NUMBER));
+    const FVector Predicted = FMath::Lerp(Before.State.Location, After.State.Location, Alpha);
+    return FVector::DistSquared(Predicted, Location) <= FMath::Square(ToleranceCm);
+}
+
+void UDroneTrajectoryComponent::Restart(double Now, const FDroneFlightState& State)
+{
+    Samples.Reset();
+    FSample& First = Samples.AddDefaulted_GetRef();
+    First.State = State;
+    First.Time = Now;
+
+    NumSwept = 1;
+    bHasImpact = false;
+}
+
+void UDroneTrajectoryComponent::Extend(double Until)
+{
+    UWorld* World = GetWorld();
+    const ACharacter* Drone = Cast<ACharacter>(GetOwner());
+    const float Radius = Drone ? Drone->GetCapsuleComponent()->GetScaledCapsuleRadius() : 10.f;
+    const double SampleTime = StepsPerSample * StepSeconds;
+
+    FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(DroneTrajectory), false, GetOwner());
+    const FCollisionObjectQueryParams ObjectParams(ECC_WorldStatic);
+    const FCollisionShape Sphere = FCollisionShape::MakeSphere(Radius);
+
+    while (!bHasImpact)
+    {
+        // Sweep what was integrated but not swept yet; segments already swept are kept as they are
+        for (; NumSwept < Samples.Num(); ++NumSwept)
+        {
+            FHitResult Hit;
+            const FVector& Start = Samples[NumSwept - 1].State.Location;
+            const FVector& End = Samples[NumSwept].State.Location;
+            if (World->SweepSingleByObjectType(Hit, Start, End, FQuat::Identity, ObjectParams, Sphere, QueryParams))
+            {
+                bHasImpact = true;
+                ImpactLocation = Hit.Location;
+                Samples[NumSwept].State.Location = Hit.Location;
+                Samples.SetNum(NumSwept + 1, EAllowShrinking::No);
+                ++NumSwept;
+                break;
+            }
+        }
+
+        if (bHasImpact || Samples.Last().Time >= Until)
+            break;
+
+        FSample Next = Samples.Last();
+        FDroneFlightModel::StepRepeated(Params, Next.State, Input, Wind, StepSeconds, StepsPerSample);
+        Next.Time += SampleTime;
+        Samples.Add(Next);
+    }
+}
+
+void UDroneTrajectoryComponent::Draw(const FVector& From)
+{
+    ULineBatchComponent* LineBatcher = GetWorld()->LineBatcher;
+    if (!LineBatcher || Samples.Num() < 2)
+        return;
+
+    Lines.Reset();
+
+    // From the drone itself, then through the samples ahead
+    FVector Start = From;
+    const int32 NumSegments = Samples.Num() - 1;
+    for (int32 Index = 1; Index < Samples.Num(); ++Index)
+    {
+        // Fades out toward the horizon
+        FLinearColor Color = PathColor;
+        Color.A = 1.f - 0.7f * float(Index - 1) / NumSegments;
+
+        const FVector& End = Samples[Index].State.Location;
+        Lines.Emplace(Start, End, Color, 0.f, Thickness, SDPG_World);
+        Start = End;
+    }
+
+    if (bHasImpact)
+    {
+        const float Size = DroneTrajectory::ImpactMarkerSize;
+        Lines.Emplace(ImpactLocation - FVector(Size, 0.f, 0.f), ImpactLocation + FVector(Size, 0.f, 0.f), ImpactColor, 0.f, Thickness * 2.f, SDPG_World);
+        Lines.Emplace(ImpactLocation - FVector(0.f, Size, 0.f), ImpactLocation + FVector(0.f, Size, 0.f), ImpactColor, 0.f, Thickness * 2.f, SDPG_World);
+        Lines.Emplace(ImpactLocation - FVector(0.f, 0.f, Size), ImpactLocation + FVector(0.f, 0.f, Size), ImpactColor, 0.f, Thickness * 2.f, SDPG_World);
+    }
+
+    LineBatcher->DrawLines(Lines);
+}
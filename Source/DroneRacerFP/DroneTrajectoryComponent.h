@@ -0,0 +1,92 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Components/LineBatchComponent.h"
+#include "DroneFlightModel.h"
+#include "DroneTrajectoryComponent.generated.h"
+
+/**
+ * Practice aid: draws where the owning drone will be over the next
+ * HorizonSeconds if the pilot holds the sticks where they are, and where it
+ * would hit the course.
+ *
+ * The path is kept between frames. As long as the sticks don't move and the
+ * drone stays within ToleranceCm of it, the samples already passed are
+ * dropped and only the end is extended, so a frame usually integrates and
+ * sweeps one or two new samples. Integration goes through
+ * FDroneFlightModel::StepRepeated (closed form with the sticks centred);
+ * each new segment is swept once against static geometry. The path and the
+ * impact marker go to the world's line batcher as one batch.
+ *
+ * Only draws for the locally controlled drone, and with bOnlyInPracticeMode
+ * only in practice mode.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class DRONERACERFP_API UDroneTrajectoryComponent : public UActorComponent
+{
+    GENERATED_BODY()
+
+public:
+    UDroneTrajectoryComponent();
+
+    virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Prediction", meta = (ClampMin = "0.1", ClampMax = "5"))
+    float HorizonSeconds = 1.5f;
+
+    /** Time between path samples, rounded to whole physics steps */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Prediction", meta = (ClampMin = "0.005"))
+    float SampleSeconds = 1.f / 30.f;
+
+    /** The path is recomputed once the drone is further than this from it (wind, collisions, rewinds) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Prediction", meta = (ClampMin = "0.1"))
+    float ToleranceCm = 10.f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Prediction")
+    bool bOnlyInPracticeMode = true;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Prediction")
+    FLinearColor PathColor = FLinearColor(0.2f, 1.f, 0.4f);
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Prediction")
+    FLinearColor ImpactColor = FLinearColor(1.f, 0.15f, 0.1f);
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Prediction", meta = (ClampMin = "0"))
+    float Thickness = 1.5f;
+
+private:
+    struct FSample
+    {
+        FDroneFlightState State;
+
+        /** World time the drone gets here */
+        double Time = 0.0;
+    };
+
+    /** Drops passed samples; false if the drone has left the path */
+    bool AdvanceTo(double Now, const FVector& Location);
+
+    void Restart(double Now, const FDroneFlightState& State);
+    void Extend(double Until);
+    void Draw(const FVector& From);
+
+    /** Front is the sample at or just before now */
+    TArray<FSample> Samples;
+
+    /** Samples before this index have been swept against the course */
+    int32 NumSwept = 1;
+
+    /** Set once a swept segment hits; the path ends there */
+    bool bHasImpact = false;
+    FVector ImpactLocation = FVector::ZeroVector;
+
+    /** What the path was predicted with */
+    FDroneFlightParams Params;
+    FDroneFlightInput Input;
+    FVector Wind = FVector::ZeroVector;
+    float StepSeconds = 1.f / 120.f;
+    int32 StepsPerSample = 4;
+
+    TArray<FBatchedLine> Lines;
+};
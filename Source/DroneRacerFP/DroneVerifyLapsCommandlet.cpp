@@ -0,0 +1,165 @@
+#include "DroneVerifyLapsCommandlet.h"
+#include "DroneFPCharacter.h"
+#include "DroneFlightModel.h"
+#include "DroneReplay.h"
+#include "LapTimeStore.h"
+#include "LapVerifier.h"
+#include "RaceGate.h"
+#include "RaceCourse.h"
+
+#include "Components/BoxComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "HAL/FileManager.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+
+UDroneVerifyLapsCommandlet::UDroneVerifyLapsCommandlet()
+{
+    IsClient = false;
+    IsEditor = false;
+    IsServer = false;
+    LogToConsole = true;
+}
+
+int32 UDroneVerifyLapsCommandlet::Main(const FString& Params)
+{
+    FString CoursesDir = FPaths::Combine(FPaths::ProjectContentDir(), TEXT("Courses"));
+    FString LapTimesDir = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("LapTimes"));
+    FString ReplaysDir = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Replays"));
+    int32 NumTop = FLapTimeStore::TopLapsPerCourse;
+    FParse::Value(*Params, TEXT("Courses="), CoursesDir);
+    FParse::Value(*Params, TEXT("LapTimes="), LapTimesDir);
+    FParse::Value(*Params, TEXT("Replays="), ReplaysDir);
+    FParse::Value(*Params, TEXT("Top="), NumTop);
+
+    // Drones the laps may have been flown with; without any, every lap is flown with the params it recorded
+    FLapVerifier::FConfig Config;
+    FString DroneClassPaths;
+    if (FParse::Value(*Params, TEXT("DroneClasses="), DroneClassPaths, /*bShouldStopOnSeparator*/ false))
+    {
+        TArray<FString> Paths;
+        DroneClassPaths.ParseIntoArray(Paths, TEXT(","));
+        for (const FString& Path : Paths)
+        {
+            UClass* DroneClass = StaticLoadClass(ADroneFPCharacter::StaticClass(), nullptr, *Path);
+            if (!DroneClass)
+            {
+                UE_LOG(LogTemp, Error, TEXT("DroneVerifyLaps: can't load drone class %s"), *Path);
+                return 1;
+            }
+
+            const ADroneFPCharacter* Drone = DroneClass->GetDefaultObject<ADroneFPCharacter>();
+            Config.AllowedFlightHashes.AddUnique(FDroneReplay::ComputeFlightHash(Drone->GetFlightParams(), Drone->GetPhysicsStepSeconds()));
+            Config.DroneRadius = Drone->GetCapsuleComponent()->GetScaledCapsuleRadius();
+        }
+    }
+    else
+    {
+        UE_LOG(LogTemp, Display, TEXT("DroneVerifyLaps: no -DroneClasses, laps are flown with the params they recorded"));
+    }
+
+    // The trigger gate actors score laps with
+    FString GateClassPath;
+    if (FParse::Value(*Params, TEXT("GateClass="), GateClassPath))
+    {
+        UClass* GateClass = StaticLoadClass(ARaceGate::StaticClass(), nullptr, *GateClassPath);
+        if (!GateClass)
+        {
+            UE_LOG(LogTemp, Error, TEXT("DroneVerifyLaps: can't load gate class %s"), *GateClassPath);
+            return 1;
+        }
+
+        const UBoxComponent* Trigger = GateClass->GetDefaultObject<ARaceGate>()->GateTrigger;
+        Config.GateTriggerTransform = Trigger->GetRelativeTransform();
+        Config.GateTriggerExtent = Trigger->GetUnscaledBoxExtent();
+    }
+    else
+    {
+        UE_LOG(LogTemp, Display, TEXT("DroneVerifyLaps: no -GateClass, laps scored by gate actors fail"));
+    }
+    FLapVerifier Verifier(Config);
+
+    TArray<FString> CourseFiles;
+    IFileManager::Get().FindFilesRecursive(CourseFiles, *CoursesDir, TEXT("*.drcourse"), true, false);
+
+    TArray<uint64> CourseIds;
+    for (const FString& Path : CourseFiles)
+    {
+        FRaceCourseFile Course;
+        if (!Course.Open(Path))
+        {
+            UE_LOG(LogTemp, Warning, TEXT("DroneVerifyLaps: skipping unreadable course %s"), *Path);
+            continue;
+        }
+
+        // Replays keep lap time, not the world time the gates' motion runs on
+        if (Course.Motions().Num() > 0)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("DroneVerifyLaps: skipping %s, moving gates can't be replayed"), *Path);
+            continue;
+        }
+
+        TArray<FTransform> Gates;
+        Gates.Reserve(Course.Gates().Num());
+        for (const FRaceCourseGateRecord& Record : Course.Gates())
+        {
+            Gates.Add(Record.ToTransform());
+        }
+
+        const uint64 CourseId = Course.GetInfo().CourseId;
+        Verifier.AddCourse(CourseId, MoveTemp(Gates));
+        CourseIds.AddUnique(CourseId);
+    }
+
+    FLapTimeStore Store;
+    if (!Store.Open(LapTimesDir))
+    {
+        UE_LOG(LogTemp, Error, TEXT("DroneVerifyLaps: can't open lap times in %s"), *LapTimesDir);
+        return 1;
+    }
+
+    // Read every claim up front, the batch only touches replay files
+    TArray<FLapVerifier::FRequest> Requests;
+    TArray<FLapIndexEntry> Entries;
+    for (const uint64 CourseId : CourseIds)
+    {
+        Store.GetTopLaps(CourseId, NumTop, Entries);
+        for (const FLapIndexEntry& Entry : Entries)
+        {
+            FLapVerifier::FRequest& Request = Requests.AddDefaulted_GetRef();
+            if (!Store.ReadLap(Entry, Request.Claim))
+            {
+                Request.Claim.CourseId = Entry.CourseId;
+                Request.Claim.LapTime = Entry.LapTime;
+            }
+            if (!Request.Claim.ReplayRef.IsEmpty())
+            {
+                Request.ReplayPath = FPaths::Combine(ReplaysDir, Request.Claim.ReplayRef);
+            }
+        }
+    }
+    Store.Close();
+
+    UE_LOG(LogTemp, Display, TEXT("DroneVerifyLaps: %d laps on %d courses"), Requests.Num(), CourseIds.Num());
+
+    const double StartTime = FPlatformTime::Seconds();
+    TArray<ELapVerifyResult> Results;
+    Verifier.VerifyBatch(Requests, Results);
+    const double Elapsed = FMath::Max(FPlatformTime::Seconds() - StartTime, UE_DOUBLE_SMALL_NUMBER);
+
+    int32 NumFailed = 0;
+    for (int32 Index = 0; Index < Requests.Num(); ++Index)
+    {
+        if (Results[Index] != ELapVerifyResult::Verified)
+        {
+            const FLapRecord& Claim = Requests[Index].Claim;
+            UE_LOG(LogTemp, Warning, TEXT("DroneVerifyLaps: %016llx %s %.3f s: %s"),
+                Claim.CourseId, *Claim.Pilot, Claim.LapTime, LexToString(Results[Index]));
+            ++NumFailed;
+        }
+    }
+
+    UE_LOG(LogTemp, Display, TEXT("DroneVerifyLaps: %d verified, %d failed in %.2f s (%.0f laps/s)"),
+        Requests.Num() - NumFailed, NumFailed, Elapsed, Requests.Num() / Elapsed);
+    return NumFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "DroneVerifyLapsCommandlet.generated.h"
+
+/**
+ * Verifies the fastest stored laps of every course by re-simulating their
+ * replays (see LapVerifier.h):
+ *
+ *   UnrealEditor-Cmd DroneRacerFP.uproject -run=DroneVerifyLaps -nullrhi -unattended
+ *       [-Courses=<dir>] [-LapTimes=<dir>] [-Replays=<dir>] [-Top=<n>] [-DroneClasses=<class path>,...]
+ *       [-GateClass=<class path>]
+ *
+ * Courses are the .drcourse files under Courses (Content/Courses by
+ * default); lap times and replays default to the game's Saved/LapTimes and
+ * Saved/Replays. Laps are flown with the flight params and step recorded
+ * in their replay; with DroneClasses, those must be the params of one of
+ * the classes. Laps the race scored with gate actors are tested against
+ * the trigger of GateClass, the race manager's GateClass, and fail without
+ * it. Every lap that isn't verified is logged; returns 1 if there were any.
+ */
+UCLASS()
+class UDroneVerifyLapsCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UDroneVerifyLapsCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,401 @@
+#include "DroneWindSubsystem.h"
+#include "DroneRacerFP.h"
+
+#include "Async/Async.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/OverlapResult.h"
+#include "Engine/World.h"
+#include "Hash/CityHash.h"
+#include "Math/VectorRegister.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace DroneWind
+{
+    constexpr uint32 CacheMagic = 0x46575244; // 'DRWF'
+    constexpr uint32 CacheVersion = 2;
+
+    FORCEINLINE VectorRegister4Float LoadCell(const FVector4f* Cell)
+    {
+        return VectorLoad(&Cell->X);
+    }
+
+    FORCEINLINE VectorRegister4Float Lerp(const VectorRegister4Float& A, const VectorRegister4Float& B, const VectorRegister4Float& T)
+    {
+        return VectorMultiplyAdd(VectorSubtract(B, A), T, A);
+    }
+}
+
+// ===== FDroneWindGrid =====
+
+void FDroneWindGrid::Init(const FBox& Bounds, float InCellSize, int32 MaxCells)
+{
+    const FVector Size = Bounds.GetSize();
+
+    CellSize = FMath::Max(InCellSize, 1.f);
+    for (;;)
+    {
+        // At least 2 cells per axis so every sample has an upper neighbour
+        Dims.X = FMath::Max(FMath::CeilToInt(Size.X / CellSize) + 1, 2);
+        Dims.Y = FMath::Max(FMath::CeilToInt(Size.Y / CellSize) + 1, 2);
+        Dims.Z = FMath::Max(FMath::CeilToInt(Size.Z / CellSize) + 1, 2);
+
+        if (int64(Dims.X) * Dims.Y * Dims.Z <= MaxCells)
+            break;
+
+        CellSize *= 1.25f;
+    }
+
+    Origin = FVector3f(Bounds.Min);
+    InvCellSize = 1.f / CellSize;
+    Cells.SetNumZeroed(Dims.X * Dims.Y * Dims.Z);
+}
+
+void FDroneWindGrid::Empty()
+{
+    Cells.Empty();
+    Dims = FIntVector::ZeroValue;
+}
+
+FVector FDroneWindGrid::GetCellCenter(int32 X, int32 Y, int32 Z) const
+{
+    return FVector(Origin) + FVector(X, Y, Z) * CellSize;
+}
+
+bool FDroneWindGrid::Contains(const FVector& Location) const
+{
+    // Same limits Locate clamps to
+    const FVector3f Local = (FVector3f(Location) - Origin) * InvCellSize;
+    return IsValid()
+        && Local.X >= 0.f && Local.X <= Dims.X - 1.001f
+        && Local.Y >= 0.f && Local.Y <= Dims.Y - 1.001f
+        && Local.Z >= 0.f && Local.Z <= Dims.Z - 1.001f;
+}
+
+int32 FDroneWindGrid::Locate(const FVector& Location, FVector3f& OutFraction) const
+{
+    const FVector3f Local = (FVector3f(Location) - Origin) * InvCellSize;
+
+    // Clamped so the upper corner is always inside the grid
+    const FVector3f Clamped(
+        FMath::Clamp(Local.X, 0.f, Dims.X - 1.001f),
+        FMath::Clamp(Local.Y, 0.f, Dims.Y - 1.001f),
+        FMath::Clamp(Local.Z, 0.f, Dims.Z - 1.001f));
+
+    const int32 X = int32(Clamped.X);
+    const int32 Y = int32(Clamped.Y);
+    const int32 Z = int32(Clamped.Z);
+    OutFraction = FVector3f(Clamped.X - X, Clamped.Y - Y, Clamped.Z - Z);
+
+    return X + Dims.X * (Y + Dims.Y * Z);
+}
+
+FVector3f FDroneWindGrid::Sample(const FVector& Location) const
+{
+    using namespace DroneWind;
+
+    if (!IsValid())
+        return FVector3f::ZeroVector;
+
+    FVector3f Fraction;
+    const FVector4f* C = Cells.GetData() + Locate(Location, Fraction);
+    const int32 SY = Dims.X;
+    const int32 SZ = Dims.X * Dims.Y;
+
+    const VectorRegister4Float FX = VectorSetFloat1(Fraction.X);
+    const VectorRegister4Float FY = VectorSetFloat1(Fraction.Y);
+    const VectorRegister4Float FZ = VectorSetFloat1(Fraction.Z);
+
+    // X pairs are adjacent in memory, Y and Z pairs one row / slice apart
+    const VectorRegister4Float C00 = Lerp(LoadCell(C), LoadCell(C + 1), FX);
+    const VectorRegister4Float C10 = Lerp(LoadCell(C + SY), LoadCell(C + SY + 1), FX);
+    const VectorRegister4Float C01 = Lerp(LoadCell(C + SZ), LoadCell(C + SZ + 1), FX);
+    const VectorRegister4Float C11 = Lerp(LoadCell(C + SY + SZ), LoadCell(C + SY + SZ + 1), FX);
+
+    const VectorRegister4Float Result = Lerp(Lerp(C00, C10, FY), Lerp(C01, C11, FY), FZ);
+
+    FVector4f Out;
+    VectorStore(Result, &Out.X);
+    return FVector3f(Out.X, Out.Y, Out.Z);
+}
+
+void FDroneWindGrid::Splat(const FVector& Location, const FVector3f& Value)
+{
+    if (!IsValid())
+        return;
+
+    FVector3f F;
+    const int32 Base = Locate(Location, F);
+    const int32 SY = Dims.X;
+    const int32 SZ = Dims.X * Dims.Y;
+
+    const FVector4f V(Value, 0.f);
+    Cells[Base] += V * ((1.f - F.X) * (1.f - F.Y) * (1.f - F.Z));
+    Cells[Base + 1] += V * (F.X * (1.f - F.Y) * (1.f - F.Z));
+    Cells[Base + SY] += V * ((1.f - F.X) * F.Y * (1.f - F.Z));
+    Cells[Base + SY + 1] += V * (F.X * F.Y * (1.f - F.Z));
+    Cells[Base + SZ] += V * ((1.f - F.X) * (1.f - F.Y) * F.Z);
+    Cells[Base + SZ + 1] += V * (F.X * (1.f - F.Y) * F.Z);
+    Cells[Base + SY + SZ] += V * ((1.f - F.X) * F.Y * F.Z);
+    Cells[Base + SY + SZ + 1] += V * (F.X * F.Y * F.Z);
+}
+
+void FDroneWindGrid::Scale(float Factor)
+{
+    const VectorRegister4Float VFactor = VectorSetFloat1(Factor);
+    for (FVector4f& Cell : Cells)
+    {
+        VectorStore(VectorMultiply(VectorLoad(&Cell.X), VFactor), &Cell.X);
+    }
+}
+
+FArchive& operator<<(FArchive& Ar, FDroneWindGrid& Grid)
+{
+    Ar << Grid.Origin << Grid.CellSize << Grid.Dims << Grid.Cells;
+
+    if (Ar.IsLoading())
+    {
+        Grid.InvCellSize = 1.f / FMath::Max(Grid.CellSize, 1.f);
+        if (Grid.Cells.Num() != Grid.Dims.X * Grid.Dims.Y * Grid.Dims.Z || Grid.Dims.GetMin() < 2)
+        {
+            Ar.SetError();
+            Grid.Empty();
+        }
+    }
+    return Ar;
+}
+
+// ===== UDroneWindSubsystem =====
+
+void UDroneWindSubsystem::PrepareCourse(uint64 CourseId, const FBox& Bounds, const FDroneWindSettings& InSettings)
+{
+    Settings = InSettings;
+    StaticField.Empty();
+    PropWash.Empty();
+    PendingField.Empty();
+    NextBakeRow = INDEX_NONE;
+
+    if (!Settings.bEnabled || !Bounds.IsValid)
+        return;
+
+    // The ClampMin metas only hold in the editor; the bake and the decay divide by these
+    Settings.GustScale = FMath::Max(Settings.GustScale, 100.f);
+    Settings.PropWashSeconds = FMath::Max(Settings.PropWashSeconds, 0.05f);
+    Settings.CellSize = FMath::Max(Settings.CellSize, 50.f);
+    Settings.PropWashCellSize = FMath::Max(Settings.PropWashCellSize, 50.f);
+
+    const FBox Padded = Bounds.ExpandBy(Settings.BoundsPadding);
+    PropWash.Init(Padded, Settings.PropWashCellSize, Settings.MaxBakedCells);
+
+    // Reuse an earlier bake of the same course, settings and geometry
+    const FString CachePath = GetCachePath(CourseId, Padded);
+    TArray<uint8> Bytes;
+    if (FFileHelper::LoadFileToArray(Bytes, *CachePath, FILEREAD_Silent))
+    {
+        FMemoryReader Reader(Bytes);
+        uint32 Magic = 0;
+        uint32 Version = 0;
+        Reader << Magic << Version;
+        if (Magic == DroneWind::CacheMagic && Version == DroneWind::CacheVersion)
+        {
+            Reader << StaticField;
+            if (!Reader.IsError())
+            {
+                UE_LOG(LogTemp, Log, TEXT("DroneWind: loaded baked field %s"), *CachePath);
+                return;
+            }
+        }
+        StaticField.Empty();
+    }
+
+    BeginBake(Padded, CachePath);
+}
+
+void UDroneWindSubsystem::BeginBake(const FBox& Bounds, const FString& CachePath)
+{
+    PendingField.Init(Bounds, Settings.CellSize, Settings.MaxBakedCells);
+    PendingCachePath = CachePath;
+    NextBakeRow = 0;
+    BakeStartTime = FPlatformTime::Seconds();
+
+    // First slice right away, like course gates
+    if (BakeRows(BakeStartTime + Settings.BakeBudgetMs / 1000.0))
+    {
+        FinishBake();
+    }
+}
+
+bool UDroneWindSubsystem::BakeRows(double Deadline)
+{
+    DRONERACER_SCOPED_STAT(WindBake);
+
+    const UWorld* World = GetWorld();
+    const FVector Upwind = -Settings.AmbientWind.GetSafeNormal();
+    const bool bTrace = !Upwind.IsZero() && Settings.ShelterDistance > 0.f;
+
+    FCollisionQueryParams Params(SCENE_QUERY_STAT(DroneWindBake), /*bTraceComplex*/ false);
+
+    // A row is at most a few hundred traces; the clock is checked between rows
+    const FIntVector Dims = PendingField.GetDims();
+    const int32 NumRows = Dims.Y * Dims.Z;
+    do
+    {
+        const int32 Y = NextBakeRow % Dims.Y;
+        const int32 Z = NextBakeRow / Dims.Y;
+        for (int32 X = 0; X < Dims.X; ++X)
+        {
+            const FVector Center = PendingField.GetCellCenter(X, Y, Z);
+
+            // 1 in free stream, toward 0 right behind an obstacle
+            float Exposure = 1.f;
+            FHitResult Hit;
+            if (bTrace && World->LineTraceSingleByChannel(Hit, Center, Center + Upwind * Settings.ShelterDistance, ECC_WorldStatic, Params))
+            {
+                Exposure = Hit.Distance / Settings.ShelterDistance;
+            }
+
+            PendingField.At(X, Y, Z) = FVector4f(FVector3f(ComputeWind(Settings, Center, Exposure)), 0.f);
+        }
+    }
+    while (++NextBakeRow < NumRows && FPlatformTime::Seconds() < Deadline);
+
+    return NextBakeRow >= NumRows;
+}
+
+FVector UDroneWindSubsystem::ComputeWind(const FDroneWindSettings& InSettings, const FVector& Location, float Exposure)
+{
+    // Sheltered air is pushed over the obstacle
+    FVector Wind = InSettings.AmbientWind * Exposure
+        + FVector::UpVector * InSettings.AmbientWind.Size() * (1.f - Exposure) * InSettings.UpdraftFactor;
+
+    // Turbulence, stronger in the wake
+    const FVector N = Location * (1.f / FMath::Max(InSettings.GustScale, 100.f));
+    const FVector Gust(
+        FMath::PerlinNoise3D(N),
+        FMath::PerlinNoise3D(N + FVector(31.7f, 0.f, 0.f)),
+        FMath::PerlinNoise3D(N + FVector(0.f, 57.3f, 0.f)));
+    return Wind + Gust * InSettings.GustStrength * (2.f - Exposure);
+}
+
+void UDroneWindSubsystem::FinishBake()
+{
+    StaticField = MoveTemp(PendingField);
+    PendingField.Empty();
+    NextBakeRow = INDEX_NONE;
+
+    const FIntVector Dims = StaticField.GetDims();
+    UE_LOG(LogTemp, Log, TEXT("DroneWind: baked %dx%dx%d cells over %.1f ms"),
+        Dims.X, Dims.Y, Dims.Z, (FPlatformTime::Seconds() - BakeStartTime) * 1000.0);
+
+    // Serialized here, written on the thread pool
+    TArray<uint8> Bytes;
+    FMemoryWriter Writer(Bytes);
+    uint32 Magic = DroneWind::CacheMagic;
+    uint32 Version = DroneWind::CacheVersion;
+    Writer << Magic << Version << StaticField;
+
+    Async(EAsyncExecution::ThreadPool, [Path = PendingCachePath, Bytes = MoveTemp(Bytes)]()
+    {
+        if (!FFileHelper::SaveArrayToFile(Bytes, *Path))
+        {
+            UE_LOG(LogTemp, Warning, TEXT("DroneWind: could not write %s"), *Path);
+        }
+    });
+}
+
+FString UDroneWindSubsystem::GetCachePath(uint64 CourseId, const FBox& Bounds) const
+{
+    // Everything the bake depends on
+    TArray<uint8> Key;
+    FMemoryWriter Writer(Key);
+    FVector Min = Bounds.Min;
+    FVector Max = Bounds.Max;
+    FVector AmbientWind = Settings.AmbientWind;
+    float GustStrength = Settings.GustStrength;
+    float GustScale = Settings.GustScale;
+    float ShelterDistance = Settings.ShelterDistance;
+    float UpdraftFactor = Settings.UpdraftFactor;
+    float CellSize = Settings.CellSize;
+    int32 MaxBakedCells = Settings.MaxBakedCells;
+    uint64 GeometryHash = HashStaticGeometry(Bounds);
+    Writer << Min << Max << AmbientWind << GustStrength << GustScale << ShelterDistance << UpdraftFactor << CellSize << MaxBakedCells << GeometryHash;
+
+    const uint64 SettingsHash = CityHash64(reinterpret_cast<const char*>(Key.GetData()), Key.Num());
+    return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("WindFields"),
+        FString::Printf(TEXT("%016llx_%016llx.wind"), CourseId, SettingsHash));
+}
+
+uint64 UDroneWindSubsystem::HashStaticGeometry(const FBox& Bounds) const
+{
+    // Only what the shelter traces can hit: static collision within reach of the baked cells
+    const FBox Reach = Bounds.ExpandBy(Settings.ShelterDistance);
+    TArray<FOverlapResult> Overlaps;
+    FCollisionQueryParams Params(SCENE_QUERY_STAT(DroneWindGeometryHash), /*bTraceComplex*/ false);
+    GetWorld()->OverlapMultiByChannel(Overlaps, Reach.GetCenter(), FQuat::Identity, ECC_WorldStatic,
+        FCollisionShape::MakeBox(Reach.GetExtent()), Params);
+
+    // Overlaps come back in no particular order; each component hashes on its own and the sum doesn't care
+    uint64 Hash = 0;
+    for (const FOverlapResult& Overlap : Overlaps)
+    {
+        const UPrimitiveComponent* Component = Overlap.GetComponent();
+        if (!Component)
+            continue;
+
+        TArray<uint8> Key;
+        FMemoryWriter Writer(Key);
+        FString Path = UWorld::RemovePIEPrefix(Component->GetPathName());
+        FTransform Transform = Component->GetComponentTransform();
+        FBox ComponentBounds = Component->Bounds.GetBox();
+        Writer << Path << Transform << ComponentBounds;
+        Hash += CityHash64(reinterpret_cast<const char*>(Key.GetData()), Key.Num());
+    }
+
+    // The level the course is in, so the same layout in two maps doesn't share a bake
+    const FString LevelName = UWorld::RemovePIEPrefix(GetWorld()->GetOutermost()->GetName());
+    return CityHash64WithSeed(reinterpret_cast<const char*>(*LevelName), LevelName.Len() * sizeof(TCHAR), Hash);
+}
+
+FVector UDroneWindSubsystem::SampleWind(const FVector& Location) const
+{
+    return FVector(StaticField.Sample(Location) + PropWash.Sample(Location));
+}
+
+void UDroneWindSubsystem::AddPropWash(const FVector& Location, const FVector& Direction, float Throttle01, float DeltaTime)
+{
+    if (!PropWash.IsValid() || Throttle01 <= 0.f)
+        return;
+
+    // Splatted two cells straight below, so it pushes whoever flies underneath and never the drone itself:
+    // the Z layers a sample at the drone reads and the ones the splat writes are disjoint. Near the
+    // grid's edges clamping would make them overlap, so the wash is dropped there.
+    const FVector Below = Location - FVector::UpVector * (2.f * PropWash.GetCellSize());
+    if (!PropWash.Contains(Location) || !PropWash.Contains(Below))
+        return;
+
+    // Rate chosen so that hovering in place settles at PropWashSpeed against the decay in Tick
+    const float Rate = DeltaTime / Settings.PropWashSeconds;
+    PropWash.Splat(Below, FVector3f(Direction * Settings.PropWashSpeed * Throttle01 * Rate));
+}
+
+void UDroneWindSubsystem::Tick(float DeltaTime)
+{
+    if (IsBaking() && BakeRows(FPlatformTime::Seconds() + Settings.BakeBudgetMs / 1000.0))
+    {
+        FinishBake();
+    }
+
+    DRONERACER_SCOPED_STAT(WindDecay);
+
+    if (PropWash.IsValid())
+    {
+        PropWash.Scale(FMath::Exp(-DeltaTime / Settings.PropWashSeconds));
+    }
+}
+
+TStatId UDroneWindSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UDroneWindSubsystem, STATGROUP_Tickables);
+}
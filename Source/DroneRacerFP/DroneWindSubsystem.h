@@ -0,0 +1,175 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DroneWindSubsystem.generated.h"
+
+/** Wind of a course, set on ARaceGateManager */
+USTRUCT(BlueprintType)
+struct DRONERACERFP_API FDroneWindSettings
+{
+    GENERATED_BODY()
+
+    /** Off by default: wind changes how the drone flies, so a level opts in */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wind")
+    bool bEnabled = false;
+
+    /** Free-stream wind (cm/s) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wind")
+    FVector AmbientWind = FVector(150.f, 0.f, 0.f);
+
+    /** Amplitude of the turbulence added on top (cm/s) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wind")
+    float GustStrength = 100.f;
+
+    /** Size of the turbulence features (cm) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wind", meta = (ClampMin = "100"))
+    float GustScale = 2000.f;
+
+    /** Distance upwind of an obstacle that still shelters a point (cm) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wind")
+    float ShelterDistance = 1500.f;
+
+    /** Share of the sheltered wind deflected upward behind obstacles */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wind")
+    float UpdraftFactor = 0.5f;
+
+    /** Baked grid cell size (cm), grown if the course would need more than MaxBakedCells */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wind", meta = (ClampMin = "50"))
+    float CellSize = 200.f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wind")
+    int32 MaxBakedCells = 256 * 1024;
+
+    /** Margin around the gates covered by the grids (cm) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wind")
+    float BoundsPadding = 2000.f;
+
+    /** Game-thread time spent baking per frame while a bake runs (ms) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wind", meta = (ClampMin = "0.1"))
+    float BakeBudgetMs = 2.f;
+
+    // ===== Prop wash =====
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wind|PropWash", meta = (ClampMin = "50"))
+    float PropWashCellSize = 400.f;
+
+    /** Downwash below a drone at full throttle (cm/s) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wind|PropWash")
+    float PropWashSpeed = 800.f;
+
+    /** Time constant the wash builds up and fades with (s) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wind|PropWash", meta = (ClampMin = "0.05"))
+    float PropWashSeconds = 0.5f;
+};
+
+/**
+ * Regular grid of wind vectors over a box, sampled trilinearly.
+ *
+ * Cells are FVector4f (W unused) stored X-fastest, so a sample reads 4 pairs
+ * of adjacent cells and blends them with SIMD vector registers.
+ */
+class DRONERACERFP_API FDroneWindGrid
+{
+public:
+    /** Zeroed grid covering Bounds, cells grown until there are at most MaxCells */
+    void Init(const FBox& Bounds, float CellSize, int32 MaxCells = MAX_int32);
+    void Empty();
+
+    bool IsValid() const { return Cells.Num() > 0; }
+    FIntVector GetDims() const { return Dims; }
+    float GetCellSize() const { return CellSize; }
+
+    /** Inside the box the cells cover, where Sample and Splat aren't clamped */
+    bool Contains(const FVector& Location) const;
+    FVector GetCellCenter(int32 X, int32 Y, int32 Z) const;
+    FVector4f& At(int32 X, int32 Y, int32 Z) { return Cells[X + Dims.X * (Y + Dims.Y * Z)]; }
+
+    /** Trilinear sample, clamped to the grid */
+    FVector3f Sample(const FVector& Location) const;
+
+    /** Adds Value to the 8 cells around Location, weighted like Sample reads them */
+    void Splat(const FVector& Location, const FVector3f& Value);
+
+    void Scale(float Factor);
+
+    friend FArchive& operator<<(FArchive& Ar, FDroneWindGrid& Grid);
+
+private:
+    /** Index of the lower corner cell and the fractions toward the upper one */
+    int32 Locate(const FVector& Location, FVector3f& OutFraction) const;
+
+    FVector3f Origin = FVector3f::ZeroVector;
+    float CellSize = 1.f;
+    float InvCellSize = 1.f;
+    FIntVector Dims = FIntVector::ZeroValue;
+    TArray<FVector4f> Cells;
+};
+
+/**
+ * Wind felt by drones: a static field baked per course (ambient wind,
+ * sheltering and updrafts around obstacles, turbulence) plus a coarse
+ * prop-wash field that drones splat their downwash into and that fades out
+ * over PropWashSeconds.
+ *
+ * The bake traces every cell against the level, so it runs over several
+ * frames within BakeBudgetMs; the course has no static wind until it is
+ * done. Bakes are cached in Saved/WindFields per course, settings and the
+ * static geometry around the course, so a course only pays the traces the
+ * first time it is flown after an edit.
+ */
+UCLASS()
+class DRONERACERFP_API UDroneWindSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    /** Builds both fields over Bounds for the given course */
+    void PrepareCourse(uint64 CourseId, const FBox& Bounds, const FDroneWindSettings& InSettings);
+
+    /** Air velocity at Location (cm/s), zero outside a prepared course */
+    FVector SampleWind(const FVector& Location) const;
+
+    /**
+     * Feeds a drone's downwash (Direction scaled by Throttle01) into the wash
+     * grid, far enough below it that the drone's own samples never read it.
+     */
+    void AddPropWash(const FVector& Location, const FVector& Direction, float Throttle01, float DeltaTime);
+
+    bool IsBaking() const { return NextBakeRow != INDEX_NONE; }
+
+    /**
+     * Static wind at Location: ambient wind scaled by Exposure (1 in free
+     * stream, toward 0 right behind an obstacle), the updraft of the
+     * sheltered part and turbulence. What the bake stores per cell.
+     */
+    static FVector ComputeWind(const FDroneWindSettings& InSettings, const FVector& Location, float Exposure = 1.f);
+
+    // UTickableWorldSubsystem
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+private:
+    void BeginBake(const FBox& Bounds, const FString& CachePath);
+
+    /** Bakes rows until Deadline; true when the field is complete */
+    bool BakeRows(double Deadline);
+    void FinishBake();
+
+    FString GetCachePath(uint64 CourseId, const FBox& Bounds) const;
+
+    /** Hash of the static collision the bake traces against, so an edited level bakes again */
+    uint64 HashStaticGeometry(const FBox& Bounds) const;
+
+    FDroneWindSettings Settings;
+    FDroneWindGrid StaticField;
+    FDroneWindGrid PropWash;
+
+    /** Field being baked, moved to StaticField when complete */
+    FDroneWindGrid PendingField;
+
+    /** Next row (Y, Z) of PendingField to bake, INDEX_NONE when no bake runs */
+    int32 NextBakeRow = INDEX_NONE;
+    FString PendingCachePath;
+    double BakeStartTime = 0.0;
+};
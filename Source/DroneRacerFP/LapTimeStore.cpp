@@ -0,0 +1,466 @@
+#include "LapTimeStore.h"
+
+#include "Algo/BinarySearch.h"
+#include "Async/MappedFileHandle.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/Event.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/RunnableThread.h"
+#include "Hash/CityHash.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace LapTimeStore
+{
+    constexpr uint32 RecordMagic = 0x5250414C; // 'LAPR'
+    constexpr uint32 SplitsMagic = 0x5053414C; // 'LASP'
+
+    struct FRecordHeader
+    {
+        uint32 Magic = RecordMagic;
+        uint32 PayloadSize = 0;
+    };
+
+    bool TruncateFile(const FString& Path, int64 Size)
+    {
+        TUniquePtr<IFileHandle> Handle(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*Path, true, true));
+        return Handle && Handle->Truncate(Size);
+    }
+}
+
+FLapTimeStore::FLapTimeStore() = default;
+
+FLapTimeStore::~FLapTimeStore()
+{
+    Close();
+}
+
+bool FLapTimeStore::Open(const FString& Directory)
+{
+    Close();
+
+    IFileManager& FileManager = IFileManager::Get();
+    FileManager.MakeDirectory(*Directory, true);
+
+    LogPath = FPaths::Combine(Directory, TEXT("laps.log"));
+    IndexPath = FPaths::Combine(Directory, TEXT("laps.idx"));
+    SplitsPath = FPaths::Combine(Directory, TEXT("bestsplits.bin"));
+
+    if (!LoadIndex())
+        return false;
+
+    LoadSplitSnapshot();
+
+    WakeEvent = FPlatformProcess::GetSynchEventFromPool();
+    bStopping = false;
+    WriterThread = FRunnableThread::Create(this, TEXT("LapTimeWriter"), 0, TPri_BelowNormal);
+
+    UE_LOG(LogTemp, Log, TEXT("LapTimeStore: %lld laps on %d courses in %s"), NumIndexedLaps, Courses.Num(), *Directory);
+    return WriterThread != nullptr;
+}
+
+void FLapTimeStore::Close()
+{
+    if (WriterThread)
+    {
+        bStopping = true;
+        WakeEvent->Trigger();
+        WriterThread->WaitForCompletion();
+        delete WriterThread;
+        WriterThread = nullptr;
+
+        FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+        WakeEvent = nullptr;
+
+        // Everything up to here is on disk now
+        SplitsCoveredOffset = NextLogOffset;
+        SaveSplitSnapshot();
+    }
+
+    Courses.Reset();
+    PersonalBests.Reset();
+    NumIndexedLaps = 0;
+    NextLogOffset = 0;
+    SplitsCoveredOffset = 0;
+}
+
+// ===== Startup =====
+
+bool FLapTimeStore::LoadIndex()
+{
+    TUniquePtr<FArchive> Log(IFileManager::Get().CreateFileReader(*LogPath, FILEREAD_Silent));
+    const int64 IndexSize = FMath::Max<int64>(IFileManager::Get().FileSize(*IndexPath), 0);
+    int64 NumEntries = IndexSize / sizeof(FLapIndexEntry);
+    int64 IndexedLogEnd = 0;
+
+    if (NumEntries > 0)
+    {
+        // Mapped only while the aggregates are built; the writer thread appends to it afterwards
+        IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+        TUniquePtr<IMappedFileHandle> IndexHandle(PlatformFile.OpenMapped(*IndexPath));
+        TUniquePtr<IMappedFileRegion> IndexRegion;
+        if (IndexHandle)
+        {
+            IndexRegion.Reset(IndexHandle->MapRegion(0, NumEntries * sizeof(FLapIndexEntry)));
+        }
+        if (!IndexRegion)
+        {
+            UE_LOG(LogTemp, Error, TEXT("LapTimeStore: could not map %s"), *IndexPath);
+            return false;
+        }
+
+        // The log is flushed before the index entry, so only a lost write (power cut) leaves entries without a record
+        const FLapIndexEntry* Entries = reinterpret_cast<const FLapIndexEntry*>(IndexRegion->GetMappedPtr());
+        while (NumEntries > 0)
+        {
+            IndexedLogEnd = Log ? ReadRecord(*Log, Entries[NumEntries - 1].LogOffset, nullptr) : INDEX_NONE;
+            if (IndexedLogEnd != INDEX_NONE)
+                break;
+            IndexedLogEnd = 0;
+            --NumEntries;
+        }
+
+        for (int64 Index = 0; Index < NumEntries; ++Index)
+        {
+            AddToAggregates(Entries[Index]);
+        }
+        NumIndexedLaps = NumEntries;
+    }
+
+    // A torn entry at the end (crash mid-write) is cut off, or every later append would land misaligned behind it
+    const int64 ValidIndexSize = NumEntries * sizeof(FLapIndexEntry);
+    if (IndexSize != ValidIndexSize)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("LapTimeStore: cutting %lld torn bytes off %s"), IndexSize - ValidIndexSize, *IndexPath);
+        if (!LapTimeStore::TruncateFile(IndexPath, ValidIndexSize))
+        {
+            UE_LOG(LogTemp, Error, TEXT("LapTimeStore: could not truncate %s"), *IndexPath);
+            return false;
+        }
+    }
+
+    return RecoverLog(MoveTemp(Log), IndexedLogEnd);
+}
+
+bool FLapTimeStore::RecoverLog(TUniquePtr<FArchive> Log, int64 IndexedLogEnd)
+{
+    NextLogOffset = IndexedLogEnd;
+    if (!Log)
+        return true; // first run
+
+    // Whole records past the last indexed one lost their index write; they are indexed again
+    TArray<FLapIndexEntry> Recovered;
+    FLapRecord Record;
+    for (int64 End; (End = ReadRecord(*Log, NextLogOffset, &Record)) != INDEX_NONE; NextLogOffset = End)
+    {
+        const FLapIndexEntry& Entry = Recovered.Add_GetRef(MakeIndexEntry(Record, NextLogOffset));
+        AddToAggregates(Entry);
+    }
+
+    const int64 LogSize = Log->TotalSize();
+    Log.Reset();
+
+    if (Recovered.Num() > 0)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("LapTimeStore: indexing %d laps missing from %s"), Recovered.Num(), *IndexPath);
+        TUniquePtr<FArchive> Index(IFileManager::Get().CreateFileWriter(*IndexPath, FILEWRITE_Append | FILEWRITE_AllowRead));
+        if (!Index)
+        {
+            UE_LOG(LogTemp, Error, TEXT("LapTimeStore: could not open %s for append"), *IndexPath);
+            return false;
+        }
+        Index->Serialize(Recovered.GetData(), Recovered.Num() * sizeof(FLapIndexEntry));
+        NumIndexedLaps += Recovered.Num();
+    }
+
+    // Then a torn record is cut off, so the next one starts where the index says it does
+    if (LogSize > int64(NextLogOffset))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("LapTimeStore: cutting %lld torn bytes off %s"), LogSize - int64(NextLogOffset), *LogPath);
+        if (!LapTimeStore::TruncateFile(LogPath, NextLogOffset))
+        {
+            UE_LOG(LogTemp, Error, TEXT("LapTimeStore: could not truncate %s"), *LogPath);
+            return false;
+        }
+    }
+    return true;
+}
+
+void FLapTimeStore::LoadSplitSnapshot()
+{
+    using namespace LapTimeStore;
+
+    if (TUniquePtr<FArchive> Reader = TUniquePtr<FArchive>(IFileManager::Get().CreateFileReader(*SplitsPath)))
+    {
+        uint32 Magic = 0;
+        *Reader << Magic;
+        if (Magic == SplitsMagic)
+        {
+            int32 NumCourses = 0;
+            *Reader << SplitsCoveredOffset << NumCourses;
+            for (int32 Index = 0; Index < NumCourses && !Reader->IsError(); ++Index)
+            {
+                uint64 CourseId = 0;
+                *Reader << CourseId;
+                *Reader << Courses.FindOrAdd(CourseId).BestSplits;
+            }
+        }
+        if (Magic != SplitsMagic || Reader->IsError())
+        {
+            SplitsCoveredOffset = 0;
+            for (TPair<uint64, FCourseStats>& Course : Courses)
+            {
+                Course.Value.BestSplits.Reset();
+            }
+        }
+    }
+
+    // Laps logged after the snapshot (e.g. the process was killed) are replayed from the log
+    if (SplitsCoveredOffset >= NextLogOffset)
+        return;
+
+    TUniquePtr<FArchive> Log(IFileManager::Get().CreateFileReader(*LogPath));
+    if (!Log)
+        return;
+
+    FLapRecord Record;
+    for (int64 Offset = SplitsCoveredOffset; (Offset = ReadRecord(*Log, Offset, &Record)) != INDEX_NONE; )
+    {
+        AddSplits(Record.CourseId, Record.Splits);
+    }
+}
+
+void FLapTimeStore::SaveSplitSnapshot() const
+{
+    using namespace LapTimeStore;
+
+    TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*SplitsPath));
+    if (!Writer)
+        return;
+
+    uint32 Magic = SplitsMagic;
+    uint64 Covered = SplitsCoveredOffset;
+    int32 NumCourses = Courses.Num();
+    *Writer << Magic << Covered << NumCourses;
+    for (const TPair<uint64, FCourseStats>& Course : Courses)
+    {
+        uint64 CourseId = Course.Key;
+        *Writer << CourseId;
+        *Writer << const_cast<TArray<float>&>(Course.Value.BestSplits);
+    }
+}
+
+// ===== Aggregates =====
+
+void FLapTimeStore::AddToAggregates(const FLapIndexEntry& Entry)
+{
+    TArray<FLapIndexEntry>& TopLaps = Courses.FindOrAdd(Entry.CourseId).TopLaps;
+    if (TopLaps.Num() < TopLapsPerCourse || Entry.LapTime < TopLaps.Last().LapTime)
+    {
+        // Ties keep submission order
+        const int32 InsertAt = Algo::UpperBoundBy(TopLaps, Entry.LapTime, &FLapIndexEntry::LapTime);
+        TopLaps.Insert(Entry, InsertAt);
+        if (TopLaps.Num() > TopLapsPerCourse)
+        {
+            TopLaps.Pop(EAllowShrinking::No);
+        }
+    }
+
+    FLapIndexEntry& Best = PersonalBests.FindOrAdd(TPair<uint64, uint64>(Entry.CourseId, Entry.PilotId), Entry);
+    if (Entry.LapTime < Best.LapTime)
+    {
+        Best = Entry;
+    }
+}
+
+void FLapTimeStore::AddSplits(uint64 CourseId, TConstArrayView<float> Splits)
+{
+    TArray<float>& BestSplits = Courses.FindOrAdd(CourseId).BestSplits;
+    if (BestSplits.Num() < Splits.Num())
+    {
+        BestSplits.Reserve(Splits.Num());
+        while (BestSplits.Num() < Splits.Num())
+        {
+            BestSplits.Add(-1.f);
+        }
+    }
+
+    for (int32 Gate = 0; Gate < Splits.Num(); ++Gate)
+    {
+        if (Splits[Gate] >= 0.f && (BestSplits[Gate] < 0.f || Splits[Gate] < BestSplits[Gate]))
+        {
+            BestSplits[Gate] = Splits[Gate];
+        }
+    }
+}
+
+// ===== Writes =====
+
+void FLapTimeStore::Submit(const FLapRecord& InRecord)
+{
+    using namespace LapTimeStore;
+
+    if (!WriterThread)
+        return;
+
+    FPendingWrite Write;
+
+    // Serialize here so the log offset of the record is known without waiting for the writer
+    FLapRecord Record = InRecord;
+    FMemoryWriter Writer(Write.LogBytes);
+    FRecordHeader Header;
+    Writer.Serialize(&Header, sizeof(Header));
+    SerializeRecord(Writer, Record);
+
+    Header.PayloadSize = Write.LogBytes.Num() - sizeof(Header);
+    FMemory::Memcpy(Write.LogBytes.GetData(), &Header, sizeof(Header));
+
+    Write.Entry = MakeIndexEntry(Record, NextLogOffset);
+
+    NextLogOffset += Write.LogBytes.Num();
+    ++NumIndexedLaps;
+
+    AddToAggregates(Write.Entry);
+    AddSplits(Record.CourseId, Record.Splits);
+
+    PendingWrites.Enqueue(MoveTemp(Write));
+    WakeEvent->Trigger();
+}
+
+uint32 FLapTimeStore::Run()
+{
+    while (!bStopping)
+    {
+        WakeEvent->Wait();
+        WritePending();
+    }
+
+    // Drain whatever was submitted before Close
+    WritePending();
+    return 0;
+}
+
+void FLapTimeStore::Stop()
+{
+    bStopping = true;
+    if (WakeEvent)
+    {
+        WakeEvent->Trigger();
+    }
+}
+
+void FLapTimeStore::WritePending()
+{
+    if (PendingWrites.IsEmpty())
+        return;
+
+    TUniquePtr<FArchive> Log(IFileManager::Get().CreateFileWriter(*LogPath, FILEWRITE_Append | FILEWRITE_AllowRead));
+    TUniquePtr<FArchive> Index(IFileManager::Get().CreateFileWriter(*IndexPath, FILEWRITE_Append | FILEWRITE_AllowRead));
+    if (!Log || !Index)
+    {
+        UE_LOG(LogTemp, Error, TEXT("LapTimeStore: could not open %s for append"), *LogPath);
+        return;
+    }
+
+    // Log first: an index entry never points past the end of the log
+    FPendingWrite Write;
+    while (PendingWrites.Dequeue(Write))
+    {
+        Log->Serialize(Write.LogBytes.GetData(), Write.LogBytes.Num());
+        Log->Flush();
+        Index->Serialize(&Write.Entry, sizeof(Write.Entry));
+    }
+}
+
+// ===== Queries =====
+
+void FLapTimeStore::GetTopLaps(uint64 CourseId, int32 Count, TArray<FLapIndexEntry>& OutLaps) const
+{
+    OutLaps.Reset();
+    if (const FCourseStats* Course = Courses.Find(CourseId))
+    {
+        OutLaps.Append(Course->TopLaps.GetData(), FMath::Clamp(Count, 0, Course->TopLaps.Num()));
+    }
+}
+
+bool FLapTimeStore::GetPersonalBest(uint64 CourseId, const FString& Pilot, FLapIndexEntry& OutLap) const
+{
+    if (const FLapIndexEntry* Best = PersonalBests.Find(TPair<uint64, uint64>(CourseId, PilotId(Pilot))))
+    {
+        OutLap = *Best;
+        return true;
+    }
+    return false;
+}
+
+TConstArrayView<float> FLapTimeStore::GetBestSplits(uint64 CourseId) const
+{
+    const FCourseStats* Course = Courses.Find(CourseId);
+    return Course ? TConstArrayView<float>(Course->BestSplits) : TConstArrayView<float>();
+}
+
+bool FLapTimeStore::ReadLap(const FLapIndexEntry& Entry, FLapRecord& OutRecord) const
+{
+    // Not written yet if the writer thread hasn't got to it
+    TUniquePtr<FArchive> Log(IFileManager::Get().CreateFileReader(*LogPath, FILEREAD_AllowWrite));
+    return Log && ReadRecord(*Log, Entry.LogOffset, &OutRecord) != INDEX_NONE;
+}
+
+int64 FLapTimeStore::ReadRecord(FArchive& Log, int64 Offset, FLapRecord* OutRecord)
+{
+    using namespace LapTimeStore;
+
+    const int64 LogSize = Log.TotalSize();
+    if (Offset < 0 || Offset + int64(sizeof(FRecordHeader)) > LogSize)
+        return INDEX_NONE;
+
+    Log.Seek(Offset);
+    FRecordHeader Header;
+    Log.Serialize(&Header, sizeof(Header));
+    const int64 End = Log.Tell() + Header.PayloadSize;
+    if (Header.Magic != RecordMagic || End > LogSize)
+        return INDEX_NONE;
+
+    if (OutRecord)
+    {
+        TArray<uint8> Payload;
+        Payload.SetNumUninitialized(Header.PayloadSize);
+        Log.Serialize(Payload.GetData(), Payload.Num());
+
+        FMemoryReader Reader(Payload);
+        SerializeRecord(Reader, *OutRecord);
+        if (Reader.IsError())
+            return INDEX_NONE;
+    }
+    return Log.IsError() ? INDEX_NONE : End;
+}
+
+FLapIndexEntry FLapTimeStore::MakeIndexEntry(const FLapRecord& Record, uint64 LogOffset)
+{
+    FLapIndexEntry Entry;
+    Entry.CourseId = Record.CourseId;
+    Entry.PilotId = PilotId(Record.Pilot);
+    Entry.LogOffset = LogOffset;
+    Entry.TimestampTicks = Record.Timestamp.GetTicks();
+    Entry.LapTime = Record.LapTime;
+    Entry.NumSplits = Record.Splits.Num();
+    return Entry;
+}
+
+void FLapTimeStore::SerializeRecord(FArchive& Ar, FLapRecord& Record)
+{
+    Ar << Record.CourseId;
+    Ar << Record.Pilot;
+    Ar << Record.LapTime;
+    Ar << Record.Splits;
+    Ar << Record.ReplayRef;
+    Ar << Record.Timestamp;
+}
+
+uint64 FLapTimeStore::PilotId(const FString& Pilot)
+{
+    const FString Key = Pilot.ToLower();
+    return CityHash64(reinterpret_cast<const char*>(*Key), Key.Len() * sizeof(TCHAR));
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "HAL/Runnable.h"
+#include <atomic>
+
+class FRunnableThread;
+class FEvent;
+
+/** A finished lap as submitted by the race */
+struct FLapRecord
+{
+    uint64 CourseId = 0;
+    FString Pilot;
+    float LapTime = 0.f;
+
+    /** Time from the previous gate (or lap start) to each gate */
+    TArray<float> Splits;
+
+    /** Replay / input recording this lap can be re-simulated from, empty if none */
+    FString ReplayRef;
+
+    FDateTime Timestamp;
+};
+
+/** Fixed-size index entry, one per lap, in laps.idx */
+struct FLapIndexEntry
+{
+    uint64 CourseId = 0;
+    uint64 PilotId = 0;
+    uint64 LogOffset = 0;
+    int64 TimestampTicks = 0;
+    float LapTime = 0.f;
+    uint32 NumSplits = 0;
+};
+static_assert(sizeof(FLapIndexEntry) == 40, "Lap index entries are written as raw bytes");
+
+/**
+ * Local persistence for lap times.
+ *
+ * Files (in one directory):
+ *   laps.log        append-only, variable-size records with the full lap (pilot, splits, replay)
+ *   laps.idx        append-only FLapIndexEntry per lap, memory mapped at startup to
+ *                   rebuild the aggregates without parsing the log
+ *   bestsplits.bin  best split per gate per course, rewritten on Close together with the
+ *                   log offset it covers; laps logged after that offset are replayed on Open
+ *
+ * Submit() updates the in-memory aggregates (top laps per course, personal
+ * bests, best splits) right away and hands the serialized record to a writer
+ * thread, so the game thread never touches the disk. Queries answer from the
+ * aggregates; the mapped index is only walked once at startup.
+ *
+ * A crash can tear the last write. Open cuts both files back to whole
+ * records before anything is appended again: a partial index entry is
+ * dropped, log records the index never got are indexed, and a partial log
+ * record is cut off.
+ */
+class DRONERACERFP_API FLapTimeStore : public FRunnable
+{
+public:
+    /** Laps kept per course for GetTopLaps */
+    static constexpr int32 TopLapsPerCourse = 100;
+
+    FLapTimeStore();
+    virtual ~FLapTimeStore();
+
+    bool Open(const FString& Directory);
+
+    /** Drains pending writes, saves the split snapshot and stops the writer */
+    void Close();
+
+    void Submit(const FLapRecord& Record);
+
+    /** Fastest laps on a course, best first, at most TopLapsPerCourse */
+    void GetTopLaps(uint64 CourseId, int32 Count, TArray<FLapIndexEntry>& OutLaps) const;
+
+    bool GetPersonalBest(uint64 CourseId, const FString& Pilot, FLapIndexEntry& OutLap) const;
+
+    /** Best split per gate, negative where no lap recorded one */
+    TConstArrayView<float> GetBestSplits(uint64 CourseId) const;
+
+    /** Reads the full record behind an index entry from the log */
+    bool ReadLap(const FLapIndexEntry& Entry, FLapRecord& OutRecord) const;
+
+    int64 GetNumLaps() const { return NumIndexedLaps; }
+
+    static uint64 PilotId(const FString& Pilot);
+
+    // FRunnable
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    struct FCourseStats
+    {
+        /** Sorted by LapTime, at most TopLapsPerCourse */
+        TArray<FLapIndexEntry> TopLaps;
+        TArray<float> BestSplits;
+    };
+
+    struct FPendingWrite
+    {
+        TArray<uint8> LogBytes;
+        FLapIndexEntry Entry;
+    };
+
+    void AddToAggregates(const FLapIndexEntry& Entry);
+    void AddSplits(uint64 CourseId, TConstArrayView<float> Splits);
+    bool LoadIndex();
+    bool RecoverLog(TUniquePtr<FArchive> Log, int64 IndexedLogEnd);
+    void LoadSplitSnapshot();
+    void SaveSplitSnapshot() const;
+    void WritePending();
+
+    static void SerializeRecord(FArchive& Ar, FLapRecord& Record);
+    static FLapIndexEntry MakeIndexEntry(const FLapRecord& Record, uint64 LogOffset);
+
+    /** Reads the record at Offset into OutRecord (if set); returns where it ends, INDEX_NONE if it is torn or missing */
+    static int64 ReadRecord(FArchive& Log, int64 Offset, FLapRecord* OutRecord);
+
+    FString LogPath;
+    FString IndexPath;
+    FString SplitsPath;
+
+    TMap<uint64, FCourseStats> Courses;
+    TMap<TPair<uint64, uint64>, FLapIndexEntry> PersonalBests;
+
+    /** Where the next record will land in laps.log; only the game thread appends */
+    uint64 NextLogOffset = 0;
+
+    /** Log offset covered by bestsplits.bin */
+    uint64 SplitsCoveredOffset = 0;
+
+    int64 NumIndexedLaps = 0;
+
+    // Writer thread
+    TQueue<FPendingWrite, EQueueMode::Spsc> PendingWrites;
+    FRunnableThread* WriterThread = nullptr;
+    FEvent* WakeEvent = nullptr;
+    std::atomic<bool> bStopping { false };
+};
@@ -0,0 +1,17 @@
+#include "LapTimeSubsystem.h"
+
+#include "Misc/Paths.h"
+
+void ULapTimeSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    Store.Open(FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("LapTimes")));
+}
+
+void ULapTimeSubsystem::Deinitialize()
+{
+    Store.Close();
+
+    Super::Deinitialize();
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "LapTimeStore.h"
+#include "LapTimeSubsystem.generated.h"
+
+/**
+ * Owns the local lap-time store for the lifetime of the game instance.
+ * Files live in Saved/LapTimes.
+ */
+UCLASS()
+class DRONERACERFP_API ULapTimeSubsystem : public UGameInstanceSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    virtual void Deinitialize() override;
+
+    FLapTimeStore& GetStore() { return Store; }
+    const FLapTimeStore& GetStore() const { return Store; }
+
+private:
+    FLapTimeStore Store;
+};
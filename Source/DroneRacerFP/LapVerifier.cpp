@@ -0,0 +1,219 @@
+#include "LapVerifier.h"
+#include "DroneReplay.h"
+#include "RaceCourse.h"
+
+#include "Async/ParallelFor.h"
+
+namespace LapVerifier
+{
+    // Sweeps stop a hair short of or back off from a surface (cm, cm/s)
+    constexpr double ContactSlack = 1.0;
+}
+
+const TCHAR* LexToString(ELapVerifyResult Result)
+{
+    switch (Result)
+    {
+    case ELapVerifyResult::Verified:        return TEXT("Verified");
+    case ELapVerifyResult::MissingReplay:   return TEXT("MissingReplay");
+    case ELapVerifyResult::UnknownCourse:   return TEXT("UnknownCourse");
+    case ELapVerifyResult::Mismatch:        return TEXT("Mismatch");
+    case ELapVerifyResult::Impossible:      return TEXT("Impossible");
+    case ELapVerifyResult::Incomplete:      return TEXT("Incomplete");
+    case ELapVerifyResult::TooFast:         return TEXT("TooFast");
+    }
+    return TEXT("Unknown");
+}
+
+FLapVerifier::FLapVerifier(const FConfig& InConfig)
+    : Config(InConfig)
+{
+}
+
+void FLapVerifier::AddCourse(uint64 CourseId, TArray<FTransform> Gates)
+{
+    Courses.Add(CourseId, MoveTemp(Gates));
+}
+
+bool FLapVerifier::IsPlausibleStart(const FDroneFlightState& State, TConstArrayView<FTransform> Gates, bool bTriggers, float StepSeconds) const
+{
+    if (!State.Rotation.IsNormalized() || State.Battery01 < 0.f || State.Battery01 > 1.f)
+        return false;
+
+    const double Speed = State.Velocity.Size();
+    if (Speed > Config.MaxStartSpeed)
+        return false;
+
+    // First lap: the race starts wherever the drone waits, near the course start
+    if (FVector::Dist(State.Location, Gates[0].GetLocation()) <= Config.MaxStartDistance)
+        return true;
+
+    // Later laps start after the step that crossed the last gate: at most one step past its opening, or into its trigger
+    const FTransform& LastGate = Gates.Last();
+    const FVector Local = LastGate.InverseTransformPositionNoScale(State.Location);
+    const FVector Scale = LastGate.GetScale3D();
+    const double Reach = Speed * StepSeconds + LapVerifier::ContactSlack;
+    if (bTriggers)
+    {
+        const FVector Grown = Config.GateTriggerExtent * Scale.GetAbs() + FVector(Config.DroneRadius + Reach);
+        return FMath::Abs(Local.X) <= Grown.X && FMath::Abs(Local.Y) <= Grown.Y && FMath::Abs(Local.Z) <= Grown.Z;
+    }
+    return Local.X >= -LapVerifier::ContactSlack && Local.X <= Reach
+        && FMath::Abs(Local.Y) <= Config.GateHalfOpening.X * Scale.Y + Reach
+        && FMath::Abs(Local.Z) <= Config.GateHalfOpening.Y * Scale.Z + Reach;
+}
+
+bool FLapVerifier::SegmentPassesGate(const FTransform& Gate, bool bTriggers, const FVector& Start, const FVector& End) const
+{
+    return bTriggers
+        ? RaceCourse::SegmentEntersGateTrigger(Gate, Config.GateTriggerExtent, Config.DroneRadius, Start, End)
+        : RaceCourse::SegmentCrossesGate(Gate, Config.GateHalfOpening, Start, End);
+}
+
+ELapVerifyResult FLapVerifier::Verify(const FRequest& Request) const
+{
+    FDroneReplay Replay;
+    if (Request.ReplayPath.IsEmpty() || !Replay.Load(Request.ReplayPath))
+        return ELapVerifyResult::MissingReplay;
+
+    return Verify(Request.Claim, Replay);
+}
+
+ELapVerifyResult FLapVerifier::Verify(const FLapRecord& Claim, const FDroneReplay& Replay) const
+{
+    const FDroneReplayHeader& Header = Replay.Header;
+
+    const TArray<FTransform>* CourseGates = Courses.Find(Claim.CourseId);
+    if (!CourseGates || CourseGates->Num() == 0)
+        return ELapVerifyResult::UnknownCourse;
+
+    if (Header.CourseId != Claim.CourseId)
+        return ELapVerifyResult::Mismatch;
+
+    // The lap is flown again with the params it recorded, as long as they are ones the race allows
+    if (Header.StepSeconds <= 0.f || Header.FlightHash != FDroneReplay::ComputeFlightHash(Header.Params, Header.StepSeconds)
+        || (Config.AllowedFlightHashes.Num() > 0 && !Config.AllowedFlightHashes.Contains(Header.FlightHash)))
+        return ELapVerifyResult::Mismatch;
+
+    const int32 NumGates = CourseGates->Num();
+    if (Claim.Splits.Num() != NumGates)
+        return ELapVerifyResult::Mismatch;
+
+    // Scored the way the race did; gate actors only with the trigger of the race's gate class
+    const bool bTriggers = Header.GateTest == FDroneReplayHeader::Trigger;
+    if ((Header.GateTest != FDroneReplayHeader::Opening && !bTriggers) || (bTriggers && Config.GateTriggerExtent.IsNearlyZero()))
+        return ELapVerifyResult::Mismatch;
+
+    // Gates (or their triggers) in the world the lap was flown in
+    const FTransform CourseTransform = Replay.GetCourseTransform();
+    TArray<FTransform, TInlineAllocator<64>> Gates;
+    Gates.Reserve(NumGates);
+    for (const FTransform& Gate : *CourseGates)
+    {
+        Gates.Add(bTriggers ? Config.GateTriggerTransform * Gate * CourseTransform : Gate * CourseTransform);
+    }
+
+    FDroneFlightState State = Replay.GetInitialState();
+    if (!IsPlausibleStart(State, Gates, bTriggers, Header.StepSeconds))
+        return ELapVerifyResult::Impossible;
+
+    const double StepSeconds = Header.StepSeconds;
+    const float MaxWindSpeedSquared = FMath::Square(Config.MaxWindSpeed);
+
+    int32 NextGate = 0;
+    int32 NextContact = 0;
+    int32 NumDronePushes = 0;
+    double LastGateTime = 0.0;
+    for (int32 StepIndex = 0; StepIndex < Replay.Steps.Num(); ++StepIndex)
+    {
+        // The lap ends on the step that crossed the last gate
+        if (NextGate == NumGates)
+            return ELapVerifyResult::Incomplete;
+
+        const FDroneReplayStep& Step = Replay.Steps[StepIndex];
+        const bool bContact = (Step.Flags & FDroneReplayStep::Contact) != 0;
+
+        // Disarmed drones don't move
+        if (!(Step.Flags & FDroneReplayStep::Armed))
+        {
+            if (bContact)
+                return ELapVerifyResult::Impossible;
+            continue;
+        }
+
+        const FVector3f Wind(Step.Wind[0], Step.Wind[1], Step.Wind[2]);
+        if (Wind.SizeSquared() > MaxWindSpeedSquared)
+            return ELapVerifyResult::Impossible;
+
+        const FVector Start = State.Location;
+        FDroneFlightModel::Step(Header.Params, State, Step.Input, FVector(Wind), Header.StepSeconds);
+
+        if (bContact)
+        {
+            if (!Replay.Contacts.IsValidIndex(NextContact) || Replay.Contacts[NextContact].Step != uint32(StepIndex))
+                return ELapVerifyResult::Impossible;
+
+            const FDroneReplayContact& Contact = Replay.Contacts[NextContact++];
+            const FVector ContactLocation(Contact.Location[0], Contact.Location[1], Contact.Location[2]);
+            const FVector ContactVelocity(Contact.Velocity[0], Contact.Velocity[1], Contact.Velocity[2]);
+
+            if (Contact.Flags & FDroneReplayContact::DronePush)
+            {
+                // Another drone can push either way, but only so far, so hard and so often
+                if (++NumDronePushes > Config.MaxDronePushes
+                    || FVector::Dist(ContactLocation, State.Location) > Config.MaxDronePushDistance
+                    || FVector::Dist(ContactVelocity, State.Velocity) > Config.MaxDronePushSpeed)
+                    return ELapVerifyResult::Impossible;
+            }
+            else
+            {
+                // The sweep stops the drone somewhere on the path the model gave it
+                if (FMath::PointDistToSegment(ContactLocation, Start, State.Location) > LapVerifier::ContactSlack)
+                    return ELapVerifyResult::Impossible;
+
+                // The slide only removes the velocity into one surface normal, so what is left is perpendicular to what was removed
+                const FVector Removed = State.Velocity - ContactVelocity;
+                const double RemovedSpeed = Removed.Size();
+                if (RemovedSpeed > LapVerifier::ContactSlack
+                    && FMath::Abs(FVector::DotProduct(ContactVelocity, Removed / RemovedSpeed)) > LapVerifier::ContactSlack)
+                    return ELapVerifyResult::Impossible;
+            }
+
+            State.Location = ContactLocation;
+            State.Velocity = ContactVelocity;
+        }
+
+        if (SegmentPassesGate(Gates[NextGate], bTriggers, Start, State.Location))
+        {
+            const double Time = (StepIndex + 1) * StepSeconds;
+            // The race may see the pass a step to either side, where the drone only grazes the gate
+            if (Claim.Splits[NextGate] < Time - LastGateTime - StepSeconds - Config.TimeTolerance)
+                return ELapVerifyResult::TooFast;
+
+            LastGateTime = Time;
+            ++NextGate;
+        }
+    }
+
+    if (NextContact != Replay.Contacts.Num())
+        return ELapVerifyResult::Impossible;
+
+    if (NextGate != NumGates)
+        return ELapVerifyResult::Incomplete;
+
+    if (Claim.LapTime < (Replay.Steps.Num() - 1) * StepSeconds - Config.TimeTolerance)
+        return ELapVerifyResult::TooFast;
+
+    return ELapVerifyResult::Verified;
+}
+
+void FLapVerifier::VerifyBatch(TConstArrayView<FRequest> Requests, TArray<ELapVerifyResult>& OutResults) const
+{
+    OutResults.SetNumUninitialized(Requests.Num());
+
+    // A lap is thousands of steps, plenty of work per task
+    ParallelFor(TEXT("LapVerifier.Batch"), Requests.Num(), 1, [&](int32 Index)
+    {
+        OutResults[Index] = Verify(Requests[Index]);
+    });
+}
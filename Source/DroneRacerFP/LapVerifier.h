@@ -0,0 +1,124 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DroneFlightModel.h"
+#include "LapTimeStore.h"
+
+struct FDroneReplay;
+
+enum class ELapVerifyResult : uint8
+{
+    Verified,
+    MissingReplay,
+    UnknownCourse,
+    /** Replay is for another course, flown with drone params or a step that aren't allowed, or scored by gates the config has no geometry for */
+    Mismatch,
+    /** A start state, contact, drone push or wind sample the race can't have produced */
+    Impossible,
+    /** The inputs don't fly through every gate in order, or fly on past the last one */
+    Incomplete,
+    /** Claimed lap or split faster than the re-simulation */
+    TooFast,
+};
+
+DRONERACERFP_API const TCHAR* LexToString(ELapVerifyResult Result);
+
+/**
+ * Verifies submitted laps by re-simulating their replays (DroneReplay.h)
+ * headless with FDroneFlightModel, then checking gate order, lap time and
+ * splits against the claim. Gates are tested the way the replay says the
+ * race scored them: through the opening of instanced gates
+ * (RaceCourse::SegmentCrossesGate with GateHalfOpening), or by entering the
+ * trigger of gate actors (RaceCourse::SegmentEntersGateTrigger with
+ * GateTriggerExtent). Laps scored by gate actors are rejected while the
+ * config has no trigger.
+ *
+ * Laps are re-simulated with the flight params and step recorded in the
+ * replay, which must hash to the recorded FlightHash and, if the config
+ * lists any, be one of AllowedFlightHashes.
+ *
+ * A replay carries the world's effect on the drone instead of the world:
+ * wind samples, sweep contacts and pushes from other drones. Those are
+ * bounded rather than trusted: a contact must lie on the step's path and
+ * only take away the velocity into one surface, like the character's slide;
+ * a push (which may be merged with a slide in the same step) must stay
+ * within MaxDronePushDistance and MaxDronePushSpeed of the model's state,
+ * at most MaxDronePushes times a lap; and wind can't exceed MaxWindSpeed.
+ * The start state must be slower than MaxStartSpeed and either near the
+ * first gate (the first lap) or just past the last gate, where the previous
+ * lap ended.
+ *
+ * Claims may be slower than their replay (frames longer than
+ * MaxPhysicsStepsPerFrame steps drop simulated time), never faster.
+ *
+ * Courses are added up front; Verify is then const and safe to run on many
+ * laps at once, which VerifyBatch does across all cores.
+ */
+class DRONERACERFP_API FLapVerifier
+{
+public:
+    struct FConfig
+    {
+        /** FDroneReplay::ComputeFlightHash of the params and steps laps may be flown with, empty for any */
+        TArray<uint64> AllowedFlightHashes;
+
+        /** As ARaceGateManager::InstancedGateHalfOpening */
+        FVector2f GateHalfOpening = FVector2f(150.f, 150.f);
+
+        /** ARaceGate::GateTrigger of the race's gate class, relative to the gate; zero extent rejects laps scored by gate actors */
+        FTransform GateTriggerTransform;
+        FVector GateTriggerExtent = FVector::ZeroVector;
+
+        /** The drone capsule's radius (cm), which overlaps gate triggers; its half height is smaller, so it is a sphere */
+        float DroneRadius = 12.f;
+
+        /** Lap time and split slack (s) beyond one physics step; the race times gates at the end of the step that passed them */
+        float TimeTolerance = 0.001f;
+
+        /** cm/s */
+        float MaxWindSpeed = 3000.f;
+
+        /** Speed a lap may start at (cm/s) */
+        float MaxStartSpeed = 6000.f;
+
+        /** How far from the first gate the first lap may start (cm) */
+        float MaxStartDistance = 5000.f;
+
+        /** How far a drone push may move a drone from where the model put it (cm); the contact pass puts drones back along their whole frame */
+        float MaxDronePushDistance = 300.f;
+
+        /** How much a drone push may change the velocity (cm/s), the closing speed of two fast drones */
+        float MaxDronePushSpeed = 4000.f;
+
+        /** Steps a lap may have drone pushes on */
+        int32 MaxDronePushes = 30;
+    };
+
+    struct FRequest
+    {
+        FLapRecord Claim;
+
+        /** Full path of the replay file */
+        FString ReplayPath;
+    };
+
+    explicit FLapVerifier(const FConfig& InConfig);
+
+    /** Gates in course space, as stored in course files */
+    void AddCourse(uint64 CourseId, TArray<FTransform> Gates);
+
+    ELapVerifyResult Verify(const FRequest& Request) const;
+    ELapVerifyResult Verify(const FLapRecord& Claim, const FDroneReplay& Replay) const;
+
+    /** Verifies Requests in parallel, OutResults is indexed like Requests */
+    void VerifyBatch(TConstArrayView<FRequest> Requests, TArray<ELapVerifyResult>& OutResults) const;
+
+private:
+    /** The state the lap starts in, Gates (or their triggers) in the world */
+    bool IsPlausibleStart(const FDroneFlightState& State, TConstArrayView<FTransform> Gates, bool bTriggers, float StepSeconds) const;
+
+    bool SegmentPassesGate(const FTransform& Gate, bool bTriggers, const FVector& Start, const FVector& End) const;
+
+    FConfig Config;
+    TMap<uint64, TArray<FTransform>> Courses;
+};
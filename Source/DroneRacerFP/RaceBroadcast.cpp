@@ -0,0 +1,254 @@
+#include "RaceBroadcast.h"
+#include "DroneRacerFP.h"
+
+#include "Common/UdpSocketBuilder.h"
+#include "HAL/RunnableThread.h"
+#include "SocketSubsystem.h"
+#include "Sockets.h"
+
+namespace RaceBroadcast
+{
+    // Thread wakes up this often; the game thread never signals, so publishing stays syscall free
+    constexpr float PollSeconds = 0.002f;
+
+    // A keyframe of 64 racers is about 3 KB
+    constexpr int32 ReservedFrameBytes = 4096;
+
+    template <typename T>
+    void WriteRaw(TArray<uint8>& Out, T Value)
+    {
+        Out.Append(reinterpret_cast<const uint8*>(&Value), sizeof(T));
+    }
+
+    void WriteVarUint(TArray<uint8>& Out, uint64 Value)
+    {
+        while (Value >= 0x80)
+        {
+            Out.Add(uint8(Value) | 0x80);
+            Value >>= 7;
+        }
+        Out.Add(uint8(Value));
+    }
+
+    void WriteVarInt(TArray<uint8>& Out, int64 Value)
+    {
+        WriteVarUint(Out, (uint64(Value) << 1) ^ uint64(Value >> 63));
+    }
+
+    int32 ToMs(float Seconds)
+    {
+        return FMath::RoundToInt32(Seconds * 1000.f);
+    }
+
+    bool IsAngle(int32 Field)
+    {
+        return Field == FRaceBroadcaster::Field_Yaw || Field == FRaceBroadcaster::Field_Pitch || Field == FRaceBroadcaster::Field_Roll;
+    }
+}
+
+FRaceBroadcaster::FRaceBroadcaster(const FIPv4Endpoint& Destination)
+{
+    // TTL 0 and loopback: every local listener in the group gets the frames, nothing goes on the wire
+    Socket = FUdpSocketBuilder(TEXT("RaceBroadcast"))
+        .AsNonBlocking()
+        .AsReusable()
+        .WithMulticastInterface(FIPv4Address::InternalLoopback)
+        .WithMulticastLoopback()
+        .WithMulticastTtl(0)
+        .Build();
+
+    if (!Socket)
+    {
+        UE_LOG(LogTemp, Error, TEXT("RaceBroadcast: can't open a UDP socket"));
+        return;
+    }
+
+    Address = Destination.ToInternetAddr();
+    Frame.Reserve(RaceBroadcast::ReservedFrameBytes);
+
+    Thread = FRunnableThread::Create(this, TEXT("RaceBroadcast"), 0, TPri_BelowNormal);
+
+    UE_LOG(LogTemp, Log, TEXT("RaceBroadcast: sending to %s"), *Destination.ToString());
+}
+
+FRaceBroadcaster::~FRaceBroadcaster()
+{
+    if (Thread)
+    {
+        Thread->Kill(true);
+        delete Thread;
+        Thread = nullptr;
+    }
+
+    if (Socket)
+    {
+        Socket->Close();
+        ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+        Socket = nullptr;
+    }
+}
+
+uint32 FRaceBroadcaster::Run()
+{
+    while (!bStopping)
+    {
+        FPlatformProcess::SleepNoStats(RaceBroadcast::PollSeconds);
+
+        if (!Snapshots.IsDirty())
+            continue;
+
+        Snapshots.SwapReadBuffers();
+        EncodeFrame(Snapshots.Read());
+        SendFrame();
+    }
+    return 0;
+}
+
+void FRaceBroadcaster::Stop()
+{
+    bStopping = true;
+}
+
+bool FRaceBroadcaster::NeedsKeyframe(const FRaceBroadcastSnapshot& Snapshot) const
+{
+    // A world restart runs time backwards
+    if (!bHasKeyframe || Snapshot.WorldTime < KeyframeTime || Snapshot.WorldTime - KeyframeTime >= KeyframeSeconds)
+        return true;
+
+    if (Snapshot.NumRacers != Keyframe.Num())
+        return true;
+
+    for (int32 Index = 0; Index < Snapshot.NumRacers; ++Index)
+    {
+        const FRaceBroadcastRacer& Racer = Snapshot.Racers[Index];
+        if (Racer.RacerIndex != Keyframe[Index].RacerIndex || Racer.Pilot != KeyframePilots[Index])
+            return true;
+    }
+    return false;
+}
+
+void FRaceBroadcaster::EncodeFrame(const FRaceBroadcastSnapshot& Snapshot)
+{
+    using namespace RaceBroadcast;
+    DRONERACER_SCOPED_STAT(RaceBroadcast);
+
+    Quantized.SetNum(Snapshot.NumRacers, EAllowShrinking::No);
+    for (int32 Index = 0; Index < Snapshot.NumRacers; ++Index)
+    {
+        const FRaceBroadcastRacer& Racer = Snapshot.Racers[Index];
+        FQuantizedRacer& Q = Quantized[Index];
+        Q.RacerIndex = Racer.RacerIndex;
+        Q.Fields[Field_LocationX] = FMath::RoundToInt32(Racer.Location.X);
+        Q.Fields[Field_LocationY] = FMath::RoundToInt32(Racer.Location.Y);
+        Q.Fields[Field_LocationZ] = FMath::RoundToInt32(Racer.Location.Z);
+        Q.Fields[Field_Yaw] = FRotator::CompressAxisToShort(Racer.Rotation.Yaw);
+        Q.Fields[Field_Pitch] = FRotator::CompressAxisToShort(Racer.Rotation.Pitch);
+        Q.Fields[Field_Roll] = FRotator::CompressAxisToShort(Racer.Rotation.Roll);
+        Q.Fields[Field_Speed] = FMath::RoundToInt32(Racer.Speed);
+        Q.Fields[Field_Health] = FMath::RoundToInt32(FMath::Clamp(Racer.Health01, 0.f, 1.f) * 255.f);
+        Q.Fields[Field_Battery] = FMath::RoundToInt32(FMath::Clamp(Racer.Battery01, 0.f, 1.f) * 255.f);
+        Q.Fields[Field_GateIndex] = Racer.GateIndex;
+        Q.Fields[Field_Lap] = Racer.Lap;
+        Q.Fields[Field_LapTime] = ToMs(Racer.LapTime);
+        Q.Fields[Field_LastSplit] = Racer.LastSplit >= 0.f ? ToMs(Racer.LastSplit) : -1;
+        Q.Fields[Field_BestLap] = Racer.BestLapTime >= 0.f ? ToMs(Racer.BestLapTime) : -1;
+        Q.Fields[Field_DeltaToBest] = Racer.bHasDeltaToBest ? ToMs(Racer.DeltaToBest) : 0;
+        Q.Fields[Field_Flags] = (Racer.bArmed ? 1 : 0) | (Racer.bHasDeltaToBest ? 2 : 0);
+    }
+
+    const bool bKeyframe = NeedsKeyframe(Snapshot);
+    ++Sequence;
+    if (bKeyframe)
+    {
+        Keyframe = Quantized;
+        KeyframePilots.SetNum(Snapshot.NumRacers);
+        for (int32 Index = 0; Index < Snapshot.NumRacers; ++Index)
+        {
+            if (KeyframePilots[Index] != Snapshot.Racers[Index].Pilot)
+            {
+                KeyframePilots[Index] = Snapshot.Racers[Index].Pilot;
+            }
+        }
+        KeyframeTime = Snapshot.WorldTime;
+        KeyframeSequence = Sequence;
+        bHasKeyframe = true;
+    }
+
+    Frame.Reset();
+    WriteRaw(Frame, Magic);
+    WriteRaw(Frame, FormatVersion);
+    WriteRaw(Frame, uint8(bKeyframe ? 1 : 0));
+    WriteRaw(Frame, Sequence);
+    WriteRaw(Frame, KeyframeSequence);
+    WriteRaw(Frame, Snapshot.WorldTime);
+    WriteRaw(Frame, Snapshot.CourseId);
+    WriteRaw(Frame, uint16(FMath::Clamp(Snapshot.NumGates, 0, int32(MAX_uint16))));
+    WriteRaw(Frame, uint8(FMath::Clamp(Snapshot.NumLaps, 0, int32(MAX_uint8))));
+    WriteVarUint(Frame, Snapshot.NumRacers);
+
+    for (int32 Index = 0; Index < Snapshot.NumRacers; ++Index)
+    {
+        const FQuantizedRacer& Q = Quantized[Index];
+        const FQuantizedRacer& Base = Keyframe[Index];
+
+        uint16 Mask = 0;
+        for (int32 Field = 0; Field < Field_Count; ++Field)
+        {
+            if (bKeyframe || Q.Fields[Field] != Base.Fields[Field])
+            {
+                Mask |= uint16(1 << Field);
+            }
+        }
+
+        WriteVarUint(Frame, uint32(Q.RacerIndex));
+        WriteRaw(Frame, Mask);
+
+        if (bKeyframe)
+        {
+            const FTCHARToUTF8 Pilot(*KeyframePilots[Index]);
+            WriteVarUint(Frame, uint32(Pilot.Length()));
+            Frame.Append(reinterpret_cast<const uint8*>(Pilot.Get()), Pilot.Length());
+        }
+
+        for (int32 Field = 0; Field < Field_Count; ++Field)
+        {
+            if (!(Mask & (1 << Field)))
+                continue;
+
+            if (bKeyframe)
+            {
+                WriteVarInt(Frame, Q.Fields[Field]);
+            }
+            else if (IsAngle(Field))
+            {
+                WriteVarInt(Frame, int16(uint16(Q.Fields[Field] - Base.Fields[Field])));
+            }
+            else
+            {
+                WriteVarInt(Frame, int64(Q.Fields[Field]) - Base.Fields[Field]);
+            }
+        }
+    }
+}
+
+void FRaceBroadcaster::SendFrame()
+{
+    if (Frame.Num() > MaxFrameBytes)
+    {
+        // Too many racers for one datagram; the next frame tries a fresh keyframe
+        NumDropped.fetch_add(1, std::memory_order_relaxed);
+        bHasKeyframe = false;
+        return;
+    }
+
+    int32 BytesSent = 0;
+    if (Socket->SendTo(Frame.GetData(), Frame.Num(), BytesSent, *Address))
+    {
+        NumFramesSent.fetch_add(1, std::memory_order_relaxed);
+        NumBytesSent.fetch_add(BytesSent, std::memory_order_relaxed);
+    }
+    else
+    {
+        NumDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
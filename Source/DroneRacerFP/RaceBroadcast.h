@@ -0,0 +1,168 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/TripleBuffer.h"
+#include "HAL/Runnable.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include <atomic>
+
+class FRunnableThread;
+class FSocket;
+class FInternetAddr;
+
+/** One racer as sampled on the game thread, in game units */
+struct FRaceBroadcastRacer
+{
+    int32 RacerIndex = 0;
+    FString Pilot;
+
+    FVector Location = FVector::ZeroVector;
+    FRotator Rotation = FRotator::ZeroRotator;
+
+    /** cm/s */
+    float Speed = 0.f;
+
+    float Health01 = 0.f;
+    float Battery01 = 0.f;
+    bool bArmed = false;
+
+    /** As FRacerProgress; LastSplit and BestLapTime negative when there is none */
+    int32 GateIndex = 0;
+    int32 Lap = 1;
+    float LapTime = 0.f;
+    float LastSplit = -1.f;
+    float BestLapTime = -1.f;
+    float DeltaToBest = 0.f;
+    bool bHasDeltaToBest = false;
+};
+
+/** Everything one broadcast frame is encoded from */
+struct FRaceBroadcastSnapshot
+{
+    double WorldTime = 0.0;
+    uint64 CourseId = 0;
+    int32 NumGates = 0;
+    int32 NumLaps = 1;
+
+    /** Only the first NumRacers are valid; the rest keep their memory for later frames */
+    TArray<FRaceBroadcastRacer> Racers;
+    int32 NumRacers = 0;
+};
+
+/**
+ * Publishes the race to spectator and overlay tools on this machine as
+ * compact binary frames over UDP, without them joining the game.
+ *
+ * The game thread only copies each racer's pose and progress into a
+ * snapshot (URaceBroadcastSubsystem). A background thread picks up the
+ * latest snapshot, quantizes it, delta-encodes it and sends it, so the
+ * number of listeners never reaches the game thread. Frames go to a
+ * multicast group with TTL 0 and loopback on, so any number of local
+ * processes can join the group and nothing leaves the host. A unicast
+ * address works too, for a single listener.
+ *
+ * Frame layout (little endian; varints are LEB128, signed ones zigzag):
+ *   uint32 Magic 'DRBC', uint8 FormatVersion, uint8 Flags (1: keyframe)
+ *   uint32 Sequence, uint32 KeyframeSequence (the frame deltas are against)
+ *   double WorldTime, uint64 CourseId, uint16 NumGates, uint8 NumLaps
+ *   varint NumRacers, then per racer:
+ *     varint RacerIndex, uint16 mask of the fields that follow
+ *     keyframes only: varint byte length + UTF-8 pilot name
+ *     one signed varint per masked field (ERaceBroadcastField order)
+ *
+ * A keyframe holds every field as is. A delta frame holds only the fields
+ * that differ from the last keyframe, as the difference; angles wrap at
+ * 16 bits. Deltas are against the keyframe rather than the previous frame,
+ * so a lost datagram costs one frame, not everything up to the next
+ * keyframe. Keyframes are sent every KeyframeSeconds and whenever racers
+ * join, leave or change pilot; listeners ignore deltas until they have the
+ * keyframe they name.
+ */
+class DRONERACERFP_API FRaceBroadcaster : public FRunnable
+{
+public:
+    static constexpr uint32 Magic = 0x43425244;
+    static constexpr uint8 FormatVersion = 1;
+
+    static constexpr double KeyframeSeconds = 1.0;
+
+    /** Frames over this are dropped rather than fragmented */
+    static constexpr int32 MaxFrameBytes = 65000;
+
+    /** Fields of a racer, in the order they are written */
+    enum ERaceBroadcastField : uint8
+    {
+        Field_LocationX,    // cm
+        Field_LocationY,
+        Field_LocationZ,
+        Field_Yaw,          // 1/65536 turn, wraps
+        Field_Pitch,
+        Field_Roll,
+        Field_Speed,        // cm/s
+        Field_Health,       // 0..255
+        Field_Battery,      // 0..255
+        Field_GateIndex,
+        Field_Lap,
+        Field_LapTime,      // ms
+        Field_LastSplit,    // ms, -1 before the first gate
+        Field_BestLap,      // ms, -1 without a completed lap
+        Field_DeltaToBest,  // ms
+        Field_Flags,        // 1: armed, 2: has delta to best
+        Field_Count
+    };
+    static_assert(Field_Count <= 16, "Field masks are 16 bits");
+
+    /** Opens the socket and starts the thread; check IsRunning */
+    explicit FRaceBroadcaster(const FIPv4Endpoint& Destination);
+    virtual ~FRaceBroadcaster();
+
+    bool IsRunning() const { return Thread != nullptr; }
+
+    /** Game thread: fill the returned snapshot, then publish it */
+    FRaceBroadcastSnapshot& BeginSnapshot() { return Snapshots.GetWriteBuffer(); }
+    void PublishSnapshot() { Snapshots.SwapWriteBuffers(); }
+
+    uint64 GetNumFramesSent() const { return NumFramesSent.load(std::memory_order_relaxed); }
+    uint64 GetNumBytesSent() const { return NumBytesSent.load(std::memory_order_relaxed); }
+    uint64 GetNumDropped() const { return NumDropped.load(std::memory_order_relaxed); }
+
+    // FRunnable
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    struct FQuantizedRacer
+    {
+        int32 RacerIndex = 0;
+        int32 Fields[Field_Count] = {};
+    };
+
+    bool NeedsKeyframe(const FRaceBroadcastSnapshot& Snapshot) const;
+    void EncodeFrame(const FRaceBroadcastSnapshot& Snapshot);
+    void SendFrame();
+
+    TTripleBuffer<FRaceBroadcastSnapshot> Snapshots;
+
+    FSocket* Socket = nullptr;
+    TSharedPtr<FInternetAddr> Address;
+
+    FRunnableThread* Thread = nullptr;
+    std::atomic<bool> bStopping { false };
+    std::atomic<uint64> NumFramesSent { 0 };
+    std::atomic<uint64> NumBytesSent { 0 };
+    std::atomic<uint64> NumDropped { 0 };
+
+    // ===== Broadcast thread only =====
+
+    TArray<uint8> Frame;
+    TArray<FQuantizedRacer> Quantized;
+
+    /** The last keyframe, what delta frames are encoded against */
+    TArray<FQuantizedRacer> Keyframe;
+    TArray<FString> KeyframePilots;
+    double KeyframeTime = 0.0;
+    uint32 KeyframeSequence = 0;
+
+    uint32 Sequence = 0;
+    bool bHasKeyframe = false;
+};
@@ -0,0 +1,156 @@
+#include "RaceBroadcastSubsystem.h"
+#include "DroneFPCharacter.h"
+#include "DroneRacerFP.h"
+#include "RaceGateManager.h"
+
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<float> CVarBroadcastRate(
+    TEXT("DroneRacer.Broadcast.Rate"),
+    0.f,
+    TEXT("Race-state frames sent per second to local spectator and overlay tools (0: off)"));
+
+static TAutoConsoleVariable<FString> CVarBroadcastAddress(
+    TEXT("DroneRacer.Broadcast.Address"),
+    TEXT("239.255.42.99:9100"),
+    TEXT("Multicast group (any number of local listeners) or 127.0.0.1 address and port of the race-state stream; read when broadcasting starts"));
+
+static FAutoConsoleCommandWithWorld GBroadcastStatsCommand(
+    TEXT("DroneRacer.Broadcast.Stats"),
+    TEXT("Logs how many race-state frames and bytes were sent"),
+    FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+    {
+        const URaceBroadcastSubsystem* Subsystem = World ? World->GetSubsystem<URaceBroadcastSubsystem>() : nullptr;
+        if (const FRaceBroadcaster* Broadcaster = Subsystem ? Subsystem->GetBroadcaster() : nullptr)
+        {
+            const uint64 NumFrames = Broadcaster->GetNumFramesSent();
+            UE_LOG(LogTemp, Log, TEXT("RaceBroadcast: %llu frames, %llu bytes (%.0f per frame), %llu dropped"),
+                NumFrames, Broadcaster->GetNumBytesSent(), NumFrames > 0 ? double(Broadcaster->GetNumBytesSent()) / NumFrames : 0.0,
+                Broadcaster->GetNumDropped());
+        }
+    }));
+
+bool URaceBroadcastSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void URaceBroadcastSubsystem::Deinitialize()
+{
+    // Waits for the frame being sent
+    Broadcaster.Reset();
+
+    Super::Deinitialize();
+}
+
+bool URaceBroadcastSubsystem::StartBroadcaster()
+{
+    FIPv4Endpoint Destination;
+    const FString Address = CVarBroadcastAddress.GetValueOnGameThread();
+    if (!FIPv4Endpoint::Parse(Address, Destination))
+    {
+        UE_LOG(LogTemp, Error, TEXT("RaceBroadcast: bad address %s, expected a.b.c.d:port"), *Address);
+        return false;
+    }
+
+    Broadcaster = MakeUnique<FRaceBroadcaster>(Destination);
+    if (!Broadcaster->IsRunning())
+    {
+        Broadcaster.Reset();
+        return false;
+    }
+    return true;
+}
+
+void URaceBroadcastSubsystem::Tick(float DeltaTime)
+{
+    const float Rate = CVarBroadcastRate.GetValueOnGameThread();
+    if (Rate <= 0.f)
+        return;
+
+    // Tried once per world, so a bad address doesn't log every frame
+    if (!Broadcaster && (bStartFailed || !StartBroadcaster()))
+    {
+        bStartFailed = true;
+        return;
+    }
+
+    const float Interval = 1.f / Rate;
+    TimeSinceSample += DeltaTime;
+    if (TimeSinceSample < Interval)
+        return;
+
+    // Hitches skip samples instead of sending a burst
+    TimeSinceSample = FMath::Fmod(TimeSinceSample, Interval);
+    Sample();
+}
+
+void URaceBroadcastSubsystem::Sample()
+{
+    DRONERACER_SCOPED_STAT(RaceBroadcast);
+
+    if (!RaceGateManager.IsValid())
+    {
+        for (TActorIterator<ARaceGateManager> It(GetWorld()); It; ++It)
+        {
+            RaceGateManager = *It;
+            break;
+        }
+    }
+
+    const ARaceGateManager* Manager = RaceGateManager.Get();
+    if (!Manager)
+        return;
+
+    FRaceBroadcastSnapshot& Snapshot = Broadcaster->BeginSnapshot();
+    Snapshot.WorldTime = GetWorld()->GetTimeSeconds();
+    Snapshot.CourseId = Manager->GetCourseId();
+    Snapshot.NumGates = Manager->GetNumGates();
+    Snapshot.NumLaps = Manager->NumLaps;
+    Snapshot.NumRacers = 0;
+
+    for (int32 RacerIndex = 0; RacerIndex < Manager->GetNumRacerSlots(); ++RacerIndex)
+    {
+        const FRacerProgress* Progress = Manager->GetRacerProgress(RacerIndex);
+        const ADroneFPCharacter* Drone = Progress ? Progress->Drone.Get() : nullptr;
+        if (!Drone)
+            continue;
+
+        if (Snapshot.Racers.Num() <= Snapshot.NumRacers)
+        {
+            Snapshot.Racers.AddDefaulted();
+        }
+        FRaceBroadcastRacer& Racer = Snapshot.Racers[Snapshot.NumRacers++];
+
+        // Names rarely change; comparing first keeps the snapshot from reallocating them
+        Racer.RacerIndex = RacerIndex;
+        if (Racer.Pilot != Progress->Pilot)
+        {
+            Racer.Pilot = Progress->Pilot;
+        }
+
+        const FDroneTelemetrySnapshot& Telemetry = Drone->GetTelemetry();
+        Racer.Location = Drone->GetActorLocation();
+        Racer.Rotation = Drone->GetActorRotation();
+        Racer.Speed = Drone->GetVelocity().Size();
+        Racer.Health01 = Telemetry.MaxHealth > 0.f ? Telemetry.Health / Telemetry.MaxHealth : 0.f;
+        Racer.Battery01 = Telemetry.Battery01;
+        Racer.bArmed = Telemetry.bArmed;
+
+        Racer.GateIndex = Progress->GateIndex;
+        Racer.Lap = Progress->Lap;
+        Racer.LapTime = float(Snapshot.WorldTime - Progress->LapStartTime);
+        Racer.LastSplit = Progress->LastSplit;
+        Racer.BestLapTime = Progress->Reference ? Progress->Reference->GetLapTime() : -1.f;
+        Racer.DeltaToBest = Progress->DeltaToBest;
+        Racer.bHasDeltaToBest = Progress->bHasDeltaToBest;
+    }
+
+    Broadcaster->PublishSnapshot();
+}
+
+TStatId URaceBroadcastSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(URaceBroadcastSubsystem, STATGROUP_Tickables);
+}
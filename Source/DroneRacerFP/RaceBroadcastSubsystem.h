@@ -0,0 +1,45 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "RaceBroadcast.h"
+#include "RaceBroadcastSubsystem.generated.h"
+
+class ARaceGateManager;
+
+/**
+ * Samples the race for FRaceBroadcaster at DroneRacer.Broadcast.Rate: every
+ * registered racer's pose, speed, health and progress from ARaceGateManager
+ * and its drone. Sampling is a copy into a snapshot that keeps its memory,
+ * encoding and sending happen on the broadcaster's thread. The broadcaster
+ * is started the first time the rate is above 0.
+ */
+UCLASS()
+class DRONERACERFP_API URaceBroadcastSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    /** Null until broadcasting starts */
+    const FRaceBroadcaster* GetBroadcaster() const { return Broadcaster.Get(); }
+
+    // UWorldSubsystem
+    virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+    virtual void Deinitialize() override;
+
+    // UTickableWorldSubsystem
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+private:
+    bool StartBroadcaster();
+    void Sample();
+
+    TUniquePtr<FRaceBroadcaster> Broadcaster;
+    bool bStartFailed = false;
+
+    TWeakObjectPtr<ARaceGateManager> RaceGateManager;
+
+    /** Game time since the last sample */
+    float TimeSinceSample = 0.f;
+};
@@ -0,0 +1,274 @@
+#include "RaceCourse.h"
+
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#include "Hash/CityHash.h"
+#include "Misc/FileHelper.h"
+
+FRaceCourseFile::FRaceCourseFile() = default;
+
+FRaceCourseFile::~FRaceCourseFile()
+{
+    Close();
+}
+
+bool FRaceCourseFile::Open(const FString& Path)
+{
+    Close();
+
+    // Prefer mapping: no copy, pages come in as the gate table is walked
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    MappedHandle.Reset(PlatformFile.OpenMapped(*Path));
+    if (MappedHandle)
+    {
+        MappedRegion.Reset(MappedHandle->MapRegion(0, MappedHandle->GetFileSize()));
+    }
+
+    const uint8* Data = nullptr;
+    int64 Size = 0;
+    if (MappedRegion)
+    {
+        Data = MappedRegion->GetMappedPtr();
+        Size = MappedRegion->GetMappedSize();
+    }
+    else
+    {
+        MappedHandle.Reset();
+        if (!FFileHelper::LoadFileToArray(LoadedBytes, *Path))
+        {
+            UE_LOG(LogTemp, Error, TEXT("RaceCourse: could not open %s"), *Path);
+            return false;
+        }
+        Data = LoadedBytes.GetData();
+        Size = LoadedBytes.Num();
+    }
+
+    if (!Validate(Data, Size))
+    {
+        UE_LOG(LogTemp, Error, TEXT("RaceCourse: %s is not a valid course file"), *Path);
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+bool FRaceCourseFile::Open(const FRaceCourseInfo& InInfo, TArray<FRaceCourseGateRecord> InGates, TArray<FRaceCourseGateMotionRecord> InMotions)
+{
+    Close();
+
+    Serialize(InInfo, InGates, InMotions, LoadedBytes);
+    if (!Validate(LoadedBytes.GetData(), LoadedBytes.Num()))
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool FRaceCourseFile::Validate(const uint8* Data, int64 Size)
+{
+    if (!Data || Size < int64(sizeof(FRaceCourseFileHeader)))
+        return false;
+
+    const FRaceCourseFileHeader* FileHeader = reinterpret_cast<const FRaceCourseFileHeader*>(Data);
+    if (FileHeader->Magic != FRaceCourseFileHeader::ExpectedMagic ||
+        FileHeader->Version < 1 || FileHeader->Version > FRaceCourseFileHeader::CurrentVersion ||
+        FileHeader->HeaderSize != sizeof(FRaceCourseFileHeader))
+    {
+        return false;
+    }
+
+    const int64 TableEnd = int64(FileHeader->GateTableOffset) + int64(FileHeader->NumGates) * sizeof(FRaceCourseGateRecord);
+    if (FileHeader->GateTableOffset < sizeof(FRaceCourseFileHeader) ||
+        FileHeader->GateTableOffset % alignof(FRaceCourseGateRecord) != 0 ||
+        TableEnd > Size)
+    {
+        return false;
+    }
+
+    // Version 1 wrote 0 where the motion count is now
+    const int64 MotionsEnd = TableEnd + int64(FileHeader->NumMotions) * sizeof(FRaceCourseGateMotionRecord);
+    if (MotionsEnd > Size)
+        return false;
+
+    // Gates are walked in Order and motions matched to them in one pass, so both tables must be sorted
+    const TConstArrayView<FRaceCourseGateRecord> Gates =
+        MakeArrayView(reinterpret_cast<const FRaceCourseGateRecord*>(Data + FileHeader->GateTableOffset), int32(FileHeader->NumGates));
+    for (int32 Index = 1; Index < Gates.Num(); ++Index)
+    {
+        if (Gates[Index].Order < Gates[Index - 1].Order)
+            return false;
+    }
+
+    const TConstArrayView<FRaceCourseGateMotionRecord> Motions =
+        MakeArrayView(reinterpret_cast<const FRaceCourseGateMotionRecord*>(Data + TableEnd), int32(FileHeader->NumMotions));
+    if (Motions.Num() > 0 && Gates.Num() == 0)
+        return false;
+
+    for (int32 Index = 0; Index < Motions.Num(); ++Index)
+    {
+        const FRaceCourseGateMotionRecord& Motion = Motions[Index];
+        if (Motion.Type >= ERaceGateMotion::Count || Motion.Axis.ContainsNaN() || Motion.Axis.IsNearlyZero())
+            return false;
+
+        // One motion per gate, for a gate in the table
+        if ((Index > 0 && Motion.GateOrder <= Motions[Index - 1].GateOrder)
+            || Motion.GateOrder < Gates[0].Order || Motion.GateOrder > Gates.Last().Order)
+            return false;
+
+        // NaN or infinite curves would put the gate nowhere, and every pass test through it
+        if (!FMath::IsFinite(Motion.Amplitude) || !FMath::IsFinite(Motion.Frequency) || !FMath::IsFinite(Motion.Phase))
+            return false;
+    }
+
+    Header = FileHeader;
+    GateView = Gates;
+    MotionView = Motions;
+
+    Info.CourseId = FileHeader->CourseId;
+    Info.NumLaps = FMath::Max<int32>(FileHeader->NumLaps, 1);
+
+    ANSICHAR Name[UE_ARRAY_COUNT(FileHeader->Name) + 1] = {};
+    FMemory::Memcpy(Name, FileHeader->Name, sizeof(FileHeader->Name));
+    Info.Name = UTF8_TO_TCHAR(Name);
+
+    return true;
+}
+
+void FRaceCourseFile::Close()
+{
+    Header = nullptr;
+    GateView = TConstArrayView<FRaceCourseGateRecord>();
+    MotionView = TConstArrayView<FRaceCourseGateMotionRecord>();
+    Info = FRaceCourseInfo();
+
+    // Region before handle
+    MappedRegion.Reset();
+    MappedHandle.Reset();
+    LoadedBytes.Empty();
+}
+
+void FRaceCourseFile::Serialize(const FRaceCourseInfo& InInfo, TArray<FRaceCourseGateRecord>& InOutGates,
+    TArray<FRaceCourseGateMotionRecord>& InOutMotions, TArray64<uint8>& OutBytes)
+{
+    InOutGates.StableSort([](const FRaceCourseGateRecord& A, const FRaceCourseGateRecord& B) { return A.Order < B.Order; });
+    InOutMotions.StableSort([](const FRaceCourseGateMotionRecord& A, const FRaceCourseGateMotionRecord& B) { return A.GateOrder < B.GateOrder; });
+
+    FRaceCourseFileHeader FileHeader;
+    FileHeader.CourseId = InInfo.CourseId != 0 ? InInfo.CourseId : ComputeCourseId(InOutGates, InOutMotions);
+    FileHeader.NumGates = InOutGates.Num();
+    FileHeader.NumLaps = FMath::Max(InInfo.NumLaps, 1);
+    FileHeader.NumMotions = InOutMotions.Num();
+
+    const FTCHARToUTF8 NameUtf8(*InInfo.Name);
+    FMemory::Memcpy(FileHeader.Name, NameUtf8.Get(), FMath::Min<int32>(NameUtf8.Length(), sizeof(FileHeader.Name) - 1));
+
+    const int64 GateBytes = int64(InOutGates.Num()) * sizeof(FRaceCourseGateRecord);
+    const int64 MotionBytes = int64(InOutMotions.Num()) * sizeof(FRaceCourseGateMotionRecord);
+    OutBytes.SetNumUninitialized(sizeof(FileHeader) + GateBytes + MotionBytes);
+    FMemory::Memcpy(OutBytes.GetData(), &FileHeader, sizeof(FileHeader));
+    FMemory::Memcpy(OutBytes.GetData() + sizeof(FileHeader), InOutGates.GetData(), GateBytes);
+    FMemory::Memcpy(OutBytes.GetData() + sizeof(FileHeader) + GateBytes, InOutMotions.GetData(), MotionBytes);
+}
+
+bool FRaceCourseFile::Save(const FString& Path, const FRaceCourseInfo& InInfo, TArray<FRaceCourseGateRecord> Gates,
+    TArray<FRaceCourseGateMotionRecord> Motions)
+{
+    TArray64<uint8> Bytes;
+    Serialize(InInfo, Gates, Motions, Bytes);
+
+    if (!FFileHelper::SaveArrayToFile(Bytes, *Path))
+    {
+        UE_LOG(LogTemp, Error, TEXT("RaceCourse: could not write %s"), *Path);
+        return false;
+    }
+    return true;
+}
+
+uint64 FRaceCourseFile::ComputeCourseId(TConstArrayView<FRaceCourseGateRecord> Gates, TConstArrayView<FRaceCourseGateMotionRecord> Motions)
+{
+    const uint64 GatesId = CityHash64(reinterpret_cast<const char*>(Gates.GetData()), Gates.Num() * sizeof(FRaceCourseGateRecord));
+    if (Motions.Num() == 0)
+        return GatesId;
+
+    // Lap times on a moving course aren't comparable with the same layout standing still
+    return CityHash64WithSeed(reinterpret_cast<const char*>(Motions.GetData()), Motions.Num() * sizeof(FRaceCourseGateMotionRecord), GatesId);
+}
+
+bool RaceCourse::SegmentCrossesGate(const FTransform& GateTransform, const FVector2f& HalfOpening,
+    const FVector& Start, const FVector& End)
+{
+    return SegmentCrossesMovingGate(GateTransform, GateTransform, HalfOpening, Start, End);
+}
+
+bool RaceCourse::SegmentCrossesMovingGate(const FTransform& GateAtStart, const FTransform& GateAtEnd,
+    const FVector2f& HalfOpening, const FVector& Start, const FVector& End)
+{
+    // Local space keeps the test independent of gate orientation and motion; scale is applied to the opening
+    const FVector LocalStart = GateAtStart.InverseTransformPositionNoScale(Start);
+    const FVector LocalEnd = GateAtEnd.InverseTransformPositionNoScale(End);
+
+    // Must go from the back (-X) to the front (+X) of the gate plane
+    if (LocalStart.X > 0.f || LocalEnd.X <= 0.f)
+        return false;
+
+    const double T = LocalStart.X / (LocalStart.X - LocalEnd.X);
+    const FVector Hit = FMath::Lerp(LocalStart, LocalEnd, T);
+
+    const FVector Scale = GateAtEnd.GetScale3D();
+    return FMath::Abs(Hit.Y) <= HalfOpening.X * Scale.Y
+        && FMath::Abs(Hit.Z) <= HalfOpening.Y * Scale.Z;
+}
+
+bool RaceCourse::SegmentCrossesCourseGate(const FTransform& Base, const FRaceCourseGateMotionRecord* Motion,
+    const FVector2f& HalfOpening, const FVector& Start, const FVector& End, double StartTime, double EndTime)
+{
+    if (!Motion || Motion->Type == ERaceGateMotion::None)
+        return SegmentCrossesGate(Base, HalfOpening, Start, End);
+
+    // Where the gate was at either end of the step, not where it was last drawn
+    return SegmentCrossesMovingGate(
+        EvaluateGateMotion(*Motion, Base, StartTime),
+        EvaluateGateMotion(*Motion, Base, EndTime),
+        HalfOpening, Start, End);
+}
+
+bool RaceCourse::SegmentEntersGateTrigger(const FTransform& Trigger, const FVector& Extent, float Radius,
+    const FVector& Start, const FVector& End)
+{
+    const FVector Grown = Extent * Trigger.GetScale3D().GetAbs() + FVector(Radius);
+    const FBox Box(-Grown, Grown);
+    const FVector LocalStart = Trigger.InverseTransformPositionNoScale(Start);
+    const FVector LocalEnd = Trigger.InverseTransformPositionNoScale(End);
+
+    // An overlap begins once: a drone already inside entered on an earlier step
+    return !Box.IsInside(LocalStart) && FMath::LineBoxIntersection(Box, LocalStart, LocalEnd, LocalEnd - LocalStart);
+}
+
+FTransform RaceCourse::EvaluateGateMotion(const FRaceCourseGateMotionRecord& Motion, const FTransform& Base, double Time)
+{
+    const FVector Axis = FVector(Motion.Axis).GetSafeNormal(UE_SMALL_NUMBER, FVector::XAxisVector);
+    const double Wave = FMath::Sin(UE_DOUBLE_TWO_PI * (Motion.Frequency * Time + Motion.Phase));
+
+    FQuat LocalRotation = FQuat::Identity;
+    FVector LocalOffset = FVector::ZeroVector;
+    switch (Motion.Type)
+    {
+    case ERaceGateMotion::Rotate:
+        LocalRotation = FQuat(Axis, FMath::DegreesToRadians(Motion.Amplitude * Time + Motion.Phase * 360.0));
+        break;
+    case ERaceGateMotion::Swing:
+        LocalRotation = FQuat(Axis, FMath::DegreesToRadians(Motion.Amplitude * Wave));
+        break;
+    case ERaceGateMotion::Slide:
+        LocalOffset = Axis * (Motion.Amplitude * Wave);
+        break;
+    default:
+        return Base;
+    }
+
+    // About the gate's own pivot; slides are in cm whatever the gate's scale
+    const FQuat BaseRotation = Base.GetRotation();
+    return FTransform(BaseRotation * LocalRotation, Base.GetLocation() + BaseRotation.RotateVector(LocalOffset), Base.GetScale3D());
+}
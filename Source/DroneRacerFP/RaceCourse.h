@@ -0,0 +1,219 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+// ===== Course file format (.drcourse) =====
+//
+// [FRaceCourseFileHeader][FRaceCourseGateRecord x NumGates][FRaceCourseGateMotionRecord x NumMotions]
+//
+// Little-endian, fixed-size POD records so the gate table can be used
+// straight out of a memory-mapped file without parsing. Version 1 files
+// have no motion table.
+
+/** One gate, 48 bytes */
+struct FRaceCourseGateRecord
+{
+    FVector3f Location = FVector3f::ZeroVector;
+
+    /** Quaternion X, Y, Z, W (FQuat4f is 16-byte aligned, which would pad the record) */
+    float Rotation[4] = { 0.f, 0.f, 0.f, 1.f };
+
+    /** Actor scale; the gate opening scales with Y / Z */
+    FVector3f Scale = FVector3f::OneVector;
+
+    /** Position in the gate sequence */
+    int32 Order = 0;
+
+    uint32 Flags = 0;
+
+    FTransform ToTransform() const
+    {
+        return FTransform(FQuat(Rotation[0], Rotation[1], Rotation[2], Rotation[3]), FVector(Location), FVector(Scale));
+    }
+
+    static FRaceCourseGateRecord FromTransform(const FTransform& Transform, int32 InOrder)
+    {
+        FRaceCourseGateRecord Record;
+        Record.Location = FVector3f(Transform.GetLocation());
+        const FQuat Quat = Transform.GetRotation();
+        Record.Rotation[0] = float(Quat.X);
+        Record.Rotation[1] = float(Quat.Y);
+        Record.Rotation[2] = float(Quat.Z);
+        Record.Rotation[3] = float(Quat.W);
+        Record.Scale = FVector3f(Transform.GetScale3D());
+        Record.Order = InOrder;
+        return Record;
+    }
+};
+static_assert(sizeof(FRaceCourseGateRecord) == 48, "Course gate records are written as raw bytes");
+
+enum class ERaceGateMotion : uint8
+{
+    None,
+
+    /** Turns about Axis at Amplitude deg/s */
+    Rotate,
+
+    /** Swings about Axis, Amplitude deg either way */
+    Swing,
+
+    /** Slides along Axis, Amplitude cm either way */
+    Slide,
+
+    Count
+};
+
+/**
+ * Parametric motion of one gate about its placed transform, 32 bytes.
+ * Swing and Slide follow a sine of Frequency; Phase (turns) offsets gates
+ * that share a motion. Axis is in the gate's local space.
+ */
+struct FRaceCourseGateMotionRecord
+{
+    /** Order of the gate that moves */
+    int32 GateOrder = 0;
+
+    ERaceGateMotion Type = ERaceGateMotion::None;
+    uint8 Padding[3] = {};
+
+    FVector3f Axis = FVector3f::XAxisVector;
+    float Amplitude = 0.f;
+
+    /** Hz */
+    float Frequency = 0.f;
+    float Phase = 0.f;
+};
+static_assert(sizeof(FRaceCourseGateMotionRecord) == 32, "Course gate motion records are written as raw bytes");
+
+struct FRaceCourseFileHeader
+{
+    static constexpr uint32 ExpectedMagic = 0x53435244; // 'DRCS'
+    static constexpr uint16 CurrentVersion = 2;
+
+    uint32 Magic = ExpectedMagic;
+    uint16 Version = CurrentVersion;
+    uint16 HeaderSize = sizeof(FRaceCourseFileHeader);
+    uint64 CourseId = 0;
+    uint32 NumGates = 0;
+    uint32 NumLaps = 1;
+
+    /** Offset of the first gate record from the start of the file */
+    uint32 GateTableOffset = sizeof(FRaceCourseFileHeader);
+
+    /** Motion records right after the gate table, sorted by GateOrder (0 in version 1) */
+    uint32 NumMotions = 0;
+
+    /** UTF-8, zero padded */
+    ANSICHAR Name[64] = {};
+};
+static_assert(sizeof(FRaceCourseFileHeader) == 96, "Course header is written as raw bytes");
+
+/** Course metadata, kept separate from the gate table */
+struct FRaceCourseInfo
+{
+    /** Stable id used to key lap times; derived from the gate table when 0 */
+    uint64 CourseId = 0;
+    FString Name;
+    int32 NumLaps = 1;
+};
+
+/**
+ * Read-only view of a course file.
+ *
+ * The file is memory mapped when the platform allows it (loose files) and
+ * read into memory otherwise (pak files); either way Gates() points at the
+ * records in place, sorted by Order.
+ */
+class DRONERACERFP_API FRaceCourseFile
+{
+public:
+    FRaceCourseFile();
+    ~FRaceCourseFile();
+
+    FRaceCourseFile(const FRaceCourseFile&) = delete;
+    FRaceCourseFile& operator=(const FRaceCourseFile&) = delete;
+
+    /** Opens and validates a course file, returns false (and logs) on any error */
+    bool Open(const FString& Path);
+
+    /** Builds the course in memory, e.g. from FRaceCourseGenerator */
+    bool Open(const FRaceCourseInfo& InInfo, TArray<FRaceCourseGateRecord> InGates, TArray<FRaceCourseGateMotionRecord> InMotions = {});
+    void Close();
+
+    bool IsOpen() const { return Header != nullptr; }
+
+    const FRaceCourseInfo& GetInfo() const { return Info; }
+    TConstArrayView<FRaceCourseGateRecord> Gates() const { return GateView; }
+
+    /** Moving gates, sorted by GateOrder */
+    TConstArrayView<FRaceCourseGateMotionRecord> Motions() const { return MotionView; }
+
+    /** Writes a course; gates are sorted by Order and motions by GateOrder before writing */
+    static bool Save(const FString& Path, const FRaceCourseInfo& Info, TArray<FRaceCourseGateRecord> Gates,
+        TArray<FRaceCourseGateMotionRecord> Motions = {});
+
+    /** Id derived from the gate and motion tables; courses without moving gates keep their version 1 id */
+    static uint64 ComputeCourseId(TConstArrayView<FRaceCourseGateRecord> Gates, TConstArrayView<FRaceCourseGateMotionRecord> Motions = {});
+
+private:
+    /** Header, gate table and motion table exactly as written to disk */
+    static void Serialize(const FRaceCourseInfo& InInfo, TArray<FRaceCourseGateRecord>& InOutGates,
+        TArray<FRaceCourseGateMotionRecord>& InOutMotions, TArray64<uint8>& OutBytes);
+
+    bool Validate(const uint8* Data, int64 Size);
+
+    TUniquePtr<IMappedFileHandle> MappedHandle;
+    TUniquePtr<IMappedFileRegion> MappedRegion;
+
+    /** Fallback storage when the file can't be mapped */
+    TArray64<uint8> LoadedBytes;
+
+    const FRaceCourseFileHeader* Header = nullptr;
+    TConstArrayView<FRaceCourseGateRecord> GateView;
+    TConstArrayView<FRaceCourseGateMotionRecord> MotionView;
+    FRaceCourseInfo Info;
+};
+
+namespace RaceCourse
+{
+    /**
+     * True if the segment Start -> End crosses the gate plane (local X = 0)
+     * inside the opening. HalfOpening is the half size of the opening in the
+     * gate's local Y / Z at scale 1; the gate transform's scale applies.
+     */
+    DRONERACERFP_API bool SegmentCrossesGate(const FTransform& GateTransform, const FVector2f& HalfOpening,
+        const FVector& Start, const FVector& End);
+
+    /**
+     * SegmentCrossesGate for a gate that moved from GateAtStart to GateAtEnd
+     * while the drone flew Start -> End: the test runs in the gate's own
+     * moving frame, so a gate sliding or turning onto the drone counts too.
+     */
+    DRONERACERFP_API bool SegmentCrossesMovingGate(const FTransform& GateAtStart, const FTransform& GateAtEnd,
+        const FVector2f& HalfOpening, const FVector& Start, const FVector& End);
+
+    /**
+     * The race's gate test for a course gate placed at Base: moving with
+     * Motion (null or None for a gate that stands still) between StartTime
+     * and EndTime while the drone flies Start -> End.
+     */
+    DRONERACERFP_API bool SegmentCrossesCourseGate(const FTransform& Base, const FRaceCourseGateMotionRecord* Motion,
+        const FVector2f& HalfOpening, const FVector& Start, const FVector& End, double StartTime, double EndTime);
+
+    /**
+     * The gate actor test (ARaceGate::GateTrigger): true if a sphere of
+     * Radius moving Start -> End starts outside the box and enters it, the
+     * way the drone's swept capsule begins to overlap the trigger. The box
+     * is centred on Trigger with half size Extent at scale 1; the
+     * transform's scale applies. Edges and corners are grown square rather
+     * than rounded, like a box sweep.
+     */
+    DRONERACERFP_API bool SegmentEntersGateTrigger(const FTransform& Trigger, const FVector& Extent, float Radius,
+        const FVector& Start, const FVector& End);
+
+    /** Where a gate placed at Base is at Time (s) */
+    DRONERACERFP_API FTransform EvaluateGateMotion(const FRaceCourseGateMotionRecord& Motion, const FTransform& Base, double Time);
+}
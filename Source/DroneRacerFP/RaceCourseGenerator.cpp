@@ -0,0 +1,154 @@
+#include "RaceCourseGenerator.h"
+
+#include "Math/RandomStream.h"
+
+namespace RaceCourseGenerator
+{
+    // Spline evaluated at two gates per control segment
+    constexpr int32 GatesPerSegment = 2;
+
+    FVector CatmullRom(const FVector& P0, const FVector& P1, const FVector& P2, const FVector& P3, float T)
+    {
+        const float T2 = T * T;
+        const float T3 = T2 * T;
+        return 0.5f * ((2.f * P1) + (P2 - P0) * T + (2.f * P0 - 5.f * P1 + 4.f * P2 - P3) * T2 + (3.f * P1 - P0 - 3.f * P2 + P3) * T3);
+    }
+
+    FVector CatmullRomTangent(const FVector& P0, const FVector& P1, const FVector& P2, const FVector& P3, float T)
+    {
+        const float T2 = T * T;
+        return 0.5f * ((P2 - P0) + 2.f * (2.f * P0 - 5.f * P1 + 4.f * P2 - P3) * T + 3.f * (3.f * P1 - P0 - 3.f * P2 + P3) * T2);
+    }
+}
+
+void FRaceCourseGenerator::Generate(const FRaceCourseGeneratorSettings& Settings, TArray<FRaceCourseGateRecord>& OutGates)
+{
+    using namespace RaceCourseGenerator;
+
+    FRandomStream Random(Settings.Seed);
+
+    const int32 NumGates = FMath::Max(Settings.NumGates, 1);
+    const float MinAltitude = FMath::Min(Settings.MinAltitude, Settings.MaxAltitude);
+    const float MaxAltitude = FMath::Max(Settings.MinAltitude, Settings.MaxAltitude);
+
+    // ===== 1) Control points from a constrained random walk =====
+
+    const float ControlSpacing = Settings.GateSpacing * GatesPerSegment;
+
+    // Heading change over one control segment on a circle of MinTurnRadius
+    const float MaxTurn = FMath::Min(ControlSpacing / FMath::Max(Settings.MinTurnRadius, 1.f), UE_HALF_PI);
+    const float MaxPitch = FMath::DegreesToRadians(Settings.MaxClimbAngle);
+
+    // One extra point before the first gate and two after the last for the spline ends
+    const int32 NumSegments = FMath::DivideAndRoundUp(NumGates, GatesPerSegment);
+    const int32 NumControl = NumSegments + 3;
+
+    TArray<FVector> Control;
+    Control.SetNumUninitialized(NumControl);
+
+    FVector Position(0.f, 0.f, 0.5f * (MinAltitude + MaxAltitude));
+    float Yaw = 0.f;
+    float Pitch = 0.f;
+    float Turn = 0.f;
+
+    // Start one segment behind the origin so the first gate sits at it
+    Control[0] = Position - FVector(ControlSpacing, 0.f, 0.f);
+    for (int32 Index = 1; Index < NumControl; ++Index)
+    {
+        Control[Index] = Position;
+
+        // Smoothed turn rate: no instant direction flips, never tighter than MinTurnRadius
+        Turn = FMath::Clamp(FMath::Lerp(Turn, Random.FRandRange(-MaxTurn, MaxTurn), 0.5f), -MaxTurn, MaxTurn);
+        Yaw += Turn;
+
+        // Random climb, steered back toward the band before leaving it
+        float TargetPitch = Random.FRandRange(-MaxPitch, MaxPitch);
+        const float NextZ = Position.Z + FMath::Sin(TargetPitch) * ControlSpacing;
+        if (NextZ > MaxAltitude || NextZ < MinAltitude)
+        {
+            const float Center = 0.5f * (MinAltitude + MaxAltitude);
+            TargetPitch = FMath::Clamp(FMath::Asin(FMath::Clamp((Center - Position.Z) / ControlSpacing, -1.f, 1.f)), -MaxPitch, MaxPitch);
+        }
+        Pitch = FMath::Lerp(Pitch, TargetPitch, 0.5f);
+
+        const float CosPitch = FMath::Cos(Pitch);
+        Position += FVector(FMath::Cos(Yaw) * CosPitch, FMath::Sin(Yaw) * CosPitch, FMath::Sin(Pitch)) * ControlSpacing;
+        Position.Z = FMath::Clamp(Position.Z, MinAltitude, MaxAltitude);
+    }
+
+    // ===== 2) Gates along the spline =====
+
+    OutGates.Reset(NumGates);
+    for (int32 GateIndex = 0; GateIndex < NumGates; ++GateIndex)
+    {
+        const int32 Segment = 1 + GateIndex / GatesPerSegment;
+        const float T = float(GateIndex % GatesPerSegment) / GatesPerSegment;
+
+        const FVector& P0 = Control[Segment - 1];
+        const FVector& P1 = Control[Segment];
+        const FVector& P2 = Control[Segment + 1];
+        const FVector& P3 = Control[Segment + 2];
+
+        const FVector Location = CatmullRom(P0, P1, P2, P3, T);
+        const FVector Tangent = CatmullRomTangent(P0, P1, P2, P3, T).GetSafeNormal();
+
+        // Gates face along +X, so the drone flies through them along the tangent
+        const FQuat Rotation = FRotationMatrix::MakeFromX(Tangent).ToQuat();
+        const float Scale = Random.FRandRange(Settings.MinGateScale, FMath::Max(Settings.MinGateScale, Settings.MaxGateScale));
+
+        OutGates.Add(FRaceCourseGateRecord::FromTransform(FTransform(Rotation, Location, FVector(Scale)), GateIndex));
+    }
+}
+
+void FRaceCourseGenerator::GenerateMotions(const FRaceCourseGeneratorSettings& Settings, TConstArrayView<FRaceCourseGateRecord> Gates,
+    TArray<FRaceCourseGateMotionRecord>& OutMotions)
+{
+    OutMotions.Reset();
+    if (Settings.MovingGateFraction <= 0.f)
+        return;
+
+    FRandomStream Random(Settings.Seed ^ 0x6D6F7665);
+    const float MinHz = FMath::Min(Settings.MinGateMotionHz, Settings.MaxGateMotionHz);
+    const float MaxHz = FMath::Max(Settings.MinGateMotionHz, Settings.MaxGateMotionHz);
+
+    for (const FRaceCourseGateRecord& Gate : Gates)
+    {
+        if (Random.FRand() >= Settings.MovingGateFraction)
+            continue;
+
+        FRaceCourseGateMotionRecord& Motion = OutMotions.AddDefaulted_GetRef();
+        Motion.GateOrder = Gate.Order;
+        Motion.Frequency = Random.FRandRange(MinHz, MaxHz);
+        Motion.Phase = Random.FRand();
+
+        switch (Random.RandHelper(3))
+        {
+        case 0:
+            Motion.Type = ERaceGateMotion::Rotate;
+            Motion.Axis = FVector3f::XAxisVector;
+            Motion.Amplitude = Random.FRandRange(-Settings.MaxGateSpinDeg, Settings.MaxGateSpinDeg);
+            break;
+        case 1:
+            Motion.Type = ERaceGateMotion::Swing;
+            Motion.Axis = FVector3f::ZAxisVector;
+            Motion.Amplitude = Random.FRandRange(0.5f, 1.f) * Settings.MaxGateSwingDeg;
+            break;
+        default:
+            // Sideways or up and down, across the flight path
+            Motion.Type = ERaceGateMotion::Slide;
+            Motion.Axis = Random.FRand() < 0.5f ? FVector3f::YAxisVector : FVector3f::ZAxisVector;
+            Motion.Amplitude = Random.FRandRange(0.5f, 1.f) * Settings.MaxGateSlide;
+            break;
+        }
+    }
+}
+
+FRaceCourseInfo FRaceCourseGenerator::MakeInfo(const FRaceCourseGeneratorSettings& Settings, TConstArrayView<FRaceCourseGateRecord> Gates,
+    TConstArrayView<FRaceCourseGateMotionRecord> Motions)
+{
+    FRaceCourseInfo Info;
+    Info.CourseId = FRaceCourseFile::ComputeCourseId(Gates, Motions);
+    Info.Name = FString::Printf(TEXT("Generated_%d_%d"), Settings.Seed, Gates.Num());
+    Info.NumLaps = Settings.NumLaps;
+    return Info;
+}
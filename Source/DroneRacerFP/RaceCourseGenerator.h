@@ -0,0 +1,97 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RaceCourse.h"
+#include "RaceCourseGenerator.generated.h"
+
+/** Constraints for FRaceCourseGenerator. Distances in cm. */
+USTRUCT(BlueprintType)
+struct DRONERACERFP_API FRaceCourseGeneratorSettings
+{
+    GENERATED_BODY()
+
+    /** Same seed and settings always give the same course */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Course")
+    int32 Seed = 1;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Course", meta = (ClampMin = "1"))
+    int32 NumGates = 100;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Course", meta = (ClampMin = "1"))
+    int32 NumLaps = 1;
+
+    /** Distance between consecutive gates along the path */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Course", meta = (ClampMin = "100"))
+    float GateSpacing = 3000.f;
+
+    /** Tightest horizontal turn the path may make */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Course", meta = (ClampMin = "100"))
+    float MinTurnRadius = 4000.f;
+
+    /** Steepest climb / dive of the path (degrees) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Course", meta = (ClampMin = "0", ClampMax = "80"))
+    float MaxClimbAngle = 25.f;
+
+    /** Altitude band the path stays in, relative to the course origin */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Course")
+    float MinAltitude = 200.f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Course")
+    float MaxAltitude = 3000.f;
+
+    /** Uniform gate scale range */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Course", meta = (ClampMin = "0.1"))
+    float MinGateScale = 1.f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Course", meta = (ClampMin = "0.1"))
+    float MaxGateScale = 1.f;
+
+    /** Share of gates that rotate, swing or slide (see ERaceGateMotion) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Course|Motion", meta = (ClampMin = "0", ClampMax = "1"))
+    float MovingGateFraction = 0.f;
+
+    /** Fastest spin of a rotating gate about its flight axis (deg/s) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Course|Motion", meta = (ClampMin = "0"))
+    float MaxGateSpinDeg = 90.f;
+
+    /** Widest swing of a swinging gate (deg either way) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Course|Motion", meta = (ClampMin = "0", ClampMax = "60"))
+    float MaxGateSwingDeg = 30.f;
+
+    /** Furthest travel of a sliding gate (cm either way) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Course|Motion", meta = (ClampMin = "0"))
+    float MaxGateSlide = 400.f;
+
+    /** Swing / slide frequency range (Hz) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Course|Motion", meta = (ClampMin = "0"))
+    float MinGateMotionHz = 0.1f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Course|Motion", meta = (ClampMin = "0"))
+    float MaxGateMotionHz = 0.5f;
+};
+
+/**
+ * Deterministic procedural courses for benchmarks and stress tests.
+ *
+ * A constrained random walk lays down spline control points (turn rate
+ * bounded by MinTurnRadius, climb by MaxClimbAngle, steered back into the
+ * altitude band), and gates are placed along the Catmull-Rom spline through
+ * them, facing along its tangent. Pure math on preallocated arrays; 10k
+ * gates take a few milliseconds.
+ */
+struct DRONERACERFP_API FRaceCourseGenerator
+{
+    static void Generate(const FRaceCourseGeneratorSettings& Settings, TArray<FRaceCourseGateRecord>& OutGates);
+
+    /**
+     * Motions for MovingGateFraction of Gates, from their own random stream
+     * so the layout of a seed doesn't change with them. Rotating gates spin
+     * about the flight axis and swinging ones about the vertical, so the
+     * opening always stays passable.
+     */
+    static void GenerateMotions(const FRaceCourseGeneratorSettings& Settings, TConstArrayView<FRaceCourseGateRecord> Gates,
+        TArray<FRaceCourseGateMotionRecord>& OutMotions);
+
+    static FRaceCourseInfo MakeInfo(const FRaceCourseGeneratorSettings& Settings, TConstArrayView<FRaceCourseGateRecord> Gates,
+        TConstArrayView<FRaceCourseGateMotionRecord> Motions = {});
+};
@@ -1,5 +1,7 @@
 #include "RaceGate.h"
 #include "RaceGateManager.h"
+#include "DroneRacerFP.h"
+#include "DroneSignificanceSubsystem.h"
 #include "Components/StaticMeshComponent.h"
 #include "Components/BoxComponent.h"
 #include "EngineUtils.h"
@@ -25,6 +27,16 @@ void ARaceGate::BeginPlay()
 {
     Super::BeginPlay();
 
+    INC_DWORD_STAT(STAT_DroneRacer_NumGates);
+
+    if (DarkMaterial)
+        GateMesh->SetMaterial(0, DarkMaterial);
+
+    if (UDroneSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UDroneSignificanceSubsystem>())
+    {
+        SignificanceHandle = Significance->Register(this, EDroneSignificanceKind::Gate);
+    }
+
     // Find RaceGateManager in the level
     if (!RaceGateManager)
     {
@@ -36,20 +48,34 @@ void ARaceGate::BeginPlay()
     }
 }
 
-void ARaceGate::ActivateGate()
+void ARaceGate::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-    bIsActiveGate = true;
+    DEC_DWORD_STAT(STAT_DroneRacer_NumGates);
+
+    if (UDroneSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UDroneSignificanceSubsystem>())
+    {
+        Significance->Unregister(SignificanceHandle);
+        SignificanceHandle = INDEX_NONE;
+    }
 
-    if (GlowMaterial)
-        GateMesh->SetMaterial(0, GlowMaterial);
+    Super::EndPlay(EndPlayReason);
 }
 
-void ARaceGate::DeactivateGate()
+void ARaceGate::SetAnimationSuspended(bool bSuspended)
 {
-    bIsActiveGate = false;
+    if (bSuspended == bAnimationSuspended)
+        return;
+    bAnimationSuspended = bSuspended;
 
-    if (DarkMaterial)
-        GateMesh->SetMaterial(0, DarkMaterial);
+    for (UActorComponent* Component : GetComponents())
+    {
+        if (Component && Component != GateMesh && Component != GateTrigger && Component->PrimaryComponentTick.bCanEverTick)
+        {
+            Component->SetComponentTickEnabled(!bSuspended);
+        }
+    }
+
+    OnAnimationSuspended(bSuspended);
 }
 
 void ARaceGate::OnTriggerBeginOverlap(UPrimitiveComponent* OverlappedComponent,
@@ -59,12 +85,13 @@ void ARaceGate::OnTriggerBeginOverlap(UPrimitiveComponent* OverlappedComponent,
     bool bFromSweep,
     const FHitResult& SweepResult)
 {
-    if (!bIsActiveGate || !RaceGateManager)
+    if (!RaceGateManager)
         return;
 
+    // The manager checks whether this is the drone's next gate
     ADroneFPCharacter* Drone = Cast<ADroneFPCharacter>(OtherActor);
     if (Drone)
     {
-        RaceGateManager->GatePassed(this);
+        RaceGateManager->GatePassed(this, Drone);
     }
 }
@@ -8,7 +8,8 @@ class UStaticMeshComponent;
 class UBoxComponent;
 class ARaceGateManager;
 
-// A single race gate the drone must fly through in order.
+// A single race gate the drones must fly through in order.
+// Shown with DarkMaterial; each pilot's next gate is highlighted by their own drone.
 UCLASS()
 class DRONERACERFP_API ARaceGate : public AActor
 {
@@ -19,6 +20,7 @@ public:
 
 protected:
     virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
 
@@ -37,18 +39,30 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     UMaterialInterface* DarkMaterial;
 
-    // Whether this gate is currently active
-    bool bIsActiveGate = false;
+    // Position in the manager's gate sequence, set by the manager
+    int32 GateIndex = INDEX_NONE;
 
     // Reference to the manager
     UPROPERTY()
     ARaceGateManager* RaceGateManager;
 
-    // Activation / Deactivation
-    void ActivateGate();
-    void DeactivateGate();
+    // Stops the ticking components a BP child adds (rotators, timelines, effects) while no one is near.
+    // Called by UDroneSignificanceSubsystem; the mesh and trigger are never affected.
+    void SetAnimationSuspended(bool bSuspended);
+
+    bool IsAnimationSuspended() const { return bAnimationSuspended; }
+
+protected:
+    // Lets a BP child pause its own material or timeline animation
+    UFUNCTION(BlueprintImplementableEvent, Category = "Gate")
+    void OnAnimationSuspended(bool bSuspended);
 
 private:
+    bool bAnimationSuspended = false;
+
+    // Handle in UDroneSignificanceSubsystem
+    int32 SignificanceHandle = INDEX_NONE;
+
     UFUNCTION()
     void OnTriggerBeginOverlap(UPrimitiveComponent* OverlappedComponent,
         AActor* OtherActor,
@@ -1,52 +1,765 @@
 ﻿#include "RaceGateManager.h"
 #include "RaceGate.h"
+#include "DroneFPCharacter.h"
+#include "DroneRacerFP.h"
+#include "LapTimeSubsystem.h"
+
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Engine/GameInstance.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+
+// DroneRacer.GenerateCourse <Seed> <NumGates> [Instanced 0/1] [MovingGateFraction]
+static FAutoConsoleCommandWithWorldAndArgs GGenerateCourseCommand(
+    TEXT("DroneRacer.GenerateCourse"),
+    TEXT("Replaces the race course with a generated one: DroneRacer.GenerateCourse <Seed> <NumGates> [Instanced 0/1] [MovingGateFraction 0..1]"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+    {
+        FRaceCourseGeneratorSettings Settings;
+        if (Args.Num() > 0) LexFromString(Settings.Seed, *Args[0]);
+        if (Args.Num() > 1) LexFromString(Settings.NumGates, *Args[1]);
+        if (Args.Num() > 3) LexFromString(Settings.MovingGateFraction, *Args[3]);
+
+        for (TActorIterator<ARaceGateManager> It(World); It; ++It)
+        {
+            if (Args.Num() > 2) It->bInstanceGates = FCString::Atoi(*Args[2]) != 0;
+            It->GenerateCourse(Settings);
+            break;
+        }
+    }));
 
 ARaceGateManager::ARaceGateManager()
 {
-    PrimaryActorTick.bCanEverTick = false;
+    // Only ticks while a course is being created or has moving gates
+    PrimaryActorTick.bCanEverTick = true;
+    PrimaryActorTick.bStartWithTickEnabled = false;
+
+    RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+
+    GateInstances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("GateInstances"));
+    GateInstances->SetupAttachment(RootComponent);
 }
 
 void ARaceGateManager::BeginPlay()
 {
     Super::BeginPlay();
 
-    // Deactivate all gates
+    if (!CourseFile.IsEmpty())
+    {
+        LoadCourse(FPaths::Combine(FPaths::ProjectContentDir(), CourseFile));
+        return;
+    }
+
+    TArray<FRaceCourseGateRecord> Layout;
+    for (int32 Index = 0; Index < Gates.Num(); ++Index)
+    {
+        if (ARaceGate* Gate = Gates[Index])
+        {
+            Gate->GateIndex = Index;
+            Layout.Add(FRaceCourseGateRecord::FromTransform(Gate->GetActorTransform(), Index));
+        }
+    }
+    CourseId = FRaceCourseFile::ComputeCourseId(Layout);
+    PrepareWind();
+
+    // Racers registered before us start over on the final gate list
+    ResetProgress();
+}
+
+void ARaceGateManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    // The instances go with the component
+    DEC_DWORD_STAT_BY(STAT_DroneRacer_NumGates, InstancedGateTransforms.Num());
+    InstancedGateTransforms.Reset();
+
+    Super::EndPlay(EndPlayReason);
+}
+
+void ARaceGateManager::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    CreateCourseGates(SpawnBudgetMs / 1000.0);
+    AnimateGates();
+
+    if (!IsLoadingCourse() && MovingGates.Num() == 0)
+    {
+        SetActorTickEnabled(false);
+    }
+}
+
+void ARaceGateManager::ResetProgress()
+{
+    const double Now = GetWorld()->GetTimeSeconds();
+    for (FRacerProgress& Racer : Racers)
+    {
+        if (Racer.Drone.IsValid())
+        {
+            ResetRacer(Racer, Now);
+        }
+    }
+}
+
+// ===== Course files =====
+
+bool ARaceGateManager::LoadCourse(const FString& Path)
+{
+    ClearCourse();
+
+    if (!Course.Open(Path))
+        return false;
+
+    BeginCourse();
+    return true;
+}
+
+bool ARaceGateManager::GenerateCourse(const FRaceCourseGeneratorSettings& Settings)
+{
+    ClearCourse();
+
+    const double StartTime = FPlatformTime::Seconds();
+
+    TArray<FRaceCourseGateRecord> Records;
+    TArray<FRaceCourseGateMotionRecord> Motions;
+    FRaceCourseGenerator::Generate(Settings, Records);
+    FRaceCourseGenerator::GenerateMotions(Settings, Records, Motions);
+    const FRaceCourseInfo Info = FRaceCourseGenerator::MakeInfo(Settings, Records, Motions);
+
+    UE_LOG(LogTemp, Log, TEXT("RaceGateManager: generated %d gates (%d moving) in %.2f ms"),
+        Records.Num(), Motions.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+    if (!Course.Open(Info, MoveTemp(Records), MoveTemp(Motions)))
+        return false;
+
+    BeginCourse();
+    return true;
+}
+
+void ARaceGateManager::BeginCourse()
+{
+    const FRaceCourseInfo& Info = Course.GetInfo();
+    NumLaps = Info.NumLaps;
+    CourseId = Info.CourseId;
+
+    UE_LOG(LogTemp, Log, TEXT("RaceGateManager: loading course '%s' (%d gates)"), *Info.Name, Course.Gates().Num());
+
+    if (bInstanceGates)
+    {
+        InstancedGateTransforms.Reserve(Course.Gates().Num());
+        MovingGateSlots.Reserve(Course.Gates().Num());
+        MovingGates.Reserve(Course.Motions().Num());
+    }
+    else
+    {
+        Gates.Reserve(Course.Gates().Num());
+
+        if (Course.Motions().Num() > 0)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("RaceGateManager: gate motions need bInstanceGates, %d gates stand still"), Course.Motions().Num());
+        }
+    }
+
+    ResetProgress();
+
+    // First slice right away so the first gates exist before the next frame
+    CreateCourseGates(SpawnBudgetMs / 1000.0);
+    SetActorTickEnabled(IsLoadingCourse() || MovingGates.Num() > 0);
+}
+
+void ARaceGateManager::ClearCourse()
+{
     for (ARaceGate* Gate : Gates)
     {
         if (Gate)
-            Gate->DeactivateGate();
+            Gate->Destroy();
     }
+    Gates.Reset();
+
+    // Gate actors count themselves; instances are counted here
+    DEC_DWORD_STAT_BY(STAT_DroneRacer_NumGates, InstancedGateTransforms.Num());
+    GateInstances->ClearInstances();
+    InstancedGateTransforms.Reset();
+    MovingGates.Reset();
+    MovingGateSlots.Reset();
+    MovingGateRuns.Reset();
+    NextMotionToMatch = 0;
 
-    // Start with the first gate
-    CurrentIndex = 0;
+    Course.Close();
+    NextGateToCreate = 0;
+    CourseId = 0;
 
-    if (Gates.IsValidIndex(CurrentIndex))
-        Gates[CurrentIndex]->ActivateGate();
+    // Reference laps only make sense on the course they were flown on
+    BestReferenceLaps.Reset();
+    for (FRacerProgress& Racer : Racers)
+    {
+        Racer.Reference.Reset();
+        Racer.bHasDeltaToBest = false;
+    }
 }
 
-void ARaceGateManager::GatePassed(ARaceGate* PassedGate)
+void ARaceGateManager::CreateCourseGates(double BudgetSeconds)
 {
-    if (!PassedGate)
+    if (!IsLoadingCourse())
         return;
 
-    int32 PassedIndex = Gates.IndexOfByKey(PassedGate);
+    const TConstArrayView<FRaceCourseGateRecord> Records = Course.Gates();
+    const double Deadline = FPlatformTime::Seconds() + BudgetSeconds;
+    const int32 FirstCreated = NextGateToCreate;
+
+    if (bInstanceGates)
+    {
+        // Instances are cheap; add them in chunks and check the clock per chunk
+        constexpr int32 ChunkSize = 256;
+        TArray<FTransform> Chunk;
+        Chunk.Reserve(ChunkSize);
 
-    // Wrong gate
-    if (PassedIndex != CurrentIndex)
+        const FTransform& ManagerTransform = GetActorTransform();
+        const TConstArrayView<FRaceCourseGateMotionRecord> Motions = Course.Motions();
+        do
+        {
+            const int32 End = FMath::Min(NextGateToCreate + ChunkSize, Records.Num());
+            Chunk.Reset();
+            for (int32 Index = NextGateToCreate; Index < End; ++Index)
+            {
+                const FTransform GateTransform = Records[Index].ToTransform() * ManagerTransform;
+                Chunk.Add(GateTransform);
+                InstancedGateTransforms.Add(GateTransform);
+
+                // Both tables are sorted by gate order
+                while (Motions.IsValidIndex(NextMotionToMatch) && Motions[NextMotionToMatch].GateOrder < Records[Index].Order)
+                {
+                    ++NextMotionToMatch;
+                }
+
+                if (!Motions.IsValidIndex(NextMotionToMatch) || Motions[NextMotionToMatch].GateOrder != Records[Index].Order)
+                {
+                    MovingGateSlots.Add(INDEX_NONE);
+                    continue;
+                }
+
+                MovingGateSlots.Add(MovingGates.Num());
+                FMovingGate& Moving = MovingGates.AddDefaulted_GetRef();
+                Moving.GateIndex = Index;
+                Moving.Base = GateTransform;
+                Moving.Motion = Motions[NextMotionToMatch++];
+
+                if (MovingGateRuns.Num() > 0 && MovingGateRuns.Last().FirstGate + MovingGateRuns.Last().NumGates == Index)
+                {
+                    ++MovingGateRuns.Last().NumGates;
+                }
+                else
+                {
+                    MovingGateRuns.Add({ Index, 1 });
+                }
+            }
+            GateInstances->AddInstances(Chunk, /*bShouldReturnIndices*/ false, /*bWorldSpace*/ true);
+            INC_DWORD_STAT_BY(STAT_DroneRacer_NumGates, Chunk.Num());
+            NextGateToCreate = End;
+        }
+        while (IsLoadingCourse() && FPlatformTime::Seconds() < Deadline);
+    }
+    else if (GateClass)
+    {
+        UWorld* World = GetWorld();
+        do
+        {
+            const FTransform GateTransform = Records[NextGateToCreate].ToTransform() * GetActorTransform();
+
+            // Deferred so the manager is set before BeginPlay, which would otherwise search the level
+            ARaceGate* Gate = World->SpawnActorDeferred<ARaceGate>(GateClass, GateTransform, this);
+            if (Gate)
+            {
+                Gate->RaceGateManager = this;
+                Gate->GateIndex = Gates.Num();
+                Gate->FinishSpawning(GateTransform);
+            }
+            Gates.Add(Gate);
+            ++NextGateToCreate;
+        }
+        while (IsLoadingCourse() && FPlatformTime::Seconds() < Deadline);
+    }
+    else
+    {
+        UE_LOG(LogTemp, Error, TEXT("RaceGateManager: no GateClass set, can't spawn course gates"));
+        ClearCourse();
         return;
+    }
 
-    // Correct gate → deactivate it
-    PassedGate->DeactivateGate();
+    // A racer's next gate may only just have been created
+    for (const FRacerProgress& Racer : Racers)
+    {
+        if (Racer.Drone.IsValid() && Racer.GateIndex >= FirstCreated && Racer.GateIndex < NextGateToCreate)
+        {
+            UpdateHighlight(Racer);
+        }
+    }
 
-    // Move to next gate
-    CurrentIndex++;
+    if (!IsLoadingCourse())
+    {
+        UE_LOG(LogTemp, Log, TEXT("RaceGateManager: course ready (%d gates)"), NextGateToCreate);
+        PrepareWind();
+    }
+}
+
+void ARaceGateManager::PrepareWind()
+{
+    UDroneWindSubsystem* WindSubsystem = GetWorld()->GetSubsystem<UDroneWindSubsystem>();
+    if (!WindSubsystem)
+        return;
+
+    FBox Bounds(ForceInit);
+    for (int32 Index = 0; Index < GetNumGates(); ++Index)
+    {
+        FTransform GateTransform;
+        if (GetGateTransform(Index, GateTransform))
+        {
+            Bounds += GateTransform.GetLocation();
+        }
+    }
+
+    WindSubsystem->PrepareCourse(CourseId, Bounds, Wind);
+}
+
+bool ARaceGateManager::SaveCourse(const FString& Path, const FString& CourseName) const
+{
+    TArray<FRaceCourseGateRecord> Records;
+    Records.Reserve(GetNumGates());
 
-    if (Gates.IsValidIndex(CurrentIndex))
+    // Stored relative to the manager so a course can be moved with it
+    const FTransform& ManagerTransform = GetActorTransform();
+    TArray<FRaceCourseGateMotionRecord> Motions;
+    for (int32 Index = 0; Index < GetNumGates(); ++Index)
     {
-        Gates[CurrentIndex]->ActivateGate();
+        FTransform GateTransform;
+        if (GetGateTransform(Index, GateTransform))
+        {
+            // Moving gates are saved where they were placed, not where they are now
+            if (MovingGateSlots.IsValidIndex(Index) && MovingGateSlots[Index] != INDEX_NONE)
+            {
+                const FMovingGate& Moving = MovingGates[MovingGateSlots[Index]];
+                GateTransform = Moving.Base;
+                Motions.Add(Moving.Motion);
+                Motions.Last().GateOrder = Index;
+            }
+
+            Records.Add(FRaceCourseGateRecord::FromTransform(GateTransform.GetRelativeTransform(ManagerTransform), Index));
+        }
+    }
+
+    FRaceCourseInfo Info;
+    Info.Name = CourseName;
+    Info.NumLaps = NumLaps;
+    return FRaceCourseFile::Save(Path, Info, MoveTemp(Records), MoveTemp(Motions));
+}
+
+// ===== Moving gates =====
+
+void ARaceGateManager::AnimateGates()
+{
+    if (MovingGates.Num() == 0)
+        return;
+
+    DRONERACER_SCOPED_STAT(GateMotion);
+
+    // Each task evaluates a slice of the curves; slices write disjoint transforms
+    constexpr int32 GatesPerTask = 128;
+    const double Time = GetWorld()->GetTimeSeconds();
+    const int32 NumTasks = FMath::DivideAndRoundUp(MovingGates.Num(), GatesPerTask);
+    ParallelFor(NumTasks, [this, Time](int32 Task)
+    {
+        const int32 First = Task * GatesPerTask;
+        const int32 Last = FMath::Min(First + GatesPerTask, MovingGates.Num());
+        for (int32 Slot = First; Slot < Last; ++Slot)
+        {
+            const FMovingGate& Moving = MovingGates[Slot];
+            InstancedGateTransforms[Moving.GateIndex] = RaceCourse::EvaluateGateMotion(Moving.Motion, Moving.Base, Time);
+        }
+    });
+
+    // Instances standing still are never touched; the render state is rebuilt once for all runs
+    for (const FMovingGateRun& Run : MovingGateRuns)
+    {
+        MovingGateBatch.Reset();
+        MovingGateBatch.Append(&InstancedGateTransforms[Run.FirstGate], Run.NumGates);
+        GateInstances->BatchUpdateInstancesTransforms(Run.FirstGate, MovingGateBatch, /*bWorldSpace*/ true, /*bMarkRenderStateDirty*/ false, /*bTeleport*/ true);
+    }
+    GateInstances->MarkRenderStateDirty();
+
+    // Highlights follow the gate they sit on
+    for (const FRacerProgress& Racer : Racers)
+    {
+        if (MovingGateSlots.IsValidIndex(Racer.GateIndex) && MovingGateSlots[Racer.GateIndex] != INDEX_NONE)
+        {
+            UpdateHighlight(Racer);
+        }
+    }
+}
+
+// ===== Race progress =====
+
+int32 ARaceGateManager::RegisterRacer(ADroneFPCharacter* Drone)
+{
+    if (!Drone)
+        return INDEX_NONE;
+
+    int32 RacerIndex = Racers.IndexOfByPredicate([](const FRacerProgress& Racer) { return !Racer.Drone.IsValid(); });
+    if (RacerIndex == INDEX_NONE)
+    {
+        RacerIndex = Racers.AddDefaulted();
+    }
+
+    FRacerProgress& Racer = Racers[RacerIndex];
+    Racer.Drone = Drone;
+
+    const APlayerState* PlayerState = Drone->GetPlayerState();
+    Racer.Pilot = PlayerState ? PlayerState->GetPlayerName() : Drone->GetName();
+
+    ResetRacer(Racer, GetWorld()->GetTimeSeconds());
+    return RacerIndex;
+}
+
+void ARaceGateManager::UnregisterRacer(int32 RacerIndex)
+{
+    if (Racers.IsValidIndex(RacerIndex))
+    {
+        Racers[RacerIndex] = FRacerProgress();
+    }
+}
+
+const FRacerProgress* ARaceGateManager::GetRacerProgress(int32 RacerIndex) const
+{
+    return Racers.IsValidIndex(RacerIndex) && Racers[RacerIndex].Drone.IsValid() ? &Racers[RacerIndex] : nullptr;
+}
+
+void ARaceGateManager::RestoreRacerProgress(int32 RacerIndex, int32 GateIndex, int32 Lap, float LapTime, float TimeSinceLastGate, float LastSplit)
+{
+    if (!GetRacerProgress(RacerIndex))
+        return;
+
+    FRacerProgress& Racer = Racers[RacerIndex];
+    const double Now = GetWorld()->GetTimeSeconds();
+
+    // Rewinding within the lap keeps the recording up to that point; across laps it is lost
+    if (FMath::Clamp(Lap, 1, NumLaps) == Racer.Lap)
+    {
+        Racer.Recording.TruncateTo(LapTime, GateIndex);
     }
     else
     {
-        UE_LOG(LogTemp, Warning, TEXT("RACE COMPLETE!"));
+        Racer.Recording.Cancel();
+    }
+    Racer.ReferenceCursor.Reset();
+    Racer.bHasDeltaToBest = false;
+    Racer.LapDeltaShownUntil = 0.0;
+    Racer.bPracticeLap = true;
+
+    const int32 NumPassed = FMath::Clamp(GateIndex, 0, Racer.PassedGates.Num());
+
+    Racer.GateIndex = FMath::Clamp(GateIndex, 0, GetNumGates());
+    Racer.Lap = FMath::Clamp(Lap, 1, NumLaps);
+    Racer.LapStartTime = Now - LapTime;
+    Racer.LastGatePassTime = Now - TimeSinceLastGate;
+    Racer.LastSplit = LastSplit;
+    Racer.PassedGates.SetRange(0, NumPassed, true);
+    Racer.PassedGates.SetRange(NumPassed, Racer.PassedGates.Num() - NumPassed, false);
+
+    UpdateHighlight(Racer);
+}
+
+void ARaceGateManager::ResetRacer(FRacerProgress& Racer, double Now) const
+{
+    const int32 NumGates = GetNumGates();
+
+    // From the step the drone's state is at, where its lap replay starts, so lap times are whole steps
+    ADroneFPCharacter* Drone = Racer.Drone.Get();
+    const double StartTime = Drone ? Drone->GetStateTime() : Now;
+
+    Racer.GateIndex = 0;
+    Racer.Lap = 1;
+    Racer.LapStartTime = StartTime;
+    Racer.LastGatePassTime = StartTime;
+    Racer.LastSplit = -1.f;
+    Racer.PassedGates.Init(false, NumGates);
+    Racer.Splits.SetNumZeroed(NumGates);
+
+    const TSharedPtr<const FRaceReferenceLap>* Best = BestReferenceLaps.Find(Racer.Pilot);
+    Racer.Reference = Best ? *Best : TSharedPtr<const FRaceReferenceLap>();
+    Racer.Recording.Begin(NumGates);
+    Racer.ReferenceCursor.Reset();
+    Racer.bHasDeltaToBest = false;
+    Racer.LapDeltaShownUntil = 0.0;
+    Racer.bPracticeLap = false;
+
+    if (Drone)
+    {
+        // Loaded courses with bInstanceGates are scored by DroneMoved, the rest by gate actor triggers
+        const bool bInstanced = bInstanceGates && Course.IsOpen();
+        Drone->BeginLapReplay(CourseId, GetActorTransform(), bInstanced ? FDroneReplayHeader::Opening : FDroneReplayHeader::Trigger);
+    }
+
+    UpdateHighlight(Racer);
+}
+
+void ARaceGateManager::GatePassed(ARaceGate* PassedGate, ADroneFPCharacter* Drone)
+{
+    // Drones moved by the network race on the machine that flies them
+    if (!PassedGate || !Drone || Drone->IsNetDriven())
+        return;
+
+    // Overlaps begin during the sweep of the drone's step
+    OnGatePassed(Drone->GetRacerIndex(), PassedGate->GateIndex, Drone->GetStateTime());
+}
+
+void ARaceGateManager::DroneMoved(ADroneFPCharacter* Drone, const FVector& Start, const FVector& End, double StartTime, double EndTime)
+{
+    const int32 RacerIndex = Drone->GetRacerIndex();
+    if (!Racers.IsValidIndex(RacerIndex))
+        return;
+
+    // Gate actors report passes through their triggers
+    const int32 GateIndex = Racers[RacerIndex].GateIndex;
+    if (InstancedGateTransforms.IsValidIndex(GateIndex) && SegmentCrossesInstancedGate(GateIndex, Start, End, StartTime, EndTime))
+    {
+        OnGatePassed(RacerIndex, GateIndex, EndTime);
+    }
+
+    // After the pass, so the point is recorded toward the gate the racer now flies to
+    UpdateDeltaToBest(Racers[RacerIndex], End, EndTime);
+}
+
+bool ARaceGateManager::SegmentCrossesInstancedGate(int32 GateIndex, const FVector& Start, const FVector& End, double StartTime, double EndTime) const
+{
+    const int32 Slot = MovingGateSlots.IsValidIndex(GateIndex) ? MovingGateSlots[GateIndex] : INDEX_NONE;
+    if (Slot == INDEX_NONE)
+        return RaceCourse::SegmentCrossesGate(InstancedGateTransforms[GateIndex], FVector2f(InstancedGateHalfOpening), Start, End);
+
+    // Not InstancedGateTransforms, which only holds where this frame's animation left the gate
+    const FMovingGate& Moving = MovingGates[Slot];
+    return RaceCourse::SegmentCrossesCourseGate(Moving.Base, &Moving.Motion, FVector2f(InstancedGateHalfOpening), Start, End, StartTime, EndTime);
+}
+
+void ARaceGateManager::UpdateDeltaToBest(FRacerProgress& Racer, const FVector& Location, double Time)
+{
+    DRONERACER_SCOPED_STAT(DeltaToBest);
+
+    // Finished
+    if (Racer.GateIndex >= GetNumGates())
+        return;
+
+    const float LapTime = float(Time - Racer.LapStartTime);
+    Racer.Recording.Record(Location, LapTime, Racer.GateIndex);
+
+    // The completed lap's delta is still on screen
+    if (Time < Racer.LapDeltaShownUntil)
+        return;
+
+    // The gate order picks the part of the reference to search, where the line crosses itself
+    float ReferenceTime = 0.f;
+    if (Racer.Reference && Racer.Reference->Project(Location, Racer.GateIndex, Racer.ReferenceCursor, ReferenceTime))
+    {
+        Racer.DeltaToBest = LapTime - ReferenceTime;
+        Racer.bHasDeltaToBest = true;
+    }
+}
+
+void ARaceGateManager::OnGatePassed(int32 RacerIndex, int32 PassedIndex, double Time)
+{
+    DRONERACER_SCOPED_STAT(GatePassed);
+
+    if (!Racers.IsValidIndex(RacerIndex))
+        return;
+
+    FRacerProgress& Racer = Racers[RacerIndex];
+
+    // Wrong gate for this racer
+    if (PassedIndex != Racer.GateIndex)
+        return;
+
+    DRONERACER_COUNT_EVENT(GatePasses);
+
+    const int32 NumGates = GetNumGates();
+    Racer.LastSplit = float(Time - Racer.LastGatePassTime);
+    Racer.LastGatePassTime = Time;
+    if (Racer.PassedGates.IsValidIndex(PassedIndex))
+    {
+        Racer.PassedGates[PassedIndex] = true;
+        Racer.Splits[PassedIndex] = Racer.LastSplit;
+    }
+
+    // Move to next gate
+    Racer.GateIndex++;
+
+    if (Racer.GateIndex >= NumGates)
+    {
+        LapCompleted(Racer, float(Time - Racer.LapStartTime));
+
+        // Wrap around to the first gate while laps remain
+        if (Racer.Lap < NumLaps)
+        {
+            Racer.GateIndex = 0;
+            Racer.Lap++;
+            Racer.LapStartTime = Time;
+            Racer.PassedGates.SetRange(0, Racer.PassedGates.Num(), false);
+            Racer.Recording.Begin(NumGates);
+            Racer.ReferenceCursor.Reset();
+            Racer.bPracticeLap = false;
+        }
+        else
+        {
+            UE_LOG(LogTemp, Warning, TEXT("RACE COMPLETE! (%s)"), *Racer.Pilot);
+        }
+    }
+
+    UpdateHighlight(Racer);
+}
+
+void ARaceGateManager::LapCompleted(FRacerProgress& Racer, float LapTime)
+{
+    // Drones may be possessed after they registered
+    ADroneFPCharacter* Drone = Racer.Drone.Get();
+    if (Drone && Drone->GetPlayerState())
+    {
+        Racer.Pilot = Drone->GetPlayerState()->GetPlayerName();
+    }
+
+    // Ends the replay even without a lap store, the drone starts the next one
+    const FString ReplayRef = Drone ? Drone->EndLapReplay(Racer.Lap < NumLaps) : FString();
+
+    UE_LOG(LogTemp, Warning, TEXT("%s: lap %d complete: %.3f s%s"), *Racer.Pilot, Racer.Lap, LapTime,
+        Racer.bPracticeLap ? TEXT(" (practice, rewound)") : TEXT(""));
+
+    // The delta shown over the line is the whole lap against the previous best
+    TSharedPtr<const FRaceReferenceLap>& Best = BestReferenceLaps.FindOrAdd(Racer.Pilot);
+    if (Best)
+    {
+        Racer.DeltaToBest = LapTime - Best->GetLapTime();
+        Racer.bHasDeltaToBest = true;
+        Racer.LapDeltaShownUntil = Racer.LastGatePassTime + LapDeltaHoldSeconds;
+    }
+
+    // A rewound lap is missing the time that was rewound away
+    if (Racer.bPracticeLap)
+        return;
+
+    if (Drone && Racer.Recording.Finish(Drone->GetActorLocation(), LapTime) && (!Best || LapTime < Best->GetLapTime()))
+    {
+        Best = MakeShared<FRaceReferenceLap>(MoveTemp(Racer.Recording));
+    }
+    Racer.Reference = Best;
+
+    ULapTimeSubsystem* LapTimes = GetGameInstance() ? GetGameInstance()->GetSubsystem<ULapTimeSubsystem>() : nullptr;
+    if (LapTimes)
+    {
+        FLapRecord Record;
+        Record.CourseId = CourseId;
+        Record.Pilot = Racer.Pilot;
+        Record.LapTime = LapTime;
+        Record.Splits = Racer.Splits;
+        Record.ReplayRef = ReplayRef;
+        Record.Timestamp = FDateTime::UtcNow();
+
+        LapTimes->GetStore().Submit(Record);
+    }
+}
+
+void ARaceGateManager::RefreshHighlight(int32 RacerIndex) const
+{
+    if (const FRacerProgress* Racer = GetRacerProgress(RacerIndex))
+    {
+        UpdateHighlight(*Racer);
     }
 }
+
+void ARaceGateManager::UpdateHighlight(const FRacerProgress& Racer) const
+{
+    ADroneFPCharacter* Drone = Racer.Drone.Get();
+    UStaticMeshComponent* Highlight = Drone ? Drone->GetGateHighlight() : nullptr;
+    if (!Highlight)
+        return;
+
+    // Only drones someone looks through show a highlight; one that lost its pilot hides it
+    FTransform GateTransform;
+    if (!Drone->IsLocallyControlled() || !Drone->IsPlayerControlled() || !GetGateTransform(Racer.GateIndex, GateTransform))
+    {
+        // Also when the race is finished, or the next gate isn't created yet
+        Highlight->SetVisibility(false);
+        return;
+    }
+
+    UStaticMesh* Mesh = nullptr;
+    UMaterialInterface* Material = nullptr;
+    if (InstancedGateTransforms.IsValidIndex(Racer.GateIndex))
+    {
+        Mesh = GateInstances->GetStaticMesh();
+        Material = InstancedGateHighlightMaterial;
+    }
+    else if (const ARaceGate* Gate = Gates[Racer.GateIndex])
+    {
+        Mesh = Gate->GateMesh->GetStaticMesh();
+        Material = Gate->GlowMaterial;
+    }
+
+    Highlight->SetStaticMesh(Mesh);
+    if (Material)
+        Highlight->SetMaterial(0, Material);
+
+    // Slightly larger so it shows over the dark gate instead of z-fighting with it
+    GateTransform.SetScale3D(GateTransform.GetScale3D() * 1.02f);
+    Highlight->SetWorldTransform(GateTransform);
+    Highlight->SetVisibility(true);
+}
+
+int32 ARaceGateManager::GetNumGates() const
+{
+    return Course.IsOpen() ? Course.Gates().Num() : Gates.Num();
+}
+
+bool ARaceGateManager::GetGateTransform(int32 Index, FTransform& OutTransform) const
+{
+    if (InstancedGateTransforms.IsValidIndex(Index))
+    {
+        OutTransform = InstancedGateTransforms[Index];
+        return true;
+    }
+
+    if (Gates.IsValidIndex(Index) && Gates[Index])
+    {
+        OutTransform = Gates[Index]->GetActorTransform();
+        return true;
+    }
+
+    return false;
+}
+
+bool ARaceGateManager::GetUpcomingGateLocation(int32 RacerIndex, int32 Ahead, FVector& OutLocation) const
+{
+    const FRacerProgress* Racer = GetRacerProgress(RacerIndex);
+    const int32 NumGates = GetNumGates();
+    if (!Racer || NumGates == 0)
+        return false;
+
+    const int32 Absolute = Racer->GateIndex + Ahead;
+    const int32 Lap = Racer->Lap + Absolute / NumGates;
+    if (Lap > NumLaps)
+        return false;
+
+    FTransform GateTransform;
+    if (!GetGateTransform(Absolute % NumGates, GateTransform))
+        return false;
+
+    OutLocation = GateTransform.GetLocation();
+    return true;
+}
+
+float ARaceGateManager::GetLapTime(int32 RacerIndex) const
+{
+    const FRacerProgress* Racer = GetRacerProgress(RacerIndex);
+    const UWorld* World = GetWorld();
+    return Racer && World ? float(World->GetTimeSeconds() - Racer->LapStartTime) : 0.f;
+}
@@ -2,12 +2,75 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "RaceCourse.h"
+#include "RaceCourseGenerator.h"
+#include "RaceReferenceLap.h"
+#include "DroneWindSubsystem.h"
 #include "RaceGateManager.generated.h"
 
 class ARaceGate;
+class ADroneFPCharacter;
+class UInstancedStaticMeshComponent;
+class UMaterialInterface;
+
+// Progress of one racer through the course, owned by ARaceGateManager.
+// Sized to the course when the racer is reset, so a gate pass doesn't allocate.
+struct FRacerProgress
+{
+    TWeakObjectPtr<ADroneFPCharacter> Drone;
+    FString Pilot;
+
+    // Gate the racer must fly through next; NumGates once the race is finished
+    int32 GateIndex = 0;
+
+    // Current lap, 1-based
+    int32 Lap = 1;
+
+    // World time the current lap started, at a physics step boundary of the drone
+    double LapStartTime = 0.0;
+
+    // World time of the last gate pass (or of the race start): the end of the physics step that passed it
+    double LastGatePassTime = 0.0;
+
+    // Time between the last two gate passes, negative until the first gate is passed
+    float LastSplit = -1.f;
+
+    // Gates passed this lap and their splits, both sized to the course
+    TBitArray<> PassedGates;
+    TArray<float> Splits;
+
+    // The lap being flown, kept as the pilot's reference if it beats their best
+    FRaceReferenceLap Recording;
+
+    // Pilot's best lap on the course, null until they complete one
+    TSharedPtr<const FRaceReferenceLap> Reference;
+    FRaceReferenceCursor ReferenceCursor;
+
+    // Rewound or respawned this lap: it took time off, so the lap is practice, not submitted or kept as the best
+    bool bPracticeLap = false;
+
+    // Lap time minus the best lap's time at the same point of the course (negative is ahead)
+    float DeltaToBest = 0.f;
+    bool bHasDeltaToBest = false;
+
+    // Game time until which DeltaToBest keeps the completed lap's delta instead of the running one
+    double LapDeltaShownUntil = 0.0;
+};
 
 // Manages an ordered list of gates.
-// When the drone passes the correct one, activates the next.
+// Every registered racer has its own progress; when a racer passes its next
+// gate, that racer moves on to the following one. The next gate is shown to
+// each local pilot through their drone's own highlight, so split-screen
+// viewports each see their own target.
+//
+// Gates are either placed in the map and assigned to Gates, or loaded from a
+// course file (see RaceCourse.h). Loaded gates are spawned, or added as
+// instances of GateInstances, over several frames within SpawnBudgetMs.
+//
+// Instanced gates with a motion in the course file move without actors:
+// every frame their curves are evaluated in parallel and written to their
+// instances in contiguous batches, and passes are tested in each gate's
+// moving frame at the exact times of the drone's step.
 UCLASS()
 class DRONERACERFP_API ARaceGateManager : public AActor
 {
@@ -16,8 +79,11 @@ class DRONERACERFP_API ARaceGateManager : public AActor
 public:
     ARaceGateManager();
 
+    virtual void Tick(float DeltaTime) override;
+
 protected:
     virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
 
@@ -25,9 +91,167 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     TArray<ARaceGate*> Gates;
 
-    // Index of current active gate
-    int32 CurrentIndex = 0;
+    // Number of laps in the race, the gate sequence restarts until the last one
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "1"))
+    int32 NumLaps = 1;
+
+    // Seconds the whole-lap delta stays shown after crossing the line, before the new lap's running delta
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0"))
+    float LapDeltaHoldSeconds = 3.f;
+
+    // ===== Course files =====
+
+    // Course loaded at BeginPlay instead of the placed Gates (relative to the project Content dir)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Course")
+    FString CourseFile;
+
+    // Gate actor spawned for every gate of a loaded course
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Course")
+    TSubclassOf<ARaceGate> GateClass;
+
+    // Add loaded gates as instances of GateInstances instead of spawning actors
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Course")
+    bool bInstanceGates = false;
+
+    // Mesh instances for bInstanceGates
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Course")
+    UInstancedStaticMeshComponent* GateInstances;
+
+    // Material of the per-pilot next-gate highlight for instanced gates (actor gates use their GlowMaterial)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Course")
+    UMaterialInterface* InstancedGateHighlightMaterial;
+
+    // Half size (cm) of an instanced gate's opening at scale 1, local Y / Z
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Course")
+    FVector2D InstancedGateHalfOpening = FVector2D(150.f, 150.f);
+
+    // Game-thread time spent creating gates per frame while a course loads (ms)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Course", meta = (ClampMin = "0.1"))
+    float SpawnBudgetMs = 2.f;
+
+    // Replaces the current course with the one in Path. Gates appear over the next frames.
+    UFUNCTION(BlueprintCallable, Category = "Course")
+    bool LoadCourse(const FString& Path);
+
+    // Replaces the current course with a procedurally generated one (deterministic per seed)
+    UFUNCTION(BlueprintCallable, Category = "Course")
+    bool GenerateCourse(const FRaceCourseGeneratorSettings& Settings);
+
+    // Writes the current gates as a course file
+    UFUNCTION(BlueprintCallable, Category = "Course")
+    bool SaveCourse(const FString& Path, const FString& CourseName) const;
+
+    UFUNCTION(BlueprintPure, Category = "Course")
+    bool IsLoadingCourse() const { return NextGateToCreate < CourseGateCount(); }
+
+    // Id lap times are stored under; derived from the gate layout for placed gates
+    uint64 GetCourseId() const { return CourseId; }
+
+    // ===== Wind =====
+
+    // Wind field built over the gates once a course is ready
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wind")
+    FDroneWindSettings Wind;
+
+    // ===== Race progress =====
+
+    // Adds a drone to the race, returns its racer index
+    int32 RegisterRacer(ADroneFPCharacter* Drone);
+    void UnregisterRacer(int32 RacerIndex);
+
+    const FRacerProgress* GetRacerProgress(int32 RacerIndex) const;
+
+    // Racer indices are below this; unregistered ones have no progress
+    int32 GetNumRacerSlots() const { return Racers.Num(); }
+
+    // Puts a racer back to an earlier point of the current lap (rewind / crash respawn), making the lap practice.
+    // Gates before GateIndex count as passed this lap; times are relative to now.
+    void RestoreRacerProgress(int32 RacerIndex, int32 GateIndex, int32 Lap, float LapTime, float TimeSinceLastGate, float LastSplit);
+
+    // Shows or hides the racer's next-gate highlight after its drone changed controller
+    void RefreshHighlight(int32 RacerIndex) const;
+
+    // Called by a gate when a drone flies through it
+    void GatePassed(ARaceGate* PassedGate, ADroneFPCharacter* Drone);
+
+    // Called by drones after they moved from Start at StartTime to End at EndTime (world seconds);
+    // detects passes through instanced gates
+    void DroneMoved(ADroneFPCharacter* Drone, const FVector& Start, const FVector& End, double StartTime, double EndTime);
+
+    // Seconds since the racer's current lap started
+    float GetLapTime(int32 RacerIndex) const;
+
+    // Gates in the course, including ones still being created
+    int32 GetNumGates() const;
+
+    // World transform of a created gate
+    bool GetGateTransform(int32 Index, FTransform& OutTransform) const;
+
+    // Location of the gate Ahead gates after the racer's next one, wrapping while laps remain
+    bool GetUpcomingGateLocation(int32 RacerIndex, int32 Ahead, FVector& OutLocation) const;
+
+private:
+    void ResetProgress();
+    void ResetRacer(FRacerProgress& Racer, double Now) const;
+
+    // Time is when the drone passed the gate, the end of its physics step (ADroneFPCharacter::GetStateTime)
+    void OnGatePassed(int32 RacerIndex, int32 PassedIndex, double Time);
+    void LapCompleted(FRacerProgress& Racer, float LapTime);
+    void UpdateDeltaToBest(FRacerProgress& Racer, const FVector& Location, double Time);
+    void UpdateHighlight(const FRacerProgress& Racer) const;
+
+    void AnimateGates();
+    bool SegmentCrossesInstancedGate(int32 GateIndex, const FVector& Start, const FVector& End, double StartTime, double EndTime) const;
+
+    void ClearCourse();
+    void BeginCourse();
+    void PrepareWind();
+    void CreateCourseGates(double BudgetSeconds);
+    int32 CourseGateCount() const { return Course.IsOpen() ? Course.Gates().Num() : 0; }
+
+    // Loaded course, gate records are read in place
+    FRaceCourseFile Course;
+
+    // Next course record to turn into a gate
+    int32 NextGateToCreate = 0;
+
+    uint64 CourseId = 0;
+
+    // World transforms of instanced gates, indexed like the course
+    TArray<FTransform> InstancedGateTransforms;
+
+    // An instanced gate with a course motion
+    struct FMovingGate
+    {
+        int32 GateIndex = 0;
+
+        // World transform the motion is about
+        FTransform Base;
+        FRaceCourseGateMotionRecord Motion;
+    };
+
+    TArray<FMovingGate> MovingGates;
+
+    // Index into MovingGates of every instanced gate, INDEX_NONE for gates standing still
+    TArray<int32> MovingGateSlots;
+
+    // Consecutive moving gates, updated with one instance batch each
+    struct FMovingGateRun
+    {
+        int32 FirstGate = 0;
+        int32 NumGates = 0;
+    };
+    TArray<FMovingGateRun> MovingGateRuns;
+
+    // Transforms of one run, handed to the instance batch update
+    TArray<FTransform> MovingGateBatch;
+
+    // Next course motion record to match with a created gate
+    int32 NextMotionToMatch = 0;
+
+    // Indexed by racer index; unregistered slots have no Drone and are reused
+    TArray<FRacerProgress> Racers;
 
-    // Called by a gate when passed
-    void GatePassed(ARaceGate* PassedGate);
+    // Fastest lap of every pilot on the current course, for the delta to best
+    TMap<FString, TSharedPtr<const FRaceReferenceLap>> BestReferenceLaps;
 };
@@ -0,0 +1,152 @@
+#include "RaceReferenceLap.h"
+
+void FRaceReferenceLap::Begin(int32 NumGates)
+{
+    Points.Reset();
+    GateFirstPoint.Init(0, FMath::Max(NumGates, 0) + 1);
+    RecordingGate = 0;
+    bComplete = false;
+}
+
+void FRaceReferenceLap::Cancel()
+{
+    Points.Reset();
+    GateFirstPoint.Reset();
+    RecordingGate = 0;
+    bComplete = false;
+}
+
+void FRaceReferenceLap::Record(const FVector& Location, float LapTime, int32 GateIndex)
+{
+    // Not recording, or the racer went back to a gate before the one recorded
+    if (bComplete || GateIndex < RecordingGate || GateIndex >= GetNumGates())
+        return;
+
+    // The first point toward a new gate is always kept so every span has one
+    const bool bNewGate = GateIndex != RecordingGate;
+    if (Points.Num() > 0 && !bNewGate && FVector::DistSquared(Location, Points.Last().Location) < FMath::Square(MinPointSpacing))
+        return;
+
+    for (int32 Gate = RecordingGate + 1; Gate <= GateIndex; ++Gate)
+    {
+        GateFirstPoint[Gate] = Points.Num();
+    }
+    RecordingGate = GateIndex;
+
+    FRaceReferencePoint& Point = Points.AddDefaulted_GetRef();
+    Point.Location = Location;
+    if (Points.Num() > 1)
+    {
+        const FRaceReferencePoint& Previous = Points[Points.Num() - 2];
+        Point.Distance = Previous.Distance + float(FVector::Dist(Location, Previous.Location));
+
+        // Several steps can share a frame time
+        Point.Time = FMath::Max(LapTime, Previous.Time);
+    }
+    else
+    {
+        Point.Time = LapTime;
+    }
+}
+
+bool FRaceReferenceLap::Finish(const FVector& Location, float LapTime)
+{
+    const int32 NumGates = GetNumGates();
+    if (bComplete || NumGates <= 0 || Points.Num() == 0 || RecordingGate != NumGates - 1)
+        return false;
+
+    // Through the last gate regardless of spacing, the lap ends exactly here
+    const FRaceReferencePoint& Previous = Points.Last();
+    FRaceReferencePoint Point;
+    Point.Location = Location;
+    Point.Distance = Previous.Distance + float(FVector::Dist(Location, Previous.Location));
+    Point.Time = FMath::Max(LapTime, Previous.Time);
+    Points.Add(Point);
+
+    GateFirstPoint[NumGates] = Points.Num();
+    bComplete = true;
+    return true;
+}
+
+void FRaceReferenceLap::TruncateTo(float LapTime, int32 GateIndex)
+{
+    if (bComplete || GateFirstPoint.Num() == 0)
+        return;
+
+    // Points are in time order
+    int32 NumKept = Points.Num();
+    while (NumKept > 0 && Points[NumKept - 1].Time > LapTime)
+    {
+        --NumKept;
+    }
+    Points.SetNum(NumKept, EAllowShrinking::No);
+
+    RecordingGate = FMath::Clamp(GateIndex, 0, GetNumGates() - 1);
+    for (int32 Gate = 1; Gate <= RecordingGate; ++Gate)
+    {
+        GateFirstPoint[Gate] = FMath::Min(GateFirstPoint[Gate], NumKept);
+    }
+}
+
+float FRaceReferenceLap::SegmentDistSquared(int32 Segment, const FVector& Location, float& OutAlpha) const
+{
+    const FVector& Start = Points[Segment].Location;
+    const FVector Along = Points[Segment + 1].Location - Start;
+    const double LengthSquared = Along.SizeSquared();
+
+    OutAlpha = LengthSquared > UE_SMALL_NUMBER ? float(FMath::Clamp(FVector::DotProduct(Location - Start, Along) / LengthSquared, 0.0, 1.0)) : 0.f;
+    return float(FVector::DistSquared(Location, Start + Along * OutAlpha));
+}
+
+bool FRaceReferenceLap::Project(const FVector& Location, int32 GateIndex, FRaceReferenceCursor& Cursor, float& OutTime, float* OutDistance) const
+{
+    if (!bComplete || GateIndex < 0 || GateIndex >= GetNumGates())
+        return false;
+
+    // The segments flown toward this gate, plus the ones through the gates on either side
+    const int32 First = FMath::Max(GateFirstPoint[GateIndex] - 1, 0);
+    const int32 Last = FMath::Clamp(GateFirstPoint[GateIndex + 1] - 1, First, Points.Num() - 2);
+
+    // Warm start: the racer is near where they were, usually on the same or the next segment
+    int32 Segment = FMath::Clamp(Cursor.Segment, First, Last);
+    float Alpha = 0.f;
+    float Best = SegmentDistSquared(Segment, Location, Alpha);
+
+    bool bMovedForward = false;
+    while (Segment < Last)
+    {
+        float NextAlpha = 0.f;
+        const float Next = SegmentDistSquared(Segment + 1, Location, NextAlpha);
+        if (Next > Best)
+            break;
+
+        ++Segment;
+        Best = Next;
+        Alpha = NextAlpha;
+        bMovedForward = true;
+    }
+
+    // Backward only after a rewind or when flying the line the wrong way
+    while (!bMovedForward && Segment > First)
+    {
+        float PrevAlpha = 0.f;
+        const float Prev = SegmentDistSquared(Segment - 1, Location, PrevAlpha);
+        if (Prev >= Best)
+            break;
+
+        --Segment;
+        Best = Prev;
+        Alpha = PrevAlpha;
+    }
+
+    Cursor.Segment = Segment;
+
+    const FRaceReferencePoint& Start = Points[Segment];
+    const FRaceReferencePoint& End = Points[Segment + 1];
+    OutTime = FMath::Lerp(Start.Time, End.Time, Alpha);
+    if (OutDistance)
+    {
+        *OutDistance = FMath::Lerp(Start.Distance, End.Distance, Alpha);
+    }
+    return true;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** One point of a recorded lap */
+struct FRaceReferencePoint
+{
+    FVector Location = FVector::ZeroVector;
+
+    /** Arc length from the first point (cm) */
+    float Distance = 0.f;
+
+    /** Lap time at this point (s) */
+    float Time = 0.f;
+};
+
+/**
+ * Where a racer was last found on a reference lap. Kept per racer between
+ * queries so the next projection starts from there.
+ */
+struct FRaceReferenceCursor
+{
+    /** Segment from point Segment to point Segment + 1; clamped into the span searched */
+    int32 Segment = 0;
+
+    void Reset() { Segment = 0; }
+};
+
+/**
+ * A lap as the path the drone flew, parameterized by arc length with the lap
+ * time at every point, used to tell a racer how far ahead or behind their
+ * best lap they are anywhere on the course.
+ *
+ * Points are recorded at least MinPointSpacing apart and grouped by the gate
+ * the drone was flying toward, so a gate's span is the stretch of path
+ * between passing the previous gate and passing it. Project() only searches
+ * the span of the racer's next gate: where the line crosses itself (figure
+ * eights, a gate flown through twice from different sides), the gate order
+ * says which part of the path the racer is on. Within the span the search
+ * starts from the cursor's last segment and walks to the nearest neighbour,
+ * so a query usually tests two or three segments.
+ */
+class DRONERACERFP_API FRaceReferenceLap
+{
+public:
+    /** Points closer than this to the last one are skipped while recording (cm) */
+    static constexpr float MinPointSpacing = 100.f;
+
+    // ===== Recording =====
+
+    /** Starts an empty recording for a course with NumGates gates */
+    void Begin(int32 NumGates);
+
+    /** Adds the drone's location at LapTime while it is flying toward GateIndex */
+    void Record(const FVector& Location, float LapTime, int32 GateIndex);
+
+    /** Adds the point the lap ended at; false if the recording doesn't cover every gate */
+    bool Finish(const FVector& Location, float LapTime);
+
+    /** Drops points after LapTime (rewinds); the racer is flying toward GateIndex again */
+    void TruncateTo(float LapTime, int32 GateIndex);
+
+    /** Stops recording until the next Begin, the lap in progress can't be used */
+    void Cancel();
+
+    // ===== Queries =====
+
+    /** Finished laps only */
+    bool IsComplete() const { return bComplete; }
+
+    float GetLapTime() const { return bComplete ? Points.Last().Time : 0.f; }
+    float GetLength() const { return Points.Num() > 0 ? Points.Last().Distance : 0.f; }
+    int32 GetNumGates() const { return GateFirstPoint.Num() - 1; }
+
+    /**
+     * Lap time at the point of the reference nearest to Location, searching
+     * the part of the lap leading to GateIndex from where Cursor was left.
+     * False if the lap isn't complete or GateIndex is past the end.
+     */
+    bool Project(const FVector& Location, int32 GateIndex, FRaceReferenceCursor& Cursor, float& OutTime, float* OutDistance = nullptr) const;
+
+private:
+    /** Squared distance from Location to a segment, and how far along it the closest point is */
+    float SegmentDistSquared(int32 Segment, const FVector& Location, float& OutAlpha) const;
+
+    TArray<FRaceReferencePoint> Points;
+
+    /**
+     * First point recorded while flying toward each gate, NumGates + 1 entries;
+     * the last is Points.Num(). Gate G's span is the segments from the point
+     * before GateFirstPoint[G] up to the first point of gate G + 1.
+     */
+    TArray<int32> GateFirstPoint;
+
+    /** Gate the last recorded point was flying toward */
+    int32 RecordingGate = 0;
+
+    bool bComplete = false;
+};
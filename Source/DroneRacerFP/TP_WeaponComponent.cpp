@@ -2,6 +2,7 @@
 
 
 #include "TP_WeaponComponent.h"
+#include "DroneRacerFP.h"
 #include "DroneRacerFPCharacter.h"
 #include "DroneRacerFPProjectile.h"
 #include "GameFramework/PlayerController.h"
@@ -39,6 +40,9 @@ void UTP_WeaponComponent::Fire()
 			// MuzzleOffset is in camera space, so transform it to world space before offsetting from the character location to find the final muzzle position
 			const FVector SpawnLocation = GetOwner()->GetActorLocation() + SpawnRotation.RotateVector(MuzzleOffset);
 	
+			DRONERACER_SCOPED_STAT(ProjectileSpawn);
+			DRONERACER_COUNT_EVENT(ProjectileSpawns);
+
 			//Set Spawn Collision Handling Override
 			FActorSpawnParameters ActorSpawnParams;
 			ActorSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButDontSpawnIfColliding;
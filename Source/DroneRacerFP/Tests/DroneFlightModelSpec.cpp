@@ -0,0 +1,110 @@
+#include "DroneFlightModel.h"
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace DroneFlightModelSpec
+{
+    constexpr float StepSeconds = 1.f / 120.f;
+    constexpr int32 NumSteps = 240;
+
+    FDroneFlightState MakeState()
+    {
+        FDroneFlightState State;
+        State.Location = FVector(100.f, -200.f, 500.f);
+        State.Rotation = FQuat(FRotator(-20.f, 35.f, 10.f));
+        State.Velocity = FVector(300.f, 50.f, -100.f);
+        State.Battery01 = 0.8f;
+        return State;
+    }
+
+    /** What NumSteps calls of Step give */
+    FDroneFlightState StepEach(const FDroneFlightParams& Params, FDroneFlightState State, const FDroneFlightInput& Input, const FVector& Wind)
+    {
+        for (int32 Step = 0; Step < NumSteps; ++Step)
+        {
+            FDroneFlightModel::Step(Params, State, Input, Wind, StepSeconds);
+        }
+        return State;
+    }
+}
+
+BEGIN_DEFINE_SPEC(FDroneFlightModelSpec, "DroneRacer.FlightModel",
+    EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+
+    void TestMatchesSteps(const FDroneFlightParams& Params, const FDroneFlightInput& Input, const FVector& Wind,
+        float LocationTolerance, float VelocityTolerance);
+
+END_DEFINE_SPEC(FDroneFlightModelSpec)
+
+void FDroneFlightModelSpec::TestMatchesSteps(const FDroneFlightParams& Params, const FDroneFlightInput& Input, const FVector& Wind,
+    float LocationTolerance, float VelocityTolerance)
+{
+    using namespace DroneFlightModelSpec;
+
+    const FDroneFlightState Expected = StepEach(Params, MakeState(), Input, Wind);
+
+    FDroneFlightState Repeated = MakeState();
+    FDroneFlightModel::StepRepeated(Params, Repeated, Input, Wind, StepSeconds, NumSteps);
+
+    TestTrue(TEXT("Location"), Repeated.Location.Equals(Expected.Location, LocationTolerance));
+    TestTrue(TEXT("Velocity"), Repeated.Velocity.Equals(Expected.Velocity, VelocityTolerance));
+    TestTrue(TEXT("Rotation"), Repeated.Rotation.Equals(Expected.Rotation, 1e-4f));
+    TestEqual(TEXT("Battery01"), Repeated.Battery01, Expected.Battery01, 1e-4f);
+}
+
+void FDroneFlightModelSpec::Define()
+{
+    Describe("StepRepeated", [this]()
+    {
+        It("matches Step in closed form with the sticks centred", [this]()
+        {
+            FDroneFlightInput Input;
+            Input.Throttle01 = 0.6f;
+            TestMatchesSteps(FDroneFlightParams(), Input, FVector(150.f, -80.f, 20.f), 1.f, 0.5f);
+        });
+
+        It("matches Step in closed form without drag", [this]()
+        {
+            FDroneFlightParams Params;
+            Params.DragCoeff = 0.f;
+
+            FDroneFlightInput Input;
+            Input.Throttle01 = 0.3f;
+            TestMatchesSteps(Params, Input, FVector::ZeroVector, 1.f, 0.5f);
+        });
+
+        It("matches Step exactly with stick input", [this]()
+        {
+            FDroneFlightInput Input;
+            Input.Throttle01 = 0.7f;
+            Input.Pitch = 0.4f;
+            Input.Roll = -0.2f;
+            TestMatchesSteps(FDroneFlightParams(), Input, FVector(100.f, 0.f, 0.f), 0.f, 0.f);
+        });
+
+        It("matches Step exactly when the battery runs out and cuts the lift", [this]()
+        {
+            FDroneFlightParams Params;
+            Params.bBatteryCutsLift = true;
+            Params.BatteryFullThrottleSeconds = 1.f;
+
+            FDroneFlightInput Input;
+            Input.Throttle01 = 1.f;
+            TestMatchesSteps(Params, Input, FVector::ZeroVector, 0.f, 0.f);
+        });
+
+        It("does nothing for no steps", [this]()
+        {
+            FDroneFlightInput Input;
+            Input.Throttle01 = 1.f;
+
+            FDroneFlightState State = DroneFlightModelSpec::MakeState();
+            FDroneFlightModel::StepRepeated(FDroneFlightParams(), State, Input, FVector::ZeroVector, DroneFlightModelSpec::StepSeconds, 0);
+            TestTrue(TEXT("Location"), State.Location.Equals(DroneFlightModelSpec::MakeState().Location, 0.f));
+        });
+    });
+}
+
+#endif
@@ -0,0 +1,154 @@
+#include "LapTimeStore.h"
+
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace LapTimeStoreSpec
+{
+    constexpr uint64 CourseId = 0x5350454353544f52;
+    constexpr int32 NumLaps = 3;
+
+    FLapRecord MakeLap(int32 Index)
+    {
+        FLapRecord Record;
+        Record.CourseId = CourseId;
+        Record.Pilot = FString::Printf(TEXT("Pilot%d"), Index);
+        Record.LapTime = 30.f + Index;
+        Record.Splits = { 10.f, 10.f, 10.f + Index };
+        Record.ReplayRef = FString::Printf(TEXT("Lap%d.drreplay"), Index);
+        Record.Timestamp = FDateTime(2026, 1, 1) + FTimespan::FromMinutes(Index);
+        return Record;
+    }
+
+    /** Appends Bytes to the end of Path, as a write torn by a crash leaves them */
+    bool AppendBytes(const FString& Path, int32 NumBytes)
+    {
+        TArray<uint8> Bytes;
+        FFileHelper::LoadFileToArray(Bytes, *Path);
+        for (int32 Index = 0; Index < NumBytes; ++Index)
+        {
+            Bytes.Add(uint8(0xA5 ^ Index));
+        }
+        return FFileHelper::SaveArrayToFile(Bytes, *Path);
+    }
+
+    bool CutBytes(const FString& Path, int32 NumBytes)
+    {
+        TArray<uint8> Bytes;
+        if (!FFileHelper::LoadFileToArray(Bytes, *Path) || Bytes.Num() < NumBytes)
+            return false;
+        Bytes.SetNum(Bytes.Num() - NumBytes);
+        return FFileHelper::SaveArrayToFile(Bytes, *Path);
+    }
+}
+
+BEGIN_DEFINE_SPEC(FLapTimeStoreSpec, "DroneRacer.LapTimeStore",
+    EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+
+    FString Directory;
+    FString LogPath;
+    FString IndexPath;
+
+    /** Opens the store, checks it holds exactly the laps with these indices (as MakeLap), closes it */
+    void TestLaps(TConstArrayView<int32> Expected)
+    {
+        FLapTimeStore Store;
+        if (!TestTrue(TEXT("Opened"), Store.Open(Directory)))
+            return;
+
+        TestEqual(TEXT("Laps"), Store.GetNumLaps(), int64(Expected.Num()));
+
+        TArray<FLapIndexEntry> Entries;
+        Store.GetTopLaps(LapTimeStoreSpec::CourseId, FLapTimeStore::TopLapsPerCourse, Entries);
+        if (TestEqual(TEXT("Top laps"), Entries.Num(), Expected.Num()))
+        {
+            // Lap times grow with the index, so the top laps come back in index order
+            for (int32 Index = 0; Index < Entries.Num(); ++Index)
+            {
+                const FLapRecord Original = LapTimeStoreSpec::MakeLap(Expected[Index]);
+                FLapRecord Read;
+                if (TestTrue(TEXT("Record read"), Store.ReadLap(Entries[Index], Read)))
+                {
+                    TestEqual(TEXT("Pilot"), Read.Pilot, Original.Pilot);
+                    TestEqual(TEXT("Lap time"), Read.LapTime, Original.LapTime);
+                    TestEqual(TEXT("Replay"), Read.ReplayRef, Original.ReplayRef);
+                }
+            }
+        }
+        Store.Close();
+    }
+
+    void SubmitLaps(int32 First, int32 Count)
+    {
+        FLapTimeStore Store;
+        if (!TestTrue(TEXT("Opened"), Store.Open(Directory)))
+            return;
+
+        for (int32 Index = First; Index < First + Count; ++Index)
+        {
+            Store.Submit(LapTimeStoreSpec::MakeLap(Index));
+        }
+        Store.Close();
+    }
+
+END_DEFINE_SPEC(FLapTimeStoreSpec)
+
+void FLapTimeStoreSpec::Define()
+{
+    using namespace LapTimeStoreSpec;
+
+    BeforeEach([this]()
+    {
+        Directory = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("LapTimeStoreSpec"));
+        LogPath = FPaths::Combine(Directory, TEXT("laps.log"));
+        IndexPath = FPaths::Combine(Directory, TEXT("laps.idx"));
+        IFileManager::Get().DeleteDirectory(*Directory, false, true);
+
+        SubmitLaps(0, NumLaps);
+    });
+
+    AfterEach([this]()
+    {
+        IFileManager::Get().DeleteDirectory(*Directory, false, true);
+    });
+
+    It("reopens with every lap", [this]()
+    {
+        TestLaps({ 0, 1, 2 });
+    });
+
+    It("cuts torn index and log tails back before appending", [this]()
+    {
+        TestTrue(TEXT("Torn index entry"), AppendBytes(IndexPath, sizeof(FLapIndexEntry) / 2 + 1));
+        TestTrue(TEXT("Torn log record"), AppendBytes(LogPath, 23));
+        TestLaps({ 0, 1, 2 });
+
+        // Appends land after the last whole record, where the index says they are
+        SubmitLaps(NumLaps, 1);
+        TestLaps({ 0, 1, 2, 3 });
+    });
+
+    It("indexes a logged lap whose index entry was lost", [this]()
+    {
+        TestTrue(TEXT("Lost index entry"), CutBytes(IndexPath, sizeof(FLapIndexEntry)));
+        TestLaps({ 0, 1, 2 });
+
+        SubmitLaps(NumLaps, 1);
+        TestLaps({ 0, 1, 2, 3 });
+    });
+
+    It("drops a lap whose log record was torn", [this]()
+    {
+        TestTrue(TEXT("Torn log record"), CutBytes(LogPath, 5));
+        TestLaps({ 0, 1 });
+
+        SubmitLaps(NumLaps, 1);
+        TestLaps({ 0, 1, 3 });
+    });
+}
+
+#endif
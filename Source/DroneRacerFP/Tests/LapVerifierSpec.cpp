@@ -0,0 +1,322 @@
+#include "LapVerifier.h"
+#include "DroneReplay.h"
+#include "RaceCourse.h"
+
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Guid.h"
+#include "Misc/Paths.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace LapVerifierSpec
+{
+    constexpr uint64 CourseId = 0x5350454356524c41;
+    constexpr float StepSeconds = 1.f / 120.f;
+    constexpr int32 NumGates = 4;
+
+    // Well past the ~2 s the lap takes
+    constexpr int32 MaxSteps = 120 * 10;
+
+    /** Without gravity a drone pitched nose down flies straight along +X at full throttle */
+    FDroneFlightParams MakeParams()
+    {
+        FDroneFlightParams Params;
+        Params.GravityZ = 0.f;
+        return Params;
+    }
+
+    TArray<FTransform> MakeGates()
+    {
+        TArray<FTransform> Gates;
+        for (int32 Index = 0; Index < NumGates; ++Index)
+        {
+            Gates.Add(FTransform(FVector(1000.f * (Index + 1), 0.f, 500.f)));
+        }
+        return Gates;
+    }
+
+    FDroneFlightState MakeStartState()
+    {
+        FDroneFlightState State;
+        State.Location = FVector(0.f, 0.f, 500.f);
+        State.Rotation = FQuat(FRotator(-90.f, 0.f, 0.f));
+        return State;
+    }
+
+    /** Gate actors whose trigger is a box 1 m deep across the opening */
+    FLapVerifier::FConfig MakeTriggerConfig()
+    {
+        FLapVerifier::FConfig Config;
+        Config.GateTriggerExtent = FVector(50.f, 150.f, 150.f);
+        return Config;
+    }
+
+    /**
+     * Flies the course at full throttle and records the lap the way the
+     * character does, scored by gate triggers if Config has one.
+     */
+    bool FlyLap(const FString& ReplayPath, FLapRecord& OutClaim, const FLapVerifier::FConfig& Config = FLapVerifier::FConfig())
+    {
+        const FDroneFlightParams Params = MakeParams();
+        const TArray<FTransform> Gates = MakeGates();
+        const bool bTriggers = !Config.GateTriggerExtent.IsNearlyZero();
+
+        FDroneFlightState State = MakeStartState();
+        FDroneReplayRecorder Recorder;
+        Recorder.BeginLap(CourseId, FTransform::Identity, bTriggers ? FDroneReplayHeader::Trigger : FDroneReplayHeader::Opening,
+            StepSeconds, Params, State);
+
+        FDroneFlightInput Input;
+        Input.Throttle01 = 1.f;
+
+        OutClaim = FLapRecord();
+        OutClaim.CourseId = CourseId;
+        OutClaim.Pilot = TEXT("Spec");
+
+        int32 NextGate = 0;
+        int32 NumSteps = 0;
+        double LastGateTime = 0.0;
+        while (NextGate < NumGates && NumSteps < MaxSteps)
+        {
+            const FVector Start = State.Location;
+            FDroneFlightModel::Step(Params, State, Input, FVector::ZeroVector, StepSeconds);
+            Recorder.AddStep(Input, FVector::ZeroVector, true);
+            ++NumSteps;
+
+            const bool bPassed = bTriggers
+                ? RaceCourse::SegmentEntersGateTrigger(Config.GateTriggerTransform * Gates[NextGate], Config.GateTriggerExtent, Config.DroneRadius, Start, State.Location)
+                : RaceCourse::SegmentCrossesGate(Gates[NextGate], Config.GateHalfOpening, Start, State.Location);
+            if (bPassed)
+            {
+                const double Time = NumSteps * StepSeconds;
+                OutClaim.Splits.Add(float(Time - LastGateTime));
+                LastGateTime = Time;
+                ++NextGate;
+            }
+        }
+        OutClaim.LapTime = NumSteps * StepSeconds;
+
+        return NextGate == NumGates && Recorder.EndLap(ReplayPath);
+    }
+
+    /** EndLap writes on the thread pool */
+    bool WaitForReplay(const FString& Path, FDroneReplay& OutReplay)
+    {
+        for (int32 Attempt = 0; Attempt < 500; ++Attempt)
+        {
+            if (OutReplay.Load(Path))
+                return true;
+            FPlatformProcess::Sleep(0.01f);
+        }
+        return false;
+    }
+}
+
+BEGIN_DEFINE_SPEC(FLapVerifierSpec, "DroneRacer.LapVerifier",
+    EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+
+    FString ReplayPath;
+    FLapRecord Claim;
+    FDroneReplay Replay;
+
+    FLapVerifier MakeVerifier(const FLapVerifier::FConfig& Config = FLapVerifier::FConfig()) const
+    {
+        FLapVerifier Verifier(Config);
+        Verifier.AddCourse(LapVerifierSpec::CourseId, LapVerifierSpec::MakeGates());
+        return Verifier;
+    }
+
+    /** Marks Step as a contact that ended in Location / Velocity */
+    void AddContact(int32 Step, const FVector& Location, const FVector& Velocity, uint32 Flags = 0)
+    {
+        Replay.Steps[Step].Flags |= FDroneReplayStep::Contact;
+        FDroneReplayContact& Contact = Replay.Contacts.AddDefaulted_GetRef();
+        Contact.Step = Step;
+        Contact.Flags = Flags;
+        for (int32 Axis = 0; Axis < 3; ++Axis)
+        {
+            Contact.Location[Axis] = Location[Axis];
+            Contact.Velocity[Axis] = Velocity[Axis];
+        }
+    }
+
+    /** State after the first NumSteps steps of the recorded lap */
+    FDroneFlightState SimulateSteps(int32 NumSteps) const
+    {
+        FDroneFlightState State = Replay.GetInitialState();
+        for (int32 Step = 0; Step < NumSteps; ++Step)
+        {
+            FDroneFlightModel::Step(Replay.Header.Params, State, Replay.Steps[Step].Input, FVector::ZeroVector, Replay.Header.StepSeconds);
+        }
+        return State;
+    }
+
+END_DEFINE_SPEC(FLapVerifierSpec)
+
+void FLapVerifierSpec::Define()
+{
+    using namespace LapVerifierSpec;
+
+    BeforeEach([this]()
+    {
+        ReplayPath = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("LapVerifierSpec"),
+            FGuid::NewGuid().ToString(EGuidFormats::Digits) + TEXT(".drreplay"));
+        TestTrue(TEXT("Lap flown and recorded"), FlyLap(ReplayPath, Claim));
+        TestTrue(TEXT("Replay written"), WaitForReplay(ReplayPath, Replay));
+    });
+
+    AfterEach([this]()
+    {
+        IFileManager::Get().Delete(*ReplayPath, false, false, true);
+    });
+
+    It("verifies a recorded lap from its file", [this]()
+    {
+        FLapVerifier::FRequest Request;
+        Request.Claim = Claim;
+        Request.ReplayPath = ReplayPath;
+        TestEqual(TEXT("Result"), MakeVerifier().Verify(Request), ELapVerifyResult::Verified);
+    });
+
+    It("verifies a recorded lap flown with allowed params", [this]()
+    {
+        FLapVerifier::FConfig Config;
+        Config.AllowedFlightHashes.Add(FDroneReplay::ComputeFlightHash(MakeParams(), StepSeconds));
+        TestEqual(TEXT("Result"), MakeVerifier(Config).Verify(Claim, Replay), ELapVerifyResult::Verified);
+    });
+
+    It("rejects a lap flown with params that aren't allowed", [this]()
+    {
+        FLapVerifier::FConfig Config;
+        Config.AllowedFlightHashes.Add(FDroneReplay::ComputeFlightHash(FDroneFlightParams(), StepSeconds));
+        TestEqual(TEXT("Result"), MakeVerifier(Config).Verify(Claim, Replay), ELapVerifyResult::Mismatch);
+    });
+
+    It("verifies a lap scored by gate triggers", [this]()
+    {
+        const FLapVerifier::FConfig Config = MakeTriggerConfig();
+        const FString TriggerReplayPath = FPaths::SetExtension(ReplayPath, TEXT("trigger.drreplay"));
+
+        FLapRecord TriggerClaim;
+        FDroneReplay TriggerReplay;
+        TestTrue(TEXT("Lap flown and recorded"), FlyLap(TriggerReplayPath, TriggerClaim, Config));
+        TestTrue(TEXT("Replay written"), WaitForReplay(TriggerReplayPath, TriggerReplay));
+        TestEqual(TEXT("Result"), MakeVerifier(Config).Verify(TriggerClaim, TriggerReplay), ELapVerifyResult::Verified);
+
+        // The triggers are entered before the opening is crossed, so testing openings flies on past the last one
+        TriggerReplay.Header.GateTest = FDroneReplayHeader::Opening;
+        TestNotEqual(TEXT("Result as openings"), MakeVerifier(Config).Verify(TriggerClaim, TriggerReplay), ELapVerifyResult::Verified);
+
+        IFileManager::Get().Delete(*TriggerReplayPath, false, false, true);
+    });
+
+    It("rejects a lap scored by gate triggers without a trigger to test", [this]()
+    {
+        Replay.Header.GateTest = FDroneReplayHeader::Trigger;
+        TestEqual(TEXT("Result"), MakeVerifier().Verify(Claim, Replay), ELapVerifyResult::Mismatch);
+    });
+
+    It("rejects params edited after recording", [this]()
+    {
+        Replay.Header.Params.MaxLiftForce *= 2.f;
+        TestEqual(TEXT("Result"), MakeVerifier().Verify(Claim, Replay), ELapVerifyResult::Mismatch);
+    });
+
+    It("rejects a claim faster than the replay", [this]()
+    {
+        Claim.LapTime -= 0.5f;
+        TestEqual(TEXT("Result"), MakeVerifier().Verify(Claim, Replay), ELapVerifyResult::TooFast);
+    });
+
+    It("rejects a split faster than the replay", [this]()
+    {
+        Claim.Splits[1] -= 0.5f;
+        TestEqual(TEXT("Result"), MakeVerifier().Verify(Claim, Replay), ELapVerifyResult::TooFast);
+    });
+
+    It("accepts a lap a step short and rejects one two steps short", [this]()
+    {
+        Claim.LapTime -= StepSeconds;
+        TestEqual(TEXT("One step"), MakeVerifier().Verify(Claim, Replay), ELapVerifyResult::Verified);
+
+        Claim.LapTime -= StepSeconds;
+        TestEqual(TEXT("Two steps"), MakeVerifier().Verify(Claim, Replay), ELapVerifyResult::TooFast);
+    });
+
+    It("rejects a lap cut short before the last gate", [this]()
+    {
+        Replay.Steps.SetNum(Replay.Steps.Num() / 2);
+        TestEqual(TEXT("Result"), MakeVerifier().Verify(Claim, Replay), ELapVerifyResult::Incomplete);
+    });
+
+    It("rejects a lap that starts far from the course", [this]()
+    {
+        Replay.Header.Location[1] = 20000.0;
+        TestEqual(TEXT("Result"), MakeVerifier().Verify(Claim, Replay), ELapVerifyResult::Impossible);
+    });
+
+    It("rejects a lap that starts too fast", [this]()
+    {
+        Replay.Header.Velocity[0] = 100000.0;
+        TestEqual(TEXT("Result"), MakeVerifier().Verify(Claim, Replay), ELapVerifyResult::Impossible);
+    });
+
+    It("rejects a contact off the step's path", [this]()
+    {
+        const FDroneFlightState State = SimulateSteps(11);
+        AddContact(10, State.Location + FVector(0.f, 0.f, 300.f), State.Velocity);
+        TestEqual(TEXT("Result"), MakeVerifier().Verify(Claim, Replay), ELapVerifyResult::Impossible);
+    });
+
+    It("rejects a contact that speeds the drone up", [this]()
+    {
+        const FDroneFlightState State = SimulateSteps(11);
+        AddContact(10, State.Location, State.Velocity * 2.f);
+        TestEqual(TEXT("Result"), MakeVerifier().Verify(Claim, Replay), ELapVerifyResult::Impossible);
+    });
+
+    It("rejects a contact that turns the drone", [this]()
+    {
+        const FDroneFlightState State = SimulateSteps(11);
+        AddContact(10, State.Location, FVector(0.f, State.Velocity.Size(), 0.f));
+        TestEqual(TEXT("Result"), MakeVerifier().Verify(Claim, Replay), ELapVerifyResult::Impossible);
+    });
+
+    It("accepts a contact that slides along a surface", [this]()
+    {
+        // A wall on the right takes away the little sideways velocity there is; the drone flies on
+        const FDroneFlightState State = SimulateSteps(11);
+        AddContact(10, State.Location, FVector(State.Velocity.X, 0.f, State.Velocity.Z));
+        TestEqual(TEXT("Result"), MakeVerifier().Verify(Claim, Replay), ELapVerifyResult::Verified);
+    });
+
+    It("accepts a drone push within its bounds", [this]()
+    {
+        // Nudged sideways off the line; the lap still flies through the gates
+        const FDroneFlightState State = SimulateSteps(11);
+        AddContact(10, State.Location + FVector(0.f, 5.f, 0.f), State.Velocity + FVector(0.f, 10.f, 0.f), FDroneReplayContact::DronePush);
+        TestEqual(TEXT("Result"), MakeVerifier().Verify(Claim, Replay), ELapVerifyResult::Verified);
+    });
+
+    It("rejects a drone push harder than any closing speed", [this]()
+    {
+        const FDroneFlightState State = SimulateSteps(11);
+        AddContact(10, State.Location, State.Velocity + FVector(10000.f, 0.f, 0.f), FDroneReplayContact::DronePush);
+        TestEqual(TEXT("Result"), MakeVerifier().Verify(Claim, Replay), ELapVerifyResult::Impossible);
+    });
+
+    It("rejects more drone pushes than a lap may have", [this]()
+    {
+        FLapVerifier::FConfig Config;
+        Config.MaxDronePushes = 1;
+
+        FDroneFlightState State = SimulateSteps(11);
+        AddContact(10, State.Location, State.Velocity, FDroneReplayContact::DronePush);
+        State = SimulateSteps(12);
+        AddContact(11, State.Location, State.Velocity, FDroneReplayContact::DronePush);
+        TestEqual(TEXT("Result"), MakeVerifier(Config).Verify(Claim, Replay), ELapVerifyResult::Impossible);
+    });
+}
+
+#endif